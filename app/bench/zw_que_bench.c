@@ -0,0 +1,193 @@
+/**
+@file   zw_que_bench.c - Request queue microbenchmark.
+
+        Compares the constant time FIFO queue (util_que_add/util_que_get) with the list that
+        walks to its tail on every append (util_list_add/util_list_get), at increasing queue
+        depths. At each depth the queue is filled, then entries are appended and removed in
+        pairs so the depth stays the same.
+
+@version    1.0 Initial release
+
+version: 1.0
+comments: Initial release
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include "../../include/zw_hci_platform.h"
+#include "../../include/zw_hci_util.h"
+
+///
+/// Benchmark defaults
+#define QB_DEPTH_MIN            1       ///< Shallowest queue depth
+#define QB_DEPTH_MAX_DEF        16384   ///< Deepest queue depth, multiplied by 4 from QB_DEPTH_MIN
+#define QB_OPS_DEF              20000   ///< Number of append and remove pairs at each depth
+#define QB_DAT_SZ               16      ///< Size of the data of each entry, a typical request
+
+
+/**
+qb_now_ns - Get the monotonic time
+@return     Time in nanoseconds
+*/
+static uint64_t qb_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+qb_que_run - Measure the FIFO queue
+@param[in]  mtx         Mutex context
+@param[in]  depth       Queue depth
+@param[in]  ops         Number of append and remove pairs
+@param[out] fill_ns     Average time to append an entry while filling the queue
+@return     Average time of an append and remove pair at the given depth in nanoseconds
+*/
+static double qb_que_run(void *mtx, int depth, int ops, double *fill_ns)
+{
+    util_que_t  que;
+    util_lst_t  *ent;
+    uint8_t     dat[QB_DAT_SZ];
+    uint64_t    t0;
+    int         i;
+
+    memset(&que, 0, sizeof(que));
+    memset(dat, 0x55, sizeof(dat));
+
+    t0 = qb_now_ns();
+    for (i = 0; i < depth; i++)
+    {
+        util_que_add(mtx, &que, dat, QB_DAT_SZ);
+    }
+    *fill_ns = (double)(qb_now_ns() - t0) / depth;
+
+    t0 = qb_now_ns();
+    for (i = 0; i < ops; i++)
+    {
+        util_que_add(mtx, &que, dat, QB_DAT_SZ);
+        ent = util_que_get(mtx, &que);
+        util_mem_free(ent);
+    }
+    t0 = qb_now_ns() - t0;
+
+    util_que_flush(mtx, &que);
+    return (double)t0 / ops;
+}
+
+
+/**
+qb_list_run - Measure the list
+@param[in]  mtx         Mutex context
+@param[in]  depth       List depth
+@param[in]  ops         Number of append and remove pairs
+@param[out] fill_ns     Average time to append an entry while filling the list
+@return     Average time of an append and remove pair at the given depth in nanoseconds
+*/
+static double qb_list_run(void *mtx, int depth, int ops, double *fill_ns)
+{
+    util_lst_t  *head = NULL;
+    util_lst_t  *ent;
+    uint8_t     dat[QB_DAT_SZ];
+    uint64_t    t0;
+    int         i;
+
+    memset(dat, 0x55, sizeof(dat));
+
+    t0 = qb_now_ns();
+    for (i = 0; i < depth; i++)
+    {
+        util_list_add(mtx, &head, dat, QB_DAT_SZ);
+    }
+    *fill_ns = (double)(qb_now_ns() - t0) / depth;
+
+    t0 = qb_now_ns();
+    for (i = 0; i < ops; i++)
+    {
+        util_list_add(mtx, &head, dat, QB_DAT_SZ);
+        ent = util_list_get(mtx, &head);
+        util_mem_free(ent);
+    }
+    t0 = qb_now_ns() - t0;
+
+    util_list_flush(mtx, &head);
+    return (double)t0 / ops;
+}
+
+
+/**
+qb_usage - Show the command line options
+@param[in]  prog    Program name
+@return
+*/
+static void qb_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -d <depth>   Deepest queue depth, default %d\n"
+           "  -o <count>   Append and remove pairs at each depth, default %d\n"
+           "  -h           Show this help\n",
+           prog, QB_DEPTH_MAX_DEF, QB_OPS_DEF);
+}
+
+
+int main(int argc, char **argv)
+{
+    void        *mtx;
+    double      que_ns;
+    double      list_ns;
+    double      que_fill_ns;
+    double      list_fill_ns;
+    int         depth_max = QB_DEPTH_MAX_DEF;
+    int         ops = QB_OPS_DEF;
+    int         depth;
+    int         opt;
+
+    while ((opt = getopt(argc, argv, "d:o:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'd': depth_max = atoi(optarg); break;
+            case 'o': ops = atoi(optarg); break;
+            default:
+                qb_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if ((depth_max < QB_DEPTH_MIN) || (ops <= 0))
+    {
+        qb_usage(argv[0]);
+        return 1;
+    }
+
+    util_mem_init();
+    if (!plt_mtx_init(&mtx))
+    {
+        printf("Mutex initialization failed\n");
+        return 1;
+    }
+
+    //Warm up the memory pool and the caches
+    qb_que_run(mtx, QB_DEPTH_MAX_DEF / 16, ops, &que_fill_ns);
+    qb_list_run(mtx, QB_DEPTH_MAX_DEF / 16, ops, &list_fill_ns);
+
+    printf("%d append and remove pairs at each depth, %d bytes per entry\n", ops, QB_DAT_SZ);
+    printf("%8s  %14s  %14s  %14s  %14s\n", "depth", "que_add+get", "list_add+get", "que_add fill", "list_add fill");
+
+    for (depth = QB_DEPTH_MIN; depth <= depth_max; depth *= 4)
+    {
+        que_ns = qb_que_run(mtx, depth, ops, &que_fill_ns);
+        list_ns = qb_list_run(mtx, depth, ops, &list_fill_ns);
+        printf("%8d  %11.0f ns  %11.0f ns  %11.0f ns  %11.0f ns\n",
+               depth, que_ns, list_ns, que_fill_ns, list_fill_ns);
+    }
+
+    plt_mtx_destroy(mtx);
+    return 0;
+}
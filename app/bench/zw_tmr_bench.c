@@ -0,0 +1,356 @@
+/**
+@file   zw_tmr_bench.c - Platform timer microbenchmark.
+
+        Starts thousands of concurrent one-shot timers, stops half of them and lets the rest
+        expire. Reports the cost of plt_tmr_start and plt_tmr_stop, the CPU time the timer
+        engine uses while the timers are pending, and how late the timers fire.
+        Then several threads keep restarting short timers as soon as the previous one fires,
+        so that timers are often added just as the timer check thread moves the wheel. This
+        catches timers that are added to a slot the wheel has already passed. The run fails
+        if a timer fires more than TB_LATE_MAX_MS late.
+
+@version    1.0 Initial release
+
+version: 1.0
+comments: Initial release
+*/
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <sys/resource.h>
+#include "../../include/zw_hci_platform.h"
+
+///
+/// Benchmark defaults
+#define TB_TMR_CNT_DEF          10000   ///< Number of timers
+#define TB_TMOUT_MIN_DEF        1000    ///< Shortest timeout in milliseconds
+#define TB_TMOUT_MAX_DEF        5000    ///< Longest timeout in milliseconds
+#define TB_TMR_CNT_MAX          30000   ///< One-shot timer ids range from 1 to 0x7FFF
+#define TB_GRACE_MS             2000    ///< Time to wait for late timers after the longest timeout
+#define TB_CHURN_CNT_DEF        4000    ///< Number of short timers restarted one after another
+#define TB_CHURN_TMOUT_MAX      4       ///< Longest timeout of the short timers in milliseconds
+#define TB_CHURN_THRD_CNT       4       ///< Number of threads restarting the short timers
+#define TB_LATE_MAX_MS          50      ///< Lateness that fails the run, well below a wheel turn of 256 ticks
+
+///
+/// Timer record
+typedef struct
+{
+    void                *hdl;       ///< Timer handle
+    uint64_t            deadline;   ///< Expected expiry time in milliseconds
+    int32_t             late_ms;    ///< Time the timer fired after its deadline
+    volatile int        fired;      ///< Number of times the callback ran
+    int                 stopped;    ///< Flag to indicate the timer was stopped
+
+} tb_tmr_t;
+
+///
+/// Short timer starter
+typedef struct
+{
+    plt_ctx_t           *plt_ctx;   ///< Platform context
+    tb_tmr_t            *tmr;       ///< First timer record to start
+    int                 cnt;        ///< Number of timers to start
+    unsigned            seed;       ///< Random seed
+    int                 err;        ///< Flag to indicate a timer failed to start
+
+} tb_churn_t;
+
+static tb_tmr_t         *tb_tmr;        ///< Timer records
+static volatile int     tb_fired_cnt;   ///< Number of callbacks run
+
+
+/**
+tb_print - Print text from the platform layer
+@param[in]  msg     Null terminated string
+@return
+*/
+static void tb_print(void *msg)
+{
+    fputs((const char *)msg, stdout);
+}
+
+
+/**
+tb_now_ns - Get the monotonic time
+@return     Time in nanoseconds
+*/
+static uint64_t tb_now_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+
+/**
+tb_cpu_ms - Get the CPU time used by the process
+@return     User and system time in milliseconds
+*/
+static uint64_t tb_cpu_ms(void)
+{
+    struct rusage   usage;
+
+    getrusage(RUSAGE_SELF, &usage);
+    return (uint64_t)(usage.ru_utime.tv_sec + usage.ru_stime.tv_sec) * 1000
+           + (uint64_t)(usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) / 1000;
+}
+
+
+/**
+tb_tmout_cb - Timer callback
+@param[in]  data    Timer record
+@return
+*/
+static void tb_tmout_cb(void *data)
+{
+    tb_tmr_t    *tmr = (tb_tmr_t *)data;
+
+    tmr->late_ms = (int32_t)((int64_t)plt_mono_ms() - (int64_t)tmr->deadline);
+    __sync_add_and_fetch(&tmr->fired, 1);
+    __sync_add_and_fetch(&tb_fired_cnt, 1);
+}
+
+
+/**
+tb_churn_thrd - Thread to restart a short timer as soon as the previous one fires
+@param[in]  data    Starter
+@return     NULL
+*/
+static void *tb_churn_thrd(void *data)
+{
+    tb_churn_t  *churn = (tb_churn_t *)data;
+    tb_tmr_t    *tmr;
+    uint64_t    end_ms;
+    uint32_t    tmout;
+    int         i;
+
+    for (i = 0; i < churn->cnt; i++)
+    {
+        tmr = &churn->tmr[i];
+        tmout = 1 + (uint32_t)rand_r(&churn->seed) % TB_CHURN_TMOUT_MAX;
+        tmr->deadline = plt_mono_ms() + tmout;
+        tmr->hdl = plt_tmr_start(churn->plt_ctx, tmout, tb_tmout_cb, tmr);
+        if (!tmr->hdl)
+        {
+            churn->err = 1;
+            break;
+        }
+
+        end_ms = tmr->deadline + TB_GRACE_MS;
+        while (!tmr->fired && (plt_mono_ms() < end_ms))
+        {
+            usleep(100);
+        }
+        plt_tmr_stop(churn->plt_ctx, tmr->hdl);
+    }
+    return NULL;
+}
+
+
+/**
+tb_late_cmp - Compare the lateness of two timers for qsort
+@param[in]  a   Lateness
+@param[in]  b   Lateness
+@return     Negative, zero or positive as a is less, equal or greater than b
+*/
+static int tb_late_cmp(const void *a, const void *b)
+{
+    return *(const int32_t *)a - *(const int32_t *)b;
+}
+
+
+/**
+tb_usage - Show the command line options
+@param[in]  prog    Program name
+@return
+*/
+static void tb_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -n <count>   Number of concurrent timers, up to %d, default %d\n"
+           "  -l <ms>      Shortest timeout, default %d\n"
+           "  -u <ms>      Longest timeout, default %d\n"
+           "  -c <count>   Number of short timers restarted one after another, default %d\n"
+           "  -S <seed>    Random seed, default is the current time\n"
+           "  -h           Show this help\n",
+           prog, TB_TMR_CNT_MAX, TB_TMR_CNT_DEF, TB_TMOUT_MIN_DEF, TB_TMOUT_MAX_DEF, TB_CHURN_CNT_DEF);
+}
+
+
+int main(int argc, char **argv)
+{
+    static plt_ctx_t    plt_ctx;
+    pthread_t           churn_thrd[TB_CHURN_THRD_CNT];
+    tb_churn_t          churn[TB_CHURN_THRD_CNT];
+    int32_t             *late;
+    unsigned            seed = (unsigned)time(NULL);
+    uint32_t            tmout_min = TB_TMOUT_MIN_DEF;
+    uint32_t            tmout_max = TB_TMOUT_MAX_DEF;
+    uint32_t            tmout;
+    uint64_t            t0;
+    uint64_t            start_ns;
+    uint64_t            stop_ns;
+    uint64_t            cpu_ms;
+    uint64_t            wait_ms;
+    uint64_t            end_ms;
+    int                 tmr_cnt = TB_TMR_CNT_DEF;
+    int                 churn_cnt = TB_CHURN_CNT_DEF;
+    int                 run_cnt = 0;
+    int                 late_cnt = 0;
+    int                 early_cnt = 0;
+    int                 missed_cnt = 0;
+    int                 wrong_cnt = 0;
+    int                 opt;
+    int                 i;
+
+    while ((opt = getopt(argc, argv, "n:l:u:c:S:h")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': tmr_cnt = atoi(optarg); break;
+            case 'l': tmout_min = (uint32_t)atoi(optarg); break;
+            case 'u': tmout_max = (uint32_t)atoi(optarg); break;
+            case 'c': churn_cnt = atoi(optarg); break;
+            case 'S': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            default:
+                tb_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if ((tmr_cnt <= 1) || (tmr_cnt > TB_TMR_CNT_MAX) || (churn_cnt < 0)
+        || (tmout_min == 0) || (tmout_max < tmout_min))
+    {
+        tb_usage(argv[0]);
+        return 1;
+    }
+
+    tb_tmr = (tb_tmr_t *)calloc(tmr_cnt + churn_cnt, sizeof(tb_tmr_t));
+    late = (int32_t *)calloc(tmr_cnt + churn_cnt, sizeof(int32_t));
+    if (!tb_tmr || !late)
+    {
+        return 1;
+    }
+
+    if (plt_init(&plt_ctx, tb_print, 0) != 0)
+    {
+        printf("Platform initialization failed\n");
+        return 1;
+    }
+
+    srand(seed);
+    printf("%d timers, timeouts %u to %u ms, %d short timers, seed %u\n",
+           tmr_cnt, tmout_min, tmout_max, churn_cnt, seed);
+
+    //Start all the timers
+    t0 = tb_now_ns();
+    for (i = 0; i < tmr_cnt; i++)
+    {
+        tmout = tmout_min + (uint32_t)rand() % (tmout_max - tmout_min + 1);
+        tb_tmr[i].deadline = plt_mono_ms() + tmout;
+        tb_tmr[i].hdl = plt_tmr_start(&plt_ctx, tmout, tb_tmout_cb, &tb_tmr[i]);
+        if (!tb_tmr[i].hdl)
+        {
+            printf("Start timer %d failed\n", i);
+            return 1;
+        }
+    }
+    start_ns = tb_now_ns() - t0;
+
+    //Stop every other timer
+    t0 = tb_now_ns();
+    for (i = 0; i < tmr_cnt; i += 2)
+    {
+        plt_tmr_stop(&plt_ctx, tb_tmr[i].hdl);
+        tb_tmr[i].stopped = 1;
+    }
+    stop_ns = tb_now_ns() - t0;
+
+    //Let the others expire
+    cpu_ms = tb_cpu_ms();
+    t0 = plt_mono_ms();
+    end_ms = t0 + tmout_max + TB_GRACE_MS;
+    while ((tb_fired_cnt < tmr_cnt / 2) && (plt_mono_ms() < end_ms))
+    {
+        plt_sleep(10);
+    }
+    wait_ms = plt_mono_ms() - t0;
+    cpu_ms = tb_cpu_ms() - cpu_ms;
+
+    //Restart short timers while the timer check thread keeps moving the wheel
+    for (i = 0; i < TB_CHURN_THRD_CNT; i++)
+    {
+        churn[i].plt_ctx = &plt_ctx;
+        churn[i].tmr = &tb_tmr[tmr_cnt + (churn_cnt * i) / TB_CHURN_THRD_CNT];
+        churn[i].cnt = (churn_cnt * (i + 1)) / TB_CHURN_THRD_CNT - (churn_cnt * i) / TB_CHURN_THRD_CNT;
+        churn[i].seed = seed + i;
+        churn[i].err = 0;
+        if (pthread_create(&churn_thrd[i], NULL, tb_churn_thrd, &churn[i]) != 0)
+        {
+            printf("Create thread failed\n");
+            return 1;
+        }
+    }
+    for (i = 0; i < TB_CHURN_THRD_CNT; i++)
+    {
+        pthread_join(churn_thrd[i], NULL);
+        if (churn[i].err)
+        {
+            printf("Start short timer failed\n");
+            return 1;
+        }
+    }
+
+    //Catch callbacks of stopped timers that fire late
+    plt_sleep(100);
+
+    for (i = 0; i < (tmr_cnt + churn_cnt); i++)
+    {
+        if (tb_tmr[i].stopped)
+        {
+            if (tb_tmr[i].fired)
+                wrong_cnt++;
+        }
+        else if (tb_tmr[i].fired != 1)
+        {
+            missed_cnt++;
+        }
+        else
+        {
+            late[run_cnt++] = tb_tmr[i].late_ms;
+            if (tb_tmr[i].late_ms < 0)
+                early_cnt++;
+            else if (tb_tmr[i].late_ms > TB_LATE_MAX_MS)
+                late_cnt++;
+        }
+    }
+
+    printf("plt_tmr_start: %.0f ns per call\n", (double)start_ns / tmr_cnt);
+    printf("plt_tmr_stop : %.0f ns per call\n", (double)stop_ns / ((tmr_cnt + 1) / 2));
+    printf("CPU time while %d timers were pending: %llu ms in %llu ms (%.2f%%)\n",
+           tmr_cnt - (tmr_cnt + 1) / 2, (unsigned long long)cpu_ms, (unsigned long long)wait_ms,
+           (wait_ms)? 100.0 * cpu_ms / wait_ms : 0.0);
+
+    if (run_cnt > 0)
+    {
+        qsort(late, run_cnt, sizeof(int32_t), tb_late_cmp);
+        printf("Lateness: median %d ms, 99th percentile %d ms, max %d ms; early %d, over %d ms %d\n",
+               late[run_cnt / 2], late[(run_cnt * 99) / 100], late[run_cnt - 1], early_cnt,
+               TB_LATE_MAX_MS, late_cnt);
+    }
+    printf("Fired %d of %d, missed %d, stopped timers fired %d\n",
+           run_cnt, tmr_cnt - (tmr_cnt + 1) / 2 + churn_cnt, missed_cnt, wrong_cnt);
+
+    plt_exit(&plt_ctx);
+    free(late);
+    free(tb_tmr);
+
+    return (missed_cnt || wrong_cnt || late_cnt)? 1 : 0;
+}
@@ -0,0 +1,448 @@
+/**
+@file   zw_frm_fuzz.c - Differential fuzzer of the frame layer receive paths.
+
+        Feeds the same random byte streams to the chunk parser (frm_rx_chunk) and to the
+        byte by byte state-machine (frm_sta_machine), then compares the frames passed to the
+        session layer, the ACK/NAK bytes sent, the send status callbacks, the statistics
+        (including the resync count) and the final state of the two.
+
+        The frame layer source is compiled into this program with its platform and transport
+        calls replaced, so that both receive paths run deterministically on the development host.
+
+@version    1.0 Initial release
+
+version: 1.0
+comments: Initial release
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <stdarg.h>
+#include <unistd.h>
+#include <time.h>
+#include "../../include/zw_hci_frame.h"
+
+static void *fz_null(void);
+static int fz_ctl_snd(uint8_t ctl_byte);
+
+//Replace the platform and transport calls of the frame layer. Only the receive paths are
+//exercised, the send path stubs fail.
+#define plt_mtx_lck(m)                  ((void)0)
+#define plt_mtx_ulck(m)                 ((void)0)
+#define plt_mtx_init(m)                 0
+#define plt_mtx_destroy(m)              ((void)0)
+#define plt_tmr_start(p, ms, cb, d)     fz_null()
+#define plt_tmr_stop(p, t)              ((void)0)
+#define plt_mono_us()                   0ULL
+#define plt_rand_get()                  7
+#define tpt_init(t)                     (-1)
+#define tpt_exit(t)                     ((void)0)
+#define tpt_ctl_byte_snd(t, b)          fz_ctl_snd(b)
+#define tpt_wr_buf_req(t, b)            0
+#define util_buf_alloc(h, sz)           fz_null()
+#define util_buf_push(b, len)           fz_null()
+#define util_buf_put(b, len)            fz_null()
+#define util_buf_hold(b)                ((void)0)
+#define util_buf_release(b)             ((void)0)
+
+#include "../../lib/zw_hci_frame.c"
+
+///
+/// Fuzzer parameters
+#define FZ_STRM_MAX             4096    ///< Maximum length of a random byte stream
+#define FZ_STRM_FILL            3800    ///< Stop adding pieces to a stream after this length
+#define FZ_CHUNK_MAX            300     ///< Maximum chunk length passed to frm_rx_chunk
+#define FZ_LOG_SZ               0x10000 ///< Size of the event log of each receive path
+#define FZ_STREAMS_DEF          20000   ///< Default number of streams
+
+///
+/// Event log of a receive path
+typedef struct
+{
+    char        buf[FZ_LOG_SZ];     ///< Events in text form
+    int         len;                ///< Length of the text
+    int         ovf;                ///< Flag to indicate the log was too small
+
+} fz_log_t;
+
+///
+/// Random stream and the points where a receive timeout is injected
+typedef struct
+{
+    uint8_t     dat[FZ_STRM_MAX];   ///< Bytes
+    uint8_t     tmo[FZ_STRM_MAX];   ///< Non-zero if a receive timeout occurs before the byte
+    int         len;                ///< Number of bytes
+
+} fz_strm_t;
+
+static fz_log_t     *fz_cur_log;    ///< The log of the receive path being run
+
+
+/**
+fz_null - Stub of the platform and buffer functions which return a pointer
+@return     NULL
+*/
+static void *fz_null(void)
+{
+    return NULL;
+}
+
+
+/**
+fz_log - Append an event to the current log
+@param[in]  fmt     Format string
+@return
+*/
+static void fz_log(const char *fmt, ...)
+{
+    fz_log_t    *log = fz_cur_log;
+    va_list     args;
+    int         len;
+
+    if (log->ovf)
+        return;
+
+    va_start(args, fmt);
+    len = vsnprintf(log->buf + log->len, FZ_LOG_SZ - log->len, fmt, args);
+    va_end(args);
+
+    if ((len < 0) || (len >= FZ_LOG_SZ - log->len))
+    {
+        log->ovf = 1;
+        return;
+    }
+    log->len += len;
+}
+
+
+/**
+fz_ctl_snd - Record an ACK/NAK sent by the frame layer
+@param[in]  ctl_byte    Control byte
+@return     Zero, the byte is always sent
+*/
+static int fz_ctl_snd(uint8_t ctl_byte)
+{
+    fz_log("C%02X ", ctl_byte);
+    return 0;
+}
+
+
+/**
+fz_snd_sts_cb - Record a send frame status callback
+@param[in]  frm_ctx     Context
+@param[in]  status      Send frame status
+@return
+*/
+static void fz_snd_sts_cb(struct _frm_layer_ctx *frm_ctx, frm_snd_sts_t status)
+{
+    fz_log("S%d ", (int)status);
+}
+
+
+/**
+fz_rx_frm_cb - Record a frame passed to the session layer
+@param[in]  frm_ctx     Context
+@param[in]  buf         Frame
+@param[in]  dat_len     Frame length
+@return
+*/
+static void fz_rx_frm_cb(struct _frm_layer_ctx *frm_ctx, uint8_t *buf, uint8_t dat_len)
+{
+    int i;
+
+    fz_log("F%u:", dat_len);
+    for (i = 0; i < dat_len; i++)
+    {
+        fz_log("%02X", buf[i]);
+    }
+    fz_log(" ");
+}
+
+
+/**
+fz_rand - Get a random number
+@param[in,out]  seed    Random number generator state
+@param[in]      range   Upper bound, exclusive
+@return     Random number between 0 and range - 1
+*/
+static unsigned fz_rand(unsigned *seed, unsigned range)
+{
+    return (unsigned)rand_r(seed) % range;
+}
+
+
+/**
+fz_strm_gen - Generate a random stream of data frames, control bytes and garbage
+@param[out]     strm    Stream
+@param[in,out]  seed    Random number generator state
+@return
+*/
+static void fz_strm_gen(fz_strm_t *strm, unsigned *seed)
+{
+    static const uint8_t    ctl_byte[] = {ACK, NAK, CAN, SOF};
+    uint8_t                 *dat = strm->dat;
+    uint8_t                 chk;
+    int                     tmo_pct;
+    int                     len;
+    int                     i;
+
+    strm->len = 0;
+
+    while (strm->len < FZ_STRM_FILL)
+    {
+        dat = strm->dat + strm->len;
+        switch (fz_rand(seed, 10))
+        {
+            case 0: case 1: case 2: case 3:
+                //Data frame. Mostly valid, some with a bad length, type or checksum
+                len = 3 + fz_rand(seed, 12);
+                if (fz_rand(seed, 20) == 0)
+                    len = fz_rand(seed, 256);
+                if (strm->len + len + 2 > FZ_STRM_MAX)
+                    goto l_GEN_DONE;
+
+                dat[0] = SOF;
+                dat[1] = (uint8_t)len;
+                dat[2] = (fz_rand(seed, 3))? (uint8_t)fz_rand(seed, 2) : (uint8_t)rand_r(seed);
+                chk = 0xFF ^ dat[1] ^ dat[2];
+                for (i = 3; i < len + 1; i++)
+                {   //Payload, with some start of frame bytes in it
+                    dat[i] = (fz_rand(seed, 4))? (uint8_t)rand_r(seed) : ((fz_rand(seed, 2))? SOF : ACK);
+                    chk ^= dat[i];
+                }
+                dat[len + 1] = (fz_rand(seed, 8))? chk : (uint8_t)rand_r(seed);
+                strm->len += len + 2;
+                break;
+
+            case 4: case 5:
+                //Control byte
+                dat[0] = ctl_byte[fz_rand(seed, sizeof(ctl_byte))];
+                strm->len++;
+                break;
+
+            default:
+                //Garbage, often small values to hit the start bytes
+                len = fz_rand(seed, 6);
+                for (i = 0; i < len; i++)
+                {
+                    dat[i] = (fz_rand(seed, 3))? (uint8_t)rand_r(seed) : (uint8_t)fz_rand(seed, 4);
+                }
+                strm->len += len;
+                break;
+        }
+    }
+
+l_GEN_DONE:
+    //Receive timeouts in a quarter of the streams
+    memset(strm->tmo, 0, sizeof(strm->tmo));
+    tmo_pct = (fz_rand(seed, 4) == 0)? 2 : 0;
+    for (i = 0; i < strm->len; i++)
+    {
+        strm->tmo[i] = (fz_rand(seed, 100) < (unsigned)tmo_pct);
+    }
+}
+
+
+/**
+fz_ctx_init - Initialize a frame layer context for a receive path
+@param[out] frm_ctx     Context
+@return
+*/
+static void fz_ctx_init(frm_layer_ctx_t *frm_ctx)
+{
+    memset(frm_ctx, 0, sizeof(frm_layer_ctx_t));
+    frm_ctx->snd_frm_sts_cb = fz_snd_sts_cb;
+    frm_ctx->rx_frm_cb = fz_rx_frm_cb;
+}
+
+
+/**
+fz_run_byte - Run a stream through the byte by byte state-machine
+@param[in]  frm_ctx     Context
+@param[in]  strm        Stream
+@return
+*/
+static void fz_run_byte(frm_layer_ctx_t *frm_ctx, fz_strm_t *strm)
+{
+    int i;
+
+    for (i = 0; i < strm->len; i++)
+    {
+        if (strm->tmo[i])
+            frm_sta_machine(frm_ctx, EVENT_RECEIVE_TIMEOUT, 0);
+        frm_sta_machine(frm_ctx, EVENT_RECEIVED_DATA, strm->dat[i]);
+    }
+}
+
+
+/**
+fz_run_chunk - Run a stream through the chunk parser in random chunks
+@param[in]      frm_ctx     Context
+@param[in]      strm        Stream
+@param[in,out]  seed        Random number generator state
+@return
+*/
+static void fz_run_chunk(frm_layer_ctx_t *frm_ctx, fz_strm_t *strm, unsigned *seed)
+{
+    int pos = 0;
+    int len;
+    int i;
+
+    while (pos < strm->len)
+    {
+        if (strm->tmo[pos])
+            frm_sta_machine(frm_ctx, EVENT_RECEIVE_TIMEOUT, 0);
+
+        //Single bytes in a third of the chunks, the way a slow serial port delivers them
+        len = (fz_rand(seed, 3) == 0)? 1 : 1 + (int)fz_rand(seed, FZ_CHUNK_MAX);
+        if (len > strm->len - pos)
+            len = strm->len - pos;
+
+        //A timeout can only occur between chunks
+        for (i = pos + 1; i < pos + len; i++)
+        {
+            if (strm->tmo[i])
+            {
+                len = i - pos;
+                break;
+            }
+        }
+
+        frm_rx_chunk(frm_ctx, strm->dat + pos, (uint32_t)len);
+        pos += len;
+    }
+}
+
+
+/**
+fz_log_diff - Show where two logs differ
+@param[in]  byte_log    Log of the byte by byte state-machine
+@param[in]  chunk_log   Log of the chunk parser
+@return
+*/
+static void fz_log_diff(fz_log_t *byte_log, fz_log_t *chunk_log)
+{
+    int ofs = 0;
+    int start;
+
+    while ((ofs < byte_log->len) && (ofs < chunk_log->len) && (byte_log->buf[ofs] == chunk_log->buf[ofs]))
+        ofs++;
+
+    start = (ofs > 60)? ofs - 60 : 0;
+    printf("Logs differ at offset %d\n", ofs);
+    printf("  byte : ...%.160s\n", byte_log->buf + start);
+    printf("  chunk: ...%.160s\n", chunk_log->buf + start);
+}
+
+
+/**
+fz_usage - Show the command line options
+@param[in]  prog    Program name
+@return
+*/
+static void fz_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -n <count>   Number of random streams, default %d\n"
+           "  -S <seed>    Random seed, default is the current time\n"
+           "  -v           Show the statistics of each stream\n"
+           "  -h           Show this help\n",
+           prog, FZ_STREAMS_DEF);
+}
+
+
+int main(int argc, char **argv)
+{
+    static frm_layer_ctx_t  byte_ctx;
+    static frm_layer_ctx_t  chunk_ctx;
+    static fz_log_t         byte_log;
+    static fz_log_t         chunk_log;
+    static fz_strm_t        strm;
+    unsigned                seed = (unsigned)time(NULL);
+    unsigned                strm_seed;
+    unsigned long           rx_frm = 0;
+    unsigned long           resync = 0;
+    int                     strm_cnt = FZ_STREAMS_DEF;
+    int                     verbose = 0;
+    int                     opt;
+    int                     i;
+
+    while ((opt = getopt(argc, argv, "n:S:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': strm_cnt = atoi(optarg); break;
+            case 'S': seed = (unsigned)strtoul(optarg, NULL, 0); break;
+            case 'v': verbose = 1; break;
+            default:
+                fz_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if (strm_cnt <= 0)
+    {
+        fz_usage(argv[0]);
+        return 1;
+    }
+
+    printf("Fuzzing %d streams with seed %u\n", strm_cnt, seed);
+
+    for (i = 0; i < strm_cnt; i++)
+    {
+        //Each stream has its own seed, so that a failure can be reproduced
+        strm_seed = seed + (unsigned)i;
+        fz_strm_gen(&strm, &strm_seed);
+
+        fz_ctx_init(&byte_ctx);
+        byte_log.len = byte_log.ovf = 0;
+        fz_cur_log = &byte_log;
+        fz_run_byte(&byte_ctx, &strm);
+
+        fz_ctx_init(&chunk_ctx);
+        chunk_log.len = chunk_log.ovf = 0;
+        fz_cur_log = &chunk_log;
+        fz_run_chunk(&chunk_ctx, &strm, &strm_seed);
+
+        if (verbose)
+        {
+            printf("Stream %d: %d bytes, frames %u, checksum errors %u, ACK %u, NAK %u, resync %u\n",
+                   i, strm.len, byte_ctx.stat.rx_frm, byte_ctx.stat.chksm_err,
+                   byte_ctx.stat.ack_tx, byte_ctx.stat.nak_tx, byte_ctx.stat.resync);
+        }
+
+        if (byte_log.ovf || chunk_log.ovf)
+        {
+            printf("Stream %d (seed %u): event log overflow\n", i, seed + (unsigned)i);
+            return 1;
+        }
+
+        if ((byte_log.len != chunk_log.len) || memcmp(byte_log.buf, chunk_log.buf, byte_log.len))
+        {
+            printf("Stream %d (seed %u): frames, ACK/NAK or send status differ\n", i, seed + (unsigned)i);
+            fz_log_diff(&byte_log, &chunk_log);
+            return 1;
+        }
+
+        if (memcmp(&byte_ctx.stat, &chunk_ctx.stat, sizeof(frm_stat_t))
+            || (byte_ctx.sta_mach.frm_sta != chunk_ctx.sta_mach.frm_sta))
+        {
+            printf("Stream %d (seed %u): statistics or final state differ\n", i, seed + (unsigned)i);
+            printf("  byte : frames %u, checksum errors %u, ACK %u, NAK %u, resync %u, state %d\n",
+                   byte_ctx.stat.rx_frm, byte_ctx.stat.chksm_err, byte_ctx.stat.ack_tx,
+                   byte_ctx.stat.nak_tx, byte_ctx.stat.resync, (int)byte_ctx.sta_mach.frm_sta);
+            printf("  chunk: frames %u, checksum errors %u, ACK %u, NAK %u, resync %u, state %d\n",
+                   chunk_ctx.stat.rx_frm, chunk_ctx.stat.chksm_err, chunk_ctx.stat.ack_tx,
+                   chunk_ctx.stat.nak_tx, chunk_ctx.stat.resync, (int)chunk_ctx.sta_mach.frm_sta);
+            return 1;
+        }
+
+        rx_frm += byte_ctx.stat.rx_frm;
+        resync += byte_ctx.stat.resync;
+    }
+
+    printf("All %d streams matched: frames %lu, resynced bytes %lu\n", strm_cnt, rx_frm, resync);
+    return 0;
+}
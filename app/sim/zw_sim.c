@@ -0,0 +1,1757 @@
+/**
+@file   zw_sim.c - Z-wave virtual controller simulator.
+
+        Emulates a Z-wave Serial API controller and a network of virtual nodes,
+        so that the host library can be load-tested without Z-wave hardware.
+        The host attaches through a pseudo terminal, a Unix domain socket or a TCP port.
+
+@version    1.0 Initial release
+
+version: 1.0
+comments: Initial release
+*/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <poll.h>
+#include <time.h>
+#include <signal.h>
+#include <termios.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include "../../include/zwave/ZW_SerialAPI.h"
+#include "../../include/zwave/ZW_classcmd.h"
+
+///
+/// Serial API frame fields
+#define SIM_SOF                 0x01    ///< Start of frame
+#define SIM_ACK                 0x06    ///< Frame acknowledged
+#define SIM_NAK                 0x15    ///< Frame not acknowledged
+#define SIM_CAN                 0x18    ///< Frame cancelled
+#define SIM_REQ                 0x00    ///< Request frame type
+#define SIM_RES                 0x01    ///< Response frame type
+
+///
+/// Serial API timing
+#define SIM_ACK_TMOUT           1600    ///< Time to wait for the host to acknowledge a frame in milliseconds
+#define SIM_RX_TMOUT            1500    ///< Maximum time between two bytes of a frame in milliseconds
+#define SIM_MAX_RETX            3       ///< Maximum number of retransmissions of a frame
+
+///
+/// Virtual network
+#define SIM_CTLR_ID             1       ///< Node id of the simulated controller
+#define SIM_MAX_NODES           232     ///< Maximum node id
+#define SIM_AWAKE_TIME          10000   ///< Time a sleeping node stays awake after wake up notification in milliseconds
+#define SIM_FLIRS_BEAM          1000    ///< Extra transmit time to wake up a FLiRS node in milliseconds
+#define SIM_NO_ACK_FACTOR       3       ///< Multiple of the radio latency before a transmission is reported as failed
+#define SIM_TXQ_MAX             32      ///< Maximum size of the controller transmit queue
+
+///
+/// Transmit status and application update status
+#define SIM_TX_OK               0x00    ///< Transmit completed
+#define SIM_TX_NO_ACK           0x01    ///< No acknowledge from the destination node
+#define SIM_UPDT_NI_RECEIVED    0x84    ///< Node info received
+#define SIM_UPDT_NI_REQ_FAILED  0x81    ///< Request node info failed
+#define SIM_SUC_SET_SUCCEEDED   0x05    ///< Set SUC node id succeeded
+#define SIM_NB_UPDT_STARTED     0x21    ///< Neighbor update started
+#define SIM_NB_UPDT_DONE        0x22    ///< Neighbor update done
+#define SIM_FAILED_NODE_OK      0x00    ///< Node is working, not removed
+#define SIM_FAILED_NODE_RM      0x01    ///< Failed node removed
+
+///
+/// Node info protocol capabilities
+#define SIM_CAP_LISTENING       0x80    ///< Always listening node
+#define SIM_CAP_ROUTING         0x40    ///< Routing node
+#define SIM_SEC_FLIRS_1000      0x40    ///< Frequently listening node with 1000 ms wake up beam
+
+///
+/// Virtual node type
+typedef enum
+{
+    SIM_NODE_SWITCH,        ///< Always listening binary switch
+    SIM_NODE_SENSOR,        ///< Always listening multilevel sensor
+    SIM_NODE_FLIRS,         ///< Frequently listening binary switch (e.g. lock)
+    SIM_NODE_SLEEP          ///< Sleeping multilevel sensor that wakes up periodically
+} sim_node_typ_t;
+
+///
+/// Virtual node
+typedef struct
+{
+    uint8_t         present;        ///< Flag to indicate the node is in the network
+    sim_node_typ_t  typ;            ///< Node type
+    uint8_t         val;            ///< Binary switch or basic value
+    uint16_t        sensor;         ///< Sensor reading in 0.1 degree Celsius
+    uint32_t        wkup_intv;      ///< Wake up interval in seconds
+    uint64_t        awake_until;    ///< Monotonic time in milliseconds the sleeping node goes back to sleep
+
+} sim_node_t;
+
+///
+/// Serial API frame to the host
+typedef struct _sim_frm
+{
+    struct _sim_frm *next;          ///< Next frame in the transmit queue
+    uint16_t        len;            ///< Frame length including SOF and checksum
+    uint8_t         buf[260];       ///< Frame
+
+} sim_frm_t;
+
+///
+/// Scheduled event type
+typedef enum
+{
+    SIM_EVT_FRAME,          ///< Send a frame to the host
+    SIM_EVT_WAKEUP,         ///< Sleeping node wakes up
+    SIM_EVT_REPORT          ///< Node sends an unsolicited report
+} sim_evt_typ_t;
+
+///
+/// Scheduled event
+typedef struct
+{
+    uint64_t        due;            ///< Monotonic time in milliseconds the event is due
+    uint32_t        seq;            ///< Sequence number to keep events of the same due time in order
+    sim_evt_typ_t   typ;            ///< Event type
+    uint8_t         node_id;        ///< Node the event belongs to
+    sim_frm_t       *frm;           ///< Frame to send for SIM_EVT_FRAME
+
+} sim_evt_t;
+
+///
+/// Simulator context
+typedef struct
+{
+    //Configuration
+    int             node_cnt;       ///< Number of virtual nodes, excluding the controller
+    uint32_t        latency;        ///< Radio latency of each transmission in milliseconds
+    uint32_t        jitter;         ///< Maximum random extra radio latency in milliseconds
+    unsigned        loss_pct;       ///< Percentage of lost transmissions
+    unsigned        cb_loss_pct;    ///< Percentage of send data transmit complete callbacks not sent to the host
+    unsigned        sleep_pct;      ///< Percentage of sleeping nodes
+    unsigned        flirs_pct;      ///< Percentage of FLiRS nodes
+    uint32_t        wkup_sec;       ///< Default wake up interval of sleeping nodes in seconds
+    uint32_t        rpt_ms;         ///< Unsolicited report interval of listening nodes in milliseconds; 0 = disabled
+    unsigned        txq_len;        ///< Size of the controller transmit queue, transmitting one at a time; 0 = unlimited
+                                    ///< with concurrent transmissions
+    uint32_t        home_id;        ///< Home id
+    int             verbose;        ///< Flag to show the frames
+
+    //State
+    int             fd;             ///< Descriptor connected to the host
+    sim_node_t      node[SIM_MAX_NODES + 1];    ///< Virtual nodes indexed by node id
+    sim_evt_t       *evt;           ///< Scheduled events as a binary min-heap
+    unsigned        evt_cnt;        ///< Number of scheduled events
+    unsigned        evt_cap;        ///< Capacity of the event heap
+    uint32_t        evt_seq;        ///< Event sequence number generator
+    sim_frm_t       *tx_hd;         ///< Head of frames waiting to be sent to the host
+    sim_frm_t       *tx_tl;         ///< Tail of frames waiting to be sent to the host
+    int             wait_ack;       ///< Flag to indicate the head frame is waiting for ACK
+    uint64_t        ack_due;        ///< Time the ACK wait times out
+    int             retx;           ///< Number of retransmissions of the head frame
+    uint8_t         rx_buf[260];    ///< Frame being received from the host
+    unsigned        rx_len;         ///< Number of bytes received in rx_buf
+    uint64_t        rx_due;         ///< Time the frame being received times out
+    uint64_t        txq_done[SIM_TXQ_MAX];  ///< Completion time of the recent send data transmissions
+    unsigned        txq_idx;        ///< Index of txq_done to store the next completion time
+
+    //Statistics
+    unsigned long   rx_frm_cnt;     ///< Number of frames received from the host
+    unsigned long   tx_frm_cnt;     ///< Number of frames sent to the host
+    unsigned long   snd_data_cnt;   ///< Number of send data requests
+    unsigned long   lost_cnt;       ///< Number of lost transmissions
+    unsigned long   cb_lost_cnt;    ///< Number of send data transmit complete callbacks not sent
+    unsigned long   txq_full_cnt;   ///< Number of send data requests rejected because the transmit queue was full
+
+} sim_ctx_t;
+
+static volatile int sim_run = 1;
+
+
+/**
+sim_now - Get monotonic time
+@return     Monotonic time in milliseconds
+*/
+static uint64_t sim_now(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+
+/**
+sim_rand - Get a random number
+@param[in]	range	    The range
+@return     Random number from 0 to range - 1; zero if range is zero
+*/
+static uint32_t sim_rand(uint32_t range)
+{
+    return (range)? (uint32_t)(rand() % range) : 0;
+}
+
+
+/**
+sim_frm_new - Create a frame to the host
+@param[in]	typ	        Frame type SIM_REQ or SIM_RES
+@param[in]	func_id	    Function id
+@param[in]	dat	        Data
+@param[in]	dat_len     Data length
+@return     The frame; NULL on failure
+*/
+static sim_frm_t *sim_frm_new(uint8_t typ, uint8_t func_id, const uint8_t *dat, uint8_t dat_len)
+{
+    sim_frm_t   *frm;
+    uint8_t     chksum;
+    unsigned    i;
+
+    if (dat_len > 250)
+    {
+        return NULL;
+    }
+
+    frm = (sim_frm_t *)malloc(sizeof(sim_frm_t));
+    if (!frm)
+    {
+        return NULL;
+    }
+
+    //SOF | LEN | TYPE | FUNC_ID | DATA | CHECKSUM
+    frm->next = NULL;
+    frm->buf[0] = SIM_SOF;
+    frm->buf[1] = dat_len + 3;
+    frm->buf[2] = typ;
+    frm->buf[3] = func_id;
+    memcpy(frm->buf + 4, dat, dat_len);
+
+    chksum = 0xFF;
+    for (i = 1; i < (unsigned)dat_len + 4; i++)
+    {
+        chksum ^= frm->buf[i];
+    }
+    frm->buf[dat_len + 4] = chksum;
+    frm->len = dat_len + 5;
+
+    return frm;
+}
+
+
+/**
+sim_write - Write to the host
+@param[in]	sim	        Context
+@param[in]	buf	        Data
+@param[in]	len         Data length
+@return
+*/
+static void sim_write(sim_ctx_t *sim, const uint8_t *buf, size_t len)
+{
+    ssize_t written;
+
+    while (len > 0)
+    {
+        written = write(sim->fd, buf, len);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            sim_run = 0;
+            return;
+        }
+        buf += written;
+        len -= written;
+    }
+}
+
+
+/**
+sim_tx_kick - Send the head of the transmit queue if it is not waiting for ACK
+@param[in]	sim	        Context
+@return
+*/
+static void sim_tx_kick(sim_ctx_t *sim)
+{
+    if (sim->wait_ack || !sim->tx_hd)
+    {
+        return;
+    }
+
+    if (sim->verbose)
+    {
+        printf("sim -> %s %02X len %u\n", (sim->tx_hd->buf[2] == SIM_RES)? "RES" : "REQ",
+               sim->tx_hd->buf[3], (unsigned)sim->tx_hd->len);
+    }
+
+    sim_write(sim, sim->tx_hd->buf, sim->tx_hd->len);
+    sim->wait_ack = 1;
+    sim->ack_due = sim_now() + SIM_ACK_TMOUT;
+    sim->tx_frm_cnt++;
+}
+
+
+/**
+sim_tx_done - Remove the head of the transmit queue and send the next frame
+@param[in]	sim	        Context
+@return
+*/
+static void sim_tx_done(sim_ctx_t *sim)
+{
+    sim_frm_t   *frm = sim->tx_hd;
+
+    if (frm)
+    {
+        sim->tx_hd = frm->next;
+        if (!sim->tx_hd)
+        {
+            sim->tx_tl = NULL;
+        }
+        free(frm);
+    }
+    sim->wait_ack = 0;
+    sim->retx = 0;
+    sim_tx_kick(sim);
+}
+
+
+/**
+sim_tx_queue - Queue a frame to the host
+@param[in]	sim	        Context
+@param[in]	frm	        Frame
+@return
+*/
+static void sim_tx_queue(sim_ctx_t *sim, sim_frm_t *frm)
+{
+    if (!frm)
+    {
+        return;
+    }
+
+    if (sim->tx_tl)
+    {
+        sim->tx_tl->next = frm;
+    }
+    else
+    {
+        sim->tx_hd = frm;
+    }
+    sim->tx_tl = frm;
+
+    sim_tx_kick(sim);
+}
+
+
+/**
+sim_evt_add - Schedule an event
+@param[in]	sim	        Context
+@param[in]	delay	    Delay in milliseconds from now
+@param[in]	typ	        Event type
+@param[in]	node_id	    Node the event belongs to
+@param[in]	frm	        Frame to send for SIM_EVT_FRAME
+@return
+*/
+static void sim_evt_add(sim_ctx_t *sim, uint32_t delay, sim_evt_typ_t typ, uint8_t node_id, sim_frm_t *frm)
+{
+    sim_evt_t   evt;
+    sim_evt_t   *new_evt;
+    unsigned    i;
+    unsigned    parent;
+
+    if ((typ == SIM_EVT_FRAME) && !frm)
+    {
+        return;
+    }
+
+    if (sim->evt_cnt == sim->evt_cap)
+    {
+        new_evt = (sim_evt_t *)realloc(sim->evt, sizeof(sim_evt_t) * (sim->evt_cap * 2 + 64));
+        if (!new_evt)
+        {
+            free(frm);
+            return;
+        }
+        sim->evt = new_evt;
+        sim->evt_cap = sim->evt_cap * 2 + 64;
+    }
+
+    evt.due = sim_now() + delay;
+    evt.seq = sim->evt_seq++;
+    evt.typ = typ;
+    evt.node_id = node_id;
+    evt.frm = frm;
+
+    //Sift up
+    i = sim->evt_cnt++;
+    while (i > 0)
+    {
+        parent = (i - 1) / 2;
+        if ((sim->evt[parent].due < evt.due)
+            || ((sim->evt[parent].due == evt.due) && ((int32_t)(sim->evt[parent].seq - evt.seq) < 0)))
+        {
+            break;
+        }
+        sim->evt[i] = sim->evt[parent];
+        i = parent;
+    }
+    sim->evt[i] = evt;
+}
+
+
+/**
+sim_evt_get - Remove the earliest event
+@param[in]	sim	        Context
+@param[out]	evt	        The earliest event
+@return
+@pre        The event heap must not be empty
+*/
+static void sim_evt_get(sim_ctx_t *sim, sim_evt_t *evt)
+{
+    sim_evt_t   last;
+    unsigned    i;
+    unsigned    child;
+
+    *evt = sim->evt[0];
+    last = sim->evt[--sim->evt_cnt];
+
+    //Sift down
+    i = 0;
+    while ((child = i * 2 + 1) < sim->evt_cnt)
+    {
+        if ((child + 1 < sim->evt_cnt)
+            && ((sim->evt[child + 1].due < sim->evt[child].due)
+                || ((sim->evt[child + 1].due == sim->evt[child].due)
+                    && ((int32_t)(sim->evt[child + 1].seq - sim->evt[child].seq) < 0))))
+        {
+            child++;
+        }
+        if ((last.due < sim->evt[child].due)
+            || ((last.due == sim->evt[child].due) && ((int32_t)(last.seq - sim->evt[child].seq) < 0)))
+        {
+            break;
+        }
+        sim->evt[i] = sim->evt[child];
+        i = child;
+    }
+    sim->evt[i] = last;
+}
+
+
+/**
+sim_res - Send a response to the host
+@param[in]	sim	        Context
+@param[in]	func_id	    Function id
+@param[in]	dat	        Data
+@param[in]	dat_len     Data length
+@return
+*/
+static void sim_res(sim_ctx_t *sim, uint8_t func_id, const uint8_t *dat, uint8_t dat_len)
+{
+    sim_tx_queue(sim, sim_frm_new(SIM_RES, func_id, dat, dat_len));
+}
+
+
+/**
+sim_req_later - Send a request (callback or unsolicited) to the host after a delay
+@param[in]	sim	        Context
+@param[in]	delay	    Delay in milliseconds
+@param[in]	func_id	    Function id
+@param[in]	dat	        Data
+@param[in]	dat_len     Data length
+@return
+*/
+static void sim_req_later(sim_ctx_t *sim, uint32_t delay, uint8_t func_id, const uint8_t *dat, uint8_t dat_len)
+{
+    sim_evt_add(sim, delay, SIM_EVT_FRAME, 0, sim_frm_new(SIM_REQ, func_id, dat, dat_len));
+}
+
+
+/**
+sim_cmd_later - Deliver a command from a virtual node to the host after a delay
+@param[in]	sim	        Context
+@param[in]	delay	    Delay in milliseconds
+@param[in]	src_node    Source node id
+@param[in]	cmd	        Command
+@param[in]	cmd_len     Command length
+@return
+*/
+static void sim_cmd_later(sim_ctx_t *sim, uint32_t delay, uint8_t src_node, const uint8_t *cmd, uint8_t cmd_len)
+{
+    uint8_t buf[256];
+
+    if (cmd_len > 240)
+    {
+        return;
+    }
+
+    //ZW->HOST: REQ | 0x04 | rxStatus | sourceNode | cmdLength | pCmd[ ]
+    buf[0] = 0;
+    buf[1] = src_node;
+    buf[2] = cmd_len;
+    memcpy(buf + 3, cmd, cmd_len);
+    sim_req_later(sim, delay, FUNC_ID_APPLICATION_COMMAND_HANDLER, buf, cmd_len + 3);
+}
+
+
+/**
+sim_radio_delay - Get the time of a transmission to a node
+@param[in]	sim	        Context
+@param[in]	node_id     Node id
+@return     Delay in milliseconds
+*/
+static uint32_t sim_radio_delay(sim_ctx_t *sim, uint8_t node_id)
+{
+    uint32_t    delay;
+
+    delay = sim->latency + sim_rand(sim->jitter + 1);
+    if (sim->node[node_id].typ == SIM_NODE_FLIRS)
+    {
+        delay += SIM_FLIRS_BEAM;
+    }
+    return delay;
+}
+
+
+/**
+sim_radio_lost - Determine whether a transmission is lost
+@param[in]	sim	        Context
+@return     Non-zero if lost
+*/
+static int sim_radio_lost(sim_ctx_t *sim)
+{
+    if (sim_rand(100) < sim->loss_pct)
+    {
+        sim->lost_cnt++;
+        return 1;
+    }
+    return 0;
+}
+
+
+/**
+sim_node_reachable - Determine whether a node can receive a transmission
+@param[in]	sim	        Context
+@param[in]	node_id     Node id
+@return     Non-zero if reachable
+*/
+static int sim_node_reachable(sim_ctx_t *sim, uint8_t node_id)
+{
+    sim_node_t  *node;
+
+    if ((node_id == 0) || (node_id > SIM_MAX_NODES) || (node_id == SIM_CTLR_ID))
+    {
+        return 0;
+    }
+
+    node = &sim->node[node_id];
+    if (!node->present)
+    {
+        return 0;
+    }
+
+    if ((node->typ == SIM_NODE_SLEEP) && (node->awake_until <= sim_now()))
+    {
+        return 0;
+    }
+    return 1;
+}
+
+
+/**
+sim_node_cls_get - Get the supported command classes of a node
+@param[in]	node        Node
+@param[out]	cls         Buffer of at least 8 bytes to store the command classes
+@return     Number of command classes
+*/
+static uint8_t sim_node_cls_get(sim_node_t *node, uint8_t *cls)
+{
+    uint8_t cnt = 0;
+
+    switch (node->typ)
+    {
+        case SIM_NODE_SWITCH:
+        case SIM_NODE_FLIRS:
+            cls[cnt++] = COMMAND_CLASS_SWITCH_BINARY;
+            break;
+
+        case SIM_NODE_SLEEP:
+            cls[cnt++] = COMMAND_CLASS_WAKE_UP;
+            cls[cnt++] = COMMAND_CLASS_SENSOR_MULTILEVEL;
+            break;
+
+        default:
+            cls[cnt++] = COMMAND_CLASS_SENSOR_MULTILEVEL;
+            break;
+    }
+    cls[cnt++] = COMMAND_CLASS_MANUFACTURER_SPECIFIC;
+    cls[cnt++] = COMMAND_CLASS_VERSION;
+
+    return cnt;
+}
+
+
+/**
+sim_node_info_get - Get the protocol info of a node
+@param[in]	sim	        Context
+@param[in]	node_id     Node id
+@param[out]	info        capability | security | reserved | basic | generic | specific
+@return
+*/
+static void sim_node_info_get(sim_ctx_t *sim, uint8_t node_id, uint8_t *info)
+{
+    sim_node_t  *node = &sim->node[node_id];
+
+    memset(info, 0, 6);
+
+    if (node_id == SIM_CTLR_ID)
+    {
+        info[0] = SIM_CAP_LISTENING | SIM_CAP_ROUTING | 0x13;
+        info[3] = BASIC_TYPE_STATIC_CONTROLLER;
+        info[4] = GENERIC_TYPE_STATIC_CONTROLLER;
+        info[5] = SPECIFIC_TYPE_PC_CONTROLLER;
+        return;
+    }
+
+    if (!node->present)
+    {
+        return;
+    }
+
+    info[0] = SIM_CAP_ROUTING | 0x13;
+    info[3] = BASIC_TYPE_ROUTING_SLAVE;
+
+    switch (node->typ)
+    {
+        case SIM_NODE_SWITCH:
+            info[0] |= SIM_CAP_LISTENING;
+            info[4] = GENERIC_TYPE_SWITCH_BINARY;
+            info[5] = SPECIFIC_TYPE_POWER_SWITCH_BINARY;
+            break;
+
+        case SIM_NODE_FLIRS:
+            info[1] = SIM_SEC_FLIRS_1000;
+            info[4] = GENERIC_TYPE_SWITCH_BINARY;
+            info[5] = SPECIFIC_TYPE_POWER_SWITCH_BINARY;
+            break;
+
+        case SIM_NODE_SENSOR:
+            info[0] |= SIM_CAP_LISTENING;
+            info[4] = GENERIC_TYPE_SENSOR_MULTILEVEL;
+            info[5] = SPECIFIC_TYPE_ROUTING_SENSOR_MULTILEVEL;
+            break;
+
+        case SIM_NODE_SLEEP:
+            info[3] = BASIC_TYPE_SLAVE;
+            info[4] = GENERIC_TYPE_SENSOR_MULTILEVEL;
+            info[5] = SPECIFIC_TYPE_ROUTING_SENSOR_MULTILEVEL;
+            break;
+    }
+}
+
+
+/**
+sim_node_rpt - Build the state report of a node
+@param[in]	sim	        Context
+@param[in]	node_id     Node id
+@param[out]	rpt         Buffer of at least 6 bytes to store the report
+@return     Report length
+*/
+static uint8_t sim_node_rpt(sim_ctx_t *sim, uint8_t node_id, uint8_t *rpt)
+{
+    sim_node_t  *node = &sim->node[node_id];
+
+    if ((node->typ == SIM_NODE_SENSOR) || (node->typ == SIM_NODE_SLEEP))
+    {
+        //Drift the reading between 15.0 and 30.0 degree Celsius
+        node->sensor = 150 + ((node->sensor - 150 + sim_rand(21) + 140) % 150);
+        rpt[0] = COMMAND_CLASS_SENSOR_MULTILEVEL;
+        rpt[1] = SENSOR_MULTILEVEL_REPORT;
+        rpt[2] = 0x01;      //Temperature
+        rpt[3] = 0x22;      //Precision 1, scale Celsius, size 2
+        rpt[4] = (uint8_t)(node->sensor >> 8);
+        rpt[5] = (uint8_t)(node->sensor & 0xFF);
+        return 6;
+    }
+
+    rpt[0] = COMMAND_CLASS_SWITCH_BINARY;
+    rpt[1] = SWITCH_BINARY_REPORT;
+    rpt[2] = node->val;
+    return 3;
+}
+
+
+/**
+sim_node_cmd - Process a command received by a virtual node and send its reply to the host
+@param[in]	sim	        Context
+@param[in]	node_id     Node id
+@param[in]	cmd	        Command
+@param[in]	cmd_len     Command length
+@param[in]	delay       Time in milliseconds the command arrives at the node
+@return
+*/
+static void sim_node_cmd(sim_ctx_t *sim, uint8_t node_id, const uint8_t *cmd, uint8_t cmd_len, uint32_t delay)
+{
+    sim_node_t  *node = &sim->node[node_id];
+    uint8_t     rpt[16];
+    uint8_t     cls[8];
+    uint8_t     cls_cnt;
+    uint8_t     rpt_len = 0;
+    uint8_t     i;
+
+    if (cmd_len < 2)
+    {
+        return;
+    }
+
+    cls_cnt = sim_node_cls_get(node, cls);
+
+    switch (cmd[0])
+    {
+        case COMMAND_CLASS_BASIC:
+        case COMMAND_CLASS_SWITCH_BINARY:
+            if ((cmd[1] == BASIC_SET) && (cmd_len >= 3))
+            {
+                node->val = cmd[2];
+            }
+            else if (cmd[1] == BASIC_GET)
+            {
+                rpt[0] = cmd[0];
+                rpt[1] = BASIC_REPORT;
+                rpt[2] = node->val;
+                rpt_len = 3;
+            }
+            break;
+
+        case COMMAND_CLASS_SENSOR_MULTILEVEL:
+            if (cmd[1] == SENSOR_MULTILEVEL_GET)
+            {
+                rpt_len = sim_node_rpt(sim, node_id, rpt);
+            }
+            else if (cmd[1] == SENSOR_MULTILEVEL_SUPPORTED_GET_SENSOR_V5)
+            {
+                rpt[0] = COMMAND_CLASS_SENSOR_MULTILEVEL;
+                rpt[1] = SENSOR_MULTILEVEL_SUPPORTED_SENSOR_REPORT_V5;
+                rpt[2] = 0x01;  //Temperature
+                rpt_len = 3;
+            }
+            break;
+
+        case COMMAND_CLASS_VERSION:
+            if (cmd[1] == VERSION_GET)
+            {
+                rpt[0] = COMMAND_CLASS_VERSION;
+                rpt[1] = VERSION_REPORT;
+                rpt[2] = 0x03;  //Library type: slave enhanced
+                rpt[3] = 4;     //Protocol version
+                rpt[4] = 5;
+                rpt[5] = 1;     //Application version
+                rpt[6] = 0;
+                rpt_len = 7;
+            }
+            else if ((cmd[1] == VERSION_COMMAND_CLASS_GET) && (cmd_len >= 3))
+            {
+                rpt[0] = COMMAND_CLASS_VERSION;
+                rpt[1] = VERSION_COMMAND_CLASS_REPORT;
+                rpt[2] = cmd[2];
+                rpt[3] = 0;
+                for (i = 0; i < cls_cnt; i++)
+                {
+                    if (cls[i] == cmd[2])
+                    {
+                        rpt[3] = 1;
+                    }
+                }
+                rpt_len = 4;
+            }
+            break;
+
+        case COMMAND_CLASS_MANUFACTURER_SPECIFIC:
+            if (cmd[1] == MANUFACTURER_SPECIFIC_GET)
+            {
+                rpt[0] = COMMAND_CLASS_MANUFACTURER_SPECIFIC;
+                rpt[1] = MANUFACTURER_SPECIFIC_REPORT;
+                rpt[2] = 0x00;  //Manufacturer id
+                rpt[3] = 0x00;
+                rpt[4] = 0x00;  //Product type
+                rpt[5] = (uint8_t)node->typ;
+                rpt[6] = 0x00;  //Product id
+                rpt[7] = node_id;
+                rpt_len = 8;
+            }
+            else if (cmd[1] == DEVICE_SPECIFIC_GET_V2)
+            {
+                rpt[0] = COMMAND_CLASS_MANUFACTURER_SPECIFIC;
+                rpt[1] = DEVICE_SPECIFIC_REPORT_V2;
+                rpt[2] = 0x01;          //Serial number
+                rpt[3] = (0x01 << 5) | 4; //Binary format, 4 bytes
+                rpt[4] = (uint8_t)(sim->home_id >> 8);
+                rpt[5] = (uint8_t)(sim->home_id & 0xFF);
+                rpt[6] = 0;
+                rpt[7] = node_id;
+                rpt_len = 8;
+            }
+            break;
+
+        case COMMAND_CLASS_WAKE_UP:
+            if ((cmd[1] == WAKE_UP_INTERVAL_SET) && (cmd_len >= 5))
+            {
+                node->wkup_intv = ((uint32_t)cmd[2] << 16) | ((uint32_t)cmd[3] << 8) | cmd[4];
+            }
+            else if (cmd[1] == WAKE_UP_INTERVAL_GET)
+            {
+                rpt[0] = COMMAND_CLASS_WAKE_UP;
+                rpt[1] = WAKE_UP_INTERVAL_REPORT;
+                rpt[2] = (uint8_t)(node->wkup_intv >> 16);
+                rpt[3] = (uint8_t)(node->wkup_intv >> 8);
+                rpt[4] = (uint8_t)(node->wkup_intv);
+                rpt[5] = SIM_CTLR_ID;
+                rpt_len = 6;
+            }
+            else if (cmd[1] == WAKE_UP_NO_MORE_INFORMATION)
+            {
+                node->awake_until = sim_now() + delay;
+            }
+            break;
+
+        default:
+            //Unsupported command class, no reply like a real device
+            break;
+    }
+
+    if (rpt_len && !sim_radio_lost(sim))
+    {
+        sim_cmd_later(sim, delay + sim_radio_delay(sim, node_id), node_id, rpt, rpt_len);
+    }
+}
+
+
+/**
+sim_txq_wait - Get the time a new transmission waits in the transmit queue
+@param[in]	sim	        Context
+@param[in]	now	        Current time
+@param[out]	wait	    Time to wait in milliseconds before the transmission starts
+@return     Non-zero if the transmission is accepted; zero if the transmit queue is full
+*/
+static int sim_txq_wait(sim_ctx_t *sim, uint64_t now, uint32_t *wait)
+{
+    uint64_t    last;
+    unsigned    pending = 0;
+    unsigned    i;
+
+    *wait = 0;
+    if (!sim->txq_len)
+    {
+        return 1;
+    }
+
+    for (i = 0; i < SIM_TXQ_MAX; i++)
+    {
+        if (sim->txq_done[i] > now)
+        {
+            pending++;
+        }
+    }
+    if (pending >= sim->txq_len)
+    {
+        return 0;
+    }
+
+    last = sim->txq_done[(sim->txq_idx + SIM_TXQ_MAX - 1) % SIM_TXQ_MAX];
+    if (last > now)
+    {
+        *wait = (uint32_t)(last - now);
+    }
+    return 1;
+}
+
+
+/**
+sim_send_data - Process send data request from the host
+@param[in]	sim	        Context
+@param[in]	dat	        nodeID | dataLength | pData[ ] | txOptions | funcID
+@param[in]	dat_len     Data length
+@return
+*/
+static void sim_send_data(sim_ctx_t *sim, const uint8_t *dat, uint8_t dat_len)
+{
+    uint8_t     node_id;
+    uint8_t     cmd_len;
+    uint8_t     func_id;
+    uint8_t     cb[4];
+    uint8_t     ret = 1;
+    uint32_t    delay;
+    uint32_t    wait;
+    uint64_t    now = sim_now();
+
+    if (!sim_txq_wait(sim, now, &wait))
+    {
+        ret = 0;
+        sim->txq_full_cnt++;
+    }
+
+    sim_res(sim, FUNC_ID_ZW_SEND_DATA, &ret, 1);
+
+    if (!ret || (dat_len < 4) || (dat_len < dat[1] + 4))
+    {
+        return;
+    }
+
+    sim->snd_data_cnt++;
+    node_id = dat[0];
+    cmd_len = dat[1];
+    func_id = dat[cmd_len + 3];
+
+    if (node_id == 0xFF)
+    {   //Broadcast is not acknowledged
+        delay = sim->latency;
+        cb[1] = SIM_TX_OK;
+    }
+    else
+    {
+        if (node_id > SIM_MAX_NODES)
+        {
+            node_id = 0;
+        }
+        delay = sim_radio_delay(sim, node_id);
+        if (sim_node_reachable(sim, node_id) && !sim_radio_lost(sim))
+        {
+            cb[1] = SIM_TX_OK;
+            sim_node_cmd(sim, node_id, dat + 2, cmd_len, wait + delay);
+        }
+        else
+        {
+            delay *= SIM_NO_ACK_FACTOR;
+            cb[1] = SIM_TX_NO_ACK;
+        }
+    }
+
+    if (sim->txq_len)
+    {   //The radio is busy until this transmission completes
+        sim->txq_done[sim->txq_idx] = now + wait + delay;
+        sim->txq_idx = (sim->txq_idx + 1) % SIM_TXQ_MAX;
+    }
+
+    if (func_id && (sim_rand(100) < sim->cb_loss_pct))
+    {   //The controller lost track of the transmission
+        sim->cb_lost_cnt++;
+    }
+    else if (func_id)
+    {   //ZW->HOST: REQ | 0x13 | funcID | txStatus | wTransmitTicks (10 ms units)
+        cb[0] = func_id;
+        cb[2] = (uint8_t)((delay / 10) >> 8);
+        cb[3] = (uint8_t)(delay / 10);
+        sim_req_later(sim, wait + delay, FUNC_ID_ZW_SEND_DATA, cb, 4);
+    }
+}
+
+
+/**
+sim_send_data_multi - Process send data multi request from the host
+@param[in]	sim	        Context
+@param[in]	dat	        numberNodes | pNodeIDList[ ] | dataLength | pData[ ] | txOptions | funcID
+@param[in]	dat_len     Data length
+@return
+*/
+static void sim_send_data_multi(sim_ctx_t *sim, const uint8_t *dat, uint8_t dat_len)
+{
+    uint8_t     node_cnt;
+    uint8_t     cmd_len;
+    uint8_t     cb[2];
+    uint8_t     ret = 1;
+    uint8_t     i;
+    uint32_t    wait;
+    uint64_t    now = sim_now();
+
+    if (!sim_txq_wait(sim, now, &wait))
+    {
+        ret = 0;
+        sim->txq_full_cnt++;
+    }
+
+    sim_res(sim, FUNC_ID_ZW_SEND_DATA_MULTI, &ret, 1);
+
+    if (!ret || (dat_len < 1))
+    {
+        return;
+    }
+
+    node_cnt = dat[0];
+    if (dat_len < node_cnt + 4)
+    {
+        return;
+    }
+    cmd_len = dat[node_cnt + 1];
+    if (dat_len < node_cnt + cmd_len + 4)
+    {
+        return;
+    }
+
+    sim->snd_data_cnt++;
+
+    //Multicast is not acknowledged, the nodes just process the command
+    for (i = 0; i < node_cnt; i++)
+    {
+        if (sim_node_reachable(sim, dat[1 + i]) && !sim_radio_lost(sim))
+        {
+            sim_node_cmd(sim, dat[1 + i], dat + node_cnt + 2, cmd_len, wait + sim->latency);
+        }
+    }
+
+    if (sim->txq_len)
+    {   //The radio is busy until the multicast frame is sent
+        sim->txq_done[sim->txq_idx] = now + wait + sim->latency;
+        sim->txq_idx = (sim->txq_idx + 1) % SIM_TXQ_MAX;
+    }
+
+    cb[0] = dat[node_cnt + cmd_len + 3];
+    cb[1] = SIM_TX_OK;
+    if (cb[0])
+    {
+        sim_req_later(sim, wait + sim->latency, FUNC_ID_ZW_SEND_DATA_MULTI, cb, 2);
+    }
+}
+
+
+/**
+sim_request_node_info - Process request node info from the host
+@param[in]	sim	        Context
+@param[in]	node_id     Node id
+@return
+*/
+static void sim_request_node_info(sim_ctx_t *sim, uint8_t node_id)
+{
+    uint8_t     buf[16];
+    uint8_t     info[6];
+    uint8_t     cls_cnt;
+    uint8_t     ret = 1;
+    uint32_t    delay;
+
+    sim_res(sim, FUNC_ID_ZW_REQUEST_NODE_INFO, &ret, 1);
+
+    delay = sim_radio_delay(sim, node_id);
+
+    if (!sim_node_reachable(sim, node_id) || sim_radio_lost(sim) || sim_radio_lost(sim))
+    {   //ZW->HOST: REQ | 0x49 | bStatus | bNodeID | bLen
+        buf[0] = SIM_UPDT_NI_REQ_FAILED;
+        buf[1] = 0;
+        buf[2] = 0;
+        sim_req_later(sim, delay * SIM_NO_ACK_FACTOR, FUNC_ID_ZW_APPLICATION_UPDATE, buf, 3);
+        return;
+    }
+
+    //ZW->HOST: REQ | 0x49 | bStatus | bNodeID | bLen | basic | generic | specific | commandclasses[ ]
+    sim_node_info_get(sim, node_id, info);
+    cls_cnt = sim_node_cls_get(&sim->node[node_id], buf + 6);
+    buf[0] = SIM_UPDT_NI_RECEIVED;
+    buf[1] = node_id;
+    buf[2] = 3 + cls_cnt;
+    buf[3] = info[3];
+    buf[4] = info[4];
+    buf[5] = info[5];
+    sim_req_later(sim, delay + sim_radio_delay(sim, node_id), FUNC_ID_ZW_APPLICATION_UPDATE, buf, 6 + cls_cnt);
+}
+
+
+/**
+sim_host_frm - Process a frame from the host
+@param[in]	sim	        Context
+@param[in]	func_id	    Function id
+@param[in]	dat	        Data
+@param[in]	dat_len     Data length
+@return
+*/
+static void sim_host_frm(sim_ctx_t *sim, uint8_t func_id, const uint8_t *dat, uint8_t dat_len)
+{
+    uint8_t     buf[64];
+    uint8_t     func_cb;
+    int         i;
+
+    //The callback function id is the last byte of the request
+    func_cb = (dat_len > 0)? dat[dat_len - 1] : 0;
+
+    switch (func_id)
+    {
+        case FUNC_ID_SERIAL_API_GET_INIT_DATA:
+            //ZW->HOST: RES | 0x02 | ver | capabilities | 29 | nodes[29] | chip_type | chip_version
+            memset(buf, 0, sizeof(buf));
+            buf[0] = 5;
+            buf[1] = 0x08;      //SIS functionality
+            buf[2] = 29;
+            for (i = 1; i <= SIM_MAX_NODES; i++)
+            {
+                if ((i == SIM_CTLR_ID) || sim->node[i].present)
+                {
+                    buf[3 + ((i - 1) >> 3)] |= (1 << ((i - 1) & 7));
+                }
+            }
+            buf[32] = 5;
+            buf[33] = 0;
+            sim_res(sim, func_id, buf, 34);
+            break;
+
+        case FUNC_ID_SERIAL_API_GET_CAPABILITIES:
+            //ZW->HOST: RES | 0x07 | version | revision | manf id(2) | product type(2) | product id(2) | func id bitmask[32]
+            memset(buf, 0, sizeof(buf));
+            buf[0] = 1;
+            buf[5] = 0x01;
+            buf[7] = 0x01;
+            {
+                static const uint8_t supp_func[] =
+                {
+                    FUNC_ID_SERIAL_API_GET_INIT_DATA, FUNC_ID_SERIAL_API_APPL_NODE_INFORMATION,
+                    FUNC_ID_APPLICATION_COMMAND_HANDLER, FUNC_ID_ZW_GET_CONTROLLER_CAPABILITIES,
+                    FUNC_ID_SERIAL_API_GET_CAPABILITIES, FUNC_ID_SERIAL_API_SOFT_RESET,
+                    FUNC_ID_ZW_SET_RF_RECEIVE_MODE, FUNC_ID_ZW_SEND_NODE_INFORMATION, FUNC_ID_ZW_SEND_DATA,
+                    FUNC_ID_ZW_SEND_DATA_MULTI, FUNC_ID_ZW_GET_VERSION, FUNC_ID_ZW_SEND_DATA_ABORT,
+                    FUNC_ID_ZW_RF_POWER_LEVEL_SET, FUNC_ID_ZW_GET_RANDOM, FUNC_ID_MEMORY_GET_ID,
+                    FUNC_ID_MEMORY_GET_BUFFER, FUNC_ID_MEMORY_PUT_BUFFER, FUNC_ID_ZW_GET_NODE_PROTOCOL_INFO,
+                    FUNC_ID_ZW_SET_DEFAULT, FUNC_ID_ZW_ASSIGN_RETURN_ROUTE, FUNC_ID_ZW_DELETE_RETURN_ROUTE,
+                    FUNC_ID_ZW_REQUEST_NODE_NEIGHBOR_UPDATE, FUNC_ID_ZW_APPLICATION_UPDATE,
+                    FUNC_ID_ZW_ENABLE_SUC, FUNC_ID_ZW_REQUEST_NETWORK_UPDATE, FUNC_ID_ZW_SET_SUC_NODE_ID,
+                    FUNC_ID_ZW_SEND_SUC_ID, FUNC_ID_ZW_ASSIGN_SUC_RETURN_ROUTE, FUNC_ID_ZW_DELETE_SUC_RETURN_ROUTE,
+                    FUNC_ID_ZW_GET_SUC_NODE_ID, FUNC_ID_ZW_REQUEST_NODE_INFO, FUNC_ID_ZW_REMOVE_FAILED_NODE_ID,
+                    FUNC_ID_ZW_IS_FAILED_NODE_ID, FUNC_ID_ZW_RF_POWER_LEVEL_GET, FUNC_ID_ZW_SEND_TEST_FRAME
+                };
+                for (i = 0; i < (int)sizeof(supp_func); i++)
+                {
+                    buf[8 + ((supp_func[i] - 1) >> 3)] |= (1 << ((supp_func[i] - 1) & 7));
+                }
+            }
+            sim_res(sim, func_id, buf, 40);
+            break;
+
+        case FUNC_ID_MEMORY_GET_ID:
+            //ZW->HOST: RES | 0x20 | HomeId(4 bytes) | NodeId
+            buf[0] = (uint8_t)(sim->home_id >> 24);
+            buf[1] = (uint8_t)(sim->home_id >> 16);
+            buf[2] = (uint8_t)(sim->home_id >> 8);
+            buf[3] = (uint8_t)(sim->home_id);
+            buf[4] = SIM_CTLR_ID;
+            sim_res(sim, func_id, buf, 5);
+            break;
+
+        case FUNC_ID_ZW_GET_VERSION:
+            //ZW->HOST: RES | 0x15 | buffer (12 bytes) | library type
+            memset(buf, 0, 13);
+            strcpy((char *)buf, "Z-Wave 4.05");
+            buf[12] = 0x01;     //Static controller
+            sim_res(sim, func_id, buf, 13);
+            break;
+
+        case FUNC_ID_ZW_GET_CONTROLLER_CAPABILITIES:
+            //SIS present, real primary, SUC
+            buf[0] = 0x04 | 0x08 | 0x10;
+            sim_res(sim, func_id, buf, 1);
+            break;
+
+        case FUNC_ID_ZW_GET_SUC_NODE_ID:
+            buf[0] = SIM_CTLR_ID;
+            sim_res(sim, func_id, buf, 1);
+            break;
+
+        case FUNC_ID_ZW_GET_NODE_PROTOCOL_INFO:
+            sim_node_info_get(sim, (dat_len > 0 && dat[0] <= SIM_MAX_NODES)? dat[0] : 0, buf);
+            sim_res(sim, func_id, buf, 6);
+            break;
+
+        case FUNC_ID_MEMORY_GET_BUFFER:
+            //HOST->ZW: REQ | 0x23 | offset(2 bytes) | length
+            i = (dat_len >= 3 && dat[2] <= sizeof(buf))? dat[2] : 0;
+            memset(buf, 0, sizeof(buf));
+            sim_res(sim, func_id, buf, (uint8_t)i);
+            break;
+
+        case FUNC_ID_ZW_GET_RANDOM:
+            i = (dat_len >= 1 && dat[0] <= 32)? dat[0] : 2;
+            buf[0] = 1;
+            buf[1] = (uint8_t)i;
+            while (i-- > 0)
+            {
+                buf[2 + i] = (uint8_t)sim_rand(256);
+            }
+            sim_res(sim, func_id, buf, 2 + buf[1]);
+            break;
+
+        case FUNC_ID_ZW_IS_FAILED_NODE_ID:
+            buf[0] = (dat_len >= 1 && sim_node_reachable(sim, dat[0]))? 0 : 1;
+            sim_res(sim, func_id, buf, 1);
+            break;
+
+        case FUNC_ID_ZW_REMOVE_FAILED_NODE_ID:
+            //ZW->HOST: RES | 0x61 | retVal, then REQ | 0x61 | funcID | txStatus
+            buf[0] = 0;
+            sim_res(sim, func_id, buf, 1);
+            buf[0] = func_cb;
+            buf[1] = SIM_FAILED_NODE_OK;
+            if ((dat_len >= 1) && (dat[0] <= SIM_MAX_NODES) && (dat[0] != SIM_CTLR_ID)
+                && sim->node[dat[0]].present && !sim_node_reachable(sim, dat[0]))
+            {
+                sim->node[dat[0]].present = 0;
+                buf[1] = SIM_FAILED_NODE_RM;
+            }
+            sim_req_later(sim, sim->latency, func_id, buf, 2);
+            break;
+
+        case FUNC_ID_ZW_SEND_DATA:
+            sim_send_data(sim, dat, dat_len);
+            break;
+
+        case FUNC_ID_ZW_SEND_DATA_MULTI:
+            sim_send_data_multi(sim, dat, dat_len);
+            break;
+
+        case FUNC_ID_ZW_REQUEST_NODE_INFO:
+            sim_request_node_info(sim, (dat_len > 0)? dat[0] : 0);
+            break;
+
+        case FUNC_ID_ZW_SET_RF_RECEIVE_MODE:
+        case FUNC_ID_ZW_ENABLE_SUC:
+        case FUNC_ID_ZW_RF_POWER_LEVEL_SET:
+            buf[0] = 1;
+            sim_res(sim, func_id, buf, 1);
+            break;
+
+        case FUNC_ID_ZW_RF_POWER_LEVEL_GET:
+            buf[0] = 0;     //Normal power
+            sim_res(sim, func_id, buf, 1);
+            break;
+
+        case FUNC_ID_ZW_ASSIGN_RETURN_ROUTE:
+        case FUNC_ID_ZW_DELETE_RETURN_ROUTE:
+        case FUNC_ID_ZW_ASSIGN_SUC_RETURN_ROUTE:
+        case FUNC_ID_ZW_DELETE_SUC_RETURN_ROUTE:
+        case FUNC_ID_ZW_SEND_SUC_ID:
+        case FUNC_ID_ZW_SEND_NODE_INFORMATION:
+        case FUNC_ID_ZW_SEND_TEST_FRAME:
+        case FUNC_ID_ZW_REQUEST_NETWORK_UPDATE:
+        case FUNC_ID_ZW_SET_SUC_NODE_ID:
+            //ZW->HOST: RES | func | retVal, then REQ | func | funcID | status
+            buf[0] = 1;
+            sim_res(sim, func_id, buf, 1);
+            buf[0] = func_cb;
+            buf[1] = (func_id == FUNC_ID_ZW_SET_SUC_NODE_ID)? SIM_SUC_SET_SUCCEEDED : SIM_TX_OK;
+            if (func_cb)
+            {
+                sim_req_later(sim, sim->latency, func_id, buf, 2);
+            }
+            break;
+
+        case FUNC_ID_MEMORY_PUT_BUFFER:
+            buf[0] = 1;
+            sim_res(sim, func_id, buf, 1);
+            if (func_cb)
+            {
+                sim_req_later(sim, 1, func_id, &func_cb, 1);
+            }
+            break;
+
+        case FUNC_ID_ZW_REQUEST_NODE_NEIGHBOR_UPDATE:
+            buf[0] = func_cb;
+            buf[1] = SIM_NB_UPDT_STARTED;
+            sim_req_later(sim, 1, func_id, buf, 2);
+            buf[1] = SIM_NB_UPDT_DONE;
+            sim_req_later(sim, sim->latency * 4, func_id, buf, 2);
+            break;
+
+        case FUNC_ID_ZW_SET_DEFAULT:
+            sim_req_later(sim, 1, func_id, &func_cb, 1);
+            break;
+
+        case FUNC_ID_SERIAL_API_APPL_NODE_INFORMATION:
+        case FUNC_ID_ZW_SEND_DATA_ABORT:
+        case FUNC_ID_SERIAL_API_SOFT_RESET:
+            //No response
+            break;
+
+        default:
+            if (sim->verbose)
+            {
+                printf("sim: unsupported function id %02X\n", func_id);
+            }
+            break;
+    }
+}
+
+
+/**
+sim_rx - Process the bytes received from the host
+@param[in]	sim	        Context
+@param[in]	buf	        Data
+@param[in]	len         Data length
+@return
+*/
+static void sim_rx(sim_ctx_t *sim, const uint8_t *buf, size_t len)
+{
+    uint8_t     chksum;
+    uint8_t     ack;
+    unsigned    i;
+
+    while (len-- > 0)
+    {
+        uint8_t data = *buf++;
+
+        if (sim->rx_len == 0)
+        {
+            switch (data)
+            {
+                case SIM_SOF:
+                    sim->rx_buf[sim->rx_len++] = data;
+                    sim->rx_due = sim_now() + SIM_RX_TMOUT;
+                    break;
+
+                case SIM_ACK:
+                    if (sim->wait_ack)
+                    {
+                        sim_tx_done(sim);
+                    }
+                    break;
+
+                case SIM_NAK:
+                case SIM_CAN:
+                    if (sim->wait_ack)
+                    {   //Resend after a short delay
+                        sim->ack_due = sim_now() + 100;
+                    }
+                    break;
+
+                default:
+                    break;
+            }
+            continue;
+        }
+
+        sim->rx_buf[sim->rx_len++] = data;
+
+        if (sim->rx_len == 2 && data < 3)
+        {   //Invalid length
+            sim->rx_len = 0;
+            continue;
+        }
+
+        if ((sim->rx_len < 2) || (sim->rx_len < (unsigned)sim->rx_buf[1] + 2))
+        {
+            continue;
+        }
+
+        //Complete frame: SOF | LEN | TYPE | FUNC_ID | DATA | CHECKSUM
+        chksum = 0xFF;
+        for (i = 1; i < sim->rx_len - 1; i++)
+        {
+            chksum ^= sim->rx_buf[i];
+        }
+
+        ack = (chksum == sim->rx_buf[sim->rx_len - 1])? SIM_ACK : SIM_NAK;
+        sim_write(sim, &ack, 1);
+
+        if (ack == SIM_ACK)
+        {
+            sim->rx_frm_cnt++;
+            if (sim->verbose)
+            {
+                printf("host -> %s %02X len %u\n", (sim->rx_buf[2] == SIM_RES)? "RES" : "REQ",
+                       sim->rx_buf[3], sim->rx_len);
+            }
+            if (sim->rx_buf[2] == SIM_REQ)
+            {
+                sim_host_frm(sim, sim->rx_buf[3], sim->rx_buf + 4, sim->rx_buf[1] - 3);
+            }
+        }
+        sim->rx_len = 0;
+    }
+}
+
+
+/**
+sim_evt_run - Run a due event
+@param[in]	sim	        Context
+@param[in]	evt	        Event
+@return
+*/
+static void sim_evt_run(sim_ctx_t *sim, sim_evt_t *evt)
+{
+    sim_node_t  *node = &sim->node[evt->node_id];
+    uint8_t     cmd[8];
+    uint8_t     cmd_len;
+
+    switch (evt->typ)
+    {
+        case SIM_EVT_FRAME:
+            sim_tx_queue(sim, evt->frm);
+            break;
+
+        case SIM_EVT_WAKEUP:
+            if (!node->present)
+            {
+                break;
+            }
+            node->awake_until = sim_now() + SIM_AWAKE_TIME;
+            cmd[0] = COMMAND_CLASS_WAKE_UP;
+            cmd[1] = WAKE_UP_NOTIFICATION;
+            sim_cmd_later(sim, 0, evt->node_id, cmd, 2);
+            cmd_len = sim_node_rpt(sim, evt->node_id, cmd);
+            sim_cmd_later(sim, sim->latency, evt->node_id, cmd, cmd_len);
+            sim_evt_add(sim, (node->wkup_intv? node->wkup_intv : sim->wkup_sec) * 1000,
+                        SIM_EVT_WAKEUP, evt->node_id, NULL);
+            break;
+
+        case SIM_EVT_REPORT:
+            if (!node->present)
+            {
+                break;
+            }
+            if (!sim_radio_lost(sim))
+            {
+                cmd_len = sim_node_rpt(sim, evt->node_id, cmd);
+                sim_cmd_later(sim, 0, evt->node_id, cmd, cmd_len);
+            }
+            sim_evt_add(sim, sim->rpt_ms, SIM_EVT_REPORT, evt->node_id, NULL);
+            break;
+    }
+}
+
+
+/**
+sim_net_init - Create the virtual nodes
+@param[in]	sim	        Context
+@return
+*/
+static void sim_net_init(sim_ctx_t *sim)
+{
+    int         i;
+    unsigned    slot;
+    sim_node_t  *node;
+
+    for (i = 0; i < sim->node_cnt; i++)
+    {
+        node = &sim->node[SIM_CTLR_ID + 1 + i];
+        node->present = 1;
+        node->sensor = 200;
+        node->wkup_intv = sim->wkup_sec;
+
+        //Spread the node types evenly by percentage
+        slot = (unsigned)(i * 100 / sim->node_cnt);
+        if (slot < sim->sleep_pct)
+        {
+            node->typ = SIM_NODE_SLEEP;
+            sim_evt_add(sim, sim_rand(sim->wkup_sec * 1000 + 1), SIM_EVT_WAKEUP, SIM_CTLR_ID + 1 + i, NULL);
+            continue;
+        }
+        if (slot < sim->sleep_pct + sim->flirs_pct)
+        {
+            node->typ = SIM_NODE_FLIRS;
+        }
+        else
+        {
+            node->typ = (i & 1)? SIM_NODE_SENSOR : SIM_NODE_SWITCH;
+        }
+
+        if (sim->rpt_ms)
+        {
+            sim_evt_add(sim, sim_rand(sim->rpt_ms + 1), SIM_EVT_REPORT, SIM_CTLR_ID + 1 + i, NULL);
+        }
+    }
+}
+
+
+/**
+sim_loop - Serve the host until the connection is closed or the simulator is stopped
+@param[in]	sim	        Context
+@return
+*/
+static void sim_loop(sim_ctx_t *sim)
+{
+    struct pollfd   pfd;
+    sim_evt_t       evt;
+    uint8_t         buf[1024];
+    ssize_t         rd_len;
+    uint64_t        now;
+    uint64_t        next;
+    int             tmout;
+
+    pfd.fd = sim->fd;
+    pfd.events = POLLIN;
+
+    while (sim_run)
+    {
+        now = sim_now();
+
+        //Run the due events
+        while (sim->evt_cnt && (sim->evt[0].due <= now))
+        {
+            sim_evt_get(sim, &evt);
+            sim_evt_run(sim, &evt);
+        }
+
+        //Retransmit if ACK timeout
+        if (sim->wait_ack && (sim->ack_due <= now))
+        {
+            sim->wait_ack = 0;
+            if (++sim->retx > SIM_MAX_RETX)
+            {
+                sim_tx_done(sim);
+            }
+            else
+            {
+                sim_tx_kick(sim);
+            }
+        }
+
+        //Discard the partially received frame if timeout
+        if (sim->rx_len && (sim->rx_due <= now))
+        {
+            sim->rx_len = 0;
+        }
+
+        //Wait for the host or the next timer
+        next = now + 1000;
+        if (sim->evt_cnt && (sim->evt[0].due < next))
+        {
+            next = sim->evt[0].due;
+        }
+        if (sim->wait_ack && (sim->ack_due < next))
+        {
+            next = sim->ack_due;
+        }
+        if (sim->rx_len && (sim->rx_due < next))
+        {
+            next = sim->rx_due;
+        }
+        tmout = (next > now)? (int)(next - now) : 0;
+
+        if (poll(&pfd, 1, tmout) <= 0)
+        {
+            continue;
+        }
+
+        rd_len = read(sim->fd, buf, sizeof(buf));
+        if (rd_len > 0)
+        {
+            sim_rx(sim, buf, (size_t)rd_len);
+        }
+        else if ((rd_len == 0) || ((errno != EINTR) && (errno != EAGAIN)))
+        {   //Host has gone
+            break;
+        }
+    }
+}
+
+
+/**
+sim_pty_open - Create a pseudo terminal for the host to attach
+@return     Master side descriptor; negative on failure
+*/
+static int sim_pty_open(void)
+{
+    struct termios  term_setting;
+    int             fd;
+
+    fd = posix_openpt(O_RDWR | O_NOCTTY);
+    if ((fd < 0) || (grantpt(fd) != 0) || (unlockpt(fd) != 0))
+    {
+        perror("pty");
+        return -1;
+    }
+
+    if (tcgetattr(fd, &term_setting) == 0)
+    {
+        cfmakeraw(&term_setting);
+        tcsetattr(fd, TCSANOW, &term_setting);
+    }
+
+    printf("Serial port: %s\n", ptsname(fd));
+    fflush(stdout);
+    return fd;
+}
+
+
+/**
+sim_listen - Wait for the host to connect to a Unix domain socket or a TCP port
+@param[in]	path	    Unix domain socket path; NULL to use TCP
+@param[in]	port	    TCP port
+@return     Connected descriptor; negative on failure
+*/
+static int sim_listen(const char *path, int port)
+{
+    struct sockaddr_un  un_addr;
+    struct sockaddr_in  in_addr;
+    struct sockaddr     *addr;
+    socklen_t           addr_len;
+    int                 lsn_fd;
+    int                 fd;
+    int                 opt = 1;
+
+    if (path)
+    {
+        memset(&un_addr, 0, sizeof(un_addr));
+        un_addr.sun_family = AF_UNIX;
+        strncpy(un_addr.sun_path, path, sizeof(un_addr.sun_path) - 1);
+        unlink(path);
+        addr = (struct sockaddr *)&un_addr;
+        addr_len = sizeof(un_addr);
+        lsn_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    }
+    else
+    {
+        memset(&in_addr, 0, sizeof(in_addr));
+        in_addr.sin_family = AF_INET;
+        in_addr.sin_addr.s_addr = htonl(INADDR_ANY);
+        in_addr.sin_port = htons((uint16_t)port);
+        addr = (struct sockaddr *)&in_addr;
+        addr_len = sizeof(in_addr);
+        lsn_fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (lsn_fd >= 0)
+        {
+            setsockopt(lsn_fd, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+        }
+    }
+
+    if ((lsn_fd < 0) || (bind(lsn_fd, addr, addr_len) != 0) || (listen(lsn_fd, 1) != 0))
+    {
+        perror("listen");
+        return -1;
+    }
+
+    if (path)
+    {
+        printf("Serial port: unix:%s\n", path);
+    }
+    else
+    {
+        printf("Serial port: tcp:<host>:%d\n", port);
+    }
+    fflush(stdout);
+
+    fd = accept(lsn_fd, NULL, NULL);
+    close(lsn_fd);
+    if (path)
+    {
+        unlink(path);
+    }
+    return fd;
+}
+
+
+/**
+sim_stop - Signal handler to stop the simulator
+@param[in]	sig	        Signal
+@return
+*/
+static void sim_stop(int sig)
+{
+    (void)sig;
+    sim_run = 0;
+}
+
+
+/**
+sim_usage - Show the command line usage
+@param[in]	prog	    Program name
+@return
+*/
+static void sim_usage(const char *prog)
+{
+    printf("Usage: %s [options]\n"
+           "  -n <count>   number of virtual nodes, 0 to 231 (default 10)\n"
+           "  -l <ms>      radio latency of a transmission (default 20)\n"
+           "  -j <ms>      maximum random extra radio latency (default 10)\n"
+           "  -x <pct>     percentage of lost transmissions (default 0)\n"
+           "  -c <pct>     percentage of send data transmit complete callbacks not sent (default 0)\n"
+           "  -s <pct>     percentage of sleeping nodes (default 0)\n"
+           "  -f <pct>     percentage of FLiRS nodes (default 0)\n"
+           "  -w <sec>     wake up interval of sleeping nodes (default 60)\n"
+           "  -r <ms>      unsolicited report interval of each listening node, 0 = off (default 0)\n"
+           "  -q <count>   controller transmit queue size up to %d, sending one at a time; 0 = unlimited\n"
+           "               and concurrent (default 0)\n"
+           "  -H <hex>     home id (default C0FFEE01)\n"
+           "  -S <seed>    random seed (default time based)\n"
+           "  -u <path>    wait for the host on a Unix domain socket instead of a pseudo terminal\n"
+           "  -t <port>    wait for the host on a TCP port instead of a pseudo terminal\n"
+           "  -v           show the frames\n", prog, SIM_TXQ_MAX);
+}
+
+
+int main(int argc, char **argv)
+{
+    static sim_ctx_t    sim;
+    const char          *sock_path = NULL;
+    int                 tcp_port = 0;
+    unsigned            seed = (unsigned)time(NULL);
+    uint64_t            start;
+    int                 opt;
+
+    sim.node_cnt = 10;
+    sim.latency = 20;
+    sim.jitter = 10;
+    sim.wkup_sec = 60;
+    sim.home_id = 0xC0FFEE01;
+
+    while ((opt = getopt(argc, argv, "n:l:j:x:c:s:f:w:r:q:H:S:u:t:vh")) != -1)
+    {
+        switch (opt)
+        {
+            case 'n': sim.node_cnt = atoi(optarg); break;
+            case 'l': sim.latency = (uint32_t)atoi(optarg); break;
+            case 'j': sim.jitter = (uint32_t)atoi(optarg); break;
+            case 'x': sim.loss_pct = (unsigned)atoi(optarg); break;
+            case 'c': sim.cb_loss_pct = (unsigned)atoi(optarg); break;
+            case 's': sim.sleep_pct = (unsigned)atoi(optarg); break;
+            case 'f': sim.flirs_pct = (unsigned)atoi(optarg); break;
+            case 'w': sim.wkup_sec = (uint32_t)atoi(optarg); break;
+            case 'r': sim.rpt_ms = (uint32_t)atoi(optarg); break;
+            case 'q': sim.txq_len = (unsigned)atoi(optarg); break;
+            case 'H': sim.home_id = (uint32_t)strtoul(optarg, NULL, 16); break;
+            case 'S': seed = (unsigned)atoi(optarg); break;
+            case 'u': sock_path = optarg; break;
+            case 't': tcp_port = atoi(optarg); break;
+            case 'v': sim.verbose = 1; break;
+            default:
+                sim_usage(argv[0]);
+                return 1;
+        }
+    }
+
+    if ((sim.node_cnt < 0) || (sim.node_cnt > SIM_MAX_NODES - SIM_CTLR_ID)
+        || (sim.sleep_pct + sim.flirs_pct > 100) || (sim.wkup_sec == 0) || (sim.txq_len > SIM_TXQ_MAX))
+    {
+        sim_usage(argv[0]);
+        return 1;
+    }
+
+    srand(seed);
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGINT, sim_stop);
+    signal(SIGTERM, sim_stop);
+
+    if (sock_path || tcp_port)
+    {
+        sim.fd = sim_listen(sock_path, tcp_port);
+    }
+    else
+    {
+        sim.fd = sim_pty_open();
+    }
+
+    if (sim.fd < 0)
+    {
+        return 1;
+    }
+
+    start = sim_now();
+    sim_net_init(&sim);
+    sim_loop(&sim);
+
+    printf("Simulated %u s: frames received %lu, sent %lu, send data %lu, lost %lu, callbacks lost %lu, "
+           "transmit queue full %lu\n",
+           (unsigned)((sim_now() - start) / 1000), sim.rx_frm_cnt, sim.tx_frm_cnt,
+           sim.snd_data_cnt, sim.lost_cnt, sim.cb_lost_cnt, sim.txq_full_cnt);
+
+    close(sim.fd);
+    return 0;
+}
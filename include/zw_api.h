@@ -453,7 +453,9 @@ typedef struct
 {
 	int				    instance;	        /**< 0 for now */
 	void			    *user;		        /**< user specified information */
-	void			    *comm_port_name;    /**< pointer to platform-dependent serial comm port name */
+	void			    *comm_port_name;    /**< pointer to platform-dependent serial comm port name. On Linux, the
+                                                 "tcp:host:port", "unix:path" and "fd:n" forms connect to a serial
+                                                 bridge or use an opened file descriptor instead */
 	zwnet_notify_fn	    notify;		        /**< command status callback */
 	zwnet_node_fn	    node;		        /**< node add/del callback */
     zwnet_appl_fn       appl_tx;            /**< application transmit data status callback*/
@@ -465,6 +467,21 @@ typedef struct
     dev_spec_cfg_usr_t  *dev_spec_cfg_usr;  /**< Device specific configurations (managed by user application). If
                                                  it is NULL, device specific configurations will be managed by
                                                  HCAPI library internally. In this case dev_spec_cfg must be valid */
+    uint8_t             tmr_cb_thrd_cnt;    /**< number of threads to execute timer callbacks; zero for default */
+    uint8_t             evt_loop;           /**< non-zero to serve the serial port on the timer thread instead of
+                                                 dedicated read and write threads (Linux only). Only the serial
+                                                 port I/O moves; callbacks and received commands are still run
+                                                 on the threads set by cb_thrd_cnt */
+    const char          *cap_file;          /**< file to capture the serial port traffic to for offline replay with
+                                                 the "replay:file" comm port name; NULL = no capture (Linux only) */
+    uint8_t             cb_thrd_cnt;        /**< number of threads to dispatch the received commands; zero for one.
+                                                 Commands from the same node and the transmit completions of the
+                                                 commands sent to it are always handled in order; with
+                                                 more than one thread, commands from different nodes are handled
+                                                 concurrently and all the callbacks must be thread-safe */
+    uint8_t             snd_win;            /**< maximum number of send data transmissions waiting for their transmit
+                                                 completion status at the same time, up to APPL_SND_DAT_WIN_MAX; zero
+                                                 for one. Use more than one only with controllers that queue them */
 }
 zwnet_init_t, *zwnet_init_p;
 
@@ -623,6 +640,68 @@ get the home controller API version and subversion
 @return
 */
 
+int zwnet_mtx_prof_dump(zwnet_p net, int reset);
+/**<
+show the mutex contention statistics as a table through the print text function. Requires the library
+to be built with PLT_MTX_PROF defined.
+@param[in]	net		Network
+@param[in]	reset	Flag to clear the statistics after showing them
+@return		ZW_ERR_NONE on success; ZW_ERR_UNSUPPORTED if the profiler is not built in.
+*/
+
+int zwnet_frm_stat_get(zwnet_p net, frm_stat_t *stat, int reset);
+/**<
+get the serial frame statistics and the histogram of the time from writing a frame to receiving its
+ACK. Slow ACKs with few NAK/CAN point to the USB or serial link; fast ACKs with slow transmit
+callbacks point to the RF side
+@param[in]	net		Network
+@param[out]	stat	Frame statistics
+@param[in]	reset	Flag to clear the statistics after reading them
+@return		ZW_ERR_XXX
+*/
+
+int zwnet_snd_cls_set(int cls);
+/**<
+set the priority class of the commands sent to the controller by the calling thread. Commands from
+application threads default to APPL_SND_CLS_INTERACTIVE; commands from library threads, including
+the callbacks to the application, default to APPL_SND_CLS_CTRL. Use APPL_SND_CLS_BG for bulk
+operations that should not delay the others
+@param[in]	cls		APPL_SND_CLS_XXX
+@return		The previous class of the calling thread, to be restored after sending
+*/
+
+int zwnet_snd_stat_get(zwnet_p net, appl_snd_stat_t *stat, int reset);
+/**<
+get the number of commands sent, the number that timed out waiting and the histogram of the time
+waited for the controller, per priority class
+@param[in]	net		Network
+@param[out]	stat	Send statistics
+@param[in]	reset	Flag to clear the statistics after reading them
+@return		ZW_ERR_XXX
+*/
+
+int zwnet_node_lat_get(zwnet_p net, uint8_t nodeid, appl_node_lat_t *lat, int reset);
+/**<
+get the transmit completion latency distribution of a node and the timeout learned from it. A
+transmission to the node without callback within this timeout lets further send data start; it is
+reported as TRANSMIT_COMPLETE_NO_CB only after the callback timeout of the session layer
+@param[in]	net		Network
+@param[in]	nodeid	Node id
+@param[out]	lat		Latency of the node
+@param[in]	reset	Flag to clear the histogram, the highest latency and the timeout count after reading them
+@return		ZW_ERR_XXX
+*/
+
+int zwnet_cb_stat_get(zwnet_p net, ssn_cb_stat_t *stat, int reset);
+/**<
+get the queue depth and dispatch latency of each thread that dispatches the received commands. A high
+latency with a deep queue on one thread points to a slow callback or a chatty node sharing that thread
+@param[in]	net		Network
+@param[out]	stat	Dispatcher statistics
+@param[in]	reset	Flag to clear the statistics after reading them. The current queue depths are kept
+@return		ZW_ERR_XXX
+*/
+
 int zwnet_send_nif(zwnet_p net, zwnoded_p noded, uint8_t broadcast);
 /**<
 send node information frame to a node or broadcast it
@@ -1055,6 +1134,40 @@ execute action on an interface
 @return	ZW_ERR_XXX
 */
 
+/** delivery status of an interface in a multicast execution */
+typedef struct
+{
+    uint8_t     nodeid;     /**< Node ID */
+    uint8_t     epid;       /**< Endpoint ID */
+    uint8_t     mcast;      /**< Flag to indicate the node was addressed by the multicast frame */
+    uint8_t     tx_sts;     /**< Transmit status of the singlecast follow-up: TRANSMIT_COMPLETE_XXX. Valid if result is ZW_ERR_NONE */
+    int         result;     /**< ZW_ERR_NONE if the follow-up was sent; ZW_ERR_QUEUED if it was queued for a sleeping
+                                 node; else the error of sending the follow-up */
+} zwif_mcast_sts_t;
+
+typedef void (*zwif_mcast_fn)(void *user, zwif_mcast_sts_t *sts, int sts_cnt);
+/**<
+multicast execution completion callback
+@param[in]	user	    user parameter of zwif_exec_mcast
+@param[in]	sts		    delivery status of each interface, in the order of the interfaces passed to zwif_exec_mcast
+@param[in]	sts_cnt		number of entries in sts
+*/
+
+int zwif_exec_mcast(zwifd_p ifd, int ifd_cnt, uint8_t *cmd_buf, int buf_len, zwif_mcast_fn cb, void *user);
+/**<
+execute the same action on several interfaces, e.g. to switch a group of lights at once. The interfaces that
+can be reached without security, multi channel encapsulation or wakeup beam are sent one multicast frame so
+that they act at the same time; then every interface is sent the command in singlecast to confirm delivery.
+Returns after the follow-ups are handed to the controller; set zwnet_init_t.snd_win above 1 to pipeline them
+@param[in]	ifd         array of interfaces
+@param[in]	ifd_cnt     number of interfaces in ifd
+@param[in]	cmd_buf		command and parameters
+@param[in]	buf_len		length of cmd in bytes
+@param[in]	cb		    callback function when the follow-ups have completed, may be called before this function returns
+@param[in]	user	    user parameter of callback function
+@return	ZW_ERR_XXX. On ZW_ERR_NONE, cb is called once; the result of each interface is reported in its status
+*/
+
 void zwif_set_user(zwifd_p ifd, void *user);
 /**<
 set user specific information for interface
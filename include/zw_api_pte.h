@@ -34,13 +34,23 @@ typedef struct _zwobj
 {
 	struct _zwobj	*next;		/**< next object in list */
 	void			*ctx;		/**< user context (opaque to server) */
+	struct _zwobj	*free_next;	/**< next removed object waiting to be freed, see zwnet_rd_lck */
 }
 zwobj_t, *zwobj_p;
 
+/** Full memory barrier between the list writer and the lock-free readers */
+#ifdef WIN32
+#define zwobj_mb()      MemoryBarrier()
+#else
+#define zwobj_mb()      __sync_synchronize()
+#endif
 
 void zwobj_add(zwobj_p *head, zwobj_p obj);
-int32_t zwobj_del(zwobj_p *head, zwobj_p obj);
-int32_t zwobj_rplc(zwobj_p *head, zwobj_p obj, zwobj_p new_obj);
+int32_t zwobj_del(zwnet_p nw, zwobj_p *head, zwobj_p obj);
+int32_t zwobj_rplc(zwnet_p nw, zwobj_p *head, zwobj_p obj, zwobj_p new_obj);
+int zwnet_rd_lck(zwnet_p nw);
+void zwnet_rd_ulck(zwnet_p nw, int idx);
+void zwnet_obj_reclaim(zwnet_p nw, int force);
 
 /**
 @}
@@ -152,6 +162,29 @@ typedef struct
 mul_cmd_q_ent_t;
 
 
+/** Reference to an interface of a multicast execution, used as the user parameter of its follow-up */
+typedef struct
+{
+    struct _zwif_mcast  *mc;            /**< Multicast execution */
+    int                 idx;            /**< Index of the interface */
+}
+zwif_mcast_ref_t;
+
+
+/** Multicast execution of zwif_exec_mcast */
+typedef struct _zwif_mcast
+{
+    zwnet_p             net;            /**< Network */
+    zwif_mcast_fn       cb;             /**< Completion callback */
+    void                *user;          /**< User parameter of the completion callback */
+    int                 pending;        /**< Number of follow-ups waiting for transmit status, plus one held by the sender */
+    int                 sts_cnt;        /**< Number of entries in ref and sts */
+    zwif_mcast_ref_t    *ref;           /**< Reference to each interface */
+    zwif_mcast_sts_t    *sts;           /**< Delivery status of each interface */
+}
+zwif_mcast_t;
+
+
 /** Command queue extra handler parameter */
 typedef struct
 {
@@ -282,6 +315,8 @@ zwnode_t;
                               } while(0)
 
 zwnode_p zwnode_find(zwnode_p first_node, uint8_t nodeid);
+void zwnode_lst_add(zwnet_p nw, zwnode_p node);
+void zwnode_lst_del(zwnet_p nw, zwnode_p node);
 int zwnode_get_desc(zwnode_p node, zwnoded_p desc);
 void zwnode_rm(zwnet_p nw, uint8_t node_id);
 void zwnode_ep_rm_all(zwnode_p node);
@@ -671,6 +706,18 @@ struct _poll_ctx;
 #define CTLR_CAP_FLASH_PROG 0x0004   /**< Controller is capable to read/write flash */
 
 
+/**
+Lock ordering of the network context mutexes. A thread holding a mutex may only acquire the mutexes
+listed after it:
+    1. mtx            - node/endpoint/interface lists, node_tbl and the per node command queues.
+                        Recursive, may be re-acquired by the holder.
+                        Lookups may instead run in a zwnet_rd_lck read section, which takes no lock and
+                        may be entered with or without mtx held. The holder of mtx must not wait for
+                        a read section to end.
+    2. sec_ctx->sec_mtx, poll_ctx->poll_mtx
+    3. Application, session and transport layer mutexes (zw_send_data and friends may be called with mtx held).
+    4. cmd_q_mtx, nw_exec_mtx, cb_mtx, rst_mtx - request queue mutexes; nothing else is acquired while they are held.
+*/
 typedef struct _zwnet
 {
 	uint32_t	            homeid;         /**< Network Home ID */
@@ -678,6 +725,12 @@ typedef struct _zwnet
 	zwnet_init_t	        init;		    /**< client initialization parameters */
     appl_layer_ctx_t        appl_ctx;       /**< Z-wave HCI application layer context */
     void                    *mtx;           /**< Mutex to access zwnet_t structure*/
+    zwnode_p                node_tbl[ZW_MAX_NODES + 1]; /**< Nodes after the controller node indexed by node id.
+                                                             Maintained by zwnode_lst_add and zwnode_lst_del */
+    volatile uint32_t       rd_epoch;       /**< Grace period number of the lock-free readers, see zwnet_rd_lck */
+    volatile int32_t        rd_cnt[2];      /**< Number of lock-free readers in the even and odd grace periods */
+    zwobj_p                 rd_pend;        /**< Objects removed in the current grace period */
+    zwobj_p                 rd_wait;        /**< Objects removed in the previous grace period, freed when its readers are done */
     void                    *rst_mtx;       /**< Mutex for access reset done condition variable */
     void                    *rst_cv;        /**< Condition variable for reset done */
     volatile int            rst_cb_sts;     /**< Reset callback status. 0=callback not arrived yet; 1=reset done*/
@@ -717,17 +770,17 @@ typedef struct _zwnet
     asc_rpt_t               asc_rpt;        /**< Store association (group) report which is split into multiple reports*/
     void                    *cmd_q_sem;     /**< Semaphore for waiting requests to execute queued commands*/
     void                    *cmd_q_mtx;     /**< Mutex for command queue thread */
-    util_lst_t              *cmd_q_req_hd;  /**< Head of linked list for requests to execute queued commands*/
+    util_que_t              cmd_q_req_hd;   /**< Queue of requests to execute queued commands*/
     void                    *wait_q_sem;    /**< Semaphore for waiting requests to execute queued commands for nodes
                                                  that require wakeup beam*/
-    util_lst_t              *wait_q_req_hd; /**< Head of linked list for requests to execute queued commands for nodes
+    util_que_t              wait_q_req_hd;  /**< Queue of requests to execute queued commands for nodes
                                                  that require wakeup beam*/
     void                    *nw_exec_sem;   /**< Semaphore for waiting requests*/
     void                    *nw_exec_mtx;   /**< Mutex for requests to execute commands */
-    util_lst_t              *nw_exec_req_hd;/**< Head of linked list for requests to execute commands*/
+    util_que_t              nw_exec_req_hd; /**< Queue of requests to execute commands*/
     void                    *cb_sem;        /**< Semaphore for callback requests*/
     void                    *cb_mtx;        /**< Mutex for requests to execute callback */
-    util_lst_t              *cb_req_hd;     /**< Head of linked list for requests to execute callback*/
+    util_que_t              cb_req_hd;      /**< Queue of requests to execute callback*/
     volatile int            wait_q_thrd_run;/**< Control the command queue thread whether to run. 1 = run, 0 = stop*/
     volatile int            wait_q_thrd_sts;/**< Command queue thread status. 1 = run, 0 = thread exited*/
     volatile int            cmd_q_thrd_run; /**< Control the command queue thread whether to run. 1 = run, 0 = stop*/
@@ -1159,6 +1212,25 @@ typedef struct
 }
 appl_cmd_prm_t;
 
+/** Node information waiting for the controller queries before updating the network structure */
+typedef struct
+{
+    zwnet_p             nw;
+    uint8_t             sts;            //application update status UPDATE_STATE_XXX
+    appl_node_info_t    node_info;      //node information, cmd_cls points to cmd_cls_buf
+    uint16_t            cmd_cls_buf[1]; //place holder for the command classes
+}
+zwnet_ni_updt_t;
+
+/** Destination of a report waiting for the data from the controller */
+typedef struct
+{
+    zwnet_p     nw;
+    uint8_t     src_node;       //node to send the report to
+    uint8_t     msg_type;       //message type of the get command
+}
+zwnet_rpt_dst_t;
+
 /** Handling function for association CC and AGI CC (to support) */
 void handle_association(uint8_t cmd_len, uint8_t *cmd_buf, appl_cmd_prm_t *prm);
 
@@ -35,6 +35,30 @@ To provide network management and controller functions.
 #define APPL_CB_TMOUT_MIN        (SESSION_RESPONSE_TIMEOUT_MIN + 2000)  ///< Min. callback timeout from session layer
 #define APPL_WAIT_SEND_TIMEOUT      7000    ///< The maximum wait time for sending a command in milliseconds
 #define APPL_WAIT_SEND_MAX_RETRY    200     ///< The maximum retries for sending a command in unit of 10 milliseconds
+
+//Send classes. A waiting command of a lower class goes ahead of the ones of the higher classes
+//queued less than APPL_SND_AGE_MS times the class difference earlier
+#define APPL_SND_CLS_INTERACTIVE    0       ///< Send class of commands from application threads
+#define APPL_SND_CLS_CTRL           1       ///< Send class of commands from library threads, e.g. node interview
+#define APPL_SND_CLS_BG             2       ///< Send class of background commands, e.g. polling
+#define APPL_SND_CLS_CNT            3       ///< Number of send classes
+#define APPL_SND_AGE_MS             1000    ///< Maximum time in milliseconds a command waits for each class above it
+#define APPL_SND_DAT_WIN_MAX        8       ///< Maximum number of outstanding send data transmissions
+#define APPL_SND_DAT_GROW           8       ///< Number of times the current limit of successful transmit completions
+                                            ///< before the limit is raised by one
+#define APPL_SND_DAT_SLOT_CNT       (APPL_SND_DAT_WIN_MAX * 2)  ///< Number of send data slots. A slot is kept until its
+                                                                ///< transmit completion status is reported
+#define APPL_SND_MULTI_NODE_MAX     64      ///< Maximum number of destination nodes of a send data multi command
+#define APPL_NODE_TMOUT_MIN         1500    ///< Minimum send data timeout in milliseconds learned for a node. After this timeout
+                                            ///< the transmission stops holding the send data window; its callback is still
+                                            ///< waited for until cb_tmout_ms
+#define APPL_NODE_TMOUT_SMPL        8       ///< Number of transmit completion latencies of a node to collect before its
+                                            ///< timeout is derived from them instead of using cb_tmout_ms
+#define APPL_NODE_BACKOFF_MAX       3       ///< Maximum number of times the learned timeout of a node is doubled after
+                                            ///< consecutive callback timeouts
+#define APPL_SND_LAT_BKT_CNT        14      ///< Number of buckets of the send wait time histogram. Bucket n counts the waits
+                                            ///< of 2^n to 2^(n+1) - 1 milliseconds (bucket 0 also counts zero); the last
+                                            ///< bucket counts all longer ones
 #define TRANSMIT_COMPLETE_NO_CB     0x05    ///< Timeout waiting for callback frame
 #ifndef ZW_FAILED_NODE_REMOVE_STARTED
 #define ZW_FAILED_NODE_REMOVE_STARTED   0   ///< Status of  zw_remove_failed_node_id() call when the remove operation is started
@@ -137,6 +161,88 @@ typedef void (*set_deflt_cb_t)(struct _appl_layer_ctx *appl_ctx);
 /// Write to NVMEM completion callback function
 typedef void (*wr_cmplt_cb_t)(struct _appl_layer_ctx *appl_ctx, void *user_prm);
 
+///
+/// Is failed node completion callback function. res is non-zero if node_id is in the failed node ID list
+typedef void (*failed_node_cb_t)(struct _appl_layer_ctx *appl_ctx, int32_t result, uint8_t node_id, uint8_t res, void *user_prm);
+
+///
+/// Get node protocol info completion callback function. node_info is the node info frame of 6 bytes
+typedef void (*node_proto_cb_t)(struct _appl_layer_ctx *appl_ctx, int32_t result, uint8_t node_id, uint8_t *node_info, void *user_prm);
+
+///
+/// Read from NVMEM completion callback function
+typedef void (*rd_cmplt_cb_t)(struct _appl_layer_ctx *appl_ctx, int32_t result, uint8_t *buf, uint8_t len, void *user_prm);
+
+///
+/// Get random word completion callback function
+typedef void (*rand_cb_t)(struct _appl_layer_ctx *appl_ctx, int32_t result, uint8_t *buf, uint8_t count, void *user_prm);
+
+///
+/// Get initialization data completion callback function
+typedef void (*init_dat_cb_t)(struct _appl_layer_ctx *appl_ctx, int32_t result, appl_init_dat_t *init_data, void *user_prm);
+
+///
+/// Send statistics of a send class
+typedef struct
+{
+    uint32_t    grant;      ///< Number of commands allowed to send
+    uint32_t    tmout;      ///< Number of commands that timed out waiting to send
+    uint32_t    aged;       ///< Number of commands sent ahead of waiting commands of lower classes because of their age
+    uint32_t    lat_max;    ///< Longest wait time to send in milliseconds
+    uint32_t    lat_hist[APPL_SND_LAT_BKT_CNT]; ///< Histogram of the wait time to send, see APPL_SND_LAT_BKT_CNT
+} appl_snd_cls_stat_t;
+
+///
+/// Send statistics
+typedef struct
+{
+    appl_snd_cls_stat_t cls[APPL_SND_CLS_CNT];  ///< Statistics of each send class
+    uint32_t    tx_q_ovf;                       ///< Number of send data rejected by the controller transmit queue
+    uint32_t    snd_dat_max;                    ///< Highest number of outstanding send data transmissions
+} appl_snd_stat_t;
+
+///
+/// Send data transmit completion latency of a node. The latency is the time from the controller starting the
+/// transmission (its response, or the completion of the transmission queued before it) to the callback
+typedef struct
+{
+    uint32_t    srtt;           ///< Smoothed latency in 1/8 milliseconds
+    uint32_t    rttvar;         ///< Smoothed mean deviation of the latency in 1/4 milliseconds
+    uint32_t    cnt;            ///< Number of latencies collected
+    uint32_t    tmout;          ///< Number of transmissions without callback before the learned timeout
+    uint32_t    lat_max;        ///< Highest latency in milliseconds
+    uint32_t    lat_hist[APPL_SND_LAT_BKT_CNT]; ///< Histogram of the latencies, buckets as in APPL_SND_LAT_BKT_CNT
+    uint32_t    cb_tmout_ms;    ///< Timeout currently learned for the node in milliseconds (set by zwhci_node_lat_get)
+    uint8_t     backoff;        ///< Number of times the timeout is doubled after consecutive callback timeouts
+} appl_node_lat_t;
+
+///
+/// Outstanding send data transmission
+typedef struct
+{
+    struct _appl_layer_ctx  *appl_ctx;  ///< Context
+    tx_cmplt_cb_t   cb;                 ///< Transmit completion status callback function
+    void            *cb_prm;            ///< Transmit completion status callback user parameter
+    void            *tmr_ctx;           ///< Callback waiting timer context
+    uint64_t        tmout_ms;           ///< Time to release the window position, or to give up waiting for the callback
+                                        ///< once released (plt_mono_ms)
+    uint64_t        start_ms;           ///< Time the controller accepted the transmission (plt_mono_ms)
+    uint8_t         node_id;            ///< Destination node for the latency estimate; zero for multicast and broadcast
+    uint32_t        seq;                ///< Sequence number matching the callback to the slot; zero if the slot is free
+    uint8_t         pending;            ///< Flag to indicate the transmission is counted in snd_dat_cnt. Cleared after the
+                                        ///< learned timeout while the callback is still waited for
+} appl_snd_dat_t;
+
+///
+/// Thread waiting to send a command
+typedef struct _appl_snd_wait
+{
+    struct _appl_snd_wait   *next;  ///< Next waiting thread
+    uint64_t    start_ms;           ///< Time the thread started waiting (plt_mono_ms)
+    uint64_t    key;                ///< Scheduling order. Start time plus APPL_SND_AGE_MS per class
+    uint8_t     cls;                ///< Send class
+} appl_snd_wait_t;
+
 ///
 /// Z-wave HCI application layer context
 typedef struct _appl_layer_ctx
@@ -149,16 +255,31 @@ typedef struct _appl_layer_ctx
     void      *data;                ///< For high-level application layer to store data/context
     void      *snd_mtx;             ///< Mutex for sending command
     void      *snd_cv;              ///< Condition variable for sending command
-    tx_cmplt_cb_t send_data_cb;     ///< Send data transmit completion status callback function (used by timer callback only)
-    void      *snd_dat_cb_prm;      ///< Send data transmit completion status callback user parameter (used by timer callback only)
+    appl_snd_wait_t *snd_wait_hd;   ///< Threads waiting to send a command, in arrival order
+    appl_snd_stat_t snd_stat;       ///< Send statistics. Protected by snd_mtx
+    tx_cmplt_cb_t send_data_cb;     ///< Network management transmit completion status callback function (used by timer callback only)
+    void      *snd_dat_cb_prm;      ///< Network management transmit completion status callback user parameter (used by timer callback only)
     void      *cb_tmr_ctx;          ///< Callback waiting timer context
     uint32_t  cb_tmout_ms;          ///< Callback timeout from session layer in milliseconds
-    volatile int wait_cmd_cb;       ///< Flag to determine whether to wait for command callback in order
-                                    ///< for the next command to be sent.
+    appl_snd_dat_t snd_dat[APPL_SND_DAT_SLOT_CNT];  ///< Send data transmissions waiting for transmit completion status
+    uint32_t  snd_dat_seq;          ///< Last send data sequence number
+    uint8_t   snd_dat_win;          ///< Maximum number of outstanding send data transmissions; zero for one. Other commands
+                                    ///< are sent only when there is no outstanding send data transmission
+    uint8_t   snd_dat_lim;          ///< Current limit of outstanding send data transmissions, lowered when the controller
+                                    ///< transmit queue overflows and raised by one after APPL_SND_DAT_GROW * snd_dat_lim
+                                    ///< transmit completions
+    uint16_t  snd_dat_ok;           ///< Number of transmit completions since the limit was last changed
+    uint64_t  snd_dat_cmplt_ms;     ///< Time of the last send data transmit completion or callback timeout (plt_mono_ms)
+    appl_node_lat_t node_lat[ZW_MAX_NODES + 1]; ///< Send data transmit completion latency of each node. Protected by snd_mtx
+    uint8_t   snd_dat_cnt;          ///< Number of outstanding send data transmissions
+    volatile int snd_busy;          ///< Flag to indicate a send data is being sent without holding the snd_mtx
     volatile int wait_nm_cb;        ///< Flag to indicate whether to wait for network management command callback
                                     ///< in order for the next command to be sent.
     ssn_layer_ctx_t   ssn_ctx;      ///< Session layer context
     plt_ctx_t         *plt_ctx;     ///< Platform context
+    const char        *cap_file;    ///< File to capture the serial comm port traffic to; NULL = no capture (Linux only)
+    uint8_t           cb_wkr_cnt;   ///< Number of threads to execute the callbacks; zero for one. With more than one, the
+                                    ///< application command handler callbacks of different nodes run concurrently
 
 } appl_layer_ctx_t;
 
@@ -166,6 +287,8 @@ int32_t    zw_send_data_abort(appl_layer_ctx_t   *appl_ctx);
 int32_t    zw_get_node_protocol_info(appl_layer_ctx_t   *appl_ctx,
                                      uint8_t  node_id,
                                      uint8_t *node_info);
+int32_t    zw_get_node_protocol_info_async(appl_layer_ctx_t   *appl_ctx, uint8_t  node_id,
+                                           node_proto_cb_t cb, void *user_prm);
 int32_t    zw_controller_change(appl_layer_ctx_t   *appl_ctx, uint8_t  mode, add_node_nw_cb_t cb);
 int32_t    zw_create_new_primary_ctrl(appl_layer_ctx_t   *appl_ctx, uint8_t  mode, add_node_nw_cb_t cb);
 int32_t    zw_get_suc_node_id(appl_layer_ctx_t   *appl_ctx, uint8_t *suc_node_id);
@@ -177,6 +300,7 @@ int32_t    zw_assign_suc_return_route(appl_layer_ctx_t   *appl_ctx, uint8_t src_
 int32_t    zw_delete_suc_return_route(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, tx_cmplt_cb_t cb);
 int32_t    zw_request_node_neighbor_update(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, tx_cmplt_cb_t cb);
 int32_t    zw_is_failed_node(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, uint8_t *res);
+int32_t    zw_is_failed_node_async(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, failed_node_cb_t cb, void *user_prm);
 int32_t    zw_remove_failed_node_id(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, tx_cmplt_cb_t cb, uint8_t *resp_flg);
 int32_t    zw_replace_failed_node(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, tx_cmplt_cb_t cb, uint8_t *resp_flg);
 int32_t    zw_replication_send(appl_layer_ctx_t   *appl_ctx, appl_snd_data_t  *prm, tx_cmplt_cb_t cb);
@@ -188,21 +312,30 @@ int32_t    zw_request_node_info(appl_layer_ctx_t   *appl_ctx, uint8_t  node_id);
 int32_t    zw_set_default(appl_layer_ctx_t   *appl_ctx, set_deflt_cb_t cb);
 int32_t    zw_set_learn_mode(appl_layer_ctx_t   *appl_ctx, uint8_t  mode, set_lrn_mod_cb_t cb);
 int32_t    zw_serial_api_get_init_data(appl_layer_ctx_t   *appl_ctx, appl_init_dat_t  *init_data);
+int32_t    zw_serial_api_get_init_data_async(appl_layer_ctx_t   *appl_ctx, init_dat_cb_t cb, void *user_prm);
 int32_t    zw_serial_api_capabilities(appl_layer_ctx_t   *appl_ctx, appl_hci_cap_t  *cap);
 int32_t    zw_get_controller_capabilities(appl_layer_ctx_t   *appl_ctx, uint8_t *cap);
 int32_t    zw_memory_get_id(appl_layer_ctx_t   *appl_ctx, uint32_t  *home_id, uint8_t *node_id);
 int32_t    zw_memory_get_buffer(appl_layer_ctx_t   *appl_ctx, uint8_t  *buf, uint16_t ofs, uint8_t len);
+int32_t    zw_memory_get_buffer_async(appl_layer_ctx_t   *appl_ctx, uint16_t ofs, uint8_t len,
+                                      rd_cmplt_cb_t cb, void *user_prm);
 int32_t    zw_memory_put_buffer(appl_layer_ctx_t   *appl_ctx, uint8_t  *buf, uint16_t ofs,
                                 uint16_t len, wr_cmplt_cb_t cb, void *user_prm);
 int32_t    zw_remove_node_from_network(appl_layer_ctx_t   *appl_ctx, uint8_t  mode, add_node_nw_cb_t cb);
 int32_t    zw_add_node_to_network(appl_layer_ctx_t   *appl_ctx, uint8_t  mode, add_node_nw_cb_t cb);
 int32_t    zw_version(appl_layer_ctx_t   *appl_ctx, uint8_t  *lib_ver, uint8_t *lib_type);
 int32_t    zw_send_data(appl_layer_ctx_t   *appl_ctx, appl_snd_data_t  *prm, tx_cmplt_cb_t cb, void *cb_prm);
+int32_t    zw_send_data_multi(appl_layer_ctx_t   *appl_ctx, appl_snd_data_multi_t  *prm, tx_cmplt_cb_t cb, void *cb_prm);
 int32_t    application_node_info(appl_layer_ctx_t   *appl_ctx, appl_node_info_t *node_info, uint8_t dev_opt);
 int32_t    zwhci_init(appl_layer_ctx_t   *appl_ctx, void   *comm_port_id);
 void       zwhci_exit(appl_layer_ctx_t   *appl_ctx);
+uint8_t    zwhci_snd_cls_get(void);
+uint8_t    zwhci_snd_cls_set(uint8_t cls);
+void       zwhci_snd_stat_get(appl_layer_ctx_t   *appl_ctx, appl_snd_stat_t *stat, int reset);
+void       zwhci_node_lat_get(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, appl_node_lat_t *lat, int reset);
 int32_t    zw_set_rf_receive_mode(appl_layer_ctx_t   *appl_ctx, uint8_t mode);
 int32_t    zw_get_random_word(appl_layer_ctx_t   *appl_ctx, uint8_t *count, uint8_t *buf);
+int32_t    zw_get_random_word_async(appl_layer_ctx_t   *appl_ctx, uint8_t count, rand_cb_t cb, void *user_prm);
 int32_t    zw_send_node_info(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, uint8_t  tx_opt, tx_cmplt_cb_t cb);
 int32_t    zw_get_rf_powerlevel(appl_layer_ctx_t   *appl_ctx, uint8_t *pbyPowerLvl);
 int32_t    zw_set_rf_powerlevel(appl_layer_ctx_t   *appl_ctx, uint8_t byPowerLvl, uint8_t *pbyPowerLvlRet);
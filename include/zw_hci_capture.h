@@ -0,0 +1,90 @@
+/**
+@file   zw_hci_capture.h - Z-wave host controller interface serial traffic capture header file.
+
+        Record the bytes exchanged with the Z-wave controller to a trace file and
+        read the trace file back for offline replay.
+
+@author David Chow
+
+@version    1.0 17-10-26  Initial release
+
+version: 1.0
+comments: Initial release
+*/
+
+#ifndef _ZW_HCI_CAPTURE_DAVID_
+#define _ZW_HCI_CAPTURE_DAVID_
+
+#include <stdint.h>
+#include <stdio.h>
+#include "zw_hci_platform.h"
+
+/**
+@defgroup Capture Serial traffic capture and replay
+Record the bytes exchanged with the Z-wave controller and read them back.
+
+Trace file format (all multi-byte fields are little-endian):
+- File header of CAP_FILE_HDR_LEN bytes: the magic "ZWCP", version (1 byte) and 3 reserved bytes.
+  A capture appended to an existing trace file does not write another header.
+- Records, each made of a CAP_REC_HDR_LEN bytes header followed by the data:
+  time since the previous record in microseconds (4 bytes), record type (1 byte, see cap_rec_typ_t)
+  and data length (1 byte).
+@{
+*/
+
+#ifdef OS_LINUX
+
+#define CAP_FILE_MAGIC          "ZWCP"  ///< Trace file magic
+#define CAP_FILE_VER            1       ///< Trace file version
+#define CAP_FILE_HDR_LEN        8       ///< Length of the trace file header
+#define CAP_REC_HDR_LEN         6       ///< Length of the record header
+
+///
+/// Size of the ring buffer of each direction. Must be a power of 2
+#define CAP_RING_SZ             0x10000
+
+///
+/// Trace record type
+typedef enum
+{
+    CAP_REC_RX,         ///< Bytes received from the Z-wave controller
+    CAP_REC_TX,         ///< Bytes written to the Z-wave controller
+    CAP_REC_LOST        ///< Records lost because the ring buffer was full. Data is the number of records (4 bytes)
+
+} cap_rec_typ_t;
+
+///
+/// Trace record as read from the trace file
+typedef struct
+{
+    uint64_t        ts;             ///< Time since the first record in microseconds
+    uint8_t         typ;            ///< Record type, see cap_rec_typ_t
+    uint8_t         len;            ///< Data length
+    uint8_t         dat[255];       ///< Data
+
+} cap_rec_t;
+
+///
+/// Trace file reader
+typedef struct
+{
+    FILE            *fp;            ///< Trace file
+    uint64_t        ts;             ///< Time of the last record read in microseconds
+
+} cap_rd_t;
+
+int     cap_open(void **cap_ctx, plt_ctx_t *plt_ctx, const char *file);
+void    cap_add(void *cap_ctx, cap_rec_typ_t typ, const uint8_t *buf, size_t len);
+void    cap_close(void *cap_ctx);
+int     cap_rd_open(cap_rd_t *rd, const char *file);
+int     cap_rd_next(cap_rd_t *rd, cap_rec_t *rec);
+void    cap_rd_close(cap_rd_t *rd);
+
+#endif
+
+/**
+@}
+*/
+
+#endif /* _ZW_HCI_CAPTURE_DAVID_ */
+
@@ -39,6 +39,7 @@ comments: Initial release
 #define     ZWHCI_ERROR_READ                -118 ///< Read failed
 #define     ZWHCI_ERROR_TIMEOUT             -119 ///< Time out
 #define     ZWHCI_ERROR_VERIFY              -120 ///< Verification failed
+#define     SESSION_ERROR_EXIT              -121 ///< The session layer exited before the command completed
 
 // Initialization error code
 #define     INIT_ERROR_TRANSPORT        1   ///< Initialization error on transport layer
@@ -30,9 +30,19 @@ and handling of frame resend if required.
 #define FRAME_CHECKSUM_FIELD_LEN     1   ///< The length of the checksum field
 #define FRAME_LENGTH_FIELD_LEN       1   ///< The length of the length field
 
+///
+/// Headroom and tailroom to reserve in the buffers passed to frm_dat_buf_snd
+#define FRAME_BUF_HEADROOM           (TPT_BUF_HEADROOM + FRAME_TYPE_FIELD_LEN + FRAME_HEADER_LEN)
+#define FRAME_BUF_TAILROOM           FRAME_CHECKSUM_FIELD_LEN
+
 
 #define FRAME_MAX_RESEND             2   ///< The maximum number of frame resend
 
+///
+/// Number of buckets of the ACK round trip time histogram. Bucket n counts the round trips of
+/// 2^n to 2^(n+1) - 1 microseconds (bucket 0 also counts zero); the last bucket counts all longer ones
+#define FRAME_RTT_BKT_CNT            24
+
 // Offset of the field in the Serial API frame
 #define FRAME_FRAME_TYPE_OFFSET      0
 #define FRAME_LENGTH_OFFSET          1
@@ -44,7 +54,14 @@ and handling of frame resend if required.
 #define     FRAME_SEND_TIMEOUT_MIN      2000    ///< Minimum send frame time out value in milliseconds
 
 //resend frame delay value
-#define     FRAME_RESEND_DELAY          1000     ///< Resend frame delay in milliseconds
+#define     FRAME_RESEND_DELAY          1000     ///< Maximum resend frame delay after CAN in milliseconds
+
+//Adaptive send frame timeout
+#define     FRAME_RTO_MIN               1600    ///< Lower limit of the send frame timeout estimated from the ACK round trip time in milliseconds.
+                                                ///< This is the Serial API ACK timeout; resending earlier could make a slow
+                                                ///< controller execute the frame twice
+#define     FRAME_RTO_GRANULARITY       20      ///< Minimum allowance for the round trip time variation in milliseconds
+#define     FRAME_CAN_BACKOFF           50      ///< Base resend delay after CAN in milliseconds, doubled on each resend and randomized
 
 ///
 /// Z-wave Serial API frame type
@@ -105,6 +122,31 @@ typedef struct
     uint8_t     frm_sz;     ///< size of frame in the buffer
 } frm_t;
 
+///
+/// Z-wave HCI frame layer statistics
+typedef struct
+{
+    uint32_t    tx_frm;             ///< Number of data frames sent, excluding resends
+    uint32_t    tx_byte;            ///< Number of data frame bytes sent, including resends
+    uint32_t    rx_frm;             ///< Number of data frames received with valid checksum
+    uint32_t    rx_byte;            ///< Number of bytes received
+    uint32_t    ack_tx;             ///< Number of ACK sent
+    uint32_t    nak_tx;             ///< Number of NAK sent
+    uint32_t    ack_rx;             ///< Number of ACK received
+    uint32_t    nak_rx;             ///< Number of NAK received
+    uint32_t    can_rx;             ///< Number of CAN received
+    uint32_t    resend;             ///< Number of data frames resent
+    uint32_t    snd_tmout;          ///< Number of data frames that were not acknowledged in time
+    uint32_t    chksm_err;          ///< Number of data frames received with checksum error
+    uint32_t    resync;             ///< Number of times received bytes were discarded to look for the next frame
+    uint32_t    rtt_max;            ///< Longest ACK round trip time in microseconds
+    uint32_t    srtt;               ///< Smoothed ACK round trip time in microseconds; zero if there is no sample yet
+    uint32_t    rttvar;             ///< ACK round trip time variation in microseconds
+    uint32_t    rto;                ///< Send frame timeout of the first transmission in milliseconds
+    uint32_t    rtt_hist[FRAME_RTT_BKT_CNT];    ///< Histogram of the time from queuing a data frame for write
+                                                ///< to receiving its ACK, see FRAME_RTT_BKT_CNT
+} frm_stat_t;
+
 ///
 /// Z-wave HCI frame layer state-machine context
 typedef struct
@@ -134,14 +176,15 @@ typedef struct _frm_layer_ctx
     void      *sta_mach_mtx;    ///< mutex for state machine
     void      *snd_tmr_ctx;     ///< Send frame timer context
     void      *resnd_tmr_ctx;   ///< Resend frame timer context
-    uint8_t   *last_frm_buf;    ///< Buffer to store the last frame
-    uint8_t   last_frm_sz;      ///< The size of last frame
+    util_buf_t *last_frm;       ///< The last frame kept for resend
     uint8_t   resend_cnt;       ///< Number of resend of the last frame
-    uint32_t  snd_tmout_ms;     ///< Send frame timeout value in milliseconds
-#ifdef DEBUG_SERIAL_API
-    uint32_t  nak_cnt;          ///< Number of NAK received from the controller
-    uint32_t  can_cnt;          ///< Number of CAN received from the controller
-#endif
+    uint32_t  snd_tmout_ms;     ///< Send frame timeout value in milliseconds. Upper limit of the adaptive timeout
+    uint32_t  srtt;             ///< Smoothed ACK round trip time in microseconds; zero if there is no sample yet
+    uint32_t  rttvar;           ///< ACK round trip time variation in microseconds
+    uint32_t  rto_ms;           ///< Send frame timeout derived from srtt and rttvar in milliseconds
+    uint64_t  snd_ts;           ///< Time of the last data frame write request in microseconds
+    frm_stat_t stat;            ///< Statistics. The counters updated by the receive state-machine (rx_frm, rx_byte,
+                                ///< ack_tx, nak_tx, chksm_err, resync) are protected by sta_mach_mtx, the others by wr_mtx
     tpt_layer_ctx_t   tpt_ctx;  ///< Transport layer context
     plt_ctx_t                 *plt_ctx;      ///< Platform context
     struct _ssn_layer_ctx     *ssn_layer_ctx;///< Pointer to session layer context
@@ -151,6 +194,9 @@ typedef struct _frm_layer_ctx
 
 int32_t frm_dat_frm_snd(frm_layer_ctx_t   *frm_ctx, dat_frm_typ_t type,
                         uint8_t   cmd_id, uint8_t   *buf, uint8_t   dat_sz);
+int32_t frm_dat_buf_snd(frm_layer_ctx_t   *frm_ctx, dat_frm_typ_t type,
+                        uint8_t   cmd_id, util_buf_t *buf);
+void frm_stat_get(frm_layer_ctx_t   *frm_ctx, frm_stat_t *stat, int reset);
 int32_t frm_init(frm_layer_ctx_t   *frm_ctx);
 void frm_exit(frm_layer_ctx_t   *frm_ctx);
 
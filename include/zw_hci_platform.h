@@ -25,7 +25,34 @@ Some common functions in multi-platform environment.
 #ifdef OS_LINUX
 ///
 /// Platform timer resolution in milliseconds
-#define PLT_TIMER_RESOLUTION    100
+#define PLT_TIMER_RESOLUTION    1
+
+///
+/// Default number of threads to execute one-shot timer callbacks
+#define PLT_TMR_CB_THRD_DEFAULT 4
+
+///
+/// Maximum number of extra threads to execute one-shot timer callbacks when all the
+/// default threads are blocked
+#define PLT_TMR_CB_OVF_MAX      8
+
+///
+/// Uncomment to build the mutex contention profiler into the plt_mtx_xxx functions.
+/// The results are shown by plt_mtx_prof_dump
+//#define PLT_MTX_PROF
+
+#ifndef OS_MAC_X
+///
+/// Event loop mode is supported: the timer check thread can also serve the serial port I/O.
+/// This covers the transport read and write only; the frame and session layers are called from
+/// the transport callbacks, and the received commands are still dispatched on the session
+/// callback threads
+#define PLT_EVT_LOOP
+
+///
+/// Maximum number of file descriptors registered to the event loop
+#define PLT_EVT_MAX             4
+#endif
 #endif
 
 #ifdef WIN32
@@ -34,6 +61,14 @@ Some common functions in multi-platform environment.
 #define USE_SAFE_VERSION
 #endif
 
+///
+/// Thread local storage class
+#if defined(_WINDOWS) || defined(WIN32)
+#define PLT_THRD_LOCAL  __declspec(thread)
+#else
+#define PLT_THRD_LOCAL  __thread
+#endif
+
 ///
 /// Maximum message length for displaying message
 #define MAX_PLT_MSG_LEN     256
@@ -56,21 +91,46 @@ typedef struct
 {
     print_fn          print_txt;      ///< Print text function
     int                 init_done;      ///< Counter to indicated how many times platform initialization has been invoked
+    int                 evt_loop;       ///< Event loop mode flag. Not supported, ignored
 } plt_ctx_t;
 
 #elif defined(OS_LINUX)
+#ifdef PLT_EVT_LOOP
+///
+/// Event loop callback when a registered file descriptor is readable
+typedef void    (*plt_evt_cb_t)(void *data);
+
+///
+/// Event loop file descriptor registration
+typedef struct
+{
+    int                 fd;             ///< file descriptor
+    plt_evt_cb_t        evt_cb;         ///< callback when the file descriptor is readable; NULL if the entry is free
+    void                *data;          ///< parameter passed to the callback
+
+} plt_evt_t;
+#endif
+
 ///Platform context
 typedef struct
 {
-    volatile uint16_t   tmr_tick;       ///< Timer tick every PLT_TIMER_RESOLUTION
     uint16_t            id_gen;         ///< One-shot Timer identifier generator (range 1 to 0x7FFF)
     uint16_t            per_id_gen;     ///< Periodic Timer identifier generator (range 0x8000 to 0xFFFF)
     int                 init_done;      ///< Counter to indicated how many times platform initialization has been invoked
-    void                *tmr_mtx;       ///< mutex for accessing timer list
-    void                *tmr_sem;       ///< semaphore for waiting timer tick event
-    util_lst_t          *tmr_lst_hd;    ///< head of linked list for timers
-    volatile int        tmr_tck_thrd_run;   ///< control the timer tick thread whether to run. 1 = run, 0 = stop
-    volatile int        tmr_tck_thrd_sts;   ///< timer tick thread status. 1 = running, 0 = thread exited
+    int                 evt_loop;       ///< Flag to serve the serial port on the timer check thread instead of dedicated
+                                        ///< threads. Set before plt_init; cleared by plt_init if not supported
+    void                *tmr_mtx;       ///< mutex for accessing timer list and event loop registrations
+#ifdef OS_MAC_X
+    int                 tmr_pipe[2];    ///< pipe for waking up the timer check thread
+#else
+    int                 tmr_fd;         ///< timerfd armed to the earliest timer expiry
+    int                 evt_fd;         ///< epoll instance the timer check thread waits on
+    plt_evt_t           evt_tbl[PLT_EVT_MAX];   ///< file descriptors served by the timer check thread
+    volatile int        evt_busy;       ///< index plus one of the registration whose callback is running; 0 = none
+#endif
+    uint64_t            tmr_armed;      ///< monotonic time in ticks the timer check thread is to wake up; 0 = none
+    void                *tmr_whl;       ///< hierarchical timing wheel holding the timers
+    void                *tmr_cb_pool;   ///< executor of one-shot timer callbacks
     volatile int        tmr_chk_thrd_run;   ///< control the timer check thread whether to run. 1 = run, 0 = stop
     volatile int        tmr_chk_thrd_sts;   ///< timer check thread status. 1 = running, 0 = thread exited
     print_fn          print_txt;      ///< Print text function
@@ -98,15 +158,22 @@ void        plt_cond_broadcast(void *cond_ctx);
 void        plt_cond_signal(void *cond_ctx);
 void        plt_cond_destroy(void *cond_ctx);
 int         plt_thrd_create(void (*start_adr)( void * ), void *args);
+int         plt_thrd_is_lib(void);
 void        plt_sleep(uint32_t    tmout_ms);
+uint64_t    plt_mono_ms(void);
+uint64_t    plt_mono_us(void);
 void        *plt_periodic_start(plt_ctx_t *pltfm_ctx, uint32_t  tmout_ms, tmr_cb_t  tmout_cb, void *data);
+#ifdef PLT_EVT_LOOP
+int         plt_evt_add(plt_ctx_t *pltfm_ctx, int fd, plt_evt_cb_t evt_cb, void *data);
+void        plt_evt_rm(plt_ctx_t *pltfm_ctx, int fd);
+#endif
 #if defined(_WINDOWS) || defined(WIN32)
 int         plt_utf16_to_8(const char *utf16_src, char *utf8_output, uint8_t out_buf_len, uint8_t big_endian);
 #else
 int         plt_utf16_to_8(const uint16_t *utf16_src, uint8_t *utf8_output, uint8_t out_buf_len, uint8_t big_endian);
 #endif
 int         plt_utf8_chk(const uint8_t *utf8, uint8_t utf8_len);
-int         plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn);
+int         plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn, uint8_t tmr_cb_thrd_cnt);
 void        plt_exit(plt_ctx_t *pltfm_ctx);
 int16_t     plt_rand_get(void);
 void        *plt_memmem(const void *buf, size_t buf_len, const void *byte_sequence, size_t byte_sequence_len);
@@ -115,6 +182,20 @@ void        *plt_memmem(const void *buf, size_t buf_len, const void *byte_sequen
 #define strcasecmp _stricmp
 #endif
 
+#if defined(OS_LINUX) && defined(PLT_MTX_PROF)
+uint32_t    plt_mtx_prof_init(void **context, const char *file, int line);
+int         plt_mtx_prof_trylck(void *context, const char *file, int line);
+void        plt_mtx_prof_lck(void *context, const char *file, int line);
+void        plt_mtx_prof_dump(plt_ctx_t *pltfm_ctx);
+void        plt_mtx_prof_reset(void);
+
+///
+/// Record the call sites of mutex initialization and locking
+#define plt_mtx_init(context)   plt_mtx_prof_init(context, __FILE__, __LINE__)
+#define plt_mtx_trylck(context) plt_mtx_prof_trylck(context, __FILE__, __LINE__)
+#define plt_mtx_lck(context)    plt_mtx_prof_lck(context, __FILE__, __LINE__)
+#endif
+
 
 
 /**
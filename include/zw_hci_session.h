@@ -38,6 +38,13 @@ To handle commands sending and the corresponding responses and/or callback.
 //Maximum funcID value
 #define     SESSION_FUNCID_MAX      252   ///< Maximum funcID value used to identify which callback to call
 
+//Response window
+#define     SESSION_RESP_WIN_DEF    1     ///< Default maximum number of commands waiting for response
+#define     SESSION_RESP_WIN_MAX    8     ///< Maximum number of commands waiting for response
+
+//Callback workers
+#define     SESSION_CB_WKR_MAX      8     ///< Maximum number of callback worker threads
+
 ///
 /// Z-wave HCI session layer state-machine event
 typedef enum
@@ -54,22 +61,12 @@ typedef enum
 /// Z-wave HCI session layer state-machine's states
 typedef enum
 {
-    SESSION_STATE_IDLE,          ///< Waiting for event.
-    SESSION_STATE_COMMAND_SENT,  ///< Command is sent.
-    SESSION_STATE_WAIT_RESPONSE  ///< Waiting for response
+    SESSION_STATE_IDLE,          ///< Ready to send the next queued command.
+    SESSION_STATE_COMMAND_SENT,  ///< Command is sent, waiting for the frame layer send status.
+    SESSION_STATE_WAIT_RESPONSE  ///< The response window is full, waiting for response
 
 } session_state_t;
 
-///
-/// Z-wave Serial API command response status
-typedef enum
-{
-    SESSION_RESPONSE_UNKNOWN,      ///< Unknown
-    SESSION_RESPONSE_OK,           ///< Send command succeeded with response received.
-    SESSION_RESPONSE_MEM,          ///< Failed to allocate memory for the response received.
-    SESSION_RESPONSE_TIMEOUT       ///< Response timeout
-} ssn_cmd_resp_sts_t;
-
 ///
 /// Session command / response
 typedef struct
@@ -88,8 +85,16 @@ struct _ssn_layer_ctx;
 typedef void    (*cmd_cb_t)(struct _ssn_layer_ctx *ssn_ctx, ssn_cmd_resp_t *command, void **param);
 
 ///
-/// network management callback function
-typedef void    (*nm_cb_t)(struct _ssn_layer_ctx *ssn_ctx, uint8_t cmd_id);
+/// network management callback function. Called from the frame receiving thread with the parameters of the command callback
+typedef void    (*nm_cb_t)(struct _ssn_layer_ctx *ssn_ctx, uint8_t cmd_id, void **param);
+
+//Forward declaration of callback request
+struct _ssn_cb_req;
+
+///
+/// Shard key callback function. Returns the source node id of an unsolicited command or the destination
+/// node id of a command callback, zero if it has none
+typedef uint8_t (*shard_key_t)(struct _ssn_layer_ctx *ssn_ctx, struct _ssn_cb_req *cb_req);
 
 ///
 /// Store the command id and the corresponding callback function pointer
@@ -125,6 +130,9 @@ typedef struct
     uint8_t     dat_buf[1];     ///< The buffer to store the parameters of the command / response. Reserved 1 byte for function id.
 } ssn_cmd_snd_param_t;
 
+//Forward declaration of queued command request
+struct _ssn_req;
+
 ///
 /// Callback request
 typedef struct  _ssn_cb_req
@@ -132,9 +140,70 @@ typedef struct  _ssn_cb_req
     ssn_cmd_resp_t      *cmd;               ///< The command info passed to command callback function
     cmd_cb_t            cmd_cb_func;        ///< The pointer to command callback
     void                *cmd_cb_prm[2];     ///< The parameters of cmd_cb_func
+    struct _ssn_req     *req;               ///< Completed request to report to its completion callback; NULL for command callback
+    uint64_t            enq_ts;             ///< Time of queuing the request in microseconds (plt_mono_us)
 
 } ssn_cb_req_t;
 
+///
+/// Callback worker statistics
+typedef struct
+{
+    uint32_t    que_depth;          ///< Number of callback requests waiting in the queue
+    uint32_t    que_depth_max;      ///< Highest number of callback requests waiting in the queue
+    uint32_t    dispatch_cnt;       ///< Number of callback requests dispatched
+    uint32_t    lat_max;            ///< Longest time from queuing to dispatching a callback request in microseconds
+    uint64_t    lat_sum;            ///< Total time from queuing to dispatching the callback requests in microseconds
+} ssn_cb_wkr_stat_t;
+
+///
+/// Callback dispatcher statistics
+typedef struct
+{
+    uint8_t             wkr_cnt;                    ///< Number of callback workers
+    ssn_cb_wkr_stat_t   wkr[SESSION_CB_WKR_MAX];    ///< Statistics of each worker; only the first wkr_cnt entries are valid
+} ssn_cb_stat_t;
+
+///
+/// Callback worker
+typedef struct
+{
+    struct _ssn_layer_ctx   *ssn_ctx;   ///< Session layer context
+    void        *mtx;                   ///< Mutex for the queue and the statistics
+    void        *sem;                   ///< Semaphore for waiting of callback requests
+    util_que_t  req_hd;                 ///< Queue of callback requests
+    ssn_cb_wkr_stat_t   stat;           ///< Statistics
+    volatile uint32_t   thrd_run;       ///< Control the worker thread whether to run. 1 = run, 0 = stop
+    volatile uint32_t   thrd_sts;       ///< Worker thread status. 1 = run, 0 = thread exited
+} ssn_cb_wkr_t;
+
+///
+/// Command completion callback function
+typedef void    (*ssn_cmd_cmplt_t)(struct _ssn_layer_ctx *ssn_ctx, int32_t result, ssn_cmd_resp_t *cmd_resp, void *user);
+
+///
+/// Queued command request
+typedef struct  _ssn_req
+{
+    struct _ssn_req     *next;          ///< Next request in the queue
+    ssn_cmd_cmplt_t     cmplt_cb;       ///< Completion callback. NULL if the caller waits on wait_sem
+    void                *user;          ///< User parameter of cmplt_cb
+    void                *wait_sem;      ///< Semaphore posted on completion if cmplt_cb is NULL
+    ssn_cmd_resp_t      *cmd_resp;      ///< The response to the command
+    uint64_t            resp_tmout;     ///< Time in milliseconds (plt_mono_ms) to give up waiting for response
+    int32_t             result;         ///< Completion result. 0 on success, negative error number on failure
+    ssn_cmd_snd_param_t param;          ///< Copy of the send command parameters. Must be the last member
+} ssn_req_t;
+
+///
+/// Queue of command requests
+typedef struct
+{
+    ssn_req_t   *head;      ///< First request
+    ssn_req_t   *tail;      ///< Last request
+    uint32_t    cnt;        ///< Number of requests
+} ssn_req_que_t;
+
 
 //Forward declaration of application layer context
 struct _appl_layer_ctx;
@@ -150,22 +219,21 @@ typedef struct _ssn_layer_ctx
     ssn_cmd_cb_ref_t  cb_map[SESSION_FUNCID_MAX + 1];  ///< To facilitate the retrieval of callback function based on funcID
     session_state_t     ssn_sta;    ///< The session layer state machine state
     void      *sta_mach_mtx;        ///< Mutex for state machine
-    void      *snd_frm_sts_sem;     ///< Semaphore for waiting of send frame status
-    void      *cmd_resp_sts_sem;    ///< Semaphore for waiting of command response status
     void      *resp_tmr_ctx;        ///< Response waiting timer context
-    void      *cb_thrd_mtx;         ///< Mutex for callback thread
-    void      *cb_thrd_sem;         ///< Semaphore for waiting of callback requests
     nm_cb_t   nm_cb;                ///< Callback for network management and send data completion function
-    ssn_cmd_resp_t *cmd_resp;       ///< store the response to a command
-    util_lst_t   *cb_req_hd;        ///< head of linked list for callback requests
-    uint8_t   last_cmd_id;          ///< Last sent command identifier
-    uint8_t   last_cmd_flag;        ///< Last sent command flag
+    shard_key_t  shard_key;         ///< Callback to get the node id of an unsolicited command or a command callback.
+                                    ///< NULL = no sharding
+    ssn_cb_wkr_t cb_wkr[SESSION_CB_WKR_MAX];    ///< Callback workers. Callbacks with the same node id run in
+                                                ///< the same worker in order; all the others run in the first worker
+    uint8_t   cb_wkr_cnt;           ///< Number of callback workers. Zero = one
+    ssn_req_que_t   req_que;        ///< Requests waiting to be sent
+    ssn_req_que_t   resp_que;       ///< Sent requests waiting for response, in the order they were sent
+    ssn_req_que_t   done_que;       ///< Completed requests to be reported after releasing sta_mach_mtx
+    ssn_req_t *snd_req;             ///< Request waiting for the frame layer send status
     uint8_t   last_gen_func_id;     ///< Last generated function id
+    uint8_t   resp_win;             ///< Maximum number of sent commands waiting for response. Zero = SESSION_RESP_WIN_DEF.
+                                    ///< The Serial API expects one; larger values only for controllers that queue requests
     uint32_t  resp_tmout_ms;        ///< Response waiting timeout value in milliseconds
-    volatile frm_snd_sts_t          snd_frm_sts;    ///< Send frame status from the frame layer
-    volatile ssn_cmd_resp_sts_t     cmd_resp_sts;   ///< command response status
-    volatile uint32_t               cb_thrd_run;    ///< Control the callback thread whether to run. 1 = run, 0 = stop
-    volatile uint32_t               cb_thrd_sts;    ///< Callback thread status. 1 = run, 0 = thread exited
     frm_layer_ctx_t                 frm_ctx;        ///< Frame layer context
     plt_ctx_t                       *plt_ctx;       ///< Platform context
     struct _appl_layer_ctx          *appl_layer_ctx;///< Pointer to application layer context
@@ -173,6 +241,10 @@ typedef struct _ssn_layer_ctx
 
 int32_t ssn_cmd_snd(ssn_layer_ctx_t   *ssn_ctx, ssn_cmd_snd_param_t   *param,
                     ssn_cmd_resp_t **cmd_resp);
+int32_t ssn_cmd_snd_async(ssn_layer_ctx_t   *ssn_ctx, ssn_cmd_snd_param_t   *param,
+                          ssn_cmd_cmplt_t cmplt_cb, void *user, void **req_hdl);
+int32_t ssn_cmd_wait(void *req_hdl, ssn_cmd_resp_t **cmd_resp);
+void ssn_cb_stat_get(ssn_layer_ctx_t   *ssn_ctx, ssn_cb_stat_t *stat, int reset);
 int32_t ssn_init(ssn_layer_ctx_t   *ssn_ctx);
 void ssn_exit(ssn_layer_ctx_t   *ssn_ctx);
 
@@ -19,11 +19,13 @@ comments: Initial release
 #include "zw_plt_windows.h"   //use in Windows platform
 #elif defined(OS_LINUX)
 #include "zw_plt_linux.h"     //use in Linux platform
+#include <sys/types.h>
 #endif
 #include <stdint.h>
 #include <stdio.h>
 #include "zw_hci_error.h"
 #include "zw_hci_platform.h"
+#include "zw_hci_capture.h"
 
 /**
 @defgroup Transport Transport layer APIs
@@ -39,6 +41,15 @@ Platform specific implementation of serial port access.
 #define COMM_MAX_READ_BUFFER        1024
 #define COMM_MAX_WRITE_BUFFER       512
 
+///
+/// Maximum number of single-byte control frames (ACK, NAK, CAN) waiting to be written to the comm port
+#define TPT_CTL_PEND_MAX            8
+
+///
+/// Headroom the upper layer should reserve in the buffers passed to tpt_wr_buf_req, so that
+/// pending control frames can be written in front of the data without copying
+#define TPT_BUF_HEADROOM            TPT_CTL_PEND_MAX
+
 ///
 /// Timeout to check for write request event
 #define COMM_WRITE_CHECK_TIMEOUT     2000
@@ -51,6 +62,39 @@ Platform specific implementation of serial port access.
 //Forward declaration of frame layer context
 struct _frm_layer_ctx;
 
+#ifdef OS_LINUX
+///
+/// Comm port name prefixes to select the transport backend. Names without any of the
+/// prefixes are opened as serial comm port (tty or pseudo terminal)
+#define TPT_PORT_PREFIX_TCP         "tcp:"  ///< TCP stream socket, e.g. "tcp:192.168.1.10:3333" (ser2net raw mode)
+#define TPT_PORT_PREFIX_UNIX        "unix:" ///< Unix domain stream socket, e.g. "unix:/tmp/zwave.sock"
+#define TPT_PORT_PREFIX_FD          "fd:"   ///< Already opened file descriptor, e.g. "fd:5" for one end of
+                                            ///< a socketpair() that loops back to an in-process peer
+#define TPT_PORT_PREFIX_REPLAY      "replay:"   ///< Replay the received bytes of a trace file as fast as the host
+                                                ///< keeps up, e.g. "replay:/tmp/field.zwcap". See zw_hci_capture.h
+#define TPT_PORT_PREFIX_REPLAY_RT   "replay-rt:"///< Replay the received bytes of a trace file in real time
+
+///
+/// Maximum time the replay waits for the host to write what it wrote before a received record in the
+/// trace. Replay carries on if the host has taken a different path
+#define TPT_RPL_SYNC_TMOUT          2000    ///< In milliseconds
+
+//Forward declaration of transport layer context
+struct _tpt_layer_ctx;
+
+///
+/// Transport backend operations. Each backend provides a file descriptor that is read by the
+/// read thread or the event loop
+typedef struct
+{
+    const char  *prefix;    ///< Comm port name prefix to select the backend; NULL for the default backend
+    int         (*open)(struct _tpt_layer_ctx *tpt_ctx, const char *addr);  ///< Open the comm port and set comm_port_fd.
+                                                                            ///< Return non-zero on success
+    ssize_t     (*wr)(struct _tpt_layer_ctx *tpt_ctx, const uint8_t *buf, size_t len);///< Write to the comm port
+    void        (*close)(struct _tpt_layer_ctx *tpt_ctx);   ///< Close the comm port; NULL to close comm_port_fd
+} tpt_port_ops_t;
+#endif
+
 ///
 /// Z-wave hci transport layer context
 typedef struct _tpt_layer_ctx
@@ -72,26 +116,40 @@ typedef struct _tpt_layer_ctx
     HANDLE  wr_thrd_hdl;                ///< write thread handle
     HANDLE  wr_evt_hdl;                 ///< handle of the synchronization event for write requests
     HANDLE  thrd_exit_evt_hdl;          ///< handle of the synchronization event for terminating threads
-    util_lst_t   *wr_req_hd;            ///< head of linked list for write requests
+    util_que_t   wr_req_hd;             ///< queue of write requests
     #endif
 
     #ifdef OS_LINUX
     char            *comm_port_name;    ///< pointer to comm port name
     int             comm_port_fd;       ///< comm port file descriptor
-    void            *wr_req_mtx;        ///< mutex for accessing write request list
+    const tpt_port_ops_t *port_ops;     ///< backend operations selected by the comm port name
+    void            *rpl_ctx;           ///< replay backend context
+    const char      *cap_file;          ///< file to capture the comm port traffic to; NULL = no capture
+    void            *cap_ctx;           ///< capture context
+    void            *wr_req_mtx;        ///< mutex for accessing write request list and pending control frames
+    void            *port_wr_mtx;       ///< mutex for writing to the comm port
+    uint8_t         ctl_pend[TPT_CTL_PEND_MAX]; ///< single-byte control frames waiting for the comm port
+    uint8_t         ctl_pend_cnt;       ///< number of bytes in ctl_pend
     void            *wr_q_sem;          ///< semaphore for waiting requests to write to the comm port
-    util_lst_t      *wr_req_hd;         ///< head of linked list for write requests
+    util_buf_que_t  wr_req_hd;          ///< queue of buffers to write
     volatile int    rd_thrd_run;        ///< control the read thread whether to run. 1 = run, 0 = stop
     volatile int    rd_thrd_sts;        ///< read thread status. 1 = running, 0 = thread exited
     volatile int    wr_thrd_run;        ///< control the write thread whether to run. 1 = run, 0 = stop
     volatile int    wr_thrd_sts;        ///< write thread status. 1 = running, 0 = thread exited
     volatile int    wr_started;         ///< flag to indicate write has started.
+    #ifdef PLT_EVT_LOOP
+    int             wr_evt_fd;          ///< eventfd to notify the event loop of write requests
+    int             rd_evt_sts;         ///< comm port registration to the event loop. 0 = not yet, 1 = registered, -1 = closing
+    void            *rd_evt_tmr_ctx;    ///< timer to register the comm port to the event loop if there is no write
+    #endif
     #endif
 
 } tpt_layer_ctx_t;
 
 
 int32_t tpt_wr_req_create(tpt_layer_ctx_t *tpt_ctx, uint8_t   *buf, uint8_t dat_sz);
+int32_t tpt_wr_buf_req(tpt_layer_ctx_t *tpt_ctx, util_buf_t *buf);
+int32_t tpt_ctl_byte_snd(tpt_layer_ctx_t *tpt_ctx, uint8_t data);
 int32_t tpt_init(tpt_layer_ctx_t *tpt_ctx);
 void tpt_exit(tpt_layer_ctx_t *tpt_ctx);
 
@@ -19,6 +19,45 @@ Some utility/miscellaneous functions.
 @{
 */
 
+///
+/// Number of size classes of the memory pool
+#define UTIL_MEM_CLS_CNT        3
+
+///
+/// Block sizes of the memory pool size classes. The largest class holds a list entry
+/// carrying a full serial frame (up to 255 bytes)
+#define UTIL_MEM_BLK_SZ_0       64
+#define UTIL_MEM_BLK_SZ_1       128
+#define UTIL_MEM_BLK_SZ_2       320
+
+///
+/// Number of blocks preallocated for each of the memory pool size classes
+#define UTIL_MEM_BLK_CNT_0      256
+#define UTIL_MEM_BLK_CNT_1      128
+#define UTIL_MEM_BLK_CNT_2      64
+
+///
+/// Memory pool statistics of a size class
+typedef struct
+{
+    uint32_t          blk_sz;       ///< Block size in bytes
+    uint32_t          blk_cnt;      ///< Number of blocks in the pool; zero if the pool is not available
+    uint32_t          in_use;       ///< Number of blocks currently allocated
+    uint32_t          peak;         ///< Highest number of blocks allocated at the same time
+    uint32_t          hit;          ///< Number of allocations served by the pool
+    uint32_t          miss;         ///< Number of allocations that fell back to the heap because the pool was exhausted
+
+} util_mem_cls_stat_t;
+
+///
+/// Memory pool statistics
+typedef struct
+{
+    util_mem_cls_stat_t cls[UTIL_MEM_CLS_CNT];  ///< Statistics of each size class
+    uint32_t          heap;         ///< Number of allocations larger than the largest block size
+
+} util_mem_stat_t;
+
 ///
 /// List entry
 typedef struct  _util_lst
@@ -29,11 +68,54 @@ typedef struct  _util_lst
 
 } util_lst_t;
 
+///
+/// FIFO queue of list entries with constant time enqueue and dequeue
+typedef struct
+{
+    util_lst_t        *head;        ///< First entry, NULL if the queue is empty
+    util_lst_t        *tail;        ///< Last entry
+    uint32_t          cnt;          ///< Number of entries in the queue
+
+} util_que_t;
+
+///
+/// Reference counted buffer with reserved headroom and tailroom, so that the layers can add their
+/// headers and trailers in place and pass the buffer on without copying the data
+typedef struct  _util_buf
+{
+    struct _util_buf  *next;        ///< Point to the next buffer in a util_buf_que_t
+    volatile int32_t  ref_cnt;      ///< Reference count. The buffer is freed when it drops to zero
+    uint8_t           queued;       ///< Flag to indicate the buffer is in a util_buf_que_t
+    uint16_t          buf_sz;       ///< Size of buf
+    uint16_t          head;         ///< Offset of the first data byte in buf
+    uint16_t          len;          ///< Data length
+    uint8_t           buf[1];       ///< Place holder for the headroom, data and tailroom
+
+} util_buf_t;
+
+///
+/// Get the first data byte of a buffer
+#define UTIL_BUF_DAT(b)     ((b)->buf + (b)->head)
+
+///
+/// FIFO queue of reference counted buffers
+typedef struct
+{
+    util_buf_t        *head;        ///< First buffer, NULL if the queue is empty
+    util_buf_t        *tail;        ///< Last buffer
+    uint32_t          cnt;          ///< Number of buffers in the queue
+
+} util_buf_que_t;
+
 ///
 /// List compare function that return 0 if s1 is same as s2; else return non-zero
 typedef int (*util_list_cmp_fn)(uint8_t *s1, uint8_t *s2);
 
 
+void    util_mem_init(void);
+void    *util_mem_alloc(size_t size);
+void    util_mem_free(void *ptr);
+void    util_mem_stat_get(util_mem_stat_t *stat);
 int     util_list_add(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint8_t dat_sz);
 int     util_list_add_no_dup(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint8_t dat_sz, util_list_cmp_fn cmp_fn);
 util_lst_t *util_list_get(void *mtx_ctx, util_lst_t **head);
@@ -41,6 +123,18 @@ void    util_list_flush(void *mtx_ctx, util_lst_t **head);
 int     util_list_find(void *mtx_ctx, util_lst_t *head, uint8_t  *buf, util_list_cmp_fn cmp_fn);
 int     util_list_rm(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, util_list_cmp_fn cmp_fn);
 int     util_list_rplc(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint16_t dat_sz, util_list_cmp_fn cmp_fn);
+int     util_que_add(void *mtx_ctx, util_que_t *que, uint8_t  *buf, uint16_t dat_sz);
+void    util_que_ent_add(void *mtx_ctx, util_que_t *que, util_lst_t *ent);
+util_lst_t *util_que_get(void *mtx_ctx, util_que_t *que);
+void    util_que_flush(void *mtx_ctx, util_que_t *que);
+util_buf_t *util_buf_alloc(uint16_t headroom, uint16_t size);
+uint8_t *util_buf_push(util_buf_t *buf, uint16_t len);
+uint8_t *util_buf_put(util_buf_t *buf, uint16_t len);
+void    util_buf_hold(util_buf_t *buf);
+void    util_buf_release(util_buf_t *buf);
+void    util_buf_que_add(void *mtx_ctx, util_buf_que_t *que, util_buf_t *buf);
+util_buf_t *util_buf_que_get(void *mtx_ctx, util_buf_que_t *que);
+void    util_buf_que_flush(void *mtx_ctx, util_buf_que_t *que);
 void    util_hex_string_add(char *src, unsigned src_size, unsigned num);
 void    util_num_string_add(char *src, unsigned src_size, unsigned num);
 void    util_ntohs(uint16_t *src, unsigned elem_cnt);
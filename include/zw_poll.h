@@ -17,7 +17,7 @@ Used to create and delete polling commands to a device
 @{
 */
 
-#define POLL_TIMER_TICK             500     /**< Periodic timer tick interval in ms */
+#define POLL_TIMER_TICK             500     /**< Polling time unit (timer tick) in ms */
 #define POLL_TICK_PER_SEC           (1000/POLL_TIMER_TICK)     /**< Number of timer ticks per second */
 #define MIN_POLL_TIME               (10 * POLL_TICK_PER_SEC) /**< Minimum polling time in terms of timer tick */
 #define CHECK_EXPIRY_INTERVAL       (1 * POLL_TICK_PER_SEC)  /**< Check for polling entries expiry interval
@@ -45,13 +45,12 @@ poll_q_ent_t;
 /** Polling context */
 typedef struct  _poll_ctx
 {
-    volatile uint32_t   tmr_tick;           /**< Periodic timer tick, incremented every POLL_TIMER_TICK ms */
     volatile int        tmr_chk_thrd_run;   /**< Control the timer check thread whether to run. 1 = run, 0 = stop */
     volatile int        tmr_chk_thrd_sts;   /**< Timer check thread status. 1 = running, 0 = thread exited */
     uint32_t            next_poll_tm;       /**< Next polling time */
-    void                *tmr_sem;           /**< Semaphore for waiting timer tick event */
+    void                *tmr_sem;           /**< Semaphore for waiting next poll time event */
     void                *poll_mtx;          /**< Mutex for the polling facility */
-    void                *tick_tmr_ctx;      /**< Tick timer context */
+    void                *tick_tmr_ctx;      /**< Next poll time timer context */
     util_lst_t          *poll_lst_hd;       /**< Head of linked list for polling requests */
     zwnet_p             net;                /**< Network */
     uint16_t            handle_gen;         /**< Handle number generator */
@@ -20,11 +20,9 @@ Some security functions.
 */
 //#define DEBUG_ZWAVE_SECURITY    // flag for debugging security layer
 
-#define SEC_TIMER_TICK              200     /**< Periodic timer tick interval in ms */
-#define INTERNAL_NONCE_TABLE_CHECK  5       /**< Internal nonce table check interval in terms of timer tick */
-#define INTERNAL_NONCE_LIFE         (5*3)   /**< Internal nonce life span in terms of SEC_TIMER_TICK*/
+#define INTERNAL_NONCE_LIFE         3000    /**< Internal nonce life span in ms*/
 #define INTERNAL_NONCE_TABLE_SIZE   38      /**< Number of entries in the internal nonce table */
-#define EXTERNAL_NONCE_LIFE         (5*1)   /**< External nonce life span in terms of SEC_TIMER_TICK*/
+#define EXTERNAL_NONCE_LIFE         1000    /**< External nonce life span in ms*/
 #define NONCE_REQ_TIMEOUT           10000   /**< Nonce request timeout in ms*/
 #define MAX_SPP_SIZE                48      /**< Maximum security payload package (SPP) size*/
 #define INCL_STA_TIMEOUT            10000   /**< Inclusion of nodes state timeout in ms*/
@@ -46,7 +44,7 @@ typedef struct
 {
     uint8_t     state;                  /**< State of this nonce INONCE_STA_XXX*/
     uint8_t     rcv_nodeid;             /**< Receiver node id*/
-    uint16_t    expiry_tick;            /**< Expiry timer tick */
+    uint64_t    expiry_ms;              /**< Expiry time in terms of plt_mono_ms() */
     uint8_t     nonce[8];               /**< Internal nonce */
 } zwsec_inonce_t;
 
@@ -56,7 +54,7 @@ typedef struct
 {
     uint8_t     valid;                  /**< Validity of this nonce. 1= valid; 0= invalid*/
     uint8_t     snd_nodeid;             /**< Sender node id*/
-    uint16_t    expiry_tick;            /**< Expiry timer tick */
+    uint64_t    expiry_ms;              /**< Expiry time in terms of plt_mono_ms() */
     uint8_t     nonce[8];               /**< External nonce */
 } zwsec_enonce_t;
 
@@ -180,13 +178,10 @@ typedef enum
 /** Security layer context */
 typedef struct  _sec_layer_ctx
 {
-    void                *tick_tmr_ctx;      /**< Tick timer context */
     void                *tx_sm_tmr_ctx;     /**< Tx state machine timer context*/
     void                *incd_sm_tmr_ctx;   /**< Included node state machine timer context*/
     void                *add_sm_tmr_ctx;    /**< Add node state machine timer context*/
     void                *sec_mtx;           /**< Mutex for security layer */
-    volatile uint16_t   tmr_tick;           /**< Periodic timer tick, updated every SEC_TIMER_TICK ms */
-    uint16_t            clean_up_tick;      /**< Internal nouce table clean up timer tick */
     zwsec_inonce_t      inonce_tbl[INTERNAL_NONCE_TABLE_SIZE];  /**< Internal nonce table */
     zwsec_enonce_t      ext_nonce;          /**< External nonce */
     zwsec_random_t      prng_ctx;           /**< Pseudo-random number generator context */
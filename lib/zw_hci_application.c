@@ -115,28 +115,382 @@ static void    appl_unsolicited_cmd_cb(struct _ssn_layer_ctx *ssn_ctx, ssn_cmd_r
 }
 
 
+static void    zw_send_data_cb(struct _ssn_layer_ctx *ssn_ctx, ssn_cmd_resp_t *cmd, void **param);
+static appl_snd_dat_t    *zw_snd_dat_slot_get(appl_layer_ctx_t   *appl_ctx, void **param);
+
+/**
+appl_shard_key - Get the node id of a received unsolicited command or command callback
+@param[in]	ssn_ctx		Session layer context
+@param[in]	cb_req		The callback request
+@return     The source node id of an unsolicited command or the destination node id of a send data;
+            zero if there is none
+*/
+static uint8_t    appl_shard_key(struct _ssn_layer_ctx *ssn_ctx, ssn_cb_req_t *cb_req)
+{
+    appl_layer_ctx_t    *appl_ctx = ssn_ctx->appl_layer_ctx;
+    ssn_cmd_resp_t      *cmd = cb_req->cmd;
+    appl_snd_dat_t      *slot;
+    uint8_t             node_id = 0;
+
+    if (cb_req->cmd_cb_func == ssn_ctx->unsolicited_cmd_cb)
+    {
+        //ZW->HOST: REQ | 0x04 | rxStatus | sourceNode | cmdLength | pCmd[ ]
+        if ((cmd->cmd_id == FUNC_ID_APPLICATION_COMMAND_HANDLER) && (cmd->len >= 3))
+        {
+            node_id = cmd->dat_buf[1];
+        }
+    }
+    else if (cb_req->cmd_cb_func == zw_send_data_cb)
+    {   //Report the transmit completion in order with the commands received from the node
+        plt_mtx_lck(appl_ctx->snd_mtx);
+        slot = zw_snd_dat_slot_get(appl_ctx, cb_req->cmd_cb_prm);
+        if (slot)
+        {
+            node_id = slot->node_id;
+        }
+        plt_mtx_ulck(appl_ctx->snd_mtx);
+    }
+    return node_id;
+}
+
+
+///
+/// Send class of the calling thread plus one; zero = not set
+static PLT_THRD_LOCAL uint8_t appl_snd_cls;
+
+/**
+zwhci_snd_cls_get - Get the send class of the calling thread
+@return  APPL_SND_CLS_XXX. Unless set by zwhci_snd_cls_set, it is APPL_SND_CLS_CTRL for library threads
+         and APPL_SND_CLS_INTERACTIVE for application threads
+*/
+uint8_t    zwhci_snd_cls_get(void)
+{
+    if (appl_snd_cls)
+        return appl_snd_cls - 1;
+
+    return (plt_thrd_is_lib())? APPL_SND_CLS_CTRL : APPL_SND_CLS_INTERACTIVE;
+}
+
+
+/**
+zwhci_snd_cls_set - Set the send class of the commands sent by the calling thread
+@param[in]	cls		Send class, APPL_SND_CLS_XXX
+@return  The previous send class of the calling thread
+*/
+uint8_t    zwhci_snd_cls_set(uint8_t cls)
+{
+    uint8_t prev_cls = zwhci_snd_cls_get();
+
+    if (cls >= APPL_SND_CLS_CNT)
+        cls = APPL_SND_CLS_BG;
+    appl_snd_cls = cls + 1;
+
+    return prev_cls;
+}
+
+
+/**
+zwhci_snd_stat_get - Get the send statistics
+@param[in]	appl_ctx		Context
+@param[out]	stat		    The statistics
+@param[in]	reset		    Flag to clear the statistics after reading them
+@return
+*/
+void    zwhci_snd_stat_get(appl_layer_ctx_t   *appl_ctx, appl_snd_stat_t *stat, int reset)
+{
+    plt_mtx_lck(appl_ctx->snd_mtx);
+    *stat = appl_ctx->snd_stat;
+    if (reset)
+    {
+        memset(&appl_ctx->snd_stat, 0, sizeof(appl_snd_stat_t));
+    }
+    plt_mtx_ulck(appl_ctx->snd_mtx);
+}
+
+
 /**
-appl_wait_to_snd - Wait for the condition where sending of command is allowed
+appl_lat_bkt - Get the histogram bucket of a latency
+@param[in]	lat		        Latency in milliseconds
+@return  The bucket index, see APPL_SND_LAT_BKT_CNT
+*/
+static uint32_t    appl_lat_bkt(uint32_t lat)
+{
+    uint32_t    bkt = 0;
+
+    while ((lat >>= 1) != 0)
+    {
+        bkt++;
+    }
+    if (bkt >= APPL_SND_LAT_BKT_CNT)
+        bkt = APPL_SND_LAT_BKT_CNT - 1;
+    return bkt;
+}
+
+
+/**
+appl_node_tmout - Get the send data callback timeout of a node
 @param[in]	appl_ctx		Context
+@param[in]	node_id		    Destination node; zero for multicast and broadcast
+@return  The timeout in milliseconds
+@pre    Caller must lock the snd_mtx
+*/
+static uint32_t    appl_node_tmout(appl_layer_ctx_t   *appl_ctx, uint8_t node_id)
+{
+    appl_node_lat_t *lat;
+    uint32_t        tmout;
+
+    if ((node_id == 0) || (node_id > ZW_MAX_NODES))
+        return appl_ctx->cb_tmout_ms;
+
+    lat = &appl_ctx->node_lat[node_id];
+    if (lat->cnt < APPL_NODE_TMOUT_SMPL)
+        return appl_ctx->cb_tmout_ms;
+
+    //Smoothed latency plus four times its mean deviation
+    tmout = (lat->srtt >> 3) + lat->rttvar;
+    if (tmout < APPL_NODE_TMOUT_MIN)
+        tmout = APPL_NODE_TMOUT_MIN;
+    tmout <<= lat->backoff;
+
+    return (tmout < appl_ctx->cb_tmout_ms)? tmout : appl_ctx->cb_tmout_ms;
+}
+
+
+/**
+appl_node_lat_upd - Update the transmit completion latency of a node
+@param[in]	appl_ctx		Context
+@param[in]	node_id		    Destination node
+@param[in]	ms		        Latency in milliseconds
+@return
+@pre    Caller must lock the snd_mtx
+*/
+static void    appl_node_lat_upd(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, uint32_t ms)
+{
+    appl_node_lat_t *lat = &appl_ctx->node_lat[node_id];
+    int32_t         err;
+
+    if (lat->cnt == 0)
+    {
+        lat->srtt = ms << 3;
+        lat->rttvar = ms << 1;
+    }
+    else
+    {
+        err = (int32_t)ms - (int32_t)(lat->srtt >> 3);
+        lat->srtt = (uint32_t)((int32_t)lat->srtt + err);
+        if (err < 0)
+            err = -err;
+        lat->rttvar = lat->rttvar + (uint32_t)err - (lat->rttvar >> 2);
+    }
+
+    lat->cnt++;
+    lat->backoff = 0;
+    if (ms > lat->lat_max)
+        lat->lat_max = ms;
+    lat->lat_hist[appl_lat_bkt(ms)]++;
+}
+
+
+/**
+zwhci_node_lat_get - Get the send data transmit completion latency of a node
+@param[in]	appl_ctx		Context
+@param[in]	node_id		    Node id
+@param[out]	lat		        The latency
+@param[in]	reset		    Flag to clear the histogram, the highest latency and the timeout count after reading
+                            them. The latency estimate is kept
+@return
+*/
+void    zwhci_node_lat_get(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, appl_node_lat_t *lat, int reset)
+{
+    appl_node_lat_t *node_lat;
+
+    memset(lat, 0, sizeof(appl_node_lat_t));
+
+    plt_mtx_lck(appl_ctx->snd_mtx);
+    if ((node_id > 0) && (node_id <= ZW_MAX_NODES))
+    {
+        node_lat = &appl_ctx->node_lat[node_id];
+        *lat = *node_lat;
+        if (reset)
+        {
+            node_lat->tmout = 0;
+            node_lat->lat_max = 0;
+            memset(node_lat->lat_hist, 0, sizeof(node_lat->lat_hist));
+        }
+    }
+    lat->cb_tmout_ms = appl_node_tmout(appl_ctx, node_id);
+    plt_mtx_ulck(appl_ctx->snd_mtx);
+}
+
+
+/**
+appl_snd_stat_upd - Update the send statistics
+@param[in]	appl_ctx		Context
+@param[in]	wait		    The waiting thread
+@param[in]	lat		        Wait time in milliseconds
+@param[in]	granted		    Flag to indicate the thread is allowed to send
+@return
+@pre    Caller must lock the snd_mtx
+*/
+static void    appl_snd_stat_upd(appl_layer_ctx_t   *appl_ctx, appl_snd_wait_t *wait, uint32_t lat, int granted)
+{
+    appl_snd_cls_stat_t *stat = &appl_ctx->snd_stat.cls[wait->cls];
+    appl_snd_wait_t     *other;
+
+    if (!granted)
+    {
+        stat->tmout++;
+        return;
+    }
+
+    stat->grant++;
+    if (lat > stat->lat_max)
+        stat->lat_max = lat;
+    stat->lat_hist[appl_lat_bkt(lat)]++;
+
+    //Check whether a command of a lower class is still waiting
+    for (other = appl_ctx->snd_wait_hd; other; other = other->next)
+    {
+        if (other->cls < wait->cls)
+        {
+            stat->aged++;
+            break;
+        }
+    }
+}
+
+
+/**
+appl_snd_is_next - Check whether a waiting thread is the next to send
+@param[in]	appl_ctx		Context
+@param[in]	wait		    The waiting thread
+@return  Non-zero if it is the next to send
+@pre    Caller must lock the snd_mtx
+*/
+static int    appl_snd_is_next(appl_layer_ctx_t   *appl_ctx, appl_snd_wait_t *wait)
+{
+    appl_snd_wait_t *other;
+    int             before = 1; //other arrived before wait
+
+    for (other = appl_ctx->snd_wait_hd; other; other = other->next)
+    {
+        if (other == wait)
+        {
+            before = 0;
+        }
+        else if ((other->key < wait->key) || (before && (other->key == wait->key)))
+        {
+            return 0;
+        }
+    }
+    return 1;
+}
+
+
+/**
+appl_snd_dat_slot - Get a free send data slot
+@param[in]	appl_ctx		Context
+@return  The free slot; NULL if all are in use
+@pre    Caller must lock the snd_mtx
+*/
+static appl_snd_dat_t    *appl_snd_dat_slot(appl_layer_ctx_t   *appl_ctx)
+{
+    int i;
+
+    for (i=0; i<APPL_SND_DAT_SLOT_CNT; i++)
+    {
+        if (appl_ctx->snd_dat[i].seq == 0)
+            return &appl_ctx->snd_dat[i];
+    }
+    return NULL;
+}
+
+
+/**
+appl_snd_ready - Check whether the controller is ready for a command
+@param[in]	appl_ctx		Context
+@param[in]	snd_dat		    Flag to indicate the command is a send data
+@return  Non-zero if ready
+@pre    Caller must lock the snd_mtx
+*/
+static int    appl_snd_ready(appl_layer_ctx_t   *appl_ctx, int snd_dat)
+{
+    int i;
+
+    if (appl_ctx->wait_nm_cb || appl_ctx->snd_busy)
+        return 0;
+
+    if (!snd_dat)
+    {   //Also wait for the transmissions past their learned timeout, the controller may still be sending them
+        for (i=0; i<APPL_SND_DAT_SLOT_CNT; i++)
+        {
+            if (appl_ctx->snd_dat[i].seq != 0)
+                return 0;
+        }
+        return 1;
+    }
+
+    return (appl_ctx->snd_dat_cnt < appl_ctx->snd_dat_lim) && appl_snd_dat_slot(appl_ctx);
+}
+
+
+/**
+appl_wait_to_snd_ex - Wait for the condition where sending of command is allowed
+@param[in]	appl_ctx		Context
+@param[in]	snd_dat		    Flag to indicate the command is a send data, which may be sent while
+                            less than snd_dat_lim send data transmissions are outstanding
 @return  1 on success, 0 on failure
 @post   If success, the caller is responsible to unlock the mutex "snd_mtx".
+@note   When several threads are waiting, the one with the smallest start time plus APPL_SND_AGE_MS per
+        send class goes first. Interactive commands overtake the others, yet a background command waits
+        at most 2 * APPL_SND_AGE_MS for the commands queued after it
 */
-static int32_t    appl_wait_to_snd(appl_layer_ctx_t   *appl_ctx)
+static int32_t    appl_wait_to_snd_ex(appl_layer_ctx_t   *appl_ctx, int snd_dat)
 {
-    int             ret;
+    appl_snd_wait_t wait;
+    appl_snd_wait_t **wait_pp;
+    uint64_t        now;
+    uint64_t        deadline;
+    int             granted;
+
+    wait.next = NULL;
+    wait.cls = zwhci_snd_cls_get();
 
     plt_mtx_lck(appl_ctx->snd_mtx);
-    ret = 0;
-    while ((appl_ctx->wait_cmd_cb || appl_ctx->wait_nm_cb)
-           && ret == 0)
-        ret = plt_cond_timedwait(appl_ctx->snd_cv, appl_ctx->snd_mtx, APPL_WAIT_SEND_TIMEOUT);
+    now = plt_mono_ms();
+    wait.start_ms = now;
+    wait.key = now + (wait.cls * APPL_SND_AGE_MS);
+
+    if (!appl_ctx->snd_wait_hd && appl_snd_ready(appl_ctx, snd_dat))
+    {   //Controller is free and no one is waiting
+        appl_snd_stat_upd(appl_ctx, &wait, 0, 1);
+        return 1;
+    }
 
-    if (ret == 1)
-    {   //Wait timeout
-        //debug_msg_show(appl_ctx->plt_ctx, "Cond wait timeout");
+    //Join the waiting list
+    for (wait_pp = &appl_ctx->snd_wait_hd; *wait_pp; wait_pp = &(*wait_pp)->next)
+        ;
+    *wait_pp = &wait;
+
+    deadline = now + APPL_WAIT_SEND_TIMEOUT;
+    while (1)
+    {
+        granted = appl_snd_ready(appl_ctx, snd_dat) && appl_snd_is_next(appl_ctx, &wait);
+        if (granted || (now >= deadline))
+            break;
+        plt_cond_timedwait(appl_ctx->snd_cv, appl_ctx->snd_mtx, (uint16_t)(deadline - now));
+        now = plt_mono_ms();
     }
 
-    if ((!appl_ctx->wait_cmd_cb) && (!appl_ctx->wait_nm_cb))
+    //Leave the waiting list and let the others check whether they are the next
+    for (wait_pp = &appl_ctx->snd_wait_hd; *wait_pp != &wait; wait_pp = &(*wait_pp)->next)
+        ;
+    *wait_pp = wait.next;
+    plt_cond_broadcast(appl_ctx->snd_cv);
+
+    appl_snd_stat_upd(appl_ctx, &wait, (uint32_t)(now - wait.start_ms), granted);
+
+    if (granted)
         return  1; //Wait success
 
     plt_mtx_ulck(appl_ctx->snd_mtx);
@@ -146,33 +500,201 @@ static int32_t    appl_wait_to_snd(appl_layer_ctx_t   *appl_ctx)
 
 
 /**
-appl_cb_tmout_cb - Timer callback when no callback received after sending a command.
-@param[in] data     Pointer to the appl_layer_ctx_t
+appl_wait_to_snd - Wait for the condition where sending of command other than send data is allowed
+@param[in]	appl_ctx		Context
+@return  1 on success, 0 on failure
+@post   If success, the caller is responsible to unlock the mutex "snd_mtx".
+*/
+static int32_t    appl_wait_to_snd(appl_layer_ctx_t   *appl_ctx)
+{
+    return appl_wait_to_snd_ex(appl_ctx, 0);
+}
+
+
+///
+/// Asynchronous query request
+typedef struct
+{
+    appl_layer_ctx_t    *appl_ctx;      ///< Context
+    union
+    {
+        failed_node_cb_t    failed_node;    ///< Is failed node callback
+        node_proto_cb_t     node_proto;     ///< Get node protocol info callback
+        rd_cmplt_cb_t       rd_cmplt;       ///< Read from NVMEM callback
+        rand_cb_t           rand;           ///< Get random word callback
+        init_dat_cb_t       init_dat;       ///< Get initialization data callback
+    } cb;                               ///< Completion callback of the query
+    void                *user_prm;      ///< User parameter of the completion callback
+    uint8_t             prm;            ///< Query parameter reported back in the completion callback
+} appl_qry_t;
+
+
+/**
+appl_qry_snd - Queue a query command and return without waiting for the response
+@param[in]	appl_ctx		Context
+@param[in]	cmd_prm		    The parameters of the command
+@param[in]	cmplt_cb		Session layer completion callback that reports the result to the query callback
+@param[in]	qry		        The query request allocated by malloc. It is freed on failure
+@return  0 on success, negative error number on failure
+*/
+static int32_t    appl_qry_snd(appl_layer_ctx_t   *appl_ctx, ssn_cmd_snd_param_t *cmd_prm,
+                               ssn_cmd_cmplt_t cmplt_cb, appl_qry_t *qry)
+{
+    int32_t result;
+
+    if (!appl_wait_to_snd(appl_ctx))
+    {
+        free(qry);
+        return  APPL_ERROR_WAIT_CB;
+    }
+
+    //The session layer keeps the order of the queued commands, no need to
+    //hold the snd_mtx until the response is received
+    result = ssn_cmd_snd_async(&appl_ctx->ssn_ctx, cmd_prm, cmplt_cb, qry, NULL);
+
+    plt_mtx_ulck(appl_ctx->snd_mtx);
+
+    if (result != 0)
+        free(qry);
+
+    return result;
+}
+
+
+/**
+appl_qry_alloc - Allocate an asynchronous query request
+@param[in]	appl_ctx		Context
+@param[in]	user_prm		User parameter of the completion callback
+@param[in]	prm		        Query parameter reported back in the completion callback
+@return  The query request on success; NULL on failure
+*/
+static appl_qry_t    *appl_qry_alloc(appl_layer_ctx_t   *appl_ctx, void *user_prm, uint8_t prm)
+{
+    appl_qry_t  *qry;
+
+    qry = (appl_qry_t *)malloc(sizeof(appl_qry_t));
+    if (qry)
+    {
+        qry->appl_ctx = appl_ctx;
+        qry->user_prm = user_prm;
+        qry->prm = prm;
+    }
+    return qry;
+}
+
+
+/**
+appl_snd_dat_rel - Release the window position of an outstanding send data transmission
+@param[in]	appl_ctx		Context
+@param[in]	slot		    The send data slot
+@return
+@pre    Caller must lock the snd_mtx
+*/
+static void    appl_snd_dat_rel(appl_layer_ctx_t   *appl_ctx, appl_snd_dat_t *slot)
+{
+    if (slot->pending)
+    {
+        slot->pending = 0;
+        appl_ctx->snd_dat_cnt--;
+
+        //Stop the timer and release timer resource
+        plt_tmr_stop(appl_ctx->plt_ctx, slot->tmr_ctx);
+        slot->tmr_ctx = NULL;
+
+        //Wake up any wait thread
+        plt_cond_broadcast(appl_ctx->snd_cv);
+    }
+}
+
+
+/**
+appl_cb_tmout_cb - Timer callback when no callback received after sending a send data.
+                   After the timeout learned for the node, the transmission stops holding the send data
+                   window but its callback is still delivered. It is reported as TRANSMIT_COMPLETE_NO_CB
+                   only after cb_tmout_ms.
+@param[in] data     Pointer to the appl_snd_dat_t
 @return
 */
 static void    appl_cb_tmout_cb(void *data)
 {
-    appl_layer_ctx_t    *appl_ctx = (appl_layer_ctx_t   *)data;
-    tx_cmplt_cb_t       cb;          //transmit completion status callback function
+    appl_snd_dat_t      *slot = (appl_snd_dat_t *)data;
+    appl_layer_ctx_t    *appl_ctx = slot->appl_ctx;
+    appl_snd_dat_t      *other;
+    tx_cmplt_cb_t       cb = NULL;   //transmit completion status callback function
     void                *usr_prm;    //transmit completion status callback user parameter
+    uint64_t            now;
+    uint64_t            start;
+    unsigned            i;
 
     //debug_msg_show(appl_ctx->plt_ctx, "appl_cb_tmout_cb: timeout");
 
     plt_mtx_lck(appl_ctx->snd_mtx);
 
-    //Release the waiting for callback flag
-    appl_ctx->wait_cmd_cb = 0;
+    now = plt_mono_ms();
 
-    //Stop the timer and release timer resource
-    plt_tmr_stop(appl_ctx->plt_ctx, appl_ctx->cb_tmr_ctx);
-    appl_ctx->cb_tmr_ctx = NULL;
+    //Ignore the timer of a slot that has been completed, reused or rearmed
+    if ((slot->seq != 0) && !slot->pending && (now >= slot->tmout_ms))
+    {   //No callback within cb_tmout_ms
+        plt_tmr_stop(appl_ctx->plt_ctx, slot->tmr_ctx);
+        slot->tmr_ctx = NULL;
+        appl_ctx->snd_dat_cmplt_ms = now;
 
-    //Save the callback function and parameter before releasing the lock
-    cb = appl_ctx->send_data_cb;
-    usr_prm = appl_ctx->snd_dat_cb_prm;
+        //Save the callback function and parameter before releasing the lock
+        cb = slot->cb;
+        usr_prm = slot->cb_prm;
 
-    //Wake up any wait thread
-    plt_cond_signal(appl_ctx->snd_cv);
+        //A late callback will not be reported
+        slot->seq = 0;
+        plt_cond_broadcast(appl_ctx->snd_cv);
+    }
+    else if (slot->pending && (now >= slot->tmout_ms))
+    {
+        //The controller transmits one frame at a time. The transmission starts when the controller accepts
+        //it or when the one before it completes, and has not started while an earlier one is outstanding
+        start = (appl_ctx->snd_dat_cmplt_ms > slot->start_ms)? appl_ctx->snd_dat_cmplt_ms : slot->start_ms;
+        for (i = 0; i < APPL_SND_DAT_SLOT_CNT; i++)
+        {
+            other = &appl_ctx->snd_dat[i];
+            if ((other != slot) && other->pending && ((int32_t)(other->seq - slot->seq) < 0))
+            {
+                start = now;
+                break;
+            }
+        }
+
+        slot->tmout_ms = start + appl_node_tmout(appl_ctx, slot->node_id);
+        if (now < slot->tmout_ms)
+        {   //Wait for the rest of the timeout
+            plt_tmr_stop(appl_ctx->plt_ctx, slot->tmr_ctx);
+            slot->tmr_ctx = plt_tmr_start(appl_ctx->plt_ctx, (uint32_t)(slot->tmout_ms - now), appl_cb_tmout_cb, slot);
+            plt_mtx_ulck(appl_ctx->snd_mtx);
+            return;
+        }
+
+        if (slot->node_id)
+        {
+            appl_ctx->node_lat[slot->node_id].tmout++;
+            if (appl_ctx->node_lat[slot->node_id].backoff < APPL_NODE_BACKOFF_MAX)
+                appl_ctx->node_lat[slot->node_id].backoff++;
+        }
+
+        //Let further send data go to the controller, e.g. a routed transmission may take several
+        //seconds. Keep the slot so that its callback is still reported
+        appl_snd_dat_rel(appl_ctx, slot);
+        slot->tmout_ms = slot->start_ms + appl_ctx->cb_tmout_ms;
+        if (now < slot->tmout_ms)
+        {
+            slot->tmr_ctx = plt_tmr_start(appl_ctx->plt_ctx, (uint32_t)(slot->tmout_ms - now), appl_cb_tmout_cb, slot);
+        }
+        if (!slot->tmr_ctx)
+        {   //Report now
+            appl_ctx->snd_dat_cmplt_ms = now;
+            cb = slot->cb;
+            usr_prm = slot->cb_prm;
+            slot->seq = 0;
+            plt_cond_broadcast(appl_ctx->snd_cv);
+        }
+    }
 
     plt_mtx_ulck(appl_ctx->snd_mtx);
     //Call the callback function
@@ -210,7 +732,7 @@ static void    appl_nm_sts_tmout_cb(void *data)
     usr_prm = appl_ctx->snd_dat_cb_prm;
 
     //Wake up any wait thread
-    plt_cond_signal(appl_ctx->snd_cv);
+    plt_cond_broadcast(appl_ctx->snd_cv);
 
     plt_mtx_ulck(appl_ctx->snd_mtx);
     //Call the callback function
@@ -280,28 +802,66 @@ int32_t    application_node_info(appl_layer_ctx_t   *appl_ctx, appl_node_info_t
 
 
 /**
-zw_nm_cb - zw_send_data callback for clearing the wait_cmd_cb flag
+zw_snd_dat_slot_get - Get the send data slot of a callback
+@param[in]	appl_ctx		Context
+@param[in]	param		    The parameters of the zw_send_data_cb callback
+@return  The slot; NULL if it has been completed
+@pre    Caller must lock the snd_mtx
+*/
+static appl_snd_dat_t    *zw_snd_dat_slot_get(appl_layer_ctx_t   *appl_ctx, void **param)
+{
+    appl_snd_dat_t  *slot = (appl_snd_dat_t *)param[0];
+
+    if ((slot >= appl_ctx->snd_dat) && (slot < appl_ctx->snd_dat + APPL_SND_DAT_SLOT_CNT)
+        && (slot->seq != 0) && (slot->seq == (uint32_t)(uintptr_t)param[1]))
+    {
+        return slot;
+    }
+    return NULL;
+}
+
+
+/**
+zw_nm_cb - Callback from the frame receiving thread for releasing the wait for network management
+           and send data callbacks
 @param[in]	ssn_ctx		Session layer context
 @param[in]	cmd_id		Command id
+@param[in]	param		The parameters of the command callback
 @return
 */
-static void    zw_nm_cb(struct _ssn_layer_ctx *ssn_ctx, uint8_t cmd_id)
+static void    zw_nm_cb(struct _ssn_layer_ctx *ssn_ctx, uint8_t cmd_id, void **param)
 {
     appl_layer_ctx_t    *appl_ctx = ssn_ctx->appl_layer_ctx;
+    appl_snd_dat_t      *slot;
+    uint64_t            now;
+    uint64_t            start;
 
     switch (cmd_id)
     {
         case FUNC_ID_ZW_SEND_DATA:
+        case FUNC_ID_ZW_SEND_DATA_MULTI:
+            //Free the window position now; the completion is reported by the callback thread
             plt_mtx_lck(appl_ctx->snd_mtx);
-            if (appl_ctx->wait_cmd_cb)
-            {   //Clear flag
-                appl_ctx->wait_cmd_cb = 0;
-                //Stop the timer and release timer resource
-                plt_tmr_stop(appl_ctx->plt_ctx, appl_ctx->cb_tmr_ctx);
-                appl_ctx->cb_tmr_ctx = NULL;
-
-                //Wake up any wait thread
-                plt_cond_signal(appl_ctx->snd_cv);
+            slot = zw_snd_dat_slot_get(appl_ctx, param);
+            if (slot)
+            {
+                //Learn the latency of the node from the start of its transmission, also from a callback
+                //that arrives after the learned timeout so that the timeout grows to cover it
+                now = plt_mono_ms();
+                start = (appl_ctx->snd_dat_cmplt_ms > slot->start_ms)? appl_ctx->snd_dat_cmplt_ms : slot->start_ms;
+                if (slot->node_id)
+                    appl_node_lat_upd(appl_ctx, slot->node_id, (now > start)? (uint32_t)(now - start) : 0);
+                appl_ctx->snd_dat_cmplt_ms = now;
+            }
+            if (slot && slot->pending)
+            {
+                appl_snd_dat_rel(appl_ctx, slot);
+                if ((appl_ctx->snd_dat_lim < appl_ctx->snd_dat_win)
+                    && (++appl_ctx->snd_dat_ok >= (APPL_SND_DAT_GROW * appl_ctx->snd_dat_lim)))
+                {   //Probe whether the controller accepts one more transmission
+                    appl_ctx->snd_dat_lim++;
+                    appl_ctx->snd_dat_ok = 0;
+                }
             }
             plt_mtx_ulck(appl_ctx->snd_mtx);
             break;
@@ -318,38 +878,172 @@ static void    zw_nm_cb(struct _ssn_layer_ctx *ssn_ctx, uint8_t cmd_id)
                 plt_tmr_stop(appl_ctx->plt_ctx, appl_ctx->cb_tmr_ctx);
                 appl_ctx->cb_tmr_ctx = NULL;
 
-                //Wake up any wait thread
-                plt_cond_signal(appl_ctx->snd_cv);
+                //Wake up any wait thread
+                plt_cond_broadcast(appl_ctx->snd_cv);
+
+            }
+            plt_mtx_ulck(appl_ctx->snd_mtx);
+            break;
+
+    }
+
+}
+
+
+/**
+zw_send_data_cb - call back high-level application layer to report transmit completion status
+@param[in]	ssn_ctx		Session layer context
+@param[in]	cmd		    The received callback command
+@param[in]	param		User defined parameters for the callback
+@return
+*/
+static void    zw_send_data_cb(struct _ssn_layer_ctx *ssn_ctx, ssn_cmd_resp_t *cmd, void **param)
+{
+    appl_layer_ctx_t    *appl_ctx = ssn_ctx->appl_layer_ctx;
+    appl_snd_dat_t      *slot;
+    tx_cmplt_cb_t       cb = NULL;   //transmit completion status callback function
+    void                *usr_prm;    //transmit completion status callback user parameter
+    //ZW->HOST: REQ | 0x13 or 0x14 | funcID | txStatus
+
+    plt_mtx_lck(appl_ctx->snd_mtx);
+    slot = zw_snd_dat_slot_get(appl_ctx, param);
+    if (slot)
+    {
+        appl_snd_dat_rel(appl_ctx, slot);
+
+        //Stop the timer of a transmission past its learned timeout
+        plt_tmr_stop(appl_ctx->plt_ctx, slot->tmr_ctx);
+        slot->tmr_ctx = NULL;
+
+        //Save the callback function before releasing the lock
+        cb = slot->cb;
+        usr_prm = slot->cb_prm;
+        slot->seq = 0;
+        plt_cond_broadcast(appl_ctx->snd_cv);
+    }
+    plt_mtx_ulck(appl_ctx->snd_mtx);
+
+    if (cmd->len >= 2 && cb)
+    {
+        cb(appl_ctx, cmd->dat_buf[1], usr_prm);
+    }
+}
+
+
+/**
+appl_snd_dat_tx - Send a send data or send data multi command in a slot of the send data window
+@param[in]	appl_ctx		Context
+@param[in]	cmd_prm         The command parameters
+@param[in]	node_id         Destination node for the callback timeout; zero for multicast and broadcast
+@param[in]	cb              The callback function on transmit completion
+@param[in]	cb_prm          The parameter to be passed when invoking cb callback function
+@return  0 on success, negative error number on failure
+*/
+static int32_t    appl_snd_dat_tx(appl_layer_ctx_t   *appl_ctx, ssn_cmd_snd_param_t *cmd_prm, uint8_t node_id,
+                                  tx_cmplt_cb_t cb, void *cb_prm)
+{
+    int32_t                 result;
+    ssn_cmd_resp_t          *resp;
+    appl_snd_dat_t          *slot;
+    uint32_t                seq;
+    uint32_t                tmout;
+    int                     retry;
+
+    if (node_id > ZW_MAX_NODES)
+        node_id = 0;
+
+    cmd_prm->cmd_flag = COMMAND_HAS_CALLBACK | COMMAND_HAS_RESPONSE;
+    cmd_prm->cmd_cb_func = zw_send_data_cb;
+
+    for (retry = 0; ; retry++)
+    {
+        if (!appl_wait_to_snd_ex(appl_ctx, 1))
+        {
+            result = APPL_ERROR_WAIT_CB;
+            break;
+        }
+
+        //Reserve a slot for the transmit completion status
+        slot = appl_snd_dat_slot(appl_ctx);
+        if (++appl_ctx->snd_dat_seq == 0)
+            ++appl_ctx->snd_dat_seq;
+        seq = appl_ctx->snd_dat_seq;
+        slot->appl_ctx = appl_ctx;
+        slot->cb = cb;
+        slot->cb_prm = cb_prm;
+        slot->tmr_ctx = NULL;
+        slot->start_ms = plt_mono_ms();
+        slot->node_id = node_id;
+        slot->seq = seq;
+        slot->pending = 1;
+        if (++appl_ctx->snd_dat_cnt > appl_ctx->snd_stat.snd_dat_max)
+            appl_ctx->snd_stat.snd_dat_max = appl_ctx->snd_dat_cnt;
+
+        //The callback finds the slot through the callback parameters
+        cmd_prm->cmd_cb_prm[0] = slot;
+        cmd_prm->cmd_cb_prm[1] = (void *)(uintptr_t)seq;
+
+        //Release the lock while waiting for the response so that the completion of the
+        //other outstanding transmissions can be processed
+        appl_ctx->snd_busy = 1;
+        plt_mtx_ulck(appl_ctx->snd_mtx);
+
+        result = ssn_cmd_snd(&appl_ctx->ssn_ctx, cmd_prm, &resp);
+        if (result == 0)
+        {
+            if (resp)
+            {   //ZW->HOST: RES | 0x13 or 0x14 | RetVal
+                if (resp->dat_buf[0] == 0)
+                    result = APPL_TX_Q_OVERFLOW;
+                free(resp);
+            }
+        }
+
+        plt_mtx_lck(appl_ctx->snd_mtx);
+        appl_ctx->snd_busy = 0;
+        plt_cond_broadcast(appl_ctx->snd_cv);
 
+        if (result == 0)
+        {
+            if ((slot->seq == seq) && slot->pending)
+            {   // Start the callback timer, learned from the earlier transmissions to the node
+                tmout = appl_node_tmout(appl_ctx, node_id);
+                slot->start_ms = plt_mono_ms();
+                slot->tmout_ms = slot->start_ms + tmout;
+                slot->tmr_ctx = plt_tmr_start(appl_ctx->plt_ctx, tmout, appl_cb_tmout_cb, slot);
+
+                if (!slot->tmr_ctx)
+                {   //timer not working
+                    debug_msg_show(appl_ctx->plt_ctx, "Error: appl callback timer not working");
+                }
             }
             plt_mtx_ulck(appl_ctx->snd_mtx);
             break;
+        }
 
-    }
-
-}
-
-
-/**
-zw_send_data_cb - call back high-level application layer to report transmit completion status
-@param[in]	ssn_ctx		Session layer context
-@param[in]	cmd		    The received callback command
-@param[in]	param		User defined parameters for the callback
-@return
-*/
-static void    zw_send_data_cb(struct _ssn_layer_ctx *ssn_ctx, ssn_cmd_resp_t *cmd, void **param)
-{
-    appl_layer_ctx_t    *appl_ctx = ssn_ctx->appl_layer_ctx;
-    tx_cmplt_cb_t       cb;          //transmit completion status callback function
-    //ZW->HOST: REQ | 0x13 | funcID | txStatus
-
-    //Save the callback function before releasing the lock
-    cb = (tx_cmplt_cb_t) param[0];
+        //Failed, no callback to wait for
+        if (slot->seq == seq)
+        {
+            appl_snd_dat_rel(appl_ctx, slot);
+            slot->seq = 0;
+        }
 
-    if (cmd->len >= 2 && cb)
-    {
-        cb(appl_ctx, cmd->dat_buf[1], param[1]);
+        if (result == APPL_TX_Q_OVERFLOW)
+        {
+            appl_ctx->snd_stat.tx_q_ovf++;
+            if ((retry == 0) && (appl_ctx->snd_dat_cnt > 0))
+            {   //Shrink the window to what the controller accepts and retry after a transmission completes
+                appl_ctx->snd_dat_lim = appl_ctx->snd_dat_cnt;
+                appl_ctx->snd_dat_ok = 0;
+                plt_mtx_ulck(appl_ctx->snd_mtx);
+                continue;
+            }
+        }
+        plt_mtx_ulck(appl_ctx->snd_mtx);
+        break;
     }
+
+    return result;
 }
 
 
@@ -365,7 +1059,6 @@ int32_t    zw_send_data(appl_layer_ctx_t   *appl_ctx, appl_snd_data_t  *prm, tx_
 {
     int32_t                 result;
     ssn_cmd_snd_param_t     *cmd_prm;
-    ssn_cmd_resp_t          *resp;
     uint8_t                 prm_len;    //the length of the parameters
 
     /*
@@ -375,16 +1068,12 @@ int32_t    zw_send_data(appl_layer_ctx_t   *appl_ctx, appl_snd_data_t  *prm, tx_
     before completeFunc callback is received because its only the pointer there is passed to the transmit
     queue.
     */
-    if (!appl_wait_to_snd(appl_ctx))
-        return  APPL_ERROR_WAIT_CB;
-
     prm_len = 3 + prm->dat_len;//total data length excluding function id
 
     cmd_prm = (ssn_cmd_snd_param_t *)calloc(1, sizeof(ssn_cmd_snd_param_t) + prm_len);
 
     if (!cmd_prm)
     {
-        plt_mtx_ulck(appl_ctx->snd_mtx);
         return  ZWHCI_ERROR_MEMORY;
     }
 
@@ -395,46 +1084,61 @@ int32_t    zw_send_data(appl_layer_ctx_t   *appl_ctx, appl_snd_data_t  *prm, tx_
     cmd_prm->dat_buf[1] = prm->dat_len;
     memcpy(cmd_prm->dat_buf + 2, prm->dat_buf, prm->dat_len);
     cmd_prm->dat_buf[2 + prm->dat_len] = prm->tx_opt;
-    cmd_prm->cmd_flag = COMMAND_HAS_CALLBACK | COMMAND_HAS_RESPONSE;
-    cmd_prm->cmd_cb_func = zw_send_data_cb;
-    //Save the pointer to callback function and the callback parameter
-    cmd_prm->cmd_cb_prm[0] = cb;
-    cmd_prm->cmd_cb_prm[1] = cb_prm;
-    appl_ctx->send_data_cb = cb;
-    appl_ctx->snd_dat_cb_prm = cb_prm;
 
-    /*printf("\n=========before ssn_cmd_snd, start, len:%d =================\n",cmd_prm->dat_sz);
-    int y = 0;
-    for(y= 0;y<cmd_prm->dat_sz;y++)
+    result = appl_snd_dat_tx(appl_ctx, cmd_prm, prm->node_id, cb, cb_prm);
+
+    free(cmd_prm);
+    return result;
+}
+
+
+/**
+zw_send_data_multi - Send data to a list of nodes in one multicast frame
+@param[in]	appl_ctx		Context
+@param[in]	prm             The parameters
+@param[in]	cb              The callback function on transmit completion
+@param[in]	cb_prm          The parameter to be passed when invoking cb callback function
+@return  0 on success, negative error number on failure
+@note   Multicast frames are not acknowledged, the transmit status only tells whether the frame was sent.
+        Unless TRANSMIT_OPTION_ACK is set, the caller has to send singlecast follow-ups to confirm delivery.
+*/
+int32_t    zw_send_data_multi(appl_layer_ctx_t   *appl_ctx, appl_snd_data_multi_t  *prm, tx_cmplt_cb_t cb, void *cb_prm)
+{
+    int32_t                 result;
+    ssn_cmd_snd_param_t     *cmd_prm;
+    unsigned                prm_len;    //the length of the parameters
+
+    if ((prm->nodes_num == 0) || (prm->nodes_num > APPL_SND_MULTI_NODE_MAX))
     {
-        printf(" (%02x) ",cmd_prm->dat_buf[y]);
+        return ZWHCI_ERROR_INVALID_VALUE;
     }
-    printf("\n===================before ssn_cmd_snd end======================\n");*/
-    result = ssn_cmd_snd(&appl_ctx->ssn_ctx, cmd_prm, &resp);
-    if (result == 0)
+
+    prm_len = 3 + prm->nodes_num + prm->dat_len;//total data length excluding function id
+
+    //The function id and the frame header must also fit in the one byte frame length
+    if ((prm_len + 1 + FRAME_HEADER_LEN) > 0xFF)
     {
-        if (resp)
-        {   //ZW->HOST: RES | 0x13 | RetVal
-            if (resp->dat_buf[0] == 0)
-                result = APPL_TX_Q_OVERFLOW;
-            free(resp);
-        }
+        return ZWHCI_ERROR_INVALID_VALUE;
     }
 
-    if (result == 0)
-    {   //Set flag to indicate waiting for callback to prevent the next command from sending
-        appl_ctx->wait_cmd_cb = 1;
-        // Start the callback timer
-        appl_ctx->cb_tmr_ctx = plt_tmr_start(appl_ctx->plt_ctx, appl_ctx->cb_tmout_ms, appl_cb_tmout_cb, appl_ctx);
-
-        if (!appl_ctx->cb_tmr_ctx)
-        {   //timer not working
-            debug_msg_show(appl_ctx->plt_ctx, "Error: appl callback timer not working");
-        }
+    cmd_prm = (ssn_cmd_snd_param_t *)calloc(1, sizeof(ssn_cmd_snd_param_t) + prm_len);
 
+    if (!cmd_prm)
+    {
+        return  ZWHCI_ERROR_MEMORY;
     }
 
-    plt_mtx_ulck(appl_ctx->snd_mtx);
+    cmd_prm->cmd_id = FUNC_ID_ZW_SEND_DATA_MULTI;
+    cmd_prm->dat_sz = (uint8_t)prm_len;
+    //HOST->ZW: REQ | 0x14 | numberNodes | pNodeIDList[ ] | dataLength | pData[ ] | txOptions | funcID
+    cmd_prm->dat_buf[0] = prm->nodes_num;
+    memcpy(cmd_prm->dat_buf + 1, prm->nodes, prm->nodes_num);
+    cmd_prm->dat_buf[1 + prm->nodes_num] = prm->dat_len;
+    memcpy(cmd_prm->dat_buf + 2 + prm->nodes_num, prm->dat_buf, prm->dat_len);
+    cmd_prm->dat_buf[2 + prm->nodes_num + prm->dat_len] = prm->tx_opt;
+
+    //The multicast frame takes a place in the send data window like a singlecast frame
+    result = appl_snd_dat_tx(appl_ctx, cmd_prm, 0, cb, cb_prm);
 
     free(cmd_prm);
     return result;
@@ -1069,6 +1773,67 @@ int32_t    zw_is_failed_node(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, uint
 }
 
 
+/**
+zw_is_failed_node_cmplt - zw_is_failed_node_async completion callback
+@param[in]	ssn_ctx		Session layer context
+@param[in]	result		Result of the command
+@param[in]	cmd_resp	The response
+@param[in]	user		The query request
+@return
+*/
+static void    zw_is_failed_node_cmplt(struct _ssn_layer_ctx *ssn_ctx, int32_t result, ssn_cmd_resp_t *cmd_resp, void *user)
+{
+    appl_qry_t  *qry = (appl_qry_t *)user;
+    uint8_t     res = 0;
+
+    if (result == 0)
+    {
+        if (cmd_resp->len >= 1)
+        {   //ZW->HOST: RES | 0x62 | retVal
+            res = cmd_resp->dat_buf[0];
+        }
+        else
+        {
+            result = SESSION_ERROR_INVALID_RESP;
+        }
+        free(cmd_resp);
+    }
+
+    qry->cb.failed_node(qry->appl_ctx, result, qry->prm, res, qry->user_prm);
+    free(qry);
+}
+
+
+/**
+zw_is_failed_node_async - Test if a node ID is stored in the failed node ID list without waiting for the response.
+@param[in]	appl_ctx		Context
+@param[in]	node_id		    Node ID to be checked
+@param[in]	cb              The callback function to report the result.
+@param[in]	user_prm        The callback function parameter.
+@return  0 on command queued successfully, negative error number on failure
+@post   The callback is called from the session layer callback thread only if 0 is returned.
+*/
+int32_t    zw_is_failed_node_async(appl_layer_ctx_t   *appl_ctx, uint8_t node_id, failed_node_cb_t cb, void *user_prm)
+{
+    ssn_cmd_snd_param_t     cmd_prm;
+    appl_qry_t              *qry;
+
+    qry = appl_qry_alloc(appl_ctx, user_prm, node_id);
+    if (!qry)
+        return  ZWHCI_ERROR_MEMORY;
+    qry->cb.failed_node = cb;
+
+    memset(&cmd_prm, 0, sizeof(ssn_cmd_snd_param_t));
+    //HOST->ZW: REQ | 0x62 | nodeID
+    cmd_prm.cmd_id = FUNC_ID_ZW_IS_FAILED_NODE_ID;
+    cmd_prm.cmd_flag = COMMAND_HAS_RESPONSE;
+    cmd_prm.dat_sz = 1;
+    cmd_prm.dat_buf[0] = node_id;
+
+    return appl_qry_snd(appl_ctx, &cmd_prm, zw_is_failed_node_cmplt, qry);
+}
+
+
 /**
 zw_remove_failed_node_id - Remove a non-responding node from the routing table in the requesting controller.
 @param[in]	appl_ctx		Context
@@ -1868,6 +2633,68 @@ int32_t    zw_memory_get_buffer(appl_layer_ctx_t   *appl_ctx, uint8_t  *buf,
     return result;
 }
 
+/**
+zw_memory_get_buffer_cmplt - zw_memory_get_buffer_async completion callback
+@param[in]	ssn_ctx		Session layer context
+@param[in]	result		Result of the command
+@param[in]	cmd_resp	The response
+@param[in]	user		The query request
+@return
+*/
+static void    zw_memory_get_buffer_cmplt(struct _ssn_layer_ctx *ssn_ctx, int32_t result, ssn_cmd_resp_t *cmd_resp, void *user)
+{
+    appl_qry_t  *qry = (appl_qry_t *)user;
+
+    if (result == 0)
+    {   //ZW->HOST: RES | 0x23 | buffer[]
+        qry->cb.rd_cmplt(qry->appl_ctx, 0, cmd_resp->dat_buf,
+                         (cmd_resp->len < qry->prm)? cmd_resp->len : qry->prm, qry->user_prm);
+        free(cmd_resp);
+    }
+    else
+    {
+        qry->cb.rd_cmplt(qry->appl_ctx, result, NULL, 0, qry->user_prm);
+    }
+    free(qry);
+}
+
+
+/**
+zw_memory_get_buffer_async - Read a number of bytes from the non-volatile memory allocated for the application
+                             without waiting for the response.
+@param[in]	appl_ctx		Context
+@param[in]	ofs             Offset from the non-volatile memory (allocated for the application) to read
+@param[in]	len             Length of the data to read
+@param[in]	cb              The callback function to report the read data.
+@param[in]	user_prm        The callback function parameter.
+@return  0 on command queued successfully, negative error number on failure
+@post   The callback is called from the session layer callback thread only if 0 is returned.
+*/
+int32_t    zw_memory_get_buffer_async(appl_layer_ctx_t   *appl_ctx, uint16_t ofs, uint8_t len,
+                                      rd_cmplt_cb_t cb, void *user_prm)
+{
+    ssn_cmd_snd_param_t     *cmd_prm;
+    appl_qry_t              *qry;
+    uint8_t                 buf[sizeof(ssn_cmd_snd_param_t) + 3];
+
+    qry = appl_qry_alloc(appl_ctx, user_prm, len);
+    if (!qry)
+        return  ZWHCI_ERROR_MEMORY;
+    qry->cb.rd_cmplt = cb;
+
+    //HOST->ZW: REQ | 0x23 | offset(2 bytes) | length
+    cmd_prm = (ssn_cmd_snd_param_t *)buf;
+    memset(buf, 0, sizeof(buf));
+    cmd_prm->cmd_id = FUNC_ID_MEMORY_GET_BUFFER;
+    cmd_prm->cmd_flag = COMMAND_HAS_RESPONSE;
+    cmd_prm->dat_sz = 3;
+    cmd_prm->dat_buf[0] = (uint8_t)(ofs >> 8);
+    cmd_prm->dat_buf[1] = (uint8_t)(ofs & 0x00FF);
+    cmd_prm->dat_buf[2] = len;
+
+    return appl_qry_snd(appl_ctx, cmd_prm, zw_memory_get_buffer_cmplt, qry);
+}
+
 /**
 zw_memory_put_buffer - Write to the application area of the non-volatile memory.
 @param[in]	appl_ctx		Context
@@ -1976,6 +2803,34 @@ int32_t    zw_serial_api_capabilities(appl_layer_ctx_t   *appl_ctx, appl_hci_cap
 }
 
 
+/**
+zw_init_data_parse - Parse the response of FUNC_ID_SERIAL_API_GET_INIT_DATA
+@param[in]	resp		    The response
+@param[out]	init_data       The initialization data stored.
+@return  0 on success, negative error number on failure
+*/
+static int32_t    zw_init_data_parse(ssn_cmd_resp_t *resp, appl_init_dat_t  *init_data)
+{
+    uint8_t     nodes_len;
+    //(Controller) ZW->HOST: RES | 0x02 | ver | capabilities | 29 | nodes[29] | chip_type | chip_version
+    //(Slave) ZW->HOST:      RES | 0x02 | ver | capabilities | 0 | chip_type | chip_version
+    if ((resp->len < 5) || (resp->len < 5 + resp->dat_buf[2]))
+        return SESSION_ERROR_INVALID_RESP;
+
+    init_data->version = resp->dat_buf[0];
+    init_data->cap = resp->dat_buf[1];
+    //Copy no more than the node bitmask in the response (none for slave)
+    nodes_len = (resp->dat_buf[2] < 29)? resp->dat_buf[2] : 29;
+    memcpy(init_data->nodes, resp->dat_buf + 3, nodes_len);
+    memset(init_data->nodes + nodes_len, 0, 29 - nodes_len);
+
+    init_data->chip_typ = resp->dat_buf[3 + resp->dat_buf[2]];
+    init_data->chip_ver = resp->dat_buf[4 + resp->dat_buf[2]];
+
+    return 0;
+}
+
+
 /**
 zw_serial_api_get_init_data - Get the initialization data stored.
 @param[in]	appl_ctx		Context
@@ -1990,7 +2845,7 @@ int32_t    zw_serial_api_get_init_data(appl_layer_ctx_t   *appl_ctx, appl_init_d
 
 #ifdef DEBUG_SERIAL_API
     debug_msg_show(appl_ctx->plt_ctx, "*************************");
-    debug_msg_show(appl_ctx->plt_ctx, "Num of NAK=%u, CAN=%u", appl_ctx->ssn_ctx.frm_ctx.nak_cnt, appl_ctx->ssn_ctx.frm_ctx.can_cnt);
+    debug_msg_show(appl_ctx->plt_ctx, "Num of NAK=%u, CAN=%u", appl_ctx->ssn_ctx.frm_ctx.stat.nak_rx, appl_ctx->ssn_ctx.frm_ctx.stat.can_rx);
 #endif
     if (!appl_wait_to_snd(appl_ctx))
         return  APPL_ERROR_WAIT_CB;
@@ -2001,29 +2856,64 @@ int32_t    zw_serial_api_get_init_data(appl_layer_ctx_t   *appl_ctx, appl_init_d
     cmd_prm.cmd_flag = COMMAND_HAS_RESPONSE;
 
     result = ssn_cmd_snd(&appl_ctx->ssn_ctx, &cmd_prm, &resp);
-    if (result == 0 && resp->len >= 3)
+    if (result == 0)
     {
-        if (resp)
-        {   //(Controller) ZW->HOST: RES | 0x02 | ver | capabilities | 29 | nodes[29] | chip_type | chip_version
-            //(Slave) ZW->HOST:      RES | 0x02 | ver | capabilities | 0 | chip_type | chip_version
+        result = zw_init_data_parse(resp, init_data);
+        free(resp);
+    }
+    plt_mtx_ulck(appl_ctx->snd_mtx);
 
+    return result;
+}
 
-            init_data->version = resp->dat_buf[0];
-            init_data->cap = resp->dat_buf[1];
-            if (resp->dat_buf[2] > 0)
-                memcpy(init_data->nodes, resp->dat_buf + 3, 29);//controller
-            else
-                memset(init_data->nodes, 0, 29);//slave
 
-            init_data->chip_typ = resp->dat_buf[3 + resp->dat_buf[2]];
-            init_data->chip_ver = resp->dat_buf[4 + resp->dat_buf[2]];
+/**
+zw_serial_api_get_init_data_cmplt - zw_serial_api_get_init_data_async completion callback
+@param[in]	ssn_ctx		Session layer context
+@param[in]	result		Result of the command
+@param[in]	cmd_resp	The response
+@param[in]	user		The query request
+@return
+*/
+static void    zw_serial_api_get_init_data_cmplt(struct _ssn_layer_ctx *ssn_ctx, int32_t result, ssn_cmd_resp_t *cmd_resp, void *user)
+{
+    appl_qry_t      *qry = (appl_qry_t *)user;
+    appl_init_dat_t init_data;
 
-            free(resp);
-        }
+    if (result == 0)
+    {
+        result = zw_init_data_parse(cmd_resp, &init_data);
+        free(cmd_resp);
     }
-    plt_mtx_ulck(appl_ctx->snd_mtx);
 
-    return result;
+    qry->cb.init_dat(qry->appl_ctx, result, (result == 0)? &init_data : NULL, qry->user_prm);
+    free(qry);
+}
+
+
+/**
+zw_serial_api_get_init_data_async - Get the initialization data stored without waiting for the response.
+@param[in]	appl_ctx		Context
+@param[in]	cb              The callback function to report the initialization data.
+@param[in]	user_prm        The callback function parameter.
+@return  0 on command queued successfully, negative error number on failure
+@post   The callback is called from the session layer callback thread only if 0 is returned.
+*/
+int32_t    zw_serial_api_get_init_data_async(appl_layer_ctx_t   *appl_ctx, init_dat_cb_t cb, void *user_prm)
+{
+    ssn_cmd_snd_param_t     cmd_prm;
+    appl_qry_t              *qry;
+
+    qry = appl_qry_alloc(appl_ctx, user_prm, 0);
+    if (!qry)
+        return  ZWHCI_ERROR_MEMORY;
+    qry->cb.init_dat = cb;
+
+    memset(&cmd_prm, 0, sizeof(ssn_cmd_snd_param_t));
+    cmd_prm.cmd_id = FUNC_ID_SERIAL_API_GET_INIT_DATA;
+    cmd_prm.cmd_flag = COMMAND_HAS_RESPONSE;
+
+    return appl_qry_snd(appl_ctx, &cmd_prm, zw_serial_api_get_init_data_cmplt, qry);
 }
 
 /**
@@ -2068,6 +2958,65 @@ int32_t    zw_get_node_protocol_info(appl_layer_ctx_t   *appl_ctx,
     return result;
 }
 
+/**
+zw_get_node_protocol_info_cmplt - zw_get_node_protocol_info_async completion callback
+@param[in]	ssn_ctx		Session layer context
+@param[in]	result		Result of the command
+@param[in]	cmd_resp	The response
+@param[in]	user		The query request
+@return
+*/
+static void    zw_get_node_protocol_info_cmplt(struct _ssn_layer_ctx *ssn_ctx, int32_t result, ssn_cmd_resp_t *cmd_resp, void *user)
+{
+    appl_qry_t  *qry = (appl_qry_t *)user;
+    uint8_t     node_info[6];
+
+    if (result == 0)
+    {
+        //ZW->HOST: RES | 0x41 | capability | security | reserved | basic | generic | specific
+        if (cmd_resp->len >= sizeof(node_info))
+            memcpy(node_info, cmd_resp->dat_buf, sizeof(node_info));
+        else
+            result = SESSION_ERROR_INVALID_RESP;
+        free(cmd_resp);
+    }
+
+    qry->cb.node_proto(qry->appl_ctx, result, qry->prm, (result == 0)? node_info : NULL, qry->user_prm);
+    free(qry);
+}
+
+
+/**
+zw_get_node_protocol_info_async - Get the Node Information Frame without command classes from the
+                                  non-volatile memory for a given node ID without waiting for the response.
+@param[in]	appl_ctx		Context
+@param[in]	node_id		    Node id
+@param[in]	cb              The callback function to report the node info frame.
+@param[in]	user_prm        The callback function parameter.
+@return  0 on command queued successfully, negative error number on failure
+@post   The callback is called from the session layer callback thread only if 0 is returned.
+*/
+int32_t    zw_get_node_protocol_info_async(appl_layer_ctx_t   *appl_ctx, uint8_t  node_id,
+                                           node_proto_cb_t cb, void *user_prm)
+{
+    ssn_cmd_snd_param_t     cmd_prm;
+    appl_qry_t              *qry;
+
+    qry = appl_qry_alloc(appl_ctx, user_prm, node_id);
+    if (!qry)
+        return  ZWHCI_ERROR_MEMORY;
+    qry->cb.node_proto = cb;
+
+    memset(&cmd_prm, 0, sizeof(ssn_cmd_snd_param_t));
+    //HOST->ZW: REQ | 0x41 | bNodeID
+    cmd_prm.cmd_id = FUNC_ID_ZW_GET_NODE_PROTOCOL_INFO;
+    cmd_prm.cmd_flag = COMMAND_HAS_RESPONSE;
+    cmd_prm.dat_sz = 1;
+    cmd_prm.dat_buf[0] = node_id;
+
+    return appl_qry_snd(appl_ctx, &cmd_prm, zw_get_node_protocol_info_cmplt, qry);
+}
+
 /**
 zw_get_rf_powerlevel - Get the current power level used in RF transmitting.
 @param[in]	appl_ctx		Context
@@ -2340,6 +3289,70 @@ int32_t    zw_get_random_word(appl_layer_ctx_t   *appl_ctx,
 }
 
 
+/**
+zw_get_random_word_cmplt - zw_get_random_word_async completion callback
+@param[in]	ssn_ctx		Session layer context
+@param[in]	result		Result of the command
+@param[in]	cmd_resp	The response
+@param[in]	user		The query request
+@return
+*/
+static void    zw_get_random_word_cmplt(struct _ssn_layer_ctx *ssn_ctx, int32_t result, ssn_cmd_resp_t *cmd_resp, void *user)
+{
+    appl_qry_t  *qry = (appl_qry_t *)user;
+    uint8_t     count = 0;
+
+    if (result == 0)
+    {
+        //ZW->HOST: RES | 0x1C | randomGenerationSuccess | noRandomBytesGenerated |
+        //noRandomGenerated[noRandomBytesGenerated]
+        if ((cmd_resp->len >= 2) && (cmd_resp->dat_buf[0] == TRUE))
+        {
+            count = cmd_resp->dat_buf[1];
+            if (count > cmd_resp->len - 2)
+                count = cmd_resp->len - 2;
+        }
+        qry->cb.rand(qry->appl_ctx, 0, cmd_resp->dat_buf + 2, count, qry->user_prm);
+        free(cmd_resp);
+    }
+    else
+    {
+        qry->cb.rand(qry->appl_ctx, result, NULL, 0, qry->user_prm);
+    }
+    free(qry);
+}
+
+
+/**
+zw_get_random_word_async - Generate random words without waiting for the response
+@param[in]	    appl_ctx		Context
+@param[in]	    count		    Number of random bytes required
+@param[in]	    cb              The callback function to report the generated random bytes.
+@param[in]	    user_prm        The callback function parameter.
+@return  0 on command queued successfully, negative error number on failure
+@post   The callback is called from the session layer callback thread only if 0 is returned.
+*/
+int32_t    zw_get_random_word_async(appl_layer_ctx_t   *appl_ctx, uint8_t count, rand_cb_t cb, void *user_prm)
+{
+    ssn_cmd_snd_param_t     cmd_prm;
+    appl_qry_t              *qry;
+
+    qry = appl_qry_alloc(appl_ctx, user_prm, count);
+    if (!qry)
+        return  ZWHCI_ERROR_MEMORY;
+    qry->cb.rand = cb;
+
+    memset(&cmd_prm, 0, sizeof(ssn_cmd_snd_param_t));
+    //HOST->ZW: REQ | 0x1C | [noRandomBytes]
+    cmd_prm.cmd_id = FUNC_ID_ZW_GET_RANDOM;
+    cmd_prm.cmd_flag = COMMAND_HAS_RESPONSE;
+    cmd_prm.dat_sz = 1;
+    cmd_prm.dat_buf[0] = count;
+
+    return appl_qry_snd(appl_ctx, &cmd_prm, zw_get_random_word_cmplt, qry);
+}
+
+
 /**
 zw_soft_reset - Software reset Z-Wave module.
 @param[in]	appl_ctx		Context
@@ -2513,9 +3526,14 @@ int32_t zwhci_init(appl_layer_ctx_t   *appl_ctx, void   *comm_port_id)
 
     //Save the comm port id
     appl_ctx->ssn_ctx.frm_ctx.tpt_ctx.comm_port_id = comm_port_id;
+#ifdef OS_LINUX
+    appl_ctx->ssn_ctx.frm_ctx.tpt_ctx.cap_file = appl_ctx->cap_file;
+#endif
 
     //Init session layer
     appl_ctx->ssn_ctx.unsolicited_cmd_cb = appl_unsolicited_cmd_cb;
+    appl_ctx->ssn_ctx.shard_key = appl_shard_key;
+    appl_ctx->ssn_ctx.cb_wkr_cnt = appl_ctx->cb_wkr_cnt;
     appl_ctx->ssn_ctx.resp_tmout_ms = SESSION_RESPONSE_TIMEOUT_MIN;
     appl_ctx->ssn_ctx.appl_layer_ctx = appl_ctx;
     appl_ctx->ssn_ctx.nm_cb = zw_nm_cb;
@@ -2527,8 +3545,20 @@ int32_t zwhci_init(appl_layer_ctx_t   *appl_ctx, void   *comm_port_id)
         return ret_val;
 
     //Init application layer
-    appl_ctx->wait_cmd_cb = 0;
     appl_ctx->wait_nm_cb = 0;
+    appl_ctx->snd_busy = 0;
+    appl_ctx->snd_wait_hd = NULL;
+    memset(appl_ctx->snd_dat, 0, sizeof(appl_ctx->snd_dat));
+    appl_ctx->snd_dat_cnt = 0;
+    if (appl_ctx->snd_dat_win == 0)
+        appl_ctx->snd_dat_win = 1;
+    else if (appl_ctx->snd_dat_win > APPL_SND_DAT_WIN_MAX)
+        appl_ctx->snd_dat_win = APPL_SND_DAT_WIN_MAX;
+    appl_ctx->snd_dat_lim = appl_ctx->snd_dat_win;
+    appl_ctx->snd_dat_ok = 0;
+    appl_ctx->snd_dat_cmplt_ms = 0;
+    memset(appl_ctx->node_lat, 0, sizeof(appl_ctx->node_lat));
+    memset(&appl_ctx->snd_stat, 0, sizeof(appl_snd_stat_t));
 
     if (appl_ctx->cb_tmout_ms < APPL_CB_TMOUT_MIN)
         appl_ctx->cb_tmout_ms = APPL_CB_TMOUT_MIN;
@@ -2558,7 +3588,13 @@ zwhci_exit - Clean up the application layer
 */
 void zwhci_exit(appl_layer_ctx_t   *appl_ctx)
 {
+    int i;
+
     ssn_exit(&appl_ctx->ssn_ctx);
+    for (i=0; i<APPL_SND_DAT_SLOT_CNT; i++)
+    {
+        plt_tmr_stop(appl_ctx->plt_ctx, appl_ctx->snd_dat[i].tmr_ctx);
+    }
     plt_mtx_destroy(appl_ctx->snd_mtx);
     plt_cond_destroy(appl_ctx->snd_cv);
 }
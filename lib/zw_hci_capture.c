@@ -0,0 +1,477 @@
+/**
+@file   zw_hci_capture.c - Z-wave host controller interface serial traffic capture implementation.
+
+        Record the bytes exchanged with the Z-wave controller to a trace file and
+        read the trace file back for offline replay.
+
+@author David Chow
+
+@version    1.0 17-10-26  Initial release
+
+version: 1.0
+comments: Initial release
+*/
+
+#include <stdlib.h>
+#include <string.h>
+#include "../include/zw_hci_capture.h"
+#include "../include/zw_hci_error.h"
+
+/**
+@defgroup Capture Serial traffic capture and replay
+Record the bytes exchanged with the Z-wave controller and read them back.
+@{
+*/
+
+#ifdef OS_LINUX
+
+///
+/// Length of the ring buffer record header: timestamp (8 bytes) and data length (1 byte)
+#define CAP_RING_REC_HDR_LEN    9
+
+///
+/// Single producer, single consumer ring buffer of one direction
+typedef struct
+{
+    volatile uint32_t   head;               ///< Free running write offset, updated by the producer only
+    volatile uint32_t   tail;               ///< Free running read offset, updated by the writer thread only
+    volatile uint32_t   lost;               ///< Number of records lost because the ring buffer was full
+    uint8_t             buf[CAP_RING_SZ];   ///< Records
+
+} cap_ring_t;
+
+///
+/// Capture context
+typedef struct
+{
+    FILE                *fp;                ///< Trace file
+    plt_ctx_t           *plt_ctx;           ///< Platform context
+    uint64_t            last_ts;            ///< Time of the last record written to the file in microseconds
+    volatile int        thrd_run;           ///< Control the writer thread whether to run. 1 = run, 0 = stop
+    volatile int        thrd_sts;           ///< Writer thread status. 1 = running, 0 = thread exited
+    void                *wr_sem;            ///< Semaphore to wake up the writer thread
+    cap_ring_t          ring[2];            ///< Ring buffers of received (CAP_REC_RX) and written (CAP_REC_TX) bytes
+
+} cap_ctx_t;
+
+
+/**
+cap_ring_cpy_in - Copy data into the ring buffer, wrapping around at the end
+@param[in] ring     Ring buffer
+@param[in] ofs      Free running offset to copy to
+@param[in] buf      Data
+@param[in] len      Data length
+@return
+*/
+static void cap_ring_cpy_in(cap_ring_t *ring, uint32_t ofs, const uint8_t *buf, uint32_t len)
+{
+    uint32_t    pos = ofs & (CAP_RING_SZ - 1);
+    uint32_t    part = CAP_RING_SZ - pos;
+
+    if (part > len)
+        part = len;
+
+    memcpy(ring->buf + pos, buf, part);
+    memcpy(ring->buf, buf + part, len - part);
+}
+
+
+/**
+cap_ring_cpy_out - Copy data out of the ring buffer, wrapping around at the end
+@param[in]  ring    Ring buffer
+@param[in]  ofs     Free running offset to copy from
+@param[out] buf     Buffer to store the data
+@param[in]  len     Data length
+@return
+*/
+static void cap_ring_cpy_out(cap_ring_t *ring, uint32_t ofs, uint8_t *buf, uint32_t len)
+{
+    uint32_t    pos = ofs & (CAP_RING_SZ - 1);
+    uint32_t    part = CAP_RING_SZ - pos;
+
+    if (part > len)
+        part = len;
+
+    memcpy(buf, ring->buf + pos, part);
+    memcpy(buf + part, ring->buf, len - part);
+}
+
+
+/**
+cap_ring_put - Put a record into the ring buffer without blocking
+@param[in] ring     Ring buffer
+@param[in] ts       Timestamp in microseconds
+@param[in] buf      Data
+@param[in] len      Data length
+@return
+@pre       Only one thread at a time may put records into a ring buffer
+*/
+static void cap_ring_put(cap_ring_t *ring, uint64_t ts, const uint8_t *buf, uint8_t len)
+{
+    uint32_t    head = ring->head;
+    uint8_t     hdr[CAP_RING_REC_HDR_LEN];
+
+    if ((CAP_RING_SZ - (head - ring->tail)) < (uint32_t)(CAP_RING_REC_HDR_LEN + len))
+    {   //Full, the writer thread cannot keep up
+        __sync_fetch_and_add(&ring->lost, 1);
+        return;
+    }
+
+    memcpy(hdr, &ts, sizeof(uint64_t));
+    hdr[8] = len;
+    cap_ring_cpy_in(ring, head, hdr, CAP_RING_REC_HDR_LEN);
+    cap_ring_cpy_in(ring, head + CAP_RING_REC_HDR_LEN, buf, len);
+
+    //Publish the record after its content
+    __sync_synchronize();
+    ring->head = head + CAP_RING_REC_HDR_LEN + len;
+}
+
+
+/**
+cap_ring_peek - Get the timestamp of the first record in the ring buffer
+@param[in]  ring    Ring buffer
+@param[out] ts      Timestamp in microseconds
+@return     Non-zero if there is a record; else return zero
+*/
+static int cap_ring_peek(cap_ring_t *ring, uint64_t *ts)
+{
+    uint8_t     hdr[CAP_RING_REC_HDR_LEN];
+
+    if (ring->head == ring->tail)
+        return 0;
+
+    __sync_synchronize();
+    cap_ring_cpy_out(ring, ring->tail, hdr, CAP_RING_REC_HDR_LEN);
+    memcpy(ts, hdr, sizeof(uint64_t));
+    return 1;
+}
+
+
+/**
+cap_u32_put - Store a 32-bit value in little-endian order
+@param[out] buf     Buffer
+@param[in]  val     Value
+@return
+*/
+static void cap_u32_put(uint8_t *buf, uint32_t val)
+{
+    buf[0] = (uint8_t)val;
+    buf[1] = (uint8_t)(val >> 8);
+    buf[2] = (uint8_t)(val >> 16);
+    buf[3] = (uint8_t)(val >> 24);
+}
+
+
+/**
+cap_rec_wr - Write a record to the trace file
+@param[in] cap      Context
+@param[in] ts       Timestamp in microseconds
+@param[in] typ      Record type
+@param[in] buf      Data
+@param[in] len      Data length
+@return
+*/
+static void cap_rec_wr(cap_ctx_t *cap, uint64_t ts, cap_rec_typ_t typ, const uint8_t *buf, uint8_t len)
+{
+    uint8_t     hdr[CAP_REC_HDR_LEN];
+    uint64_t    delta;
+
+    delta = (ts > cap->last_ts)? (ts - cap->last_ts) : 0;
+    if (delta > 0xFFFFFFFF)
+        delta = 0xFFFFFFFF;
+    cap->last_ts = ts;
+
+    cap_u32_put(hdr, (uint32_t)delta);
+    hdr[4] = (uint8_t)typ;
+    hdr[5] = len;
+
+    fwrite(hdr, 1, CAP_REC_HDR_LEN, cap->fp);
+    fwrite(buf, 1, len, cap->fp);
+}
+
+
+/**
+cap_ring_drain - Write the first record of the ring buffer to the trace file
+@param[in] cap      Context
+@param[in] typ      Record type of the ring buffer
+@return
+*/
+static void cap_ring_drain(cap_ctx_t *cap, cap_rec_typ_t typ)
+{
+    cap_ring_t  *ring = &cap->ring[typ];
+    uint8_t     hdr[CAP_RING_REC_HDR_LEN];
+    uint8_t     dat[255];
+    uint64_t    ts;
+    uint32_t    tail = ring->tail;
+
+    cap_ring_cpy_out(ring, tail, hdr, CAP_RING_REC_HDR_LEN);
+    memcpy(&ts, hdr, sizeof(uint64_t));
+    cap_ring_cpy_out(ring, tail + CAP_RING_REC_HDR_LEN, dat, hdr[8]);
+
+    //Release the space after copying the record out
+    __sync_synchronize();
+    ring->tail = tail + CAP_RING_REC_HDR_LEN + hdr[8];
+
+    cap_rec_wr(cap, ts, typ, dat, hdr[8]);
+}
+
+
+/**
+cap_lost_wr - Write a record of the number of records lost in a ring buffer, if any
+@param[in] cap      Context
+@param[in] typ      Record type of the ring buffer
+@return
+*/
+static void cap_lost_wr(cap_ctx_t *cap, cap_rec_typ_t typ)
+{
+    uint32_t    lost;
+    uint8_t     dat[4];
+
+    lost = __sync_lock_test_and_set(&cap->ring[typ].lost, 0);
+    if (lost)
+    {
+        debug_msg_show(cap->plt_ctx, "Capture lost %u records", lost);
+        cap_u32_put(dat, lost);
+        cap_rec_wr(cap, cap->last_ts, CAP_REC_LOST, dat, 4);
+    }
+}
+
+
+/**
+cap_wr_thrd - Thread to write the records in the ring buffers to the trace file in time order
+@param[in] data     Context
+@return
+*/
+static void cap_wr_thrd(void *data)
+{
+    cap_ctx_t   *cap = (cap_ctx_t *)data;
+    uint64_t    rx_ts;
+    uint64_t    tx_ts;
+    int         rx_rdy;
+    int         tx_rdy;
+    int         run;
+
+    do
+    {
+        run = cap->thrd_run;
+
+        cap_lost_wr(cap, CAP_REC_RX);
+        cap_lost_wr(cap, CAP_REC_TX);
+
+        //Merge both directions by timestamp
+        while (1)
+        {
+            rx_rdy = cap_ring_peek(&cap->ring[CAP_REC_RX], &rx_ts);
+            tx_rdy = cap_ring_peek(&cap->ring[CAP_REC_TX], &tx_ts);
+
+            if (rx_rdy && (!tx_rdy || (rx_ts <= tx_ts)))
+                cap_ring_drain(cap, CAP_REC_RX);
+            else if (tx_rdy)
+                cap_ring_drain(cap, CAP_REC_TX);
+            else
+                break;
+        }
+
+        fflush(cap->fp);
+
+        //Sleep until cap_add or cap_close has something for us
+        if (run)
+            plt_sem_wait(cap->wr_sem);
+
+    } while (run);
+
+    cap->thrd_sts = 0;
+}
+
+
+/**
+cap_open - Open the trace file and start capturing
+@param[out] cap_ctx     Capture context
+@param[in]  plt_ctx     Platform context
+@param[in]  file        Trace file name. If the file exists, the records are appended to it
+@return     Non-zero on success; else return zero
+*/
+int cap_open(void **cap_ctx, plt_ctx_t *plt_ctx, const char *file)
+{
+    cap_ctx_t   *cap;
+    uint8_t     hdr[CAP_FILE_HDR_LEN] = {0};
+
+    cap = (cap_ctx_t *)calloc(1, sizeof(cap_ctx_t));
+    if (!cap)
+        return 0;
+
+    cap->plt_ctx = plt_ctx;
+    cap->fp = fopen(file, "ab");
+    if (!cap->fp)
+    {
+        debug_msg_show(plt_ctx, "Open capture file %s failed", file);
+        goto l_CAP_OPEN_ERROR;
+    }
+
+    //Write the file header if the file is new
+    if (ftell(cap->fp) == 0)
+    {
+        memcpy(hdr, CAP_FILE_MAGIC, 4);
+        hdr[4] = CAP_FILE_VER;
+        fwrite(hdr, 1, CAP_FILE_HDR_LEN, cap->fp);
+    }
+
+    if (!plt_sem_init(&cap->wr_sem))
+        goto l_CAP_OPEN_ERROR1;
+
+    cap->last_ts = plt_mono_us();
+    cap->thrd_run = 1;
+    cap->thrd_sts = 1;
+
+    if (plt_thrd_create(cap_wr_thrd, cap) < 0)
+        goto l_CAP_OPEN_ERROR2;
+
+    *cap_ctx = cap;
+    return 1;
+
+l_CAP_OPEN_ERROR2:
+    plt_sem_destroy(cap->wr_sem);
+
+l_CAP_OPEN_ERROR1:
+    fclose(cap->fp);
+
+l_CAP_OPEN_ERROR:
+    free(cap);
+    return 0;
+}
+
+
+/**
+cap_add - Record bytes exchanged with the Z-wave controller
+@param[in] cap_ctx  Capture context
+@param[in] typ      Record type, CAP_REC_RX or CAP_REC_TX
+@param[in] buf      Data
+@param[in] len      Data length
+@return
+@pre       Only one thread at a time may record each type. The record is dropped if the
+           writer thread cannot keep up
+*/
+void cap_add(void *cap_ctx, cap_rec_typ_t typ, const uint8_t *buf, size_t len)
+{
+    cap_ctx_t   *cap = (cap_ctx_t *)cap_ctx;
+    uint64_t    ts = plt_mono_us();
+    uint8_t     rec_len;
+
+    while (len > 0)
+    {
+        rec_len = (len > 0xFF)? 0xFF : (uint8_t)len;
+        cap_ring_put(&cap->ring[typ], ts, buf, rec_len);
+        buf += rec_len;
+        len -= rec_len;
+    }
+
+    plt_sem_post(cap->wr_sem);
+}
+
+
+/**
+cap_close - Stop capturing and close the trace file
+@param[in] cap_ctx  Capture context
+@return
+@pre       No thread is recording
+*/
+void cap_close(void *cap_ctx)
+{
+    cap_ctx_t   *cap = (cap_ctx_t *)cap_ctx;
+    int         wait_count;
+
+    //Stop the writer thread, it writes all the remaining records before exit
+    cap->thrd_run = 0;
+    plt_sem_post(cap->wr_sem);
+
+    wait_count = 50;
+    while (wait_count-- > 0)
+    {
+        if (cap->thrd_sts == 0)
+            break;
+        plt_sleep(100);
+    }
+
+    if (cap->thrd_sts)
+    {   //The writer thread is still using the context, leave it allocated
+        debug_msg_show(cap->plt_ctx, "Capture writer thread did not exit");
+        return;
+    }
+
+    plt_sem_destroy(cap->wr_sem);
+    fclose(cap->fp);
+    free(cap);
+}
+
+
+/**
+cap_rd_open - Open a trace file for reading
+@param[out] rd      Reader
+@param[in]  file    Trace file name
+@return     Non-zero on success; else return zero
+*/
+int cap_rd_open(cap_rd_t *rd, const char *file)
+{
+    uint8_t     hdr[CAP_FILE_HDR_LEN];
+
+    rd->ts = 0;
+    rd->fp = fopen(file, "rb");
+    if (!rd->fp)
+        return 0;
+
+    if ((fread(hdr, 1, CAP_FILE_HDR_LEN, rd->fp) != CAP_FILE_HDR_LEN)
+        || (memcmp(hdr, CAP_FILE_MAGIC, 4) != 0)
+        || (hdr[4] != CAP_FILE_VER))
+    {
+        fclose(rd->fp);
+        rd->fp = NULL;
+        return 0;
+    }
+
+    return 1;
+}
+
+
+/**
+cap_rd_next - Read the next record of a trace file
+@param[in]  rd      Reader
+@param[out] rec     Record
+@return     Non-zero on success; zero at the end of the file or on a truncated record
+*/
+int cap_rd_next(cap_rd_t *rd, cap_rec_t *rec)
+{
+    uint8_t     hdr[CAP_REC_HDR_LEN];
+
+    if (fread(hdr, 1, CAP_REC_HDR_LEN, rd->fp) != CAP_REC_HDR_LEN)
+        return 0;
+
+    rd->ts += (uint32_t)hdr[0] | ((uint32_t)hdr[1] << 8) | ((uint32_t)hdr[2] << 16) | ((uint32_t)hdr[3] << 24);
+    rec->ts = rd->ts;
+    rec->typ = hdr[4];
+    rec->len = hdr[5];
+
+    if (fread(rec->dat, 1, rec->len, rd->fp) != rec->len)
+        return 0;
+
+    return 1;
+}
+
+
+/**
+cap_rd_close - Close a trace file reader
+@param[in]  rd      Reader
+@return
+*/
+void cap_rd_close(cap_rd_t *rd)
+{
+    if (rd->fp)
+        fclose(rd->fp);
+    rd->fp = NULL;
+}
+
+#endif
+
+/**
+@}
+*/
@@ -132,22 +132,6 @@ static uint8_t frm_dat_get(frm_t  *frame, uint8_t  *dat_buf)
 }
 
 
-/**
-frm_dat_set - Set the command specific data into the data frame
-@param[in,out] frame    Pointer to the frame object.
-@param[in] dat_buf      Buffer that stores the data
-@param[in] dat_len      Number of bytes to be stored
-@return
-*/
-static void frm_dat_set(frm_t  *frame, uint8_t  *dat_buf, uint8_t dat_len)
-{
-    if (dat_len > 0)
-    {
-        memcpy(frame->frm_buf + FRAME_DATA_OFFSET, dat_buf, dat_len);
-    }
-}
-
-
 /**
 frm_chksm_get - Get the checksum of the data frame.
 
@@ -200,6 +184,41 @@ static uint8_t frm_chksm_cal(frm_t  *frame)
 }
 
 
+/**
+frm_snd_tmout_get - Get the send frame timeout of the current transmission
+@param[in] frm_ctx      Context.
+@return  Timeout in milliseconds
+@pre       Caller must lock the wr_mtx
+*/
+static uint32_t frm_snd_tmout_get(frm_layer_ctx_t   *frm_ctx)
+{
+    uint32_t    tmout;
+
+    //Exponential backoff on resend
+    tmout = frm_ctx->rto_ms << frm_ctx->resend_cnt;
+
+    return (tmout < frm_ctx->snd_tmout_ms)? tmout : frm_ctx->snd_tmout_ms;
+}
+
+
+/**
+frm_can_backoff_get - Get the randomized resend delay after CAN
+@param[in] frm_ctx      Context.
+@return  Delay in milliseconds
+@pre       Caller must lock the wr_mtx
+*/
+static uint32_t frm_can_backoff_get(frm_layer_ctx_t   *frm_ctx)
+{
+    uint32_t    delay;
+
+    //The controller has a frame to send. Give it a short, randomized window to do so before retrying
+    delay = FRAME_CAN_BACKOFF << frm_ctx->resend_cnt;
+    delay += (uint16_t)plt_rand_get() % delay;
+
+    return (delay < FRAME_RESEND_DELAY)? delay : FRAME_RESEND_DELAY;
+}
+
+
 /**
 frm_snd_tmout_cb - Send frame timeout callback
 @param[in] data     Pointer to the frm_layer_ctx_t
@@ -207,7 +226,6 @@ frm_snd_tmout_cb - Send frame timeout callback
 */
 static void    frm_snd_tmout_cb(void *data)
 {
-//  int               result;
     frm_layer_ctx_t   *frm_ctx = (frm_layer_ctx_t   *)data;
 
     plt_mtx_lck(frm_ctx->wr_mtx);
@@ -216,24 +234,20 @@ static void    frm_snd_tmout_cb(void *data)
     plt_tmr_stop(frm_ctx->plt_ctx, frm_ctx->snd_tmr_ctx);
     frm_ctx->snd_tmr_ctx = 0;
 
-    //Resend packet
-//  result = frm_resend(frm_ctx, 0);
-//
-//  plt_mtx_ulck(frm_ctx->wr_mtx);
-//
-//  if (!result)
-//  {
-//      //Failed. Update send status to session layer
-//      frm_ctx->snd_frm_sts_cb(frm_ctx, FRAME_SEND_TIMEOUT);
-//
-//  }
-
-    //Stop resend
-    if (frm_ctx->last_frm_buf)
+    if (!frm_ctx->last_frm)
+    {   //The ACK has arrived just before the timeout
+        plt_mtx_ulck(frm_ctx->wr_mtx);
+        return;
+    }
+
+    frm_ctx->stat.snd_tmout++;
+
+    //Resend packet with a longer timeout. The adaptive timeout is never shorter than the
+    //Serial API ACK timeout, so the controller has dropped the frame
+    if (frm_resend(frm_ctx, 0))
     {
-        free(frm_ctx->last_frm_buf);
-        frm_ctx->last_frm_buf = NULL;
-        frm_ctx->resend_cnt = 0;
+        plt_mtx_ulck(frm_ctx->wr_mtx);
+        return;
     }
 
     plt_mtx_ulck(frm_ctx->wr_mtx);
@@ -251,86 +265,83 @@ frm_single_byte_snd - Send a single byte (e.g. ACK, NAK, CAN)
 */
 static int32_t frm_single_byte_snd(frm_layer_ctx_t   *frm_ctx, uint8_t   data)
 {
-    int32_t     ret_val;
+    if (data == ACK)
+        frm_ctx->stat.ack_tx++;
+    else if (data == NAK)
+        frm_ctx->stat.nak_tx++;
 
-    plt_mtx_lck(frm_ctx->wr_mtx);
-    ret_val = tpt_wr_req_create(&frm_ctx->tpt_ctx, &data, 1);
-    plt_mtx_ulck(frm_ctx->wr_mtx);
-    return ret_val;
+    //Control frames bypass the write queue so that the controller is answered promptly
+    return tpt_ctl_byte_snd(&frm_ctx->tpt_ctx, data);
 }
 
 
 /**
-frm_dat_frm_snd - Send a data frame
+frm_dat_buf_snd - Send a data frame built in place in a buffer
 @param[in] frm_ctx      Context.
 @param[in] type         The type of data frame.
 @param[in] cmd_id       Unique command ID for the function to be carried out.
-@param[in] buf          Buffer that stores the data
-@param[in] dat_sz       Number of bytes stored in the buffer
+@param[in] buf          Buffer that stores the data, with FRAME_BUF_HEADROOM bytes of headroom and
+                        FRAME_BUF_TAILROOM bytes of tailroom reserved. The frame header and checksum
+                        are added in place. On success the frame layer keeps a reference for resend;
+                        the caller should release its own reference
 @return  0 on success, negative error number on failure
 */
-int32_t frm_dat_frm_snd(frm_layer_ctx_t   *frm_ctx, dat_frm_typ_t type,
-                        uint8_t   cmd_id, uint8_t   *buf, uint8_t   dat_sz)
+int32_t frm_dat_buf_snd(frm_layer_ctx_t   *frm_ctx, dat_frm_typ_t type,
+                        uint8_t   cmd_id, util_buf_t *buf)
 {
     int32_t     ret_val;
     frm_t       frame;
+    uint8_t     dat_sz = (uint8_t)buf->len;
 
     plt_mtx_lck(frm_ctx->wr_mtx);
 
     //Check whether any write operation still pending
-    if (frm_ctx->last_frm_buf)
+    if (frm_ctx->last_frm)
     {
         plt_mtx_ulck(frm_ctx->wr_mtx);
         return FRAME_ERROR_MULTIPLE_WRITE;
     }
 
-    frame.frm_sz = FRAME_HEADER_LEN + FRAME_TYPE_FIELD_LEN
-                   + FRAME_CHECKSUM_FIELD_LEN + dat_sz;
-    frame.frm_buf = (uint8_t *)malloc(frame.frm_sz);
-
-    if (!frame.frm_buf)
+    //Add the header and checksum fields around the data
+    if (!util_buf_push(buf, FRAME_TYPE_FIELD_LEN + FRAME_HEADER_LEN)
+        || !util_buf_put(buf, FRAME_CHECKSUM_FIELD_LEN))
     {
         plt_mtx_ulck(frm_ctx->wr_mtx);
         return ZWHCI_ERROR_MEMORY;
     }
 
     // Fill in the frame
+    frame.frm_buf = UTIL_BUF_DAT(buf);
+    frame.frm_sz = (uint8_t)buf->len;
     frm_frm_typ_set(&frame, SOF);
     frm_len_set(&frame, FRAME_HEADER_LEN + dat_sz);
     frm_typ_set(&frame, type);
     frm_cmd_id_set(&frame, cmd_id);
-    frm_dat_set(&frame, buf, dat_sz);
     frm_chksm_set(&frame, frm_chksm_cal(&frame));
 
-    /*printf("\n=========before tpt_wr_req_create,start, len:%d =================\n",frame.frm_sz);
-    int y = 0;
-    for(y= 0;y<frame.frm_sz;y++)
-    {
-        printf(" =>%02x<= ",frame.frm_buf[y]);
-    }
-    printf("\n===================tpt_wr_req_create message end======================\n");*/
-    ret_val = tpt_wr_req_create(&frm_ctx->tpt_ctx, frame.frm_buf, frame.frm_sz);
+    frm_ctx->snd_ts = plt_mono_us();
+    ret_val = tpt_wr_buf_req(&frm_ctx->tpt_ctx, buf);
 
     if (ret_val == ZWHCI_NO_ERROR)
     {
+        frm_ctx->stat.tx_frm++;
+        frm_ctx->stat.tx_byte += buf->len;
+
         //Start send timer
-        frm_ctx->snd_tmr_ctx = plt_tmr_start(frm_ctx->plt_ctx, frm_ctx->snd_tmout_ms, frm_snd_tmout_cb, frm_ctx);
+        frm_ctx->snd_tmr_ctx = plt_tmr_start(frm_ctx->plt_ctx, frm_snd_tmout_get(frm_ctx), frm_snd_tmout_cb, frm_ctx);
 
         if (frm_ctx->snd_tmr_ctx)
         {
-            //Save frame for resend
-            frm_ctx->last_frm_buf = frame.frm_buf;
-            frm_ctx->last_frm_sz = frame.frm_sz;
+            //Keep frame for resend
+            util_buf_hold(buf);
+            frm_ctx->last_frm = buf;
             frm_ctx->resend_cnt = 0;
         }
         else
         {   //Timer error
             ret_val = FRAME_ERROR_SEND_TIMER;
-            free(frame.frm_buf);
         }
     }
-    else    //Error, free the buffer
-        free(frame.frm_buf);
 
     plt_mtx_ulck(frm_ctx->wr_mtx);
     return ret_val;
@@ -338,6 +349,37 @@ int32_t frm_dat_frm_snd(frm_layer_ctx_t   *frm_ctx, dat_frm_typ_t type,
 }
 
 
+/**
+frm_dat_frm_snd - Send a data frame
+@param[in] frm_ctx      Context.
+@param[in] type         The type of data frame.
+@param[in] cmd_id       Unique command ID for the function to be carried out.
+@param[in] buf          Buffer that stores the data
+@param[in] dat_sz       Number of bytes stored in the buffer
+@return  0 on success, negative error number on failure
+*/
+int32_t frm_dat_frm_snd(frm_layer_ctx_t   *frm_ctx, dat_frm_typ_t type,
+                        uint8_t   cmd_id, uint8_t   *buf, uint8_t   dat_sz)
+{
+    int32_t     ret_val;
+    util_buf_t  *frm_buf;
+
+    frm_buf = util_buf_alloc(FRAME_BUF_HEADROOM, dat_sz + FRAME_BUF_TAILROOM);
+
+    if (!frm_buf)
+    {
+        return ZWHCI_ERROR_MEMORY;
+    }
+
+    memcpy(util_buf_put(frm_buf, dat_sz), buf, dat_sz);
+
+    ret_val = frm_dat_buf_snd(frm_ctx, type, cmd_id, frm_buf);
+    util_buf_release(frm_buf);
+
+    return ret_val;
+}
+
+
 /**
 frm_resnd_tmr_cb - Frame resend timer callback
 @param[in] data     Pointer to the frm_layer_ctx_t
@@ -355,17 +397,19 @@ static void    frm_resnd_tmr_cb(void *data)
     frm_ctx->resnd_tmr_ctx = 0;
 
     //Resend
-    if (frm_ctx->last_frm_buf)
+    if (frm_ctx->last_frm)
     {
-        ret_val = tpt_wr_req_create(&frm_ctx->tpt_ctx, frm_ctx->last_frm_buf, frm_ctx->last_frm_sz);
-
+        ret_val = tpt_wr_buf_req(&frm_ctx->tpt_ctx, frm_ctx->last_frm);
+        frm_ctx->stat.resend++;
+        frm_ctx->stat.tx_byte += frm_ctx->last_frm->len;
+        frm_ctx->snd_ts = plt_mono_us();
 
         if (ret_val == ZWHCI_NO_ERROR)
         {
             //Restart send timer
             plt_tmr_stop(frm_ctx->plt_ctx, frm_ctx->snd_tmr_ctx);
 
-            frm_ctx->snd_tmr_ctx = plt_tmr_start(frm_ctx->plt_ctx, frm_ctx->snd_tmout_ms, frm_snd_tmout_cb, frm_ctx);
+            frm_ctx->snd_tmr_ctx = plt_tmr_start(frm_ctx->plt_ctx, frm_snd_tmout_get(frm_ctx), frm_snd_tmout_cb, frm_ctx);
 
             if (frm_ctx->snd_tmr_ctx)
             {
@@ -374,8 +418,8 @@ static void    frm_resnd_tmr_cb(void *data)
             }
         }
         //Free send data buffer
-        free(frm_ctx->last_frm_buf);
-        frm_ctx->last_frm_buf = NULL;
+        util_buf_release(frm_ctx->last_frm);
+        frm_ctx->last_frm = NULL;
         frm_ctx->resend_cnt = 0;
 
         //Stop send timer
@@ -409,7 +453,7 @@ static int frm_resend(frm_layer_ctx_t   *frm_ctx, uint32_t delay_ms)
 
     plt_mtx_lck(frm_ctx->wr_mtx);
     //Check the buffer is valid
-    if (!frm_ctx->last_frm_buf)
+    if (!frm_ctx->last_frm)
         goto l_RESEND_FRAME_ERROR;
 
     //Check number of resend has been exceeded
@@ -418,6 +462,10 @@ static int frm_resend(frm_layer_ctx_t   *frm_ctx, uint32_t delay_ms)
 
     if (delay_ms > 0)
     {
+        //Stop send timer, it is restarted on resend
+        plt_tmr_stop(frm_ctx->plt_ctx, frm_ctx->snd_tmr_ctx);
+        frm_ctx->snd_tmr_ctx = 0;
+
         //Restart resend timer to wait for the delay before resending frame
         plt_tmr_stop(frm_ctx->plt_ctx, frm_ctx->resnd_tmr_ctx);
 
@@ -431,15 +479,17 @@ static int frm_resend(frm_layer_ctx_t   *frm_ctx, uint32_t delay_ms)
     }
     else
     {   //Send immediately
-        ret_val = tpt_wr_req_create(&frm_ctx->tpt_ctx, frm_ctx->last_frm_buf, frm_ctx->last_frm_sz);
-
+        ret_val = tpt_wr_buf_req(&frm_ctx->tpt_ctx, frm_ctx->last_frm);
+        frm_ctx->stat.resend++;
+        frm_ctx->stat.tx_byte += frm_ctx->last_frm->len;
+        frm_ctx->snd_ts = plt_mono_us();
 
         if (ret_val == ZWHCI_NO_ERROR)
         {
             //Restart send timer
             plt_tmr_stop(frm_ctx->plt_ctx, frm_ctx->snd_tmr_ctx);
 
-            frm_ctx->snd_tmr_ctx = plt_tmr_start(frm_ctx->plt_ctx, frm_ctx->snd_tmout_ms, frm_snd_tmout_cb, frm_ctx);
+            frm_ctx->snd_tmr_ctx = plt_tmr_start(frm_ctx->plt_ctx, frm_snd_tmout_get(frm_ctx), frm_snd_tmout_cb, frm_ctx);
 
             if (frm_ctx->snd_tmr_ctx)
             {
@@ -451,9 +501,9 @@ static int frm_resend(frm_layer_ctx_t   *frm_ctx, uint32_t delay_ms)
 
 l_RESEND_FRAME_ERROR:
     //Free send data buffer
-    if (frm_ctx->last_frm_buf)
-        free(frm_ctx->last_frm_buf);
-    frm_ctx->last_frm_buf = NULL;
+    if (frm_ctx->last_frm)
+        util_buf_release(frm_ctx->last_frm);
+    frm_ctx->last_frm = NULL;
     frm_ctx->resend_cnt = 0;
 
     //Stop send timer
@@ -466,6 +516,189 @@ l_RESEND_FRAME_ERROR:
 }
 
 
+/**
+frm_rto_update - Update the smoothed round trip time and derive the send frame timeout from it
+@param[in] frm_ctx      Context.
+@param[in] rtt          Round trip time sample in microseconds
+@return
+@pre       Caller must lock the wr_mtx
+*/
+static void frm_rto_update(frm_layer_ctx_t   *frm_ctx, uint32_t rtt)
+{
+    uint32_t    dev;
+    uint32_t    rto;
+
+    if (frm_ctx->srtt == 0)
+    {   //First sample
+        frm_ctx->srtt = (rtt)? rtt : 1;
+        frm_ctx->rttvar = rtt / 2;
+    }
+    else
+    {   //RTTVAR = 3/4 RTTVAR + 1/4 |SRTT - R|, SRTT = 7/8 SRTT + 1/8 R
+        dev = (frm_ctx->srtt > rtt)? (frm_ctx->srtt - rtt) : (rtt - frm_ctx->srtt);
+        frm_ctx->rttvar = frm_ctx->rttvar - (frm_ctx->rttvar >> 2) + (dev >> 2);
+        frm_ctx->srtt = frm_ctx->srtt - (frm_ctx->srtt >> 3) + (rtt >> 3);
+        if (frm_ctx->srtt == 0)
+            frm_ctx->srtt = 1;
+    }
+
+    //RTO = SRTT + max(G, 4 * RTTVAR), kept within the conservative limits
+    dev = frm_ctx->rttvar * 4;
+    if (dev < FRAME_RTO_GRANULARITY * 1000)
+        dev = FRAME_RTO_GRANULARITY * 1000;
+    rto = (frm_ctx->srtt + dev + 999) / 1000;
+
+    if (rto < FRAME_RTO_MIN)
+        rto = FRAME_RTO_MIN;
+    if (rto > frm_ctx->snd_tmout_ms)
+        rto = frm_ctx->snd_tmout_ms;
+
+    frm_ctx->rto_ms = rto;
+}
+
+
+/**
+frm_rtt_add - Add the round trip time of the acknowledged data frame to the histogram
+@param[in] frm_ctx      Context.
+@return
+@pre       Caller must lock the wr_mtx
+*/
+static void frm_rtt_add(frm_layer_ctx_t   *frm_ctx)
+{
+    uint64_t    elapsed;
+    uint32_t    rtt;
+    uint32_t    val;
+    unsigned    bkt;
+
+    elapsed = plt_mono_us() - frm_ctx->snd_ts;
+    rtt = (elapsed > 0xFFFFFFFF)? 0xFFFFFFFF : (uint32_t)elapsed;
+
+    if (rtt > frm_ctx->stat.rtt_max)
+        frm_ctx->stat.rtt_max = rtt;
+
+    //Bucket is the position of the highest bit set
+    bkt = 0;
+    val = rtt;
+    while ((val >>= 1) != 0)
+    {
+        bkt++;
+    }
+    if (bkt >= FRAME_RTT_BKT_CNT)
+        bkt = FRAME_RTT_BKT_CNT - 1;
+
+    frm_ctx->stat.rtt_hist[bkt]++;
+
+    //Only the frames acknowledged on their first transmission give an unambiguous sample
+    if (frm_ctx->resend_cnt == 0)
+    {
+        frm_rto_update(frm_ctx, rtt);
+    }
+}
+
+
+/**
+frm_ctl_rx - Handle a received single-byte control frame (ACK, NAK or CAN)
+@param[in] frm_ctx      Context.
+@param[in] data         The received byte
+@return
+*/
+static void    frm_ctl_rx(frm_layer_ctx_t   *frm_ctx, uint8_t data)
+{
+    uint32_t    can_delay;
+
+    switch (data)
+    {
+        case ACK:
+            //The sent request is acknowledged
+            plt_mtx_lck(frm_ctx->wr_mtx);
+
+            frm_ctx->stat.ack_rx++;
+            if (!frm_ctx->last_frm)
+            {   //No frame is outstanding, e.g. a late ACK of a frame that has been given up.
+                //Don't take it as the ACK of the frame sent next
+                plt_mtx_ulck(frm_ctx->wr_mtx);
+                break;
+            }
+            frm_rtt_add(frm_ctx);
+
+            //Free send data buffer
+            util_buf_release(frm_ctx->last_frm);
+            frm_ctx->last_frm = NULL;
+            frm_ctx->resend_cnt = 0;
+
+            //Stop send timer
+            plt_tmr_stop(frm_ctx->plt_ctx, frm_ctx->snd_tmr_ctx);
+            frm_ctx->snd_tmr_ctx = 0;
+
+            plt_mtx_ulck(frm_ctx->wr_mtx);
+
+            //Update send status to session layer
+            frm_ctx->snd_frm_sts_cb(frm_ctx, FRAME_SEND_OK);
+            break;
+
+        case NAK:
+            //Checksum error
+            plt_mtx_lck(frm_ctx->wr_mtx);
+            frm_ctx->stat.nak_rx++;
+            plt_mtx_ulck(frm_ctx->wr_mtx);
+            if (!frm_resend(frm_ctx, 0))
+            {
+                //Failed. Update send status to session layer
+                frm_ctx->snd_frm_sts_cb(frm_ctx, FRAME_SEND_FAIL_CHKSUM);
+
+            }
+            break;
+
+        case CAN:
+            plt_mtx_lck(frm_ctx->wr_mtx);
+            frm_ctx->stat.can_rx++;
+            can_delay = frm_can_backoff_get(frm_ctx);
+            plt_mtx_ulck(frm_ctx->wr_mtx);
+            //The sent request is dropped by the Z-wave controller
+            if (!frm_resend(frm_ctx, can_delay))
+            {
+                //Failed. Update send status to session layer
+                frm_ctx->snd_frm_sts_cb(frm_ctx, FRAME_SEND_FAIL_DROPPED);
+
+            }
+            break;
+    }
+}
+
+
+/**
+frm_rx_frm_chk - Verify the checksum of a complete data frame and pass it to the session layer
+@param[in] frm_ctx      Context.
+@param[in] frm_buf      The complete data frame, starting from the frame type field
+@return
+*/
+static void    frm_rx_frm_chk(frm_layer_ctx_t   *frm_ctx, uint8_t *frm_buf)
+{
+    frm_t    frame;
+
+    frame.frm_buf = frm_buf;
+    frame.frm_sz = frm_buf[FRAME_LENGTH_OFFSET] + FRAME_TYPE_FIELD_LEN + FRAME_CHECKSUM_FIELD_LEN;
+    if (frm_chksm_cal(&frame) == frm_chksm_get(&frame))
+    {
+        frm_ctx->stat.rx_frm++;
+
+        //Send ACK to Z-wave controller
+        frm_single_byte_snd(frm_ctx, ACK);
+
+        //Pass the frame (without frame type and checksum fields) to the session layer
+        frm_ctx->rx_frm_cb(frm_ctx, &frm_buf[FRAME_LENGTH_OFFSET], frm_buf[FRAME_LENGTH_OFFSET]);
+
+    }
+    else
+    {
+        frm_ctx->stat.chksm_err++;
+
+        //Send NAK to Z-wave controller
+        frm_single_byte_snd(frm_ctx, NAK);
+    }
+}
+
+
 /**
 frm_sta_machine - frame layer state-machine.
 Try to assemble a frame and pass it to the session layer
@@ -476,7 +709,6 @@ Try to assemble a frame and pass it to the session layer
 */
 static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, uint8_t data)
 {
-
     switch (frm_ctx->sta_mach.frm_sta)
     {
             //-------------------------------------
@@ -487,49 +719,9 @@ static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, ui
                 switch (data)
                 {
                     case ACK:
-                        //The sent request is acknowledged
-                        plt_mtx_lck(frm_ctx->wr_mtx);
-
-                        //Free send data buffer
-                        if (frm_ctx->last_frm_buf)
-                            free(frm_ctx->last_frm_buf);
-                        frm_ctx->last_frm_buf = NULL;
-                        frm_ctx->resend_cnt = 0;
-
-                        //Stop send timer
-                        plt_tmr_stop(frm_ctx->plt_ctx, frm_ctx->snd_tmr_ctx);
-                        frm_ctx->snd_tmr_ctx = 0;
-
-                        plt_mtx_ulck(frm_ctx->wr_mtx);
-
-                        //Update send status to session layer
-                        frm_ctx->snd_frm_sts_cb(frm_ctx, FRAME_SEND_OK);
-                        break;
-
                     case NAK:
-                        //Checksum error
-#ifdef DEBUG_SERIAL_API
-                        frm_ctx->nak_cnt++;
-#endif
-                        if (!frm_resend(frm_ctx, 0))
-                        {
-                            //Failed. Update send status to session layer
-                            frm_ctx->snd_frm_sts_cb(frm_ctx, FRAME_SEND_FAIL_CHKSUM);
-
-                        }
-                        break;
-
                     case CAN:
-#ifdef DEBUG_SERIAL_API
-                        frm_ctx->can_cnt++;
-#endif
-                        //The sent request is dropped by the Z-wave controller
-                        if (!frm_resend(frm_ctx, FRAME_RESEND_DELAY))
-                        {
-                            //Failed. Update send status to session layer
-                            frm_ctx->snd_frm_sts_cb(frm_ctx, FRAME_SEND_FAIL_DROPPED);
-
-                        }
+                        frm_ctl_rx(frm_ctx, data);
                         break;
 
                     case SOF:
@@ -539,6 +731,7 @@ static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, ui
                         break;
 
                     default:
+                        frm_ctx->stat.resync++;
                         break;
 
                 }
@@ -560,6 +753,7 @@ static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, ui
                 }
             }
             //Read timeout or byte received is invalid
+            frm_ctx->stat.resync++;
             frm_ctx->sta_mach.frm_sta = FRAME_STATE_IDLE;
             break;
 
@@ -585,6 +779,7 @@ static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, ui
                 }
             }
             //Read timeout or byte received is invalid
+            frm_ctx->stat.resync++;
             frm_ctx->sta_mach.frm_sta = FRAME_STATE_IDLE;
             break;
 
@@ -598,25 +793,7 @@ static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, ui
 
                 if (--frm_ctx->sta_mach.pending_rx_bytes <= 0)
                 {   //Receive complete frame, calculate checksum
-                    frm_t    frame;
-
-                    frame.frm_buf = frm_ctx->sta_mach.frm_buf;
-                    frame.frm_sz = frm_ctx->sta_mach.frm_offset;
-                    if (frm_chksm_cal(&frame) == frm_chksm_get(&frame))
-                    {
-                        //Send ACK to Z-wave controller
-                        frm_single_byte_snd(frm_ctx, ACK);
-
-                        //Pass the frame (without frame type and checksum fields) to the session layer
-                        frm_ctx->rx_frm_cb(frm_ctx, &frm_ctx->sta_mach.frm_buf[FRAME_LENGTH_OFFSET],
-                                           frm_ctx->sta_mach.frm_buf[FRAME_LENGTH_OFFSET]);
-
-                    }
-                    else
-                    {
-                        //Send NAK to Z-wave controller
-                        frm_single_byte_snd(frm_ctx, NAK);
-                    }
+                    frm_rx_frm_chk(frm_ctx, frm_ctx->sta_mach.frm_buf);
                     //Done. Go back to idle state
                     frm_ctx->sta_mach.frm_sta = FRAME_STATE_IDLE;
                 }
@@ -624,6 +801,7 @@ static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, ui
             else    //EVENT_RECEIVE_TIMEOUT
             {
                 //Read timeout
+                frm_ctx->stat.resync++;
                 frm_ctx->sta_mach.frm_sta = FRAME_STATE_IDLE;
             }
             break;
@@ -633,6 +811,107 @@ static void    frm_sta_machine(frm_layer_ctx_t   *frm_ctx, frm_evt_t frm_evt, ui
 
 
 
+/**
+frm_rx_scan - Find the first byte that could start a frame (SOF, ACK, NAK or CAN)
+@param[in] buf      Buffer that stores the received bytes
+@param[in] dat_len  Number of bytes in the buffer
+@return  Number of bytes before the first frame start byte; dat_len if there is none
+*/
+static uint32_t frm_rx_scan(const uint8_t *buf, uint32_t dat_len)
+{
+    uint32_t    i;
+
+    for (i = 0; i < dat_len; i++)
+    {
+        //All the frame start bytes are below 0x19; skip the rest with a single compare
+        if (buf[i] <= CAN)
+        {
+            if (buf[i] == SOF || buf[i] == ACK || buf[i] == NAK || buf[i] == CAN)
+                break;
+        }
+    }
+    return i;
+}
+
+
+/**
+frm_rx_chunk - Assemble frames from a chunk of received bytes.
+Complete frames are verified in place in the chunk; only the frames split across
+chunks are collected byte by byte in the state-machine buffer.
+@param[in] frm_ctx  Context.
+@param[in] buf      Buffer that stores the received bytes
+@param[in] dat_len  Number of bytes received
+@return
+@pre       Caller must lock the sta_mach_mtx
+*/
+static void    frm_rx_chunk(frm_layer_ctx_t   *frm_ctx, uint8_t *buf, uint32_t dat_len)
+{
+    frm_sta_mach_t  *sta_mach = &frm_ctx->sta_mach;
+    uint32_t        len;
+
+    while (dat_len > 0)
+    {
+        if (sta_mach->frm_sta == FRAME_STATE_WAIT_COMPLETE_FRAME)
+        {   //Collect the rest of a frame started in a previous chunk
+            len = (dat_len < (uint32_t)sta_mach->pending_rx_bytes)? dat_len : (uint32_t)sta_mach->pending_rx_bytes;
+            memcpy(sta_mach->frm_buf + sta_mach->frm_offset, buf, len);
+            sta_mach->frm_offset += len;
+            sta_mach->pending_rx_bytes -= len;
+            buf += len;
+            dat_len -= len;
+
+            if (sta_mach->pending_rx_bytes <= 0)
+            {
+                frm_rx_frm_chk(frm_ctx, sta_mach->frm_buf);
+                sta_mach->frm_sta = FRAME_STATE_IDLE;
+            }
+            continue;
+        }
+
+        if (sta_mach->frm_sta != FRAME_STATE_IDLE)
+        {   //Frame header split across chunks
+            frm_sta_machine(frm_ctx, EVENT_RECEIVED_DATA, *buf++);
+            dat_len--;
+            continue;
+        }
+
+        //Skip the bytes that cannot start a frame
+        len = frm_rx_scan(buf, dat_len);
+        frm_ctx->stat.resync += len;
+        buf += len;
+        dat_len -= len;
+        if (dat_len == 0)
+            break;
+
+        if (*buf != SOF)
+        {
+            frm_ctl_rx(frm_ctx, *buf++);
+            dat_len--;
+            continue;
+        }
+
+        //Check whether the whole data frame is in this chunk
+        if ((dat_len > FRAME_TYPE_OFFSET)
+            && (buf[FRAME_LENGTH_OFFSET] >= FRAME_HEADER_LEN)
+            && (buf[FRAME_TYPE_OFFSET] == RES || buf[FRAME_TYPE_OFFSET] == REQ))
+        {
+            len = buf[FRAME_LENGTH_OFFSET] + FRAME_TYPE_FIELD_LEN + FRAME_CHECKSUM_FIELD_LEN;
+            if (dat_len >= len)
+            {
+                frm_rx_frm_chk(frm_ctx, buf);
+                buf += len;
+                dat_len -= len;
+                continue;
+            }
+        }
+
+        //Incomplete or invalid header, let the state-machine handle it
+        frm_sta_machine(frm_ctx, EVENT_RECEIVED_DATA, *buf++);
+        dat_len--;
+    }
+}
+
+
 /**
 frm_tpt_rd_cb - Read callback from transport layer.
 @param[in] tpt_ctx  Transport layer context.
@@ -644,11 +923,9 @@ static void    frm_tpt_rd_cb(struct _tpt_layer_ctx *tpt_ctx, uint8_t *buf, uint8
 {
     frm_layer_ctx_t   *frm_ctx = tpt_ctx->frm_layer_ctx;
     plt_mtx_lck(frm_ctx->sta_mach_mtx);
-    //Call the frame state-machine to assemble a frame
-    while (dat_len-- > 0)
-    {
-        frm_sta_machine(frm_ctx, EVENT_RECEIVED_DATA, *buf++);
-    }
+    frm_ctx->stat.rx_byte += dat_len;
+    //Assemble frames from the whole chunk under a single lock
+    frm_rx_chunk(frm_ctx, buf, dat_len);
     plt_mtx_ulck(frm_ctx->sta_mach_mtx);
 }
 
@@ -668,6 +945,32 @@ static void    frm_tpt_rd_tmout_cb(struct _tpt_layer_ctx *tpt_ctx)
 }
 
 
+/**
+frm_stat_get - Get the frame layer statistics
+@param[in]  frm_ctx     Context.
+@param[out] stat        The statistics
+@param[in]  reset       Flag to clear the statistics after reading them
+@return
+*/
+void frm_stat_get(frm_layer_ctx_t   *frm_ctx, frm_stat_t *stat, int reset)
+{
+    plt_mtx_lck(frm_ctx->sta_mach_mtx);
+    plt_mtx_lck(frm_ctx->wr_mtx);
+
+    *stat = frm_ctx->stat;
+    stat->srtt = frm_ctx->srtt;
+    stat->rttvar = frm_ctx->rttvar;
+    stat->rto = frm_ctx->rto_ms;
+    if (reset)
+    {
+        memset(&frm_ctx->stat, 0, sizeof(frm_stat_t));
+    }
+
+    plt_mtx_ulck(frm_ctx->wr_mtx);
+    plt_mtx_ulck(frm_ctx->sta_mach_mtx);
+}
+
+
 /**
 frm_init - Init the frame layer.
 Should be called once before calling the other frame layer functions
@@ -693,11 +996,17 @@ int32_t frm_init(frm_layer_ctx_t   *frm_ctx)
 
 
     //Init frame layer
-    frm_ctx->last_frm_buf = NULL;
+    frm_ctx->last_frm = NULL;
+    memset(&frm_ctx->stat, 0, sizeof(frm_stat_t));
     frm_ctx->sta_mach.frm_sta = FRAME_STATE_IDLE;
     if (frm_ctx->snd_tmout_ms < FRAME_SEND_TIMEOUT_MIN)
         frm_ctx->snd_tmout_ms = FRAME_SEND_TIMEOUT_MIN;
 
+    //Use the conservative timeout until there is a round trip time sample
+    frm_ctx->srtt = 0;
+    frm_ctx->rttvar = 0;
+    frm_ctx->rto_ms = frm_ctx->snd_tmout_ms;
+
     if (!plt_mtx_init(&frm_ctx->wr_mtx))
         goto l_FRAME_INIT_ERROR;
 
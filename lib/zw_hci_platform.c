@@ -22,6 +22,11 @@ comments: Initial release
     #include <unistd.h>
     #ifdef OS_MAC_X
     #include <sys/time.h>
+    #include <sys/select.h>
+    #include <fcntl.h>
+    #else
+    #include <sys/timerfd.h>
+    #include <sys/epoll.h>
     #endif
 #endif
 #include <stdlib.h>
@@ -771,6 +776,30 @@ void     plt_cond_destroy(void *cond_ctx)
     free(cv);
 }
 
+///Thread context
+typedef struct
+{
+    void (*start_adr)(void * ); ///< The function to run
+    void *args;                 ///< Argument to pass to the start_adr()
+} thrd_ctx_t;
+
+///
+/// Flag to indicate the calling thread is created by plt_thrd_create
+static PLT_THRD_LOCAL int plt_lib_thrd;
+
+/**
+plt_thrd_run - Run a thread
+@param[in] args         Thread context.
+@return
+*/
+static void plt_thrd_run(void *args)
+{
+    thrd_ctx_t      *thrd_ctx = (thrd_ctx_t *)args;
+    plt_lib_thrd = 1;
+    thrd_ctx->start_adr(thrd_ctx->args);
+    free(thrd_ctx);
+}
+
 /**
 plt_thrd_create - Create a thread and run it
 @param[in] start_adr    Pointer to a function for the newly created thread to execute.
@@ -779,15 +808,34 @@ plt_thrd_create - Create a thread and run it
 */
 int     plt_thrd_create(void(*start_adr)( void * ), void *args)
 {
+    thrd_ctx_t      *thrd_ctx;
+
+    thrd_ctx = (thrd_ctx_t *)malloc(sizeof(thrd_ctx_t));
+    if (!thrd_ctx)
+    {
+        return -1;
+    }
+    thrd_ctx->start_adr = start_adr;
+    thrd_ctx->args = args;
 
-    if (_beginthread(start_adr, 0, args) == -1L)
+    if (_beginthread(plt_thrd_run, 0, thrd_ctx) == -1L)
     {
+        free(thrd_ctx);
         return -1;
     }
     return 0;
 
 }
 
+/**
+plt_thrd_is_lib - Check whether the calling thread is created by plt_thrd_create
+@return     Non-zero if the calling thread is a library thread; zero if it is an application thread.
+*/
+int     plt_thrd_is_lib(void)
+{
+    return plt_lib_thrd;
+}
+
 /**
 plt_sleep - Suspends the execution of the current thread until the time-out interval elapses.
 @param[in] tmout_ms   The time interval for which execution is to be suspended, in milliseconds.
@@ -799,6 +847,32 @@ void     plt_sleep(uint32_t    tmout_ms)
 }
 
 
+/**
+plt_mono_ms - Get monotonic time
+@return     Monotonic time in milliseconds. It is not affected by system time changes.
+*/
+uint64_t plt_mono_ms(void)
+{
+    return GetTickCount64();
+}
+
+
+/**
+plt_mono_us - Get monotonic time
+@return     Monotonic time in microseconds. It is not affected by system time changes.
+*/
+uint64_t plt_mono_us(void)
+{
+    LARGE_INTEGER   cnt;
+    LARGE_INTEGER   freq;
+
+    QueryPerformanceCounter(&cnt);
+    QueryPerformanceFrequency(&freq);
+    return (uint64_t)((cnt.QuadPart / freq.QuadPart) * 1000000
+                      + ((cnt.QuadPart % freq.QuadPart) * 1000000) / freq.QuadPart);
+}
+
+
 /**
 plt_periodic_start - Start a periodic timer
 @param[in] pltfm_ctx    Context
@@ -932,12 +1006,14 @@ plt_init - Initialize platform
 @param[in] pltfm_ctx        Context
 @param[in] display_txt_fn   Function pointer to display null terminated string
 @param[in] display_ctx      Display context
+@param[in] tmr_cb_thrd_cnt  Number of threads to execute one-shot timer callbacks (unused, the system
+                            timer queue thread pool is used)
 @return    Return zero on success; negative error number indicates failure.
 */
 #ifdef TCP_PORTAL
-int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn, void *display_ctx)
+int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn, void *display_ctx, uint8_t tmr_cb_thrd_cnt)
 #else
-int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn)
+int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn, uint8_t tmr_cb_thrd_cnt)
 #endif
 {
     if (pltfm_ctx->init_done > 0)
@@ -953,6 +1029,9 @@ int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn)
     pltfm_ctx->display_ctx = display_ctx;
 #endif
 
+    //Set up the memory pool for queue entries and frame buffers
+    util_mem_init();
+
     //Init random number seed
     srand((unsigned)time(NULL));
 
@@ -998,16 +1077,93 @@ typedef struct
     void *args;                 ///< Argument to pass to the start_adr()
 } thrd_ctx_t;
 
+///
+/// Flag to indicate the calling thread is created by plt_thrd_create
+static PLT_THRD_LOCAL int plt_lib_thrd;
+
+///
+/// Timing wheel geometry. A tick is one PLT_TIMER_RESOLUTION. The root wheel resolves the next 256 ticks
+/// exactly, each of the outer wheels covers 64 times the range of the wheel below it; together they span
+/// 2^32 ticks.
+#define TMR_WHL_ROOT_BITS   8
+#define TMR_WHL_LVL_BITS    6
+#define TMR_WHL_LVL_CNT     4
+#define TMR_WHL_ROOT_SZ     (1 << TMR_WHL_ROOT_BITS)
+#define TMR_WHL_LVL_SZ      (1 << TMR_WHL_LVL_BITS)
+#define TMR_WHL_ROOT_MASK   (TMR_WHL_ROOT_SZ - 1)
+#define TMR_WHL_LVL_MASK    (TMR_WHL_LVL_SZ - 1)
+
+///
+/// Number of buckets of the timer id hash table (must be power of 2)
+#define TMR_HASH_SZ         1024
+
+///Timer link of a doubly linked circular list
+typedef struct _tmr_lnk
+{
+    struct _tmr_lnk *next;  ///< Next entry
+    struct _tmr_lnk *prev;  ///< Previous entry
+} tmr_lnk_t;
+
 ///Timer context to facilitate callback and stopping the timer
-typedef struct
-{
-    uint16_t    tmr_expiry;///< Timer ticks the timer will expire
-    uint16_t    tmr_reload;///< Timer ticks to reload (for periodic timer only)
+typedef struct _tmr_ctx
+{
+    tmr_lnk_t   lnk;       ///< Link to the timing wheel slot. MUST be the first member
+    struct _tmr_ctx *hash_nxt; ///< Next timer in the same id hash bucket
+    uint64_t    tmr_expiry;///< Monotonic time in milliseconds the timer will expire
+    uint32_t    tmr_reload;///< Timer ticks to reload (for periodic timer only)
+    int         whl_lvl;   ///< The wheel the timer is in: 0 = root, 1 to TMR_WHL_LVL_CNT = outer wheels,
+                           ///< -1 = not in any wheel
     uint16_t    id;        ///< Timer identifier
     tmr_cb_t    tmr_cb;    ///< The callback function to call when timer expires
     void        *data;     ///< The data passed as parameter to the callback function
 } tmr_ctx_t;
 
+///Timer callback job
+typedef struct _tmr_cb_job
+{
+    struct _tmr_cb_job  *next;  ///< Next job
+    tmr_cb_t    tmr_cb;         ///< The callback function to call
+    void        *data;          ///< The data passed as parameter to the callback function
+} tmr_cb_job_t;
+
+struct _tmr_cb_pool;
+
+///Timer callback worker
+typedef struct
+{
+    struct _tmr_cb_pool *pool;  ///< The pool this worker belongs to
+    void        *data;          ///< The data of the callback being executed; NULL if none
+    int         in_use;         ///< Flag to indicate the worker slot is in use
+} tmr_cb_wrk_t;
+
+///Timer callback executor
+typedef struct _tmr_cb_pool
+{
+    void        *mtx;           ///< Mutex for accessing the job queue and workers
+    void        *sem;           ///< Semaphore for waking up the workers
+    tmr_cb_job_t *job_hd;       ///< Head of the job queue
+    tmr_cb_job_t *job_tl;       ///< Tail of the job queue
+    tmr_cb_wrk_t *wrk;          ///< Workers; the first thrd_cnt entries are the fixed workers,
+                                ///< the rest are for overflow workers
+    int         thrd_cnt;       ///< Number of fixed worker threads
+    int         idle_cnt;       ///< Number of fixed workers waiting for job and not yet claimed by a queued job
+    int         wake_cnt;       ///< Number of queued jobs that claimed an idle fixed worker which has not woken yet
+    int         ovf_cnt;        ///< Number of running overflow workers
+    volatile int run;           ///< Control the workers whether to run. 1 = run, 0 = stop
+    volatile int thrd_sts_cnt;  ///< Number of running worker threads
+} tmr_cb_pool_t;
+
+///Hierarchical timing wheel
+typedef struct
+{
+    tmr_lnk_t   root[TMR_WHL_ROOT_SZ];                  ///< Root wheel, one slot per tick
+    tmr_lnk_t   lvl[TMR_WHL_LVL_CNT][TMR_WHL_LVL_SZ];   ///< Outer wheels
+    tmr_lnk_t   due;                    ///< Expired timers waiting for their callbacks to be invoked
+    tmr_ctx_t   *hash[TMR_HASH_SZ];     ///< Timer id hash table
+    uint32_t    tmr_cnt[TMR_WHL_LVL_CNT + 1];   ///< Number of timers in each wheel, index 0 is the root wheel
+    uint64_t    cur_tick;               ///< The last tick processed by the wheel, in monotonic milliseconds
+} tmr_whl_t;
+
 
 #ifdef OS_MAC_X
 ///Semaphore context
@@ -1138,219 +1294,1306 @@ void plt_msg_ts_show(void *pltfm_ctx, char * format, ...)
 
 
 /**
-plt_tmr_create - Create and run a timer
-@param[in] pltfm_ctx    Context
-@param[in] tmout_ms     Timeout value in milliseconds
-@param[in] tmout_cb     Pointer to the timeout callback function
-@param[in] data         The data that will be passed back as parameter when the callback function is invoked
-@param[in] periodic     Flag to indicate timer is a periodic timer.
-@return     Return a pointer to the internal timer context, NULL indicates failure.
-@pre        Must call plt_init once before using all timer related functions
-@post 		Must call plt_tmr_stop to release the timer resource even if the timer has expired.
+tmr_lnk_init - Initialize a circular list head
+@param[in] hd       List head
+@return
+*/
+static void tmr_lnk_init(tmr_lnk_t *hd)
+{
+    hd->next = hd->prev = hd;
+}
 
+/**
+tmr_lnk_add - Append an entry to the tail of a circular list
+@param[in] hd       List head
+@param[in] ent      Entry to append
+@return
 */
-static void *plt_tmr_create(plt_ctx_t *pltfm_ctx, uint32_t  tmout_ms, tmr_cb_t  tmout_cb, void *data, int16_t periodic)
+static void tmr_lnk_add(tmr_lnk_t *hd, tmr_lnk_t *ent)
 {
-    tmr_ctx_t   tmr_ctx;
-    int         ret_val;
-    uint16_t    tmr_period;
+    ent->next = hd;
+    ent->prev = hd->prev;
+    hd->prev->next = ent;
+    hd->prev = ent;
+}
 
-    //Generate timer id
-    //Note: Periodic timer id should be in different range from one-shot timer id.  If not
-    //      there will be a possibility one-shot timer id equals to periodic timer id after id roll-over
-    //      from 0xFFFF and this may cause the periodic timer being removed while the real intention is to
-    //      remove the one-shot timer with the identical timer id.
-    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+/**
+tmr_lnk_del - Remove an entry from the circular list it is linked to
+@param[in] ent      Entry to remove
+@return
+*/
+static void tmr_lnk_del(tmr_lnk_t *ent)
+{
+    ent->prev->next = ent->next;
+    ent->next->prev = ent->prev;
+    ent->next = ent->prev = ent;
+}
 
-    if (!periodic)
-    {   //One-shot
-        tmr_ctx.id = ++pltfm_ctx->id_gen & ~0x8000;
-        if (tmr_ctx.id == 0)
-        {   //Don't use value of zero as it also represents NULL
-            tmr_ctx.id++;
-            pltfm_ctx->id_gen++;
-        }
-    }
-    else
-    {   //Periodic
-        tmr_ctx.id = (++pltfm_ctx->per_id_gen) | 0x8000;
+/**
+tmr_lnk_splice - Move all the entries of a circular list to the tail of another list
+@param[in] src      Source list head, will be empty on return
+@param[in] dst      Destination list head
+@return
+*/
+static void tmr_lnk_splice(tmr_lnk_t *src, tmr_lnk_t *dst)
+{
+    if (src->next == src)
+    {   //Empty
+        return;
     }
+    src->next->prev = dst->prev;
+    dst->prev->next = src->next;
+    src->prev->next = dst;
+    dst->prev = src->prev;
+    tmr_lnk_init(src);
+}
 
+/**
+tmr_hash_find - Find a timer by its identifier
+@param[in] whl      Timing wheel
+@param[in] id       Timer identifier
+@return     The timer context if found; else NULL
+*/
+static tmr_ctx_t *tmr_hash_find(tmr_whl_t *whl, uint16_t id)
+{
+    tmr_ctx_t   *tmr_ctx;
 
-    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
-
-    //Save the parameters for callback when timer expires
-    tmr_ctx.tmr_cb = tmout_cb;
-    tmr_ctx.data = data;
+    tmr_ctx = whl->hash[id & (TMR_HASH_SZ - 1)];
+    while (tmr_ctx)
+    {
+        if (tmr_ctx->id == id)
+        {
+            return tmr_ctx;
+        }
+        tmr_ctx = tmr_ctx->hash_nxt;
+    }
+    return NULL;
+}
 
-    //Calculate expiry timer ticks
-    tmr_period = tmout_ms / PLT_TIMER_RESOLUTION;
+/**
+tmr_hash_rm - Remove a timer from the id hash table
+@param[in] whl      Timing wheel
+@param[in] tmr_ctx  Timer context
+@return
+*/
+static void tmr_hash_rm(tmr_whl_t *whl, tmr_ctx_t *tmr_ctx)
+{
+    tmr_ctx_t   **ent;
 
-    if ((tmout_ms % PLT_TIMER_RESOLUTION) > 0)
+    ent = &whl->hash[tmr_ctx->id & (TMR_HASH_SZ - 1)];
+    while (*ent)
     {
-        tmr_period++;
+        if (*ent == tmr_ctx)
+        {
+            *ent = tmr_ctx->hash_nxt;
+            return;
+        }
+        ent = &(*ent)->hash_nxt;
     }
+}
 
-    tmr_ctx.tmr_reload = (periodic)? tmr_period : 0;
-    tmr_ctx.tmr_expiry = pltfm_ctx->tmr_tick + tmr_period;
+/**
+tmr_whl_add - Insert a timer into the timing wheel slot according to its expiry ticks
+@param[in] whl      Timing wheel
+@param[in] tmr_ctx  Timer context
+@return
+*/
+static void tmr_whl_add(tmr_whl_t *whl, tmr_ctx_t *tmr_ctx)
+{
+    uint64_t    expiry = tmr_ctx->tmr_expiry;
+    uint64_t    delta = expiry - whl->cur_tick;
+    tmr_lnk_t   *slot;
+    int         i;
+
+    if (expiry <= whl->cur_tick)
+    {   //Already expired or due on the tick just processed, put it in the slot to be processed next
+        expiry = whl->cur_tick + 1;
+        delta = 1;
+    }
 
-    //Add to the timer list
-    ret_val = util_list_add(pltfm_ctx->tmr_mtx, &pltfm_ctx->tmr_lst_hd, (uint8_t *)&tmr_ctx, sizeof(tmr_ctx_t));
-    if (ret_val == 0)
+    if (delta < TMR_WHL_ROOT_SZ)
     {
-        return(void *)tmr_ctx.id;
+        slot = &whl->root[expiry & TMR_WHL_ROOT_MASK];
+        tmr_ctx->whl_lvl = 0;
+    }
+    else
+    {
+        //Find the innermost outer wheel that covers the delta. Timer beyond the range of the
+        //outermost wheel will be cascaded and re-inserted until it is in range.
+        for (i = 0; i < (TMR_WHL_LVL_CNT - 1); i++)
+        {
+            if (delta < (1ULL << (TMR_WHL_ROOT_BITS + ((i + 1) * TMR_WHL_LVL_BITS))))
+            {
+                break;
+            }
+        }
+        slot = &whl->lvl[i][(expiry >> (TMR_WHL_ROOT_BITS + (i * TMR_WHL_LVL_BITS))) & TMR_WHL_LVL_MASK];
+        tmr_ctx->whl_lvl = i + 1;
     }
-    return NULL;
 
+    whl->tmr_cnt[tmr_ctx->whl_lvl]++;
+    tmr_lnk_add(slot, &tmr_ctx->lnk);
 }
 
 /**
-plt_tmr_start - Start a timer
-@param[in] pltfm_ctx    Context
-@param[in] tmout_ms     Timeout value in milliseconds
-@param[in] tmout_cb     Pointer to the timeout callback function
-@param[in] data         The data that will be passed back as parameter when the callback function is invoked
-@return     Return a pointer to the internal timer context, NULL indicates failure.
-@pre        Must call plt_init once before using all timer related functions
-@post 		Must call plt_tmr_stop to release the timer resource even if the timer has expired.
-
+tmr_whl_rm - Remove a timer from the timing wheel or the due list
+@param[in] whl      Timing wheel
+@param[in] tmr_ctx  Timer context
+@return
 */
-void    *plt_tmr_start(plt_ctx_t *pltfm_ctx, uint32_t  tmout_ms, tmr_cb_t  tmout_cb, void *data)
+static void tmr_whl_rm(tmr_whl_t *whl, tmr_ctx_t *tmr_ctx)
 {
-    return plt_tmr_create(pltfm_ctx, tmout_ms, tmout_cb, data, 0);
+    if (tmr_ctx->whl_lvl >= 0)
+    {
+        whl->tmr_cnt[tmr_ctx->whl_lvl]--;
+        tmr_ctx->whl_lvl = -1;
+    }
+    tmr_lnk_del(&tmr_ctx->lnk);
 }
 
 /**
-plt_tmr_stop - Stop the timer and release timer resource
-@param[in] pltfm_ctx   Context
-@param[in] context     The timer context returned from the plt_tmr_start
-@return     Return non-zero indicates success, zero indicates failure.
-@pre        Must call plt_init once before using all timer related functions
-@post		The caller should not use the timer context after this call.
+tmr_whl_cascade - Redistribute the timers in a slot of an outer wheel into the inner wheels
+@param[in] whl      Timing wheel
+@param[in] lvl      Outer wheel level
+@return     The slot index of the outer wheel that has been cascaded
 */
-uint32_t     plt_tmr_stop(plt_ctx_t *pltfm_ctx, void  *context)
+static int tmr_whl_cascade(tmr_whl_t *whl, int lvl)
 {
-    uint32_t        ret_val;
-    uint16_t        tmr_id = (uint16_t)context;
-    util_lst_t      *prev_ent;     //Pointer to previous list entry
-    util_lst_t      *temp;
-    tmr_ctx_t       *tmr_ctx;
-
-    if (!tmr_id)
-        return 0;
+    tmr_lnk_t   *slot;
+    int         idx;
 
-    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+    idx = (whl->cur_tick >> (TMR_WHL_ROOT_BITS + (lvl * TMR_WHL_LVL_BITS))) & TMR_WHL_LVL_MASK;
+    slot = &whl->lvl[lvl][idx];
 
-    if (pltfm_ctx->tmr_lst_hd == NULL)
-    {   //Nothing to remove
-        plt_mtx_ulck(pltfm_ctx->tmr_mtx);
-        return 0;
+    if (whl->tmr_cnt[lvl + 1] == 0)
+    {
+        return idx;
     }
 
-    temp = pltfm_ctx->tmr_lst_hd;
-    prev_ent = NULL;
-
-    ret_val = 0;    //initialize return value to failure
-    while (temp)
+    //Detach the slot first as a timer beyond the range of the outermost wheel
+    //is re-inserted into the same slot
+    if (slot->next != slot)
     {
-        tmr_ctx = (tmr_ctx_t *)temp->wr_buf;
+        tmr_lnk_t   tmp_hd;
 
-        if (tmr_ctx->id == tmr_id)
-        {   //Found timer
-            if (!prev_ent)
-            {   //No previous entry, this is the head of list
-                pltfm_ctx->tmr_lst_hd = temp->next;
-            }
-            else
-            {   //Assign the next entry to the previous entry
-                prev_ent->next = temp->next;
-            }
-            free(temp);
-            ret_val = 1;
-            break;
+        tmr_lnk_init(&tmp_hd);
+        tmr_lnk_splice(slot, &tmp_hd);
+
+        while (tmp_hd.next != &tmp_hd)
+        {
+            tmr_ctx_t *tmr_ctx = (tmr_ctx_t *)tmp_hd.next;
+
+            tmr_whl_rm(whl, tmr_ctx);
+            tmr_whl_add(whl, tmr_ctx);
         }
-        prev_ent = temp;
-        temp = temp->next;
     }
 
-    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
-    return ret_val;
+    return idx;
 }
 
-
-
 /**
-plt_mtx_init - Initialize a recursive mutex
-@param[in, out] context     Pointer to a void * for storing the mutex context
-@return     Return non-zero indicates success, zero indicates failure.
-@post       Should call  plt_mtx_destroy to free the mutex context
+tmr_whl_advance - Advance the timing wheel by one tick and move the expired timers to the due list
+@param[in] whl      Timing wheel
+@return
 */
-uint32_t     plt_mtx_init(void **context)
+static void tmr_whl_advance(tmr_whl_t *whl)
 {
-    uint32_t                ret_val;
-    pthread_mutexattr_t     attr;
-    pthread_mutex_t         *mutex = (pthread_mutex_t  *)malloc(sizeof (pthread_mutex_t));
+    tmr_lnk_t   *slot;
+    int         idx;
+    int         i;
 
-    if (!mutex)
-        return 0;
+    idx = ++whl->cur_tick & TMR_WHL_ROOT_MASK;
 
-    if (pthread_mutexattr_init(&attr) != 0)
-        return 0;
+    if (idx == 0)
+    {   //Root wheel has rolled over, pull in timers from the outer wheels
+        for (i = 0; i < TMR_WHL_LVL_CNT; i++)
+        {
+            if (tmr_whl_cascade(whl, i) != 0)
+            {
+                break;
+            }
+        }
+    }
 
-    //Set attribute to recursive mutex
-#ifdef OS_MAC_X
-    if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
+    slot = &whl->root[idx];
+    while (slot->next != slot)
     {
-        pthread_mutexattr_destroy(&attr);
-        return 0;
+        tmr_ctx_t *tmr_ctx = (tmr_ctx_t *)slot->next;
+
+        tmr_whl_rm(whl, tmr_ctx);
+        tmr_lnk_add(&whl->due, &tmr_ctx->lnk);
     }
-#else
-    if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE_NP) != 0)
+}
+
+/**
+tmr_whl_skip - Skip the ticks that have no timer to process
+@param[in] whl      Timing wheel
+@param[in] now      Current tick
+@return     Non-zero if the wheel has caught up with current tick; else zero
+@post       If the wheel has not caught up, the next call to tmr_whl_advance has work to do
+*/
+static int tmr_whl_skip(tmr_whl_t *whl, uint64_t now)
+{
+    uint64_t    nxt_cascade;
+    int         i;
+
+    if (whl->tmr_cnt[0] > 0)
     {
-        pthread_mutexattr_destroy(&attr);
         return 0;
     }
-#endif
-    //Initialize mutex
-    if (pthread_mutex_init (mutex, &attr) == 0)
-    {   //Successful
-        *context = mutex;
-        ret_val = 1;
-    }
-    else
+
+    for (i = 1; i <= TMR_WHL_LVL_CNT; i++)
     {
-        free(mutex);
-        ret_val = 0;
+        if (whl->tmr_cnt[i] > 0)
+        {
+            break;
+        }
     }
 
-    pthread_mutexattr_destroy(&attr);
-    return ret_val;
+    if (i > TMR_WHL_LVL_CNT)
+    {   //No timer at all
+        whl->cur_tick = now;
+        return 1;
+    }
 
+    //Root wheel is empty, jump to the tick before the next cascade
+    nxt_cascade = (whl->cur_tick | TMR_WHL_ROOT_MASK) + 1;
+    if (nxt_cascade > now)
+    {
+        whl->cur_tick = now;
+        return 1;
+    }
+    whl->cur_tick = nxt_cascade - 1;
+    return 0;
 }
 
-
 /**
-plt_mtx_trylck - Try to lock a mutex
-@param[in] context     The mutex context
-@return     Zero if a lock on the mutex object referenced by mutex is acquired.
-            Otherwise, an error number is returned to indicate the error.
-@pre       The mutex context must be initialized by plt_mtx_init
+tmr_whl_next - Get the earliest expiry of the timers in the timing wheel
+@param[in] whl      Timing wheel
+@return     The earliest expiry in ticks; zero if there is no timer
 */
-int     plt_mtx_trylck(void *context)
+static uint64_t tmr_whl_next(tmr_whl_t *whl)
 {
-    return pthread_mutex_trylock((pthread_mutex_t *)context);
-}
+    uint64_t    next_exp = 0;
+    tmr_lnk_t   *slot;
+    tmr_lnk_t   *ent;
+    int         idx;
+    int         i;
+    int         j;
 
+    //Timers in the root wheel are within the next 256 ticks, the first non-empty slot holds the earliest
+    if (whl->tmr_cnt[0] > 0)
+    {
+        for (i = 1; i <= TMR_WHL_ROOT_SZ; i++)
+        {
+            slot = &whl->root[(whl->cur_tick + i) & TMR_WHL_ROOT_MASK];
+            if (slot->next != slot)
+            {
+                next_exp = whl->cur_tick + i;
+                break;
+            }
+        }
+    }
 
-/**
-plt_mtx_lck - Lock a mutex
-@param[in] context     The mutex context
-@return
-@pre       The mutex context must be initialized by plt_mtx_init
-*/
-void     plt_mtx_lck(void *context)
+    //For outer wheels, the slots following the current slot are in chronological order;
+    //the current slot itself holds the timers one revolution later.
+    for (i = 0; i < TMR_WHL_LVL_CNT; i++)
+    {
+        if (whl->tmr_cnt[i + 1] == 0)
+        {
+            continue;
+        }
+
+        idx = (whl->cur_tick >> (TMR_WHL_ROOT_BITS + (i * TMR_WHL_LVL_BITS))) & TMR_WHL_LVL_MASK;
+        for (j = 1; j <= TMR_WHL_LVL_SZ; j++)
+        {
+            slot = &whl->lvl[i][(idx + j) & TMR_WHL_LVL_MASK];
+            if (slot->next != slot)
+            {
+                for (ent = slot->next; ent != slot; ent = ent->next)
+                {
+                    if ((next_exp == 0) || (((tmr_ctx_t *)ent)->tmr_expiry < next_exp))
+                    {
+                        next_exp = ((tmr_ctx_t *)ent)->tmr_expiry;
+                    }
+                }
+                break;
+            }
+        }
+    }
+
+    return next_exp;
+}
+
+/**
+tmr_whl_create - Create a timing wheel
+@return     The timing wheel if successful; else NULL
+*/
+static tmr_whl_t *tmr_whl_create(void)
+{
+    tmr_whl_t   *whl;
+    int         i;
+    int         j;
+
+    whl = (tmr_whl_t *)calloc(1, sizeof(tmr_whl_t));
+    if (!whl)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < TMR_WHL_ROOT_SZ; i++)
+    {
+        tmr_lnk_init(&whl->root[i]);
+    }
+
+    for (i = 0; i < TMR_WHL_LVL_CNT; i++)
+    {
+        for (j = 0; j < TMR_WHL_LVL_SZ; j++)
+        {
+            tmr_lnk_init(&whl->lvl[i][j]);
+        }
+    }
+
+    tmr_lnk_init(&whl->due);
+
+    return whl;
+}
+
+/**
+tmr_whl_destroy - Free all the timers and the timing wheel
+@param[in] whl      Timing wheel
+@return
+*/
+static void tmr_whl_destroy(tmr_whl_t *whl)
+{
+    tmr_ctx_t   *tmr_ctx;
+    int         i;
+
+    for (i = 0; i < TMR_HASH_SZ; i++)
+    {
+        while (whl->hash[i])
+        {
+            tmr_ctx = whl->hash[i];
+            whl->hash[i] = tmr_ctx->hash_nxt;
+            free(tmr_ctx);
+        }
+    }
+    free(whl);
+}
+
+
+#ifdef PLT_EVT_LOOP
+///
+/// Flag to indicate the calling thread is a timer check thread which serves the event loop
+static __thread int plt_evt_thrd;
+
+/**
+plt_evt_dispatch - Call the callback of a registered file descriptor that is readable
+@param[in] pltfm_ctx    Context
+@param[in] evt_id       The registration index in the lower 32 bits and the file descriptor in the upper 32 bits
+@return
+*/
+static void plt_evt_dispatch(plt_ctx_t *pltfm_ctx, uint64_t evt_id)
+{
+    plt_evt_t       *evt;
+    plt_evt_cb_t    evt_cb;
+    void            *cb_prm;
+    uint32_t        idx = (uint32_t)evt_id;
+
+    if (idx >= PLT_EVT_MAX)
+        return;
+
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+    evt = &pltfm_ctx->evt_tbl[idx];
+    if (!evt->evt_cb || (evt->fd != (int)(evt_id >> 32)))
+    {   //Removed while the event was pending
+        plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+        return;
+    }
+    evt_cb = evt->evt_cb;
+    cb_prm = evt->data;
+    pltfm_ctx->evt_busy = idx + 1;
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+
+    evt_cb(cb_prm);
+
+    pltfm_ctx->evt_busy = 0;
+}
+
+
+/**
+plt_evt_add - Register a file descriptor to be served by the timer check thread
+@param[in] pltfm_ctx    Context
+@param[in] fd           File descriptor
+@param[in] evt_cb       Callback when the file descriptor is readable. It runs on the timer check thread
+                        and must not block.
+@param[in] data         Parameter passed to the callback
+@return     Return ZWHCI_NO_ERROR on success; otherwise negative error number.
+*/
+int plt_evt_add(plt_ctx_t *pltfm_ctx, int fd, plt_evt_cb_t evt_cb, void *data)
+{
+    struct epoll_event  evt;
+    plt_evt_t           *reg;
+    int                 i;
+
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+
+    for (i=0; i<PLT_EVT_MAX; i++)
+    {
+        if (!pltfm_ctx->evt_tbl[i].evt_cb)
+            break;
+    }
+
+    if (i == PLT_EVT_MAX)
+    {
+        plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+        return ZWHCI_ERROR_RESOURCE;
+    }
+
+    reg = &pltfm_ctx->evt_tbl[i];
+    reg->fd = fd;
+    reg->evt_cb = evt_cb;
+    reg->data = data;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.events = EPOLLIN;
+    evt.data.u64 = ((uint64_t)(uint32_t)fd << 32) | (uint32_t)i;
+    if (epoll_ctl(pltfm_ctx->evt_fd, EPOLL_CTL_ADD, fd, &evt) < 0)
+    {
+        reg->evt_cb = NULL;
+        plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+        return ZWHCI_ERROR_RESOURCE;
+    }
+
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+    return ZWHCI_NO_ERROR;
+}
+
+
+/**
+plt_evt_rm - Unregister a file descriptor from the timer check thread
+@param[in] pltfm_ctx    Context
+@param[in] fd           File descriptor
+@return
+@post   The callback of the file descriptor will not be called again. It is not running either,
+        unless this function is called from a callback of the event loop.
+*/
+void plt_evt_rm(plt_ctx_t *pltfm_ctx, int fd)
+{
+    int     i;
+
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+
+    for (i=0; i<PLT_EVT_MAX; i++)
+    {
+        if (pltfm_ctx->evt_tbl[i].evt_cb && (pltfm_ctx->evt_tbl[i].fd == fd))
+            break;
+    }
+
+    if (i == PLT_EVT_MAX)
+    {
+        plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+        return;
+    }
+
+    epoll_ctl(pltfm_ctx->evt_fd, EPOLL_CTL_DEL, fd, NULL);
+    pltfm_ctx->evt_tbl[i].evt_cb = NULL;
+
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+
+    //Wait for the running callback to finish, unless called from the callback
+    while (!plt_evt_thrd && (pltfm_ctx->evt_busy == (i + 1)))
+    {
+        plt_sleep(1);
+    }
+}
+#endif
+
+
+/**
+tmr_wake_arm - Arm the timer check thread wake-up source
+@param[in] pltfm_ctx    Context
+@param[in] deadline     Monotonic time in ticks to wake up the timer check thread; zero to disarm
+@param[in] kick         Flag to indicate the call is from other than the timer check thread
+@return
+@pre        Caller must lock tmr_mtx
+*/
+static void tmr_wake_arm(plt_ctx_t *pltfm_ctx, uint64_t deadline, int kick)
+{
+#ifdef OS_MAC_X
+    uint8_t             dummy = 0;
+
+    pltfm_ctx->tmr_armed = deadline;
+    if (kick)
+    {   //Let the timer check thread re-calculate its timeout
+        if (write(pltfm_ctx->tmr_pipe[1], &dummy, 1) < 0)
+        {
+            //Pipe is full, the thread will wake up anyway
+        }
+    }
+#else
+    struct itimerspec   its;
+    uint64_t            deadline_ms = deadline * PLT_TIMER_RESOLUTION;
+
+    pltfm_ctx->tmr_armed = deadline;
+
+    memset(&its, 0, sizeof(its));
+    if (deadline)
+    {
+        its.it_value.tv_sec = deadline_ms / 1000;
+        its.it_value.tv_nsec = (deadline_ms % 1000) * 1000000;
+    }
+    timerfd_settime(pltfm_ctx->tmr_fd, TFD_TIMER_ABSTIME, &its, NULL);
+#endif
+}
+
+/**
+tmr_wake_wait - Wait for the timer check thread wake-up source. Callbacks of the registered
+                file descriptors that become readable are called while waiting.
+@param[in] pltfm_ctx    Context
+@return
+*/
+static void tmr_wake_wait(plt_ctx_t *pltfm_ctx)
+{
+#ifdef OS_MAC_X
+    struct timeval  tv;
+    struct timeval  *tmout = NULL;
+    fd_set          rd_fds;
+    uint64_t        deadline;
+    uint64_t        now;
+    uint8_t         buf[16];
+
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+    deadline = pltfm_ctx->tmr_armed;
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+
+    if (deadline)
+    {
+        now = plt_mono_ms() / PLT_TIMER_RESOLUTION;
+        deadline = (deadline > now)? (deadline - now) * PLT_TIMER_RESOLUTION : 0;
+        tv.tv_sec = deadline / 1000;
+        tv.tv_usec = (deadline % 1000) * 1000;
+        tmout = &tv;
+    }
+
+    FD_ZERO(&rd_fds);
+    FD_SET(pltfm_ctx->tmr_pipe[0], &rd_fds);
+    if (select(pltfm_ctx->tmr_pipe[0] + 1, &rd_fds, NULL, NULL, tmout) > 0)
+    {
+        if (read(pltfm_ctx->tmr_pipe[0], buf, sizeof(buf)) < 0)
+        {
+            //Nothing to drain
+        }
+    }
+#else
+    struct epoll_event  evts[PLT_EVT_MAX + 1];
+    uint64_t            expr_cnt;
+    int                 evt_cnt;
+    int                 i;
+
+    evt_cnt = epoll_wait(pltfm_ctx->evt_fd, evts, PLT_EVT_MAX + 1, -1);
+
+    for (i=0; i<evt_cnt; i++)
+    {
+        if ((uint32_t)evts[i].data.u64 == PLT_EVT_MAX)
+        {   //Timer expired
+            if (read(pltfm_ctx->tmr_fd, &expr_cnt, sizeof(expr_cnt)) < 0)
+            {
+                //Re-armed by other thread, the caller will re-arm the timer
+            }
+        }
+        else
+        {
+            plt_evt_dispatch(pltfm_ctx, evts[i].data.u64);
+        }
+    }
+#endif
+}
+
+/**
+plt_mono_ms - Get monotonic time
+@return     Monotonic time in milliseconds. It is not affected by system time changes.
+*/
+uint64_t plt_mono_ms(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+
+/**
+plt_mono_us - Get monotonic time
+@return     Monotonic time in microseconds. It is not affected by system time changes.
+*/
+uint64_t plt_mono_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+
+/**
+plt_tmr_create - Create and run a timer
+@param[in] pltfm_ctx    Context
+@param[in] tmout_ms     Timeout value in milliseconds
+@param[in] tmout_cb     Pointer to the timeout callback function
+@param[in] data         The data that will be passed back as parameter when the callback function is invoked
+@param[in] periodic     Flag to indicate timer is a periodic timer.
+@return     Return a pointer to the internal timer context, NULL indicates failure.
+@pre        Must call plt_init once before using all timer related functions
+@post 		Must call plt_tmr_stop to release the timer resource even if the timer has expired.
+
+*/
+static void *plt_tmr_create(plt_ctx_t *pltfm_ctx, uint32_t  tmout_ms, tmr_cb_t  tmout_cb, void *data, int16_t periodic)
+{
+    tmr_whl_t   *whl = (tmr_whl_t *)pltfm_ctx->tmr_whl;
+    tmr_ctx_t   *tmr_ctx;
+    uint32_t    tmr_period;
+    uint64_t    now;
+    uint16_t    id;
+
+    tmr_ctx = (tmr_ctx_t *)malloc(sizeof(tmr_ctx_t));
+    if (!tmr_ctx)
+    {
+        return NULL;
+    }
+
+    //Save the parameters for callback when timer expires
+    tmr_ctx->tmr_cb = tmout_cb;
+    tmr_ctx->data = data;
+
+    //Calculate expiry timer ticks
+    tmr_period = tmout_ms / PLT_TIMER_RESOLUTION;
+
+    if ((tmout_ms % PLT_TIMER_RESOLUTION) > 0)
+    {
+        tmr_period++;
+    }
+
+    if (tmr_period == 0)
+    {   //Expire on the next tick
+        tmr_period = 1;
+    }
+
+    tmr_ctx->tmr_reload = (periodic)? tmr_period : 0;
+
+    //Generate timer id
+    //Note: Periodic timer id should be in different range from one-shot timer id.  If not
+    //      there will be a possibility one-shot timer id equals to periodic timer id after id roll-over
+    //      from 0xFFFF and this may cause the periodic timer being removed while the real intention is to
+    //      remove the one-shot timer with the identical timer id.
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+
+    //Sample the time under the lock so that the timer check thread can't move the wheel past it
+    now = plt_mono_ms() / PLT_TIMER_RESOLUTION;
+
+    do
+    {
+        if (!periodic)
+        {   //One-shot
+            id = ++pltfm_ctx->id_gen & ~0x8000;
+            if (id == 0)
+            {   //Don't use value of zero as it also represents NULL
+                id++;
+                pltfm_ctx->id_gen++;
+            }
+        }
+        else
+        {   //Periodic
+            id = (++pltfm_ctx->per_id_gen) | 0x8000;
+        }
+        //Skip the id of a long running timer that is still in use after id roll-over
+    } while (tmr_hash_find(whl, id));
+
+    tmr_ctx->id = id;
+    tmr_ctx->tmr_expiry = now + tmr_period;
+
+    //Add to the id hash table and timing wheel
+    tmr_ctx->hash_nxt = whl->hash[id & (TMR_HASH_SZ - 1)];
+    whl->hash[id & (TMR_HASH_SZ - 1)] = tmr_ctx;
+    tmr_whl_add(whl, tmr_ctx);
+
+    //Wake up the timer check thread earlier if this is the earliest timer
+    if ((pltfm_ctx->tmr_armed == 0) || (tmr_ctx->tmr_expiry < pltfm_ctx->tmr_armed))
+    {
+        tmr_wake_arm(pltfm_ctx, tmr_ctx->tmr_expiry, 1);
+    }
+
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+
+    return(void *)(uintptr_t)id;
+
+}
+
+/**
+plt_tmr_start - Start a timer
+@param[in] pltfm_ctx    Context
+@param[in] tmout_ms     Timeout value in milliseconds
+@param[in] tmout_cb     Pointer to the timeout callback function
+@param[in] data         The data that will be passed back as parameter when the callback function is invoked
+@return     Return a pointer to the internal timer context, NULL indicates failure.
+@pre        Must call plt_init once before using all timer related functions
+@post 		Must call plt_tmr_stop to release the timer resource even if the timer has expired.
+
+*/
+void    *plt_tmr_start(plt_ctx_t *pltfm_ctx, uint32_t  tmout_ms, tmr_cb_t  tmout_cb, void *data)
+{
+    return plt_tmr_create(pltfm_ctx, tmout_ms, tmout_cb, data, 0);
+}
+
+/**
+plt_tmr_stop - Stop the timer and release timer resource
+@param[in] pltfm_ctx   Context
+@param[in] context     The timer context returned from the plt_tmr_start
+@return     Return non-zero indicates success, zero indicates failure.
+@pre        Must call plt_init once before using all timer related functions
+@post		The caller should not use the timer context after this call.
+*/
+uint32_t     plt_tmr_stop(plt_ctx_t *pltfm_ctx, void  *context)
+{
+    uint16_t        tmr_id = (uint16_t)(uintptr_t)context;
+    tmr_ctx_t       *tmr_ctx;
+
+    if (!tmr_id)
+        return 0;
+
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+
+    tmr_ctx = tmr_hash_find((tmr_whl_t *)pltfm_ctx->tmr_whl, tmr_id);
+    if (!tmr_ctx)
+    {   //Timer has expired or been stopped
+        plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+        return 0;
+    }
+
+    tmr_hash_rm((tmr_whl_t *)pltfm_ctx->tmr_whl, tmr_ctx);
+    tmr_whl_rm((tmr_whl_t *)pltfm_ctx->tmr_whl, tmr_ctx);
+    free(tmr_ctx);
+
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
+    return 1;
+}
+
+
+
+#ifdef PLT_MTX_PROF
+//The functions below are the ones wrapped by the call site recording macros
+#undef plt_mtx_init
+#undef plt_mtx_trylck
+#undef plt_mtx_lck
+#endif
+
+/**
+plt_mtx_recursive_init - Initialize a recursive mutex
+@param[out] mutex       The mutex
+@return     Return non-zero indicates success, zero indicates failure.
+*/
+static uint32_t plt_mtx_recursive_init(pthread_mutex_t *mutex)
+{
+    uint32_t                ret_val;
+    pthread_mutexattr_t     attr;
+
+    if (pthread_mutexattr_init(&attr) != 0)
+        return 0;
+
+    //Set attribute to recursive mutex
+#ifdef OS_MAC_X
+    if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE) != 0)
+    {
+        pthread_mutexattr_destroy(&attr);
+        return 0;
+    }
+#else
+    if (pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE_NP) != 0)
+    {
+        pthread_mutexattr_destroy(&attr);
+        return 0;
+    }
+#endif
+    //Initialize mutex
+    ret_val = (pthread_mutex_init (mutex, &attr) == 0)? 1 : 0;
+
+    pthread_mutexattr_destroy(&attr);
+    return ret_val;
+}
+
+#ifdef PLT_MTX_PROF
+#define PLT_MTX_PROF_CLS_MAX    64      ///< Maximum number of mutex initialization call sites
+#define PLT_MTX_PROF_SITE_MAX   16      ///< Maximum number of lock call sites per mutex initialization call site
+#define PLT_MTX_PROF_HIST_CNT   8       ///< Number of histogram buckets: <1us, <10us, ..., <1s, >=1s
+
+///
+/// Lock call site statistics
+typedef struct
+{
+    const char      *file;      ///< Source file
+    int             line;       ///< Line number
+    uint32_t        acq;        ///< Number of acquisitions
+    uint32_t        cont;       ///< Number of acquisitions that had to wait
+    uint64_t        wait_ns;    ///< Total wait time in nanoseconds
+
+} plt_mtx_site_t;
+
+///
+/// Statistics of the mutexes created at a call site of plt_mtx_init
+typedef struct
+{
+    const char      *file;      ///< Source file
+    int             line;       ///< Line number
+    uint32_t        mtx_cnt;    ///< Number of mutexes created
+    uint32_t        acq;        ///< Number of acquisitions
+    uint32_t        cont;       ///< Number of acquisitions that had to wait
+    uint64_t        wait_ns;    ///< Total wait time in nanoseconds
+    uint64_t        wait_max_ns;///< Longest wait time in nanoseconds
+    uint64_t        hold_ns;    ///< Total hold time in nanoseconds
+    uint64_t        hold_max_ns;///< Longest hold time in nanoseconds
+    uint32_t        wait_hist[PLT_MTX_PROF_HIST_CNT];   ///< Histogram of the wait time of contended acquisitions
+    uint32_t        hold_hist[PLT_MTX_PROF_HIST_CNT];   ///< Histogram of the hold time
+    uint32_t        site_cnt;   ///< Number of lock call sites recorded
+    plt_mtx_site_t  site[PLT_MTX_PROF_SITE_MAX];        ///< Lock call sites
+
+} plt_mtx_cls_t;
+
+///
+/// Profiled mutex
+typedef struct
+{
+    pthread_mutex_t mtx;        ///< The mutex. Must be the first member as the context is used as pthread_mutex_t
+    plt_mtx_cls_t   *cls;       ///< Statistics; NULL if the statistics table is full
+    uint32_t        depth;      ///< Recursive lock count of the owner
+    uint64_t        acq_ns;     ///< Time the owner acquired the mutex
+
+} plt_mtx_prof_t;
+
+static pthread_mutex_t  plt_mtx_prof_mtx = PTHREAD_MUTEX_INITIALIZER;   //Protect the statistics
+static plt_mtx_cls_t    plt_mtx_prof_cls[PLT_MTX_PROF_CLS_MAX];
+static uint32_t         plt_mtx_prof_cls_cnt;
+
+/**
+plt_mtx_prof_ns - Get monotonic time in nanoseconds
+@return     Monotonic time in nanoseconds
+*/
+static uint64_t plt_mtx_prof_ns(void)
+{
+#ifdef OS_MAC_X
+    struct timeval  tv;
+
+    gettimeofday(&tv, NULL);
+    return ((uint64_t)tv.tv_sec * 1000000000) + ((uint64_t)tv.tv_usec * 1000);
+#else
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+#endif
+}
+
+/**
+plt_mtx_prof_bkt - Get the histogram bucket of a time period
+@param[in] ns       Time period in nanoseconds
+@return     Bucket index
+*/
+static int plt_mtx_prof_bkt(uint64_t ns)
+{
+    uint64_t    limit = 1000;
+    int         i;
+
+    for (i=0; i<(PLT_MTX_PROF_HIST_CNT - 1); i++)
+    {
+        if (ns < limit)
+            break;
+        limit *= 10;
+    }
+    return i;
+}
+
+/**
+plt_mtx_prof_acq - Record an acquisition of the mutex
+@param[in] prof         The profiled mutex
+@param[in] file         Lock call site source file
+@param[in] line         Lock call site line number
+@param[in] wait_ns      Time waited for the mutex; zero if not contended
+@param[in] now          Current time
+@return
+@pre    Caller must own the mutex
+*/
+static void plt_mtx_prof_acq(plt_mtx_prof_t *prof, const char *file, int line, uint64_t wait_ns, uint64_t now)
+{
+    plt_mtx_cls_t   *cls = prof->cls;
+    plt_mtx_site_t  *site;
+    uint32_t        i;
+
+    if (prof->depth++ == 0)
+    {
+        prof->acq_ns = now;
+    }
+
+    if (!cls)
+        return;
+
+    pthread_mutex_lock(&plt_mtx_prof_mtx);
+
+    cls->acq++;
+    if (wait_ns)
+    {
+        cls->cont++;
+        cls->wait_ns += wait_ns;
+        if (wait_ns > cls->wait_max_ns)
+        {
+            cls->wait_max_ns = wait_ns;
+        }
+        cls->wait_hist[plt_mtx_prof_bkt(wait_ns)]++;
+    }
+
+    //Find the lock call site
+    for (i=0; i<cls->site_cnt; i++)
+    {
+        site = &cls->site[i];
+        if ((site->line == line) && ((site->file == file) || (strcmp(site->file, file) == 0)))
+            break;
+    }
+
+    if (i == cls->site_cnt)
+    {
+        if (i < PLT_MTX_PROF_SITE_MAX)
+        {   //New call site
+            site = &cls->site[cls->site_cnt++];
+            site->file = file;
+            site->line = line;
+        }
+        else
+        {
+            site = NULL;
+        }
+    }
+
+    if (site)
+    {
+        site->acq++;
+        if (wait_ns)
+        {
+            site->cont++;
+            site->wait_ns += wait_ns;
+        }
+    }
+
+    pthread_mutex_unlock(&plt_mtx_prof_mtx);
+}
+
+/**
+plt_mtx_prof_rel - Record the hold time when the owner releases the mutex
+@param[in] prof         The profiled mutex
+@return
+@pre    Caller must own the mutex and have just released the outermost lock
+*/
+static void plt_mtx_prof_rel(plt_mtx_prof_t *prof)
+{
+    plt_mtx_cls_t   *cls = prof->cls;
+    uint64_t        hold_ns;
+
+    if (!cls)
+        return;
+
+    hold_ns = plt_mtx_prof_ns() - prof->acq_ns;
+
+    pthread_mutex_lock(&plt_mtx_prof_mtx);
+    cls->hold_ns += hold_ns;
+    if (hold_ns > cls->hold_max_ns)
+    {
+        cls->hold_max_ns = hold_ns;
+    }
+    cls->hold_hist[plt_mtx_prof_bkt(hold_ns)]++;
+    pthread_mutex_unlock(&plt_mtx_prof_mtx);
+}
+
+/**
+plt_mtx_prof_init - Initialize a recursive mutex with contention profiling
+@param[in, out] context     Pointer to a void * for storing the mutex context
+@param[in]      file        Call site source file
+@param[in]      line        Call site line number
+@return     Return non-zero indicates success, zero indicates failure.
+@post       Should call  plt_mtx_destroy to free the mutex context
+*/
+uint32_t plt_mtx_prof_init(void **context, const char *file, int line)
+{
+    plt_mtx_prof_t  *prof;
+    plt_mtx_cls_t   *cls;
+    uint32_t        i;
+
+    prof = (plt_mtx_prof_t *)calloc(1, sizeof(plt_mtx_prof_t));
+    if (!prof)
+        return 0;
+
+    if (!plt_mtx_recursive_init(&prof->mtx))
+    {
+        free(prof);
+        return 0;
+    }
+
+    //Mutexes created at the same call site share the statistics
+    pthread_mutex_lock(&plt_mtx_prof_mtx);
+    for (i=0; i<plt_mtx_prof_cls_cnt; i++)
+    {
+        cls = &plt_mtx_prof_cls[i];
+        if ((cls->line == line) && ((cls->file == file) || (strcmp(cls->file, file) == 0)))
+            break;
+    }
+
+    if (i == plt_mtx_prof_cls_cnt)
+    {
+        if (i < PLT_MTX_PROF_CLS_MAX)
+        {
+            cls = &plt_mtx_prof_cls[plt_mtx_prof_cls_cnt++];
+            cls->file = file;
+            cls->line = line;
+        }
+        else
+        {
+            cls = NULL;
+        }
+    }
+
+    if (cls)
+    {
+        cls->mtx_cnt++;
+    }
+    prof->cls = cls;
+    pthread_mutex_unlock(&plt_mtx_prof_mtx);
+
+    *context = prof;
+    return 1;
+}
+
+/**
+plt_mtx_prof_trylck - Try to lock a mutex with contention profiling
+@param[in] context     The mutex context
+@param[in] file        Call site source file
+@param[in] line        Call site line number
+@return     Zero if a lock on the mutex object referenced by mutex is acquired.
+            Otherwise, an error number is returned to indicate the error.
+@pre       The mutex context must be initialized by plt_mtx_init
+*/
+int plt_mtx_prof_trylck(void *context, const char *file, int line)
+{
+    plt_mtx_prof_t  *prof = (plt_mtx_prof_t *)context;
+    int             ret;
+
+    ret = pthread_mutex_trylock(&prof->mtx);
+    if (ret == 0)
+    {
+        plt_mtx_prof_acq(prof, file, line, 0, plt_mtx_prof_ns());
+    }
+    return ret;
+}
+
+/**
+plt_mtx_prof_lck - Lock a mutex with contention profiling
+@param[in] context     The mutex context
+@param[in] file        Call site source file
+@param[in] line        Call site line number
+@return
+@pre       The mutex context must be initialized by plt_mtx_init
+*/
+void plt_mtx_prof_lck(void *context, const char *file, int line)
+{
+    plt_mtx_prof_t  *prof = (plt_mtx_prof_t *)context;
+    uint64_t        start;
+    uint64_t        now;
+
+    if (pthread_mutex_trylock(&prof->mtx) == 0)
+    {
+        plt_mtx_prof_acq(prof, file, line, 0, plt_mtx_prof_ns());
+        return;
+    }
+
+    //Contended
+    start = plt_mtx_prof_ns();
+    pthread_mutex_lock(&prof->mtx);
+    now = plt_mtx_prof_ns();
+    plt_mtx_prof_acq(prof, file, line, (now > start)? (now - start) : 1, now);
+}
+
+/**
+plt_mtx_prof_cmp - Compare function to sort the statistics by total wait time in descending order
+@param[in] a    Statistics
+@param[in] b    Statistics
+@return     Negative if a should come first, positive if b should come first; else zero
+*/
+static int plt_mtx_prof_cmp(const void *a, const void *b)
+{
+    const plt_mtx_cls_t *cls_a = (const plt_mtx_cls_t *)a;
+    const plt_mtx_cls_t *cls_b = (const plt_mtx_cls_t *)b;
+
+    if (cls_a->wait_ns != cls_b->wait_ns)
+        return (cls_a->wait_ns > cls_b->wait_ns)? -1 : 1;
+
+    return (int)cls_b->acq - (int)cls_a->acq;
+}
+
+/**
+plt_mtx_prof_name - Get the file name without directories
+@param[in] file     Source file
+@return     The file name
+*/
+static const char *plt_mtx_prof_name(const char *file)
+{
+    const char *name = strrchr(file, '/');
+
+    return (name)? name + 1 : file;
+}
+
+/**
+plt_mtx_prof_dump - Show the mutex contention statistics, with the mutexes that callers waited the longest
+                    for first. Mutexes created at the same call site of plt_mtx_init are reported together.
+                    Time spent in plt_cond_timedwait is not counted as hold time.
+@param[in] pltfm_ctx    Context
+@return
+*/
+void plt_mtx_prof_dump(plt_ctx_t *pltfm_ctx)
+{
+    plt_mtx_cls_t   *snap;
+    plt_mtx_cls_t   *cls;
+    plt_mtx_site_t  *site;
+    uint32_t        cls_cnt;
+    uint32_t        i;
+    uint32_t        j;
+    char            site_name[64];
+
+    snap = (plt_mtx_cls_t *)malloc(sizeof(plt_mtx_prof_cls));
+    if (!snap)
+        return;
+
+    pthread_mutex_lock(&plt_mtx_prof_mtx);
+    cls_cnt = plt_mtx_prof_cls_cnt;
+    memcpy(snap, plt_mtx_prof_cls, sizeof(plt_mtx_cls_t) * cls_cnt);
+    pthread_mutex_unlock(&plt_mtx_prof_mtx);
+
+    qsort(snap, cls_cnt, sizeof(plt_mtx_cls_t), plt_mtx_prof_cmp);
+
+    plt_msg_show(pltfm_ctx, "Mutex contention profile (time in us)");
+    plt_msg_show(pltfm_ctx, "%-28s %4s %10s %8s %10s %8s %10s %8s",
+                 "Created at", "Mtx", "Acquired", "Waited", "Wait", "Wait max", "Hold", "Hold max");
+
+    for (i=0; i<cls_cnt; i++)
+    {
+        cls = &snap[i];
+        snprintf(site_name, sizeof(site_name), "%s:%d", plt_mtx_prof_name(cls->file), cls->line);
+        plt_msg_show(pltfm_ctx, "%-28s %4u %10u %8u %10llu %8llu %10llu %8llu",
+                     site_name, cls->mtx_cnt, cls->acq, cls->cont,
+                     (unsigned long long)(cls->wait_ns / 1000), (unsigned long long)(cls->wait_max_ns / 1000),
+                     (unsigned long long)(cls->hold_ns / 1000), (unsigned long long)(cls->hold_max_ns / 1000));
+
+        plt_msg_show(pltfm_ctx, "    wait <1us:%u <10us:%u <100us:%u <1ms:%u <10ms:%u <100ms:%u <1s:%u >=1s:%u",
+                     cls->wait_hist[0], cls->wait_hist[1], cls->wait_hist[2], cls->wait_hist[3],
+                     cls->wait_hist[4], cls->wait_hist[5], cls->wait_hist[6], cls->wait_hist[7]);
+
+        plt_msg_show(pltfm_ctx, "    hold <1us:%u <10us:%u <100us:%u <1ms:%u <10ms:%u <100ms:%u <1s:%u >=1s:%u",
+                     cls->hold_hist[0], cls->hold_hist[1], cls->hold_hist[2], cls->hold_hist[3],
+                     cls->hold_hist[4], cls->hold_hist[5], cls->hold_hist[6], cls->hold_hist[7]);
+
+        for (j=0; j<cls->site_cnt; j++)
+        {
+            site = &cls->site[j];
+            plt_msg_show(pltfm_ctx, "    locked at %s:%d acquired:%u waited:%u wait:%llu",
+                         plt_mtx_prof_name(site->file), site->line, site->acq, site->cont,
+                         (unsigned long long)(site->wait_ns / 1000));
+        }
+    }
+
+    free(snap);
+}
+
+/**
+plt_mtx_prof_reset - Clear the mutex contention statistics
+@return
+*/
+void plt_mtx_prof_reset(void)
+{
+    plt_mtx_cls_t   *cls;
+    uint32_t        i;
+    uint32_t        j;
+
+    pthread_mutex_lock(&plt_mtx_prof_mtx);
+    for (i=0; i<plt_mtx_prof_cls_cnt; i++)
+    {
+        cls = &plt_mtx_prof_cls[i];
+        cls->acq = cls->cont = 0;
+        cls->wait_ns = cls->wait_max_ns = cls->hold_ns = cls->hold_max_ns = 0;
+        memset(cls->wait_hist, 0, sizeof(cls->wait_hist));
+        memset(cls->hold_hist, 0, sizeof(cls->hold_hist));
+        for (j=0; j<cls->site_cnt; j++)
+        {
+            cls->site[j].acq = cls->site[j].cont = 0;
+            cls->site[j].wait_ns = 0;
+        }
+    }
+    pthread_mutex_unlock(&plt_mtx_prof_mtx);
+}
+#endif
+
+
+/**
+plt_mtx_init - Initialize a recursive mutex
+@param[in, out] context     Pointer to a void * for storing the mutex context
+@return     Return non-zero indicates success, zero indicates failure.
+@post       Should call  plt_mtx_destroy to free the mutex context
+*/
+uint32_t     plt_mtx_init(void **context)
+{
+#ifdef PLT_MTX_PROF
+    return plt_mtx_prof_init(context, __FILE__, __LINE__);
+#else
+    pthread_mutex_t         *mutex = (pthread_mutex_t  *)malloc(sizeof (pthread_mutex_t));
+
+    if (!mutex)
+        return 0;
+
+    if (!plt_mtx_recursive_init(mutex))
+    {
+        free(mutex);
+        return 0;
+    }
+
+    *context = mutex;
+    return 1;
+#endif
+}
+
+
+/**
+plt_mtx_trylck - Try to lock a mutex
+@param[in] context     The mutex context
+@return     Zero if a lock on the mutex object referenced by mutex is acquired.
+            Otherwise, an error number is returned to indicate the error.
+@pre       The mutex context must be initialized by plt_mtx_init
+*/
+int     plt_mtx_trylck(void *context)
+{
+#ifdef PLT_MTX_PROF
+    return plt_mtx_prof_trylck(context, __FILE__, __LINE__);
+#else
+    return pthread_mutex_trylock((pthread_mutex_t *)context);
+#endif
+}
+
+
+/**
+plt_mtx_lck - Lock a mutex
+@param[in] context     The mutex context
+@return
+@pre       The mutex context must be initialized by plt_mtx_init
+*/
+void     plt_mtx_lck(void *context)
 {
+#ifdef PLT_MTX_PROF
+    plt_mtx_prof_lck(context, __FILE__, __LINE__);
+#else
     pthread_mutex_lock((pthread_mutex_t *)context);
+#endif
 }
 
 /**
@@ -1361,6 +2604,14 @@ plt_mtx_ulck - Unlock a mutex
 */
 void     plt_mtx_ulck(void *context)
 {
+#ifdef PLT_MTX_PROF
+    plt_mtx_prof_t  *prof = (plt_mtx_prof_t *)context;
+
+    if (prof->depth && (--prof->depth == 0))
+    {
+        plt_mtx_prof_rel(prof);
+    }
+#endif
     pthread_mutex_unlock((pthread_mutex_t *)context);
 }
 
@@ -1620,10 +2871,33 @@ int     plt_cond_timedwait(void *cond_ctx, void *mtx, uint16_t timeout_ms)
 
     ts.tv_nsec = nanosec;
 
+#ifdef PLT_MTX_PROF
+    {
+        plt_mtx_prof_t  *prof = (plt_mtx_prof_t *)mtx;
+        uint32_t        depth = prof->depth;
+
+        //The mutex is released while waiting, don't count the wait as hold time
+        if (depth)
+        {
+            prof->depth = 0;
+            plt_mtx_prof_rel(prof);
+        }
+
+        ret = pthread_cond_timedwait(cv, mutex, &ts);
+
+        prof->depth = depth;
+        prof->acq_ns = plt_mtx_prof_ns();
+    }
+    if (ret == 0)
+    {
+        return 0;
+    }
+#else
     if ((ret = pthread_cond_timedwait(cv, mutex, &ts)) == 0)
     {
         return 0;
     }
+#endif
 
     if (ret == ETIMEDOUT)
     {
@@ -1683,6 +2957,7 @@ plt_thrd_run - Run a thread
 static void *plt_thrd_run(void *args)
 {
     thrd_ctx_t      *thrd_ctx = (thrd_ctx_t *)args;
+    plt_lib_thrd = 1;
     thrd_ctx->start_adr(thrd_ctx->args);
     free(thrd_ctx);
     return NULL;
@@ -1718,6 +2993,15 @@ int     plt_thrd_create(void(*start_adr)( void * ), void *args)
     return -2;
 }
 
+/**
+plt_thrd_is_lib - Check whether the calling thread is created by plt_thrd_create
+@return     Non-zero if the calling thread is a library thread; zero if it is an application thread.
+*/
+int     plt_thrd_is_lib(void)
+{
+    return plt_lib_thrd;
+}
+
 /**
 plt_sleep - Suspends the execution of the current thread until the time-out interval elapses.
 @param[in] tmout_ms   The time interval for which execution is to be suspended, in milliseconds.
@@ -1754,46 +3038,339 @@ void    *plt_periodic_start(plt_ctx_t *pltfm_ctx, uint32_t  tmout_ms, tmr_cb_t
 
 
 /**
-tmr_tck_thrd - thread to generate timer tick
-@param[in]	data		Context
+tmr_cb_job_get - Get the first job in the queue whose data is not being processed by other worker
+@param[in] pool     Timer callback executor
+@param[in] wrk      The worker requesting the job
+@return     The job if found; else NULL
+@pre        Caller must lock pool->mtx
+*/
+static tmr_cb_job_t *tmr_cb_job_get(tmr_cb_pool_t *pool, tmr_cb_wrk_t *wrk)
+{
+    tmr_cb_job_t    *job;
+    tmr_cb_job_t    *prev_job = NULL;
+    int             i;
+    int             busy;
+
+    for (job = pool->job_hd; job; prev_job = job, job = job->next)
+    {
+        //Callbacks of the same object are executed one at a time and in order
+        busy = 0;
+        if (job->data)
+        {
+            for (i = 0; i < (pool->thrd_cnt + PLT_TMR_CB_OVF_MAX); i++)
+            {
+                if (pool->wrk[i].data == job->data)
+                {
+                    busy = 1;
+                    break;
+                }
+            }
+        }
+
+        if (!busy)
+        {   //Remove from queue
+            if (prev_job)
+            {
+                prev_job->next = job->next;
+            }
+            else
+            {
+                pool->job_hd = job->next;
+            }
+
+            if (pool->job_tl == job)
+            {
+                pool->job_tl = prev_job;
+            }
+
+            wrk->data = job->data;
+            return job;
+        }
+    }
+    return NULL;
+}
+
+/**
+tmr_cb_job_run - Run a job and release it
+@param[in] pool     Timer callback executor
+@param[in] wrk      The worker running the job
+@param[in] job      The job
 @return
 */
-static void tmr_tck_thrd(void   *data)
+static void tmr_cb_job_run(tmr_cb_pool_t *pool, tmr_cb_wrk_t *wrk, tmr_cb_job_t *job)
 {
-    plt_ctx_t *plt_ctx = (plt_ctx_t *)data;
-    struct timespec timeout_val;
+    job->tmr_cb(job->data);
+    free(job);
 
-    plt_ctx->tmr_tck_thrd_sts = 1;
+    plt_mtx_lck(pool->mtx);
+    wrk->data = NULL;
+    if (pool->job_hd)
+    {   //Jobs of the same object may be waiting for this job to complete
+        plt_sem_post(pool->sem);
+    }
+    plt_mtx_ulck(pool->mtx);
+}
 
-    // Calculate timeout
-    timeout_val.tv_sec = 0;
-    timeout_val.tv_nsec = PLT_TIMER_RESOLUTION * 1000000; //convert ms to ns
+/**
+tmr_cb_wrk_thrd - Fixed worker thread of the timer callback executor
+@param[in] data     Worker
+@return
+*/
+static void tmr_cb_wrk_thrd(void *data)
+{
+    tmr_cb_wrk_t    *wrk = (tmr_cb_wrk_t *)data;
+    tmr_cb_pool_t   *pool = wrk->pool;
+    tmr_cb_job_t    *job;
 
-    while (plt_ctx->tmr_tck_thrd_run)
+    while (1)
     {
-        nanosleep(&timeout_val, NULL);
-        //Update timer tick
-        plt_ctx->tmr_tick++;
+        plt_mtx_lck(pool->mtx);
+        pool->idle_cnt++;
+        plt_mtx_ulck(pool->mtx);
+
+        //Wait for job
+        plt_sem_wait(pool->sem);
 
-        //Send timer tick event
-        plt_sem_post(plt_ctx->tmr_sem);
+        plt_mtx_lck(pool->mtx);
+        //A claimed wake up was counted out of idle_cnt when the job was queued
+        if (pool->wake_cnt > 0)
+        {
+            pool->wake_cnt--;
+        }
+        else
+        {
+            pool->idle_cnt--;
+        }
+
+        //Check whether to exit the thread
+        if (pool->run == 0)
+        {
+            pool->thrd_sts_cnt--;
+            plt_mtx_ulck(pool->mtx);
+            return;
+        }
 
+        job = tmr_cb_job_get(pool, wrk);
+        plt_mtx_ulck(pool->mtx);
+
+        if (job)
+        {
+            tmr_cb_job_run(pool, wrk, job);
+        }
     }
+}
+
+/**
+tmr_cb_ovf_thrd - Overflow worker thread of the timer callback executor. It runs until no job can be served.
+@param[in] data     Worker
+@return
+*/
+static void tmr_cb_ovf_thrd(void *data)
+{
+    tmr_cb_wrk_t    *wrk = (tmr_cb_wrk_t *)data;
+    tmr_cb_pool_t   *pool = wrk->pool;
+    tmr_cb_job_t    *job;
+
+    while (1)
+    {
+        plt_mtx_lck(pool->mtx);
 
-    plt_ctx->tmr_tck_thrd_sts = 0;
+        job = (pool->run)? tmr_cb_job_get(pool, wrk) : NULL;
+        if (!job)
+        {
+            wrk->in_use = 0;
+            pool->ovf_cnt--;
+            pool->thrd_sts_cnt--;
+            plt_mtx_ulck(pool->mtx);
+            return;
+        }
+        plt_mtx_ulck(pool->mtx);
 
+        tmr_cb_job_run(pool, wrk, job);
+    }
 }
 
 /**
-tmr_expr_cb_thrd - Timer expire callback thread
-@param[in] args         Thread context.
+tmr_cb_job_put - Queue a timer callback to the executor
+@param[in] pool     Timer callback executor
+@param[in] tmr_cb   The callback function to call
+@param[in] data     The data passed as parameter to the callback function
+@return     Zero on success; else negative error number
+*/
+static int tmr_cb_job_put(tmr_cb_pool_t *pool, tmr_cb_t tmr_cb, void *data)
+{
+    tmr_cb_job_t    *job;
+    int             i;
+
+    job = (tmr_cb_job_t *)malloc(sizeof(tmr_cb_job_t));
+    if (!job)
+    {
+        return ZWHCI_ERROR_MEMORY;
+    }
+
+    job->next = NULL;
+    job->tmr_cb = tmr_cb;
+    job->data = data;
+
+    plt_mtx_lck(pool->mtx);
+
+    if (pool->job_tl)
+    {
+        pool->job_tl->next = job;
+    }
+    else
+    {
+        pool->job_hd = job;
+    }
+    pool->job_tl = job;
+
+    if (pool->idle_cnt > 0)
+    {   //Claim an idle fixed worker for this job only, so that the other jobs queued before
+        //it wakes up don't count on it
+        pool->idle_cnt--;
+        pool->wake_cnt++;
+    }
+    else if (pool->ovf_cnt < PLT_TMR_CB_OVF_MAX)
+    {   //All the fixed workers are busy, probably blocked by their callbacks. Start an overflow
+        //worker so that the callback doesn't wait for them, which may cause deadlock.
+        for (i = pool->thrd_cnt; i < (pool->thrd_cnt + PLT_TMR_CB_OVF_MAX); i++)
+        {
+            if (!pool->wrk[i].in_use)
+            {
+                pool->wrk[i].in_use = 1;
+                pool->ovf_cnt++;
+                pool->thrd_sts_cnt++;
+                if (plt_thrd_create(tmr_cb_ovf_thrd, &pool->wrk[i]) < 0)
+                {
+                    pool->wrk[i].in_use = 0;
+                    pool->ovf_cnt--;
+                    pool->thrd_sts_cnt--;
+                }
+                break;
+            }
+        }
+    }
+
+    plt_sem_post(pool->sem);
+
+    plt_mtx_ulck(pool->mtx);
+
+    return 0;
+}
+
+/**
+tmr_cb_pool_destroy - Stop the worker threads and destroy the timer callback executor
+@param[in] pool     Timer callback executor
 @return
 */
-static void tmr_expr_cb_thrd(void *args)
+static void tmr_cb_pool_destroy(tmr_cb_pool_t *pool)
 {
-    thrd_ctx_t      *thrd_ctx = (thrd_ctx_t *)args;
-    thrd_ctx->start_adr(thrd_ctx->args);
-    free(thrd_ctx);
+    tmr_cb_job_t    *job;
+    int             i;
+    int             wait_count;
+
+    //Stop all the threads
+    plt_mtx_lck(pool->mtx);
+    pool->run = 0;
+    for (i = 0; i < pool->thrd_cnt; i++)
+    {
+        plt_sem_post(pool->sem);
+    }
+    plt_mtx_ulck(pool->mtx);
+
+    wait_count = 50;
+    while (wait_count-- > 0)
+    {
+        if (pool->thrd_sts_cnt == 0)
+            break;
+        plt_sleep(100);
+    }
+
+    if (pool->thrd_sts_cnt != 0)
+    {   //A worker is still blocked in a callback and would access the pool after it is freed,
+        //leave the pool allocated
+        return;
+    }
+
+    //Free the pending jobs
+    while (pool->job_hd)
+    {
+        job = pool->job_hd;
+        pool->job_hd = job->next;
+        free(job);
+    }
+
+    plt_sem_destroy(pool->sem);
+    plt_mtx_destroy(pool->mtx);
+    free(pool->wrk);
+    free(pool);
+}
+
+/**
+tmr_cb_pool_create - Create the timer callback executor and start its fixed worker threads
+@param[in] thrd_cnt     Number of fixed worker threads
+@return     The timer callback executor if successful; else NULL
+*/
+static tmr_cb_pool_t *tmr_cb_pool_create(int thrd_cnt)
+{
+    tmr_cb_pool_t   *pool;
+    int             i;
+
+    pool = (tmr_cb_pool_t *)calloc(1, sizeof(tmr_cb_pool_t));
+    if (!pool)
+    {
+        return NULL;
+    }
+
+    pool->wrk = (tmr_cb_wrk_t *)calloc(thrd_cnt + PLT_TMR_CB_OVF_MAX, sizeof(tmr_cb_wrk_t));
+    if (!pool->wrk)
+    {
+        goto l_TMR_CB_POOL_ERROR;
+    }
+
+    if (!plt_mtx_init(&pool->mtx))
+    {
+        goto l_TMR_CB_POOL_ERROR1;
+    }
+
+    if (!plt_sem_init(&pool->sem))
+    {
+        goto l_TMR_CB_POOL_ERROR2;
+    }
+
+    pool->run = 1;
+    for (i = 0; i < (thrd_cnt + PLT_TMR_CB_OVF_MAX); i++)
+    {
+        pool->wrk[i].pool = pool;
+    }
+
+    for (i = 0; i < thrd_cnt; i++)
+    {
+        pool->wrk[i].in_use = 1;
+        plt_mtx_lck(pool->mtx);
+        pool->thrd_sts_cnt++;
+        pool->thrd_cnt++;
+        plt_mtx_ulck(pool->mtx);
+        if (plt_thrd_create(tmr_cb_wrk_thrd, &pool->wrk[i]) < 0)
+        {
+            plt_mtx_lck(pool->mtx);
+            pool->thrd_sts_cnt--;
+            pool->thrd_cnt--;
+            plt_mtx_ulck(pool->mtx);
+            tmr_cb_pool_destroy(pool);
+            return NULL;
+        }
+    }
+
+    return pool;
+
+l_TMR_CB_POOL_ERROR2:
+    plt_mtx_destroy(pool->mtx);
+l_TMR_CB_POOL_ERROR1:
+    free(pool->wrk);
+l_TMR_CB_POOL_ERROR:
+    free(pool);
+    return NULL;
 }
 
 /**
@@ -1804,18 +3381,21 @@ tmr_chk_thrd - thread to process timer tick event
 static void tmr_chk_thrd(void   *data)
 {
     plt_ctx_t       *plt_ctx = (plt_ctx_t *)data;
-    util_lst_t      *prev_ent;     //Pointer to previous list entry
-    util_lst_t      *temp;
+    tmr_whl_t       *whl = (tmr_whl_t *)plt_ctx->tmr_whl;
     tmr_ctx_t       *tmr_ctx;
     tmr_cb_t        tmr_cb;         //The callback function to call when timer expires
     void            *cb_prm;        //The data passed as parameter to the callback function
+    uint64_t        now;
 
     plt_ctx->tmr_chk_thrd_sts = 1;
+#ifdef PLT_EVT_LOOP
+    plt_evt_thrd = 1;
+#endif
 
     while (1)
     {
-        //Wait for timer tick event
-        plt_sem_wait(plt_ctx->tmr_sem);
+        //Sleep until the earliest timer expires or a new earlier timer is started
+        tmr_wake_wait(plt_ctx);
 
         //Check whether to exit the thread
         if (plt_ctx->tmr_chk_thrd_run == 0)
@@ -1824,27 +3404,28 @@ static void tmr_chk_thrd(void   *data)
             return;
         }
 
-        //Check each of the timer contexts for expiry
         plt_mtx_lck(plt_ctx->tmr_mtx);
 
-        if (plt_ctx->tmr_lst_hd == NULL)
-        {   //Nothing to remove
-            plt_mtx_ulck(plt_ctx->tmr_mtx);
-            continue;
-        }
+        now = plt_mono_ms() / PLT_TIMER_RESOLUTION;
 
-        temp = plt_ctx->tmr_lst_hd;
-        prev_ent = NULL;
-
-        while (temp)
+        //Advance the timing wheel to current time; ticks without timer to process are skipped
+        while (whl->cur_tick < now)
         {
-            tmr_ctx = (tmr_ctx_t *)temp->wr_buf;
+            if (tmr_whl_skip(whl, now))
+            {
+                break;
+            }
 
-            if (util_tmr_exp_chk(plt_ctx->tmr_tick, tmr_ctx->tmr_expiry))
-            {   //Timer expired
-                thrd_ctx_t      *thrd_ctx;
+            tmr_whl_advance(whl);
+
+            //Process the expired timers
+            while (whl->due.next != &whl->due)
+            {
                 int             periodic;   //flag whether timer is periodic
 
+                tmr_ctx = (tmr_ctx_t *)whl->due.next;
+                tmr_whl_rm(whl, tmr_ctx);
+
                 tmr_cb = tmr_ctx->tmr_cb;
                 cb_prm = tmr_ctx->data;
 
@@ -1852,28 +3433,25 @@ static void tmr_chk_thrd(void   *data)
                 if (tmr_ctx->tmr_reload > 0)
                 {   //Periodic timer
                     periodic = 1;
-                    tmr_ctx->tmr_expiry = plt_ctx->tmr_tick + tmr_ctx->tmr_reload;
+                    tmr_ctx->tmr_expiry += tmr_ctx->tmr_reload;
+                    if (tmr_ctx->tmr_expiry <= whl->cur_tick)
+                    {   //Missed some periods, don't try to catch up
+                        tmr_ctx->tmr_expiry = whl->cur_tick + tmr_ctx->tmr_reload;
+                    }
+                    tmr_whl_add(whl, tmr_ctx);
                 }
                 else
                 {   //One shot timer, remove it.
                     periodic = 0;
-                    if (!prev_ent)
-                    {   //No previous entry, this is the head of list
-                        plt_ctx->tmr_lst_hd = temp->next;
-                    }
-                    else
-                    {   //Assign the next entry to the previous entry
-                        prev_ent->next = temp->next;
-                    }
-                    free(temp);
-
+                    tmr_hash_rm(whl, tmr_ctx);
+                    free(tmr_ctx);
                 }
 
                 //Callback timer callback function
                 //DON'T hold the lock as this could cause deadlock if timer callback function calls
                 //plt_sem_wait() etc. that may sleep.
                 plt_mtx_ulck(plt_ctx->tmr_mtx);
-                if (periodic)
+                if (periodic && !plt_ctx->evt_loop)
                 {
                     //IMPORTANT: Make sure the periodic callback function does not sleep/block
                     //          (by calling plt_sem_wait, plt_mtx_lck, etc) to avoid deadlock
@@ -1881,27 +3459,21 @@ static void tmr_chk_thrd(void   *data)
                 }
                 else
                 {
-                    //Create new thread for every callback to avoid deadlock
-                    thrd_ctx = (thrd_ctx_t *)malloc(sizeof(thrd_ctx_t));
-                    if (thrd_ctx)
-                    {
-                        thrd_ctx->start_adr = tmr_cb;
-                        thrd_ctx->args = cb_prm;
-                        plt_thrd_create(tmr_expr_cb_thrd, thrd_ctx);
-                    }
+                    //Hand over to the callback executor so that a blocking callback
+                    //doesn't hold up the timers. In event loop mode this thread also serves
+                    //the serial port, so periodic callbacks are handed over as well
+                    tmr_cb_job_put((tmr_cb_pool_t *)plt_ctx->tmr_cb_pool, tmr_cb, cb_prm);
                 }
                 plt_mtx_lck(plt_ctx->tmr_mtx);
 
-                //Start checking from the list head again since the timer callback function
-                //may have changed the timer list.
-                temp = plt_ctx->tmr_lst_hd;
-                prev_ent = NULL;
-                continue;
+                //Note: the timer callback function may have stopped other due timers,
+                //      these have been unlinked from the due list by plt_tmr_stop.
             }
-            prev_ent = temp;
-            temp = temp->next;
         }
 
+        //Sleep until the next timer expires
+        tmr_wake_arm(plt_ctx, tmr_whl_next(whl), 0);
+
         plt_mtx_ulck(plt_ctx->tmr_mtx);
     }
 }
@@ -2225,17 +3797,20 @@ int plt_utf16_to_8(const uint16_t *utf16_src, uint8_t *utf8_output, uint8_t out_
 plt_init - Initialize platform
 @param[in] pltfm_ctx        Context
 @param[in] display_txt_fn   Function pointer to display null terminated string
+@param[in] tmr_cb_thrd_cnt  Number of threads to execute one-shot timer callbacks; zero for default
 @param[in] display_ctx      Display context
 @return    Return zero on success; negative error number indicates failure.
 */
 #ifdef TCP_PORTAL
-int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn, void *display_ctx)
+int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn, void *display_ctx, uint8_t tmr_cb_thrd_cnt)
 #else
-int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn)
+int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn, uint8_t tmr_cb_thrd_cnt)
 #endif
 {
-    int wait_count;
+#ifndef OS_MAC_X
+    struct epoll_event  evt;
 
+#endif
     if (pltfm_ctx->init_done > 0)
     {
         //Update initialization count
@@ -2249,25 +3824,68 @@ int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn)
     pltfm_ctx->display_ctx = display_ctx;
 #endif
 
+    //Set up the memory pool for queue entries and frame buffers
+    util_mem_init();
+
+
+    pltfm_ctx->tmr_whl = tmr_whl_create();
+    if (!pltfm_ctx->tmr_whl)
+        return ZWHCI_ERROR_MEMORY;
+
+    //Synchronize the wheel with the monotonic clock
+    ((tmr_whl_t *)pltfm_ctx->tmr_whl)->cur_tick = plt_mono_ms() / PLT_TIMER_RESOLUTION;
+    pltfm_ctx->tmr_armed = 0;
 
     if (!plt_mtx_init(&pltfm_ctx->tmr_mtx))
-        return ZWHCI_ERROR_RESOURCE;
+        goto l_PLATFORM_INIT_ERROR0;
+
+    //Create the wake-up source of the timer check thread
+#ifdef OS_MAC_X
+    if (pipe(pltfm_ctx->tmr_pipe) < 0)
+    {
+        goto l_PLATFORM_INIT_ERROR;
+    }
+    fcntl(pltfm_ctx->tmr_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(pltfm_ctx->tmr_pipe[1], F_SETFL, O_NONBLOCK);
+    //Event loop mode is not supported
+    pltfm_ctx->evt_loop = 0;
+#else
+    pltfm_ctx->tmr_fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (pltfm_ctx->tmr_fd < 0)
+    {
+        goto l_PLATFORM_INIT_ERROR;
+    }
 
-    if (!plt_sem_init(&pltfm_ctx->tmr_sem))
+    //The timer check thread waits on the timerfd and the registered file descriptors
+    pltfm_ctx->evt_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (pltfm_ctx->evt_fd < 0)
     {
+        close(pltfm_ctx->tmr_fd);
         goto l_PLATFORM_INIT_ERROR;
     }
 
-    //Init random number seed
-    srand(time(NULL));
+    memset(pltfm_ctx->evt_tbl, 0, sizeof(pltfm_ctx->evt_tbl));
+    pltfm_ctx->evt_busy = 0;
+
+    memset(&evt, 0, sizeof(evt));
+    evt.events = EPOLLIN;
+    evt.data.u64 = PLT_EVT_MAX;
+    if (epoll_ctl(pltfm_ctx->evt_fd, EPOLL_CTL_ADD, pltfm_ctx->tmr_fd, &evt) < 0)
+    {
+        goto l_PLATFORM_INIT_ERROR1;
+    }
+#endif
 
-    //Start timer tick thread
-    pltfm_ctx->tmr_tck_thrd_run = 1;
-    if (plt_thrd_create(tmr_tck_thrd, pltfm_ctx) < 0)
+    //Start timer callback executor
+    pltfm_ctx->tmr_cb_pool = tmr_cb_pool_create((tmr_cb_thrd_cnt)? tmr_cb_thrd_cnt : PLT_TMR_CB_THRD_DEFAULT);
+    if (!pltfm_ctx->tmr_cb_pool)
     {
         goto l_PLATFORM_INIT_ERROR1;
     }
 
+    //Init random number seed
+    srand(time(NULL));
+
     //Start timer check thread
     pltfm_ctx->tmr_chk_thrd_run = 1;
     if (plt_thrd_create(tmr_chk_thrd, pltfm_ctx) < 0)
@@ -2280,22 +3898,25 @@ int plt_init(plt_ctx_t *pltfm_ctx, print_fn display_txt_fn)
     return 0;
 
 l_PLATFORM_INIT_ERROR2:
-    //Stop the timer tick thread
-    pltfm_ctx->tmr_tck_thrd_run = 0;
-    wait_count = 50;
-    while (wait_count-- > 0)
-    {
-        if (pltfm_ctx->tmr_tck_thrd_sts == 0)
-            break;
-        plt_sleep(100);
-    }
+    tmr_cb_pool_destroy((tmr_cb_pool_t *)pltfm_ctx->tmr_cb_pool);
+    pltfm_ctx->tmr_cb_pool = NULL;
 
 l_PLATFORM_INIT_ERROR1:
-    plt_sem_destroy(pltfm_ctx->tmr_sem);
+#ifdef OS_MAC_X
+    close(pltfm_ctx->tmr_pipe[0]);
+    close(pltfm_ctx->tmr_pipe[1]);
+#else
+    close(pltfm_ctx->evt_fd);
+    close(pltfm_ctx->tmr_fd);
+#endif
 
 l_PLATFORM_INIT_ERROR:
     plt_mtx_destroy(pltfm_ctx->tmr_mtx);
 
+l_PLATFORM_INIT_ERROR0:
+    tmr_whl_destroy((tmr_whl_t *)pltfm_ctx->tmr_whl);
+    pltfm_ctx->tmr_whl = NULL;
+
     return ZWHCI_ERROR_RESOURCE;
 
 }
@@ -2318,18 +3939,11 @@ void plt_exit(plt_ctx_t *pltfm_ctx)
         return;
     }
 
-    //Stop all the threads
-    pltfm_ctx->tmr_tck_thrd_run = 0;
+    //Stop the timer check thread by waking it up immediately
     pltfm_ctx->tmr_chk_thrd_run = 0;
-    plt_sem_post(pltfm_ctx->tmr_sem);
-
-    wait_count = 50;
-    while (wait_count-- > 0)
-    {
-        if (pltfm_ctx->tmr_tck_thrd_sts == 0)
-            break;
-        plt_sleep(100);
-    }
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+    tmr_wake_arm(pltfm_ctx, 1, 1);
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
 
     wait_count = 50;
     while (wait_count-- > 0)
@@ -2340,9 +3954,20 @@ void plt_exit(plt_ctx_t *pltfm_ctx)
     }
 
     plt_sleep(20);  //delay 20ms to give timer threads enough time to terminate and clean up
-    util_list_flush(pltfm_ctx->tmr_mtx, &pltfm_ctx->tmr_lst_hd);
+    tmr_cb_pool_destroy((tmr_cb_pool_t *)pltfm_ctx->tmr_cb_pool);
+    pltfm_ctx->tmr_cb_pool = NULL;
+    plt_mtx_lck(pltfm_ctx->tmr_mtx);
+    tmr_whl_destroy((tmr_whl_t *)pltfm_ctx->tmr_whl);
+    pltfm_ctx->tmr_whl = NULL;
+    plt_mtx_ulck(pltfm_ctx->tmr_mtx);
     plt_mtx_destroy(pltfm_ctx->tmr_mtx);
-    plt_sem_destroy(pltfm_ctx->tmr_sem);
+#ifdef OS_MAC_X
+    close(pltfm_ctx->tmr_pipe[0]);
+    close(pltfm_ctx->tmr_pipe[1]);
+#else
+    close(pltfm_ctx->evt_fd);
+    close(pltfm_ctx->tmr_fd);
+#endif
     memset(pltfm_ctx, 0, sizeof(plt_ctx_t));
 }
 
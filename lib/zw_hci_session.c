@@ -20,6 +20,207 @@ To handle commands sending and the corresponding responses and/or callback.
 
 static void    ssn_resp_tmout_cb(void *data);
 
+/**
+ssn_req_enq - Append a request to the tail of a request queue
+@param[in,out] que  Request queue
+@param[in] req      The request
+@return
+*/
+static void    ssn_req_enq(ssn_req_que_t *que, ssn_req_t *req)
+{
+    req->next = NULL;
+    if (que->tail)
+        que->tail->next = req;
+    else
+        que->head = req;
+    que->tail = req;
+    que->cnt++;
+}
+
+
+/**
+ssn_req_rm - Remove a request from a request queue
+@param[in,out] que  Request queue
+@param[in] req      The request
+@param[in] prev     The request before req in the queue; NULL if req is the head
+@return
+*/
+static void    ssn_req_rm(ssn_req_que_t *que, ssn_req_t *req, ssn_req_t *prev)
+{
+    if (prev)
+        prev->next = req->next;
+    else
+        que->head = req->next;
+
+    if (que->tail == req)
+        que->tail = prev;
+    que->cnt--;
+    req->next = NULL;
+}
+
+
+/**
+ssn_req_done - Complete a request
+@param[in,out] ssn_ctx  Context.
+@param[in] req          The request
+@param[in] result       The result, 0 on success, negative error number on failure
+@return
+@pre Caller must lock the sta_mach_mtx before calling this function
+@post The request is reported by ssn_req_cmplt after the sta_mach_mtx is released
+*/
+static void    ssn_req_done(ssn_layer_ctx_t   *ssn_ctx, ssn_req_t *req, int32_t result)
+{
+    req->result = result;
+    ssn_req_enq(&ssn_ctx->done_que, req);
+}
+
+
+/**
+ssn_cb_post - Queue a callback request to a callback worker
+@param[in,out] ssn_ctx  Context.
+@param[in]	cb_req		The callback request
+@return     Return zero indicates success, non-zero indicates failure.
+@note   Unsolicited commands are sharded by their source node id, and command callbacks by their
+        destination node id, so that the commands from one node are executed in order with the
+        transmit completions of the commands sent to it. All the other callbacks go to the first
+        worker, in order among themselves
+*/
+static int32_t ssn_cb_post(ssn_layer_ctx_t   *ssn_ctx, ssn_cb_req_t *cb_req)
+{
+    ssn_cb_wkr_t    *wkr;
+    int32_t         ret_val;
+    uint8_t         node_id = 0;
+
+    if ((ssn_ctx->cb_wkr_cnt > 1) && ssn_ctx->shard_key && !cb_req->req)
+    {
+        node_id = ssn_ctx->shard_key(ssn_ctx, cb_req);
+    }
+    wkr = &ssn_ctx->cb_wkr[node_id % ssn_ctx->cb_wkr_cnt];
+
+    cb_req->enq_ts = plt_mono_us();
+
+    plt_mtx_lck(wkr->mtx);
+    ret_val = util_que_add(wkr->mtx, &wkr->req_hd, (uint8_t *)cb_req, sizeof(ssn_cb_req_t));
+    if (ret_val == 0)
+    {
+        if (++wkr->stat.que_depth > wkr->stat.que_depth_max)
+            wkr->stat.que_depth_max = wkr->stat.que_depth;
+    }
+    plt_mtx_ulck(wkr->mtx);
+
+    if (ret_val == 0)
+        plt_sem_post(wkr->sem);
+
+    return ret_val;
+}
+
+
+/**
+ssn_req_cmplt - Report the completed requests to their waiting threads or to the callback thread
+@param[in,out] ssn_ctx  Context.
+@return
+@pre Caller must not hold the sta_mach_mtx
+*/
+static void    ssn_req_cmplt(ssn_layer_ctx_t   *ssn_ctx)
+{
+    ssn_req_t       *req;
+    ssn_req_t       *next;
+    ssn_cb_req_t    cb_req;
+
+    plt_mtx_lck(ssn_ctx->sta_mach_mtx);
+    req = ssn_ctx->done_que.head;
+    ssn_ctx->done_que.head = ssn_ctx->done_que.tail = NULL;
+    ssn_ctx->done_que.cnt = 0;
+    plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
+
+    while (req)
+    {
+        next = req->next;
+        if (req->cmplt_cb)
+        {
+            //Report in the callback thread, in order with the command callbacks
+            cb_req.cmd = NULL;
+            cb_req.cmd_cb_func = NULL;
+            cb_req.req = req;
+            if (ssn_cb_post(ssn_ctx, &cb_req) != 0)
+            {
+                req->cmplt_cb(ssn_ctx, req->result, req->cmd_resp, req->user);
+                util_mem_free(req);
+            }
+        }
+        else
+        {   //The waiting thread owns the request from now on
+            plt_sem_post(req->wait_sem);
+        }
+        req = next;
+    }
+}
+
+
+/**
+ssn_resp_tmr_start - Start the response timer for the oldest request waiting for response
+@param[in,out] ssn_ctx  Context.
+@return
+@pre Caller must lock the sta_mach_mtx before calling this function
+*/
+static void    ssn_resp_tmr_start(ssn_layer_ctx_t   *ssn_ctx)
+{
+    uint64_t    now;
+    uint32_t    tmout_ms = 1;
+
+    plt_tmr_stop(ssn_ctx->plt_ctx, ssn_ctx->resp_tmr_ctx);
+    ssn_ctx->resp_tmr_ctx = NULL;
+
+    if (!ssn_ctx->resp_que.head)
+        return;
+
+    now = plt_mono_ms();
+    if (ssn_ctx->resp_que.head->resp_tmout > now)
+        tmout_ms = (uint32_t)(ssn_ctx->resp_que.head->resp_tmout - now);
+
+    ssn_ctx->resp_tmr_ctx = plt_tmr_start(ssn_ctx->plt_ctx, tmout_ms, ssn_resp_tmout_cb, ssn_ctx);
+}
+
+
+/**
+ssn_sta_upd - Update the state after the number of requests waiting for response has changed
+@param[in,out] ssn_ctx  Context.
+@return
+*/
+static void    ssn_sta_upd(ssn_layer_ctx_t   *ssn_ctx)
+{
+    if (ssn_ctx->ssn_sta == SESSION_STATE_COMMAND_SENT)
+        return;
+
+    ssn_ctx->ssn_sta = (ssn_ctx->resp_que.cnt >= ssn_ctx->resp_win)? SESSION_STATE_WAIT_RESPONSE : SESSION_STATE_IDLE;
+}
+
+
+/**
+ssn_snd_sts_err - Map the frame layer send status to error number
+@param[in] frm_snd_sts  The frame layer send status
+@return  Negative error number
+*/
+static int32_t    ssn_snd_sts_err(frm_snd_sts_t frm_snd_sts)
+{
+    switch (frm_snd_sts)
+    {
+        case FRAME_SEND_TIMEOUT://Send frame timeout due to no ACK received
+            return SESSION_ERROR_SND_FRM_TMOUT;
+
+        case FRAME_SEND_FAIL_CHKSUM:
+            return SESSION_ERROR_SEND_CHKSUM;
+
+        case FRAME_SEND_FAIL_DROPPED:
+            return SESSION_ERROR_SEND_BUSY;
+
+        default:
+            //Shouldn't happen, it means the state-machine is out of sync!
+            return SESSION_ERROR_SYNC;
+    }
+}
+
+
 /**
 ssn_sta_machine - Session layer state-machine
 @param[in] ssn_ctx  Context.
@@ -27,9 +228,64 @@ ssn_sta_machine - Session layer state-machine
 @param[in] data     The data associated with the event
 @param[in] dat_len  The length of the data
 @return
+@pre Caller must lock the sta_mach_mtx before calling this function
 */
 static void    ssn_sta_machine(ssn_layer_ctx_t   *ssn_ctx, ssn_evt_t ssn_evt, uint8_t *data, uint8_t dat_len)
 {
+    ssn_req_t   *req;
+    ssn_req_t   *prev;
+
+    //Responses and response timeouts may arrive while the next command is being sent
+    if (ssn_evt == EVENT_RECEIVED_RESPONSE)
+    {
+        //Match the oldest request waiting for response with the same command id
+        for (prev = NULL, req = ssn_ctx->resp_que.head; req; prev = req, req = req->next)
+        {
+            if (req->param.cmd_id == data[SESSION_COMMAND_ID_OFFSET])
+                break;
+        }
+
+        if (!req)
+        {   //Stale response to a timed out command
+            return;
+        }
+
+        ssn_req_rm(&ssn_ctx->resp_que, req, prev);
+        if (!prev)
+        {
+            ssn_resp_tmr_start(ssn_ctx);
+        }
+
+        req->cmd_resp = (ssn_cmd_resp_t *)malloc(sizeof(ssn_cmd_resp_t) + dat_len - FRAME_HEADER_LEN);
+        if (req->cmd_resp)
+        {
+            req->cmd_resp->type = (dat_frm_typ_t)data[SESSION_TYPE_OFFSET];
+            req->cmd_resp->cmd_id = data[SESSION_COMMAND_ID_OFFSET];
+            req->cmd_resp->len = dat_len - FRAME_HEADER_LEN;
+            memcpy(req->cmd_resp->dat_buf, data + SESSION_DATA_OFFSET, req->cmd_resp->len);
+            ssn_req_done(ssn_ctx, req, 0);
+        }
+        else
+        {
+            ssn_req_done(ssn_ctx, req, ZWHCI_ERROR_MEMORY);
+        }
+        ssn_sta_upd(ssn_ctx);
+        return;
+    }
+
+    if (ssn_evt == EVENT_RESPONSE_TIMEOUT)
+    {
+        uint64_t    now = plt_mono_ms();
+
+        while ((req = ssn_ctx->resp_que.head) != NULL && req->resp_tmout <= now)
+        {
+            ssn_req_rm(&ssn_ctx->resp_que, req, NULL);
+            ssn_req_done(ssn_ctx, req, SESSION_ERROR_RESP_TMOUT);
+        }
+        ssn_resp_tmr_start(ssn_ctx);
+        ssn_sta_upd(ssn_ctx);
+        return;
+    }
 
     switch (ssn_ctx->ssn_sta)
     {
@@ -38,21 +294,21 @@ static void    ssn_sta_machine(ssn_layer_ctx_t   *ssn_ctx, ssn_evt_t ssn_evt, ui
             //-------------------------------------
             if (ssn_evt == EVENT_COMMAND_SENT)
             {
-                ssn_cmd_attr_t *cmd_attr = (ssn_cmd_attr_t  *)data;
+                req = (ssn_req_t *)data;
                 //Check if callback frame is expected, then update the function id to callback function map
-                if ((cmd_attr->cmd_flag & COMMAND_HAS_CALLBACK) != 0)
+                if ((req->param.cmd_flag & COMMAND_HAS_CALLBACK) != 0)
                 {
-                    if ((cmd_attr->func_id > 0) && (cmd_attr->func_id <= SESSION_FUNCID_MAX))
+                    uint8_t func_id = req->param.dat_buf[req->param.dat_sz - 1];
+
+                    if ((func_id > 0) && (func_id <= SESSION_FUNCID_MAX))
                     {
-                        ssn_ctx->cb_map[cmd_attr->func_id].cmd_id = cmd_attr->cmd_id;
-                        ssn_ctx->cb_map[cmd_attr->func_id].cmd_cb_func = cmd_attr->cmd_cb_func;
-                        ssn_ctx->cb_map[cmd_attr->func_id].cmd_cb_prm[0] = cmd_attr->cmd_cb_prm[0];
-                        ssn_ctx->cb_map[cmd_attr->func_id].cmd_cb_prm[1] = cmd_attr->cmd_cb_prm[1];
+                        ssn_ctx->cb_map[func_id].cmd_id = req->param.cmd_id;
+                        ssn_ctx->cb_map[func_id].cmd_cb_func = req->param.cmd_cb_func;
+                        ssn_ctx->cb_map[func_id].cmd_cb_prm[0] = req->param.cmd_cb_prm[0];
+                        ssn_ctx->cb_map[func_id].cmd_cb_prm[1] = req->param.cmd_cb_prm[1];
                     }
                 }
-                //Save the command id and flag
-                ssn_ctx->last_cmd_id = cmd_attr->cmd_id;
-                ssn_ctx->last_cmd_flag = cmd_attr->cmd_flag;
+                ssn_ctx->snd_req = req;
                 ssn_ctx->ssn_sta = SESSION_STATE_COMMAND_SENT;
             }
             break;
@@ -63,66 +319,43 @@ static void    ssn_sta_machine(ssn_layer_ctx_t   *ssn_ctx, ssn_evt_t ssn_evt, ui
             if (ssn_evt == EVENT_RECEIVED_SEND_FRAME_STATUS)
             {
                 frm_snd_sts_t *frm_snd_sts = (frm_snd_sts_t *)data;
-                if (*frm_snd_sts == FRAME_SEND_OK)
-                {
-                    if ((ssn_ctx->last_cmd_flag & COMMAND_HAS_RESPONSE) != 0)
-                    {
-                        //Start wait response timer
-                        ssn_ctx->resp_tmr_ctx = plt_tmr_start(ssn_ctx->plt_ctx, ssn_ctx->resp_tmout_ms, ssn_resp_tmout_cb, ssn_ctx);
 
-                        ssn_ctx->ssn_sta = SESSION_STATE_WAIT_RESPONSE;
-
-                        ssn_ctx->snd_frm_sts = FRAME_SEND_OK;
-                        plt_sem_post(ssn_ctx->snd_frm_sts_sem);
+                req = ssn_ctx->snd_req;
+                ssn_ctx->snd_req = NULL;
+                ssn_ctx->ssn_sta = SESSION_STATE_IDLE;
 
-                        break;
+                if (*frm_snd_sts != FRAME_SEND_OK)
+                {
+                    ssn_req_done(ssn_ctx, req, ssn_snd_sts_err(*frm_snd_sts));
+                }
+                else if ((req->param.cmd_flag & COMMAND_HAS_RESPONSE) != 0)
+                {
+                    //Wait for response while the next command is sent
+                    req->resp_tmout = plt_mono_ms() + ssn_ctx->resp_tmout_ms;
+                    ssn_req_enq(&ssn_ctx->resp_que, req);
+                    if (ssn_ctx->resp_que.cnt == 1)
+                    {
+                        ssn_resp_tmr_start(ssn_ctx);
                     }
                 }
-                //No response frame is expected, go back to idle state
-                ssn_ctx->ssn_sta = SESSION_STATE_IDLE;
-                ssn_ctx->snd_frm_sts = *frm_snd_sts;
-                plt_sem_post(ssn_ctx->snd_frm_sts_sem);
-
+                else
+                {
+                    //No response frame is expected, the command has completed
+                    ssn_req_done(ssn_ctx, req, 0);
+                }
+                ssn_sta_upd(ssn_ctx);
             }
             break;
 
             //-------------------------------------
         case SESSION_STATE_WAIT_RESPONSE:
             //-------------------------------------
-            if (ssn_evt == EVENT_RECEIVED_RESPONSE)
-            {
-                //Stop the timer and release timer resource
-                plt_tmr_stop(ssn_ctx->plt_ctx, ssn_ctx->resp_tmr_ctx);
-                ssn_ctx->resp_tmr_ctx = NULL;
-
-                ssn_ctx->cmd_resp = (ssn_cmd_resp_t *)malloc(sizeof(ssn_cmd_resp_t) + dat_len - FRAME_HEADER_LEN);
-                if (ssn_ctx->cmd_resp)
-                {
-                    ssn_ctx->cmd_resp_sts = SESSION_RESPONSE_OK;
-                    ssn_ctx->cmd_resp->type = (dat_frm_typ_t)data[SESSION_TYPE_OFFSET];
-                    ssn_ctx->cmd_resp->cmd_id = data[SESSION_COMMAND_ID_OFFSET];
-                    ssn_ctx->cmd_resp->len = dat_len - FRAME_HEADER_LEN;
-                    memcpy(ssn_ctx->cmd_resp->dat_buf, data + SESSION_DATA_OFFSET, ssn_ctx->cmd_resp->len);
-                }
-                else
-                {
-                    ssn_ctx->cmd_resp_sts = SESSION_RESPONSE_MEM;
-                }
-                ssn_ctx->ssn_sta = SESSION_STATE_IDLE;
-
-                plt_sem_post(ssn_ctx->cmd_resp_sts_sem);
-
-            }
-            else if (ssn_evt == EVENT_RESPONSE_TIMEOUT)
-            {
-                ssn_ctx->cmd_resp_sts = SESSION_RESPONSE_TIMEOUT;
-                ssn_ctx->ssn_sta = SESSION_STATE_IDLE;
-                plt_sem_post(ssn_ctx->cmd_resp_sts_sem);
-            }
+            //Leaves this state on response or response timeout
             break;
     }
 }
 
+
 /**
 ssn_func_id_gen - generate a function id
 @param[in,out]	ssn_ctx		Context
@@ -148,150 +381,147 @@ static uint8_t    ssn_func_id_gen(ssn_layer_ctx_t   *ssn_ctx)
 
 
 /**
-ssn_cmd_snd - Send a command
-@param[in,out] ssn_ctx      Context.
-@param[in] param            The parameters related to the command.
-@param[out] cmd_resp        The response to the command.
-@return  0 on success, negative error number on failure
-@post   It is the responsibility of the caller with COMMAND_HAS_RESPONSE to free the
-        memory allocated to the cmd_resp.
+ssn_req_snd - Send the queued requests to the frame layer as long as the state machine is idle
+@param[in,out]	ssn_ctx		Context
+@return
+@pre Caller must lock the sta_mach_mtx before calling this function
 */
-int32_t ssn_cmd_snd(ssn_layer_ctx_t   *ssn_ctx, ssn_cmd_snd_param_t   *param,
-                    ssn_cmd_resp_t **cmd_resp)
+static void    ssn_req_snd(ssn_layer_ctx_t   *ssn_ctx)
 {
-    int32_t             ret_val;
-    uint8_t             func_id;
-    ssn_cmd_attr_t      cmd_attr;
-
-    plt_mtx_lck(ssn_ctx->sta_mach_mtx);
+    int32_t     ret_val;
+    ssn_req_t   *req;
 
-    //Check whether the previous command has completed
-    if (ssn_ctx->ssn_sta != SESSION_STATE_IDLE)
+    while ((ssn_ctx->ssn_sta == SESSION_STATE_IDLE) && ((req = ssn_ctx->req_que.head) != NULL))
     {
-        plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
-        return SESSION_ERROR_PREVIOUS_COMMAND_UNCOMPLETED;
-    }
+        ssn_req_rm(&ssn_ctx->req_que, req, NULL);
 
-    //Insert function id if command requires callback
-    if ((param->cmd_flag & COMMAND_HAS_CALLBACK) != 0)
-    {
-        func_id = ssn_func_id_gen(ssn_ctx);
-        //append the function id at the end of data buffer
-        param->dat_buf[param->dat_sz] = func_id;
-        param->dat_sz++;
+        //Insert function id if command requires callback
+        if ((req->param.cmd_flag & COMMAND_HAS_CALLBACK) != 0)
+        {
+            //append the function id at the end of data buffer
+            req->param.dat_buf[req->param.dat_sz] = ssn_func_id_gen(ssn_ctx);
+            req->param.dat_sz++;
+        }
 
-    }
-    /*printf("\n=========before frm_dat_frm_snd,start, len:%d =================\n",param->dat_sz);
-    int y = 0;
-    for(y= 0;y<param->dat_sz;y++)
-    {
-        printf(" ->%02x<- ",param->dat_buf[y]);
-    }
-    printf("\n===================frm_dat_frm_snd message end======================\n");*/
-    //Send to frame layer
-    ssn_ctx->snd_frm_sts = FRAME_SEND_UNKNOWN;
-    ret_val = frm_dat_frm_snd(&ssn_ctx->frm_ctx, REQ, param->cmd_id,
-                              param->dat_buf, param->dat_sz);
+        //Send to frame layer
+        ret_val = frm_dat_frm_snd(&ssn_ctx->frm_ctx, REQ, req->param.cmd_id,
+                                  req->param.dat_buf, req->param.dat_sz);
 
-    if (ret_val != 0)
-    {
-        plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
-        return ret_val;
+        if (ret_val != 0)
+        {
+            ssn_req_done(ssn_ctx, req, ret_val);
+            continue;
+        }
+
+        //Call the state machine
+        ssn_sta_machine(ssn_ctx, EVENT_COMMAND_SENT, (uint8_t *)req, sizeof(ssn_req_t));
     }
+}
 
-    //Call the state machine
-    cmd_attr.cmd_id = param->cmd_id;
-    cmd_attr.cmd_flag = param->cmd_flag;
 
-    if ((param->cmd_flag & COMMAND_HAS_CALLBACK) != 0)
+/**
+ssn_cmd_snd_async - Queue a command for sending
+@param[in,out] ssn_ctx      Context.
+@param[in] param            The parameters related to the command. The parameters are copied.
+@param[in] cmplt_cb         The callback to report completion. It is called from the callback thread, in order
+                            with the command callbacks. NULL to wait for completion with ssn_cmd_wait.
+@param[in] user             The user parameter of cmplt_cb
+@param[out] req_hdl         The request handle to wait for completion with ssn_cmd_wait. Required if cmplt_cb is NULL
+@return  0 on success, negative error number on failure
+@post   It is the responsibility of cmplt_cb to free the memory allocated to its cmd_resp with free().
+        If cmplt_cb is NULL, ssn_cmd_wait must be called exactly once with the request handle.
+*/
+int32_t ssn_cmd_snd_async(ssn_layer_ctx_t   *ssn_ctx, ssn_cmd_snd_param_t   *param,
+                          ssn_cmd_cmplt_t cmplt_cb, void *user, void **req_hdl)
+{
+    ssn_req_t   *req;
+
+    if (!cmplt_cb && !req_hdl)
+        return ZWHCI_ERROR_INVALID_VALUE;
+
+    //Reserve 1 byte for function id
+    req = (ssn_req_t *)util_mem_alloc(sizeof(ssn_req_t) + param->dat_sz);
+    if (!req)
+        return ZWHCI_ERROR_MEMORY;
+
+    req->param = *param;
+    memcpy(req->param.dat_buf, param->dat_buf, param->dat_sz);
+    req->cmplt_cb = cmplt_cb;
+    req->user = user;
+    req->wait_sem = NULL;
+    req->cmd_resp = NULL;
+    req->resp_tmout = 0;
+    req->result = 0;
+
+    if (!cmplt_cb)
     {
-        cmd_attr.func_id = func_id;
-        cmd_attr.cmd_cb_func = param->cmd_cb_func;
-        cmd_attr.cmd_cb_prm[0] = param->cmd_cb_prm[0];
-        cmd_attr.cmd_cb_prm[1] = param->cmd_cb_prm[1];
+        if (!plt_sem_init(&req->wait_sem))
+        {
+            util_mem_free(req);
+            return ZWHCI_ERROR_RESOURCE;
+        }
+        *req_hdl = req;
     }
 
-    if ((param->cmd_flag & COMMAND_HAS_RESPONSE) != 0)
-    {
-        ssn_ctx->cmd_resp_sts = SESSION_RESPONSE_UNKNOWN;
-        ssn_ctx->cmd_resp = NULL;
-    }
-    ssn_sta_machine(ssn_ctx, EVENT_COMMAND_SENT, (uint8_t *)&cmd_attr, sizeof(ssn_cmd_attr_t));
+    plt_mtx_lck(ssn_ctx->sta_mach_mtx);
+    ssn_req_enq(&ssn_ctx->req_que, req);
+    ssn_req_snd(ssn_ctx);
     plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
 
-    //Wait for send frame status from the frame layer
-    plt_sem_wait(ssn_ctx->snd_frm_sts_sem);
-    if (ssn_ctx->snd_frm_sts != FRAME_SEND_OK)
-    {
-        switch (ssn_ctx->snd_frm_sts)
-        {
-            case FRAME_SEND_UNKNOWN:
-                //Shouldn't happen, it means the state-machine is out of sync!
-                ret_val = SESSION_ERROR_SYNC;
-                break;
+    ssn_req_cmplt(ssn_ctx);
 
-            case FRAME_SEND_TIMEOUT://Send frame timeout due to no ACK received
-                ret_val = SESSION_ERROR_SND_FRM_TMOUT;
-                break;
+    return 0;
+}
 
-            case FRAME_SEND_FAIL_CHKSUM:
-                ret_val = SESSION_ERROR_SEND_CHKSUM;
-                break;
 
-            case FRAME_SEND_FAIL_DROPPED:
-                ret_val = SESSION_ERROR_SEND_BUSY;
-                break;
+/**
+ssn_cmd_wait - Wait for completion of a command queued by ssn_cmd_snd_async without completion callback
+@param[in] req_hdl          The request handle
+@param[out] cmd_resp        The response to the command. NULL if the response is not needed
+@return  0 on success, negative error number on failure
+@post   It is the responsibility of the caller with COMMAND_HAS_RESPONSE to free the
+        memory allocated to the cmd_resp.
+*/
+int32_t ssn_cmd_wait(void *req_hdl, ssn_cmd_resp_t **cmd_resp)
+{
+    int32_t     ret_val;
+    ssn_req_t   *req = (ssn_req_t *)req_hdl;
 
-            default:
-                break;
-        }
-        return ret_val;
-    }
+    plt_sem_wait(req->wait_sem);
 
+    ret_val = req->result;
+    if (cmd_resp && (ret_val == 0))
+        *cmd_resp = req->cmd_resp;
+    else
+        free(req->cmd_resp);
 
-    //Wait for response
-    if ((param->cmd_flag & COMMAND_HAS_RESPONSE) != 0)
-    {
-        plt_sem_wait(ssn_ctx->cmd_resp_sts_sem);
-        if (ssn_ctx->cmd_resp_sts != SESSION_RESPONSE_OK)
-        {
-            switch (ssn_ctx->cmd_resp_sts)
-            {
-                case SESSION_RESPONSE_UNKNOWN:
-                    //Shouldn't happen, it means the state-machine is out of sync!
-                    ret_val = SESSION_ERROR_SYNC;
-                    break;
+    plt_sem_destroy(req->wait_sem);
+    util_mem_free(req);
 
-                case SESSION_RESPONSE_MEM:
-                    ret_val = ZWHCI_ERROR_MEMORY;
-                    break;
+    return ret_val;
+}
 
-                case SESSION_RESPONSE_TIMEOUT://Wait for response frame timeout
-                    ret_val = SESSION_ERROR_RESP_TMOUT;
-                    break;
 
-                default:
-                    break;
-            }
+/**
+ssn_cmd_snd - Send a command and wait for its completion
+@param[in,out] ssn_ctx      Context.
+@param[in] param            The parameters related to the command.
+@param[out] cmd_resp        The response to the command.
+@return  0 on success, negative error number on failure
+@post   It is the responsibility of the caller with COMMAND_HAS_RESPONSE to free the
+        memory allocated to the cmd_resp.
+*/
+int32_t ssn_cmd_snd(ssn_layer_ctx_t   *ssn_ctx, ssn_cmd_snd_param_t   *param,
+                    ssn_cmd_resp_t **cmd_resp)
+{
+    int32_t     ret_val;
+    void        *req_hdl;
 
-            return ret_val;
-        }
-        plt_mtx_lck(ssn_ctx->sta_mach_mtx);
-        if (ssn_ctx->cmd_resp->cmd_id == param->cmd_id)
-        {
-            *cmd_resp = ssn_ctx->cmd_resp;
-        }
-        else
-        {
-            ret_val = SESSION_ERROR_INVALID_RESP;
-            free(ssn_ctx->cmd_resp);
-        }
-        plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
+    ret_val = ssn_cmd_snd_async(ssn_ctx, param, NULL, NULL, &req_hdl);
+    if (ret_val != 0)
         return ret_val;
 
-    }
-    return 0;
-
+    return ssn_cmd_wait(req_hdl, cmd_resp);
 }
 
 
@@ -305,15 +535,13 @@ static void    ssn_resp_tmout_cb(void *data)
     ssn_layer_ctx_t   *ssn_ctx = (ssn_layer_ctx_t   *)data;
     plt_mtx_lck(ssn_ctx->sta_mach_mtx);
 
-    //Stop the timer and release timer resource
-    plt_tmr_stop(ssn_ctx->plt_ctx, ssn_ctx->resp_tmr_ctx);
-    ssn_ctx->resp_tmr_ctx = NULL;
-
     //Call the state machine
     ssn_sta_machine(ssn_ctx, EVENT_RESPONSE_TIMEOUT, NULL, 0);
+    ssn_req_snd(ssn_ctx);
 
     plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
 
+    ssn_req_cmplt(ssn_ctx);
 }
 
 
@@ -339,7 +567,7 @@ static void    ssn_rx_frm_cb(struct _frm_layer_ctx *frm_ctx, uint8_t *buf, uint8
         uint8_t   func_id = buf[SESSION_DATA_OFFSET];
         uint8_t   cmd_id = buf[SESSION_COMMAND_ID_OFFSET];
 
-        cb_cmd = (ssn_cmd_resp_t *)malloc(sizeof(ssn_cmd_resp_t) + dat_len - FRAME_HEADER_LEN);
+        cb_cmd = (ssn_cmd_resp_t *)util_mem_alloc(sizeof(ssn_cmd_resp_t) + dat_len - FRAME_HEADER_LEN);
         if (!cb_cmd)
             return;
         cb_cmd->type = (dat_frm_typ_t)buf[SESSION_TYPE_OFFSET];
@@ -349,6 +577,7 @@ static void    ssn_rx_frm_cb(struct _frm_layer_ctx *frm_ctx, uint8_t *buf, uint8
 
         //Build a callback request for the callback thread to execute
         cb_req.cmd = cb_cmd;
+        cb_req.req = NULL;
 
         cb_req.cmd_cb_func = NULL;
 
@@ -364,7 +593,7 @@ static void    ssn_rx_frm_cb(struct _frm_layer_ctx *frm_ctx, uint8_t *buf, uint8
                     cb_req.cmd_cb_prm[1] = ssn_ctx->cb_map[func_id].cmd_cb_prm[1];
                     if (ssn_ctx->nm_cb)
                     {
-                        ssn_ctx->nm_cb(ssn_ctx, cmd_id);
+                        ssn_ctx->nm_cb(ssn_ctx, cmd_id, cb_req.cmd_cb_prm);
                     }
 
                 }
@@ -378,14 +607,12 @@ static void    ssn_rx_frm_cb(struct _frm_layer_ctx *frm_ctx, uint8_t *buf, uint8
             cb_req.cmd_cb_func = ssn_ctx->unsolicited_cmd_cb;
         }
 
-        ret_val = util_list_add(ssn_ctx->cb_thrd_mtx, &ssn_ctx->cb_req_hd,
-                                 (uint8_t *)&cb_req, sizeof(ssn_cb_req_t));
+        ret_val = ssn_cb_post(ssn_ctx, &cb_req);
         if (ret_val)
         {   //Error
-            free(cb_cmd);
+            util_mem_free(cb_cmd);
             return;
         }
-        plt_sem_post(ssn_ctx->cb_thrd_sem);
 
     }
     else //RES
@@ -393,7 +620,10 @@ static void    ssn_rx_frm_cb(struct _frm_layer_ctx *frm_ctx, uint8_t *buf, uint8
         //Handling of response
         plt_mtx_lck(ssn_ctx->sta_mach_mtx);
         ssn_sta_machine(ssn_ctx, EVENT_RECEIVED_RESPONSE, buf, dat_len);
+        ssn_req_snd(ssn_ctx);
         plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
+
+        ssn_req_cmplt(ssn_ctx);
     }
 
 }
@@ -411,46 +641,207 @@ static void    ssn_snd_frm_sts_cb(struct _frm_layer_ctx *frm_ctx, frm_snd_sts_t
 
     plt_mtx_lck(ssn_ctx->sta_mach_mtx);
     ssn_sta_machine(ssn_ctx, EVENT_RECEIVED_SEND_FRAME_STATUS, (uint8_t *)&status, sizeof(frm_snd_sts_t));
+    //Send the next queued command as soon as the previous frame is done
+    ssn_req_snd(ssn_ctx);
     plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
+
+    ssn_req_cmplt(ssn_ctx);
 }
 
 
 /**
-ssn_cb_thrd - Thread to serve the callback requests
-@param[in]	data		The session context
+ssn_cb_req_exec - Execute a callback request
+@param[in]	ssn_ctx		The session context
+@param[in]	cb_req		The callback request
+@return
+*/
+static void ssn_cb_req_exec(ssn_layer_ctx_t   *ssn_ctx, ssn_cb_req_t *cb_req)
+{
+    ssn_req_t   *req = cb_req->req;
+
+    if (req)
+    {
+        req->cmplt_cb(ssn_ctx, req->result, req->cmd_resp, req->user);
+        util_mem_free(req);
+    }
+    else
+    {
+        cb_req->cmd_cb_func(ssn_ctx, cb_req->cmd, cb_req->cmd_cb_prm);
+        util_mem_free(cb_req->cmd);
+    }
+}
+
+
+/**
+ssn_cb_thrd - Callback worker thread to serve the callback requests
+@param[in]	data		The callback worker
 @return
 */
 static void ssn_cb_thrd(void   *data)
 {
-    ssn_layer_ctx_t   *ssn_ctx = (ssn_layer_ctx_t *)data;
+    ssn_cb_wkr_t    *wkr = (ssn_cb_wkr_t *)data;
     util_lst_t      *cb_req_lst;
+    ssn_cb_req_t    *cb_req;
+    uint64_t        lat;
 
-    ssn_ctx->cb_thrd_sts = 1;
+    wkr->thrd_sts = 1;
     while (1)
     {
         //Wait for callback request
-        plt_sem_wait(ssn_ctx->cb_thrd_sem);
+        plt_sem_wait(wkr->sem);
 
         //Check whether to exit the thread
-        if (ssn_ctx->cb_thrd_run == 0)
+        if (wkr->thrd_run == 0)
         {
-            ssn_ctx->cb_thrd_sts = 0;
+            wkr->thrd_sts = 0;
             return;
         }
 
-        cb_req_lst = util_list_get(ssn_ctx->cb_thrd_mtx, &ssn_ctx->cb_req_hd);
+        plt_mtx_lck(wkr->mtx);
+        cb_req_lst = util_que_get(wkr->mtx, &wkr->req_hd);
+        if (cb_req_lst)
+        {
+            cb_req = (ssn_cb_req_t *)cb_req_lst->wr_buf;
+            lat = plt_mono_us() - cb_req->enq_ts;
+            wkr->stat.que_depth--;
+            wkr->stat.dispatch_cnt++;
+            wkr->stat.lat_sum += lat;
+            if (lat > wkr->stat.lat_max)
+                wkr->stat.lat_max = (uint32_t)lat;
+        }
+        plt_mtx_ulck(wkr->mtx);
 
         //Callback
         if (cb_req_lst)
         {
-            ssn_cb_req_t    *cb_req;
+            ssn_cb_req_exec(wkr->ssn_ctx, (ssn_cb_req_t *)cb_req_lst->wr_buf);
+            util_mem_free(cb_req_lst);
+        }
+    }
+}
+
+
+/**
+ssn_cb_wkr_start - Start the callback workers
+@param[in,out]	ssn_ctx		Context
+@return     Number of workers started. Equals to cb_wkr_cnt on success
+*/
+static uint8_t ssn_cb_wkr_start(ssn_layer_ctx_t   *ssn_ctx)
+{
+    ssn_cb_wkr_t    *wkr;
+    uint8_t         i;
+
+    for (i = 0; i < ssn_ctx->cb_wkr_cnt; i++)
+    {
+        wkr = &ssn_ctx->cb_wkr[i];
+        wkr->ssn_ctx = ssn_ctx;
+
+        if (!plt_mtx_init(&wkr->mtx))
+            break;
+
+        if (!plt_sem_init(&wkr->sem))
+        {
+            plt_mtx_destroy(wkr->mtx);
+            break;
+        }
+
+        wkr->thrd_run = 1;
+        if (plt_thrd_create(ssn_cb_thrd, wkr) < 0)
+        {
+            plt_sem_destroy(wkr->sem);
+            plt_mtx_destroy(wkr->mtx);
+            break;
+        }
+    }
+    return i;
+}
+
+
+/**
+ssn_cb_wkr_stop - Stop the callback workers and flush their queues
+@param[in,out]	ssn_ctx		Context
+@param[in]	    wkr_cnt		Number of workers to stop
+@return
+*/
+static void ssn_cb_wkr_stop(ssn_layer_ctx_t   *ssn_ctx, uint8_t wkr_cnt)
+{
+    ssn_cb_wkr_t    *wkr;
+    util_lst_t      *cb_req_lst;
+    ssn_cb_req_t    *cb_req;
+    uint32_t        wait_count;
+    uint8_t         i;
+
+    for (i = 0; i < wkr_cnt; i++)
+    {
+        ssn_ctx->cb_wkr[i].thrd_run = 0;
+        plt_sem_post(ssn_ctx->cb_wkr[i].sem);
+    }
+
+    for (i = 0; i < wkr_cnt; i++)
+    {
+        wait_count = 50;
+        while (wait_count-- > 0)
+        {
+            if (ssn_ctx->cb_wkr[i].thrd_sts == 0)
+                break;
+            plt_sleep(100);
+        }
+    }
 
+    //Extra time for the threads to fully exit
+    //Needed to avoid program crash if calling init and exit in a very short interval
+    plt_sleep(100);
+
+    //Flush lists. Report the completed requests so that their owners can free their resources
+    for (i = 0; i < wkr_cnt; i++)
+    {
+        wkr = &ssn_ctx->cb_wkr[i];
+        while ((cb_req_lst = util_que_get(wkr->mtx, &wkr->req_hd)) != NULL)
+        {
             cb_req = (ssn_cb_req_t *)cb_req_lst->wr_buf;
+            if (cb_req->req)
+            {
+                ssn_cb_req_exec(ssn_ctx, cb_req);
+            }
+            else
+            {
+                util_mem_free(cb_req->cmd);
+            }
+            util_mem_free(cb_req_lst);
+        }
+
+        plt_sem_destroy(wkr->sem);
+        plt_mtx_destroy(wkr->mtx);
+    }
+}
+
+
+/**
+ssn_cb_stat_get - Get the callback dispatcher statistics
+@param[in]  ssn_ctx     Context.
+@param[out] stat        The statistics
+@param[in]  reset       Flag to clear the statistics after reading them. The current queue depths are kept
+@return
+*/
+void ssn_cb_stat_get(ssn_layer_ctx_t   *ssn_ctx, ssn_cb_stat_t *stat, int reset)
+{
+    ssn_cb_wkr_t    *wkr;
+    uint8_t         i;
+
+    memset(stat, 0, sizeof(ssn_cb_stat_t));
+    stat->wkr_cnt = ssn_ctx->cb_wkr_cnt;
 
-            cb_req->cmd_cb_func(ssn_ctx, cb_req->cmd, cb_req->cmd_cb_prm);
-            free(cb_req->cmd);
-            free(cb_req_lst);
+    for (i = 0; i < ssn_ctx->cb_wkr_cnt; i++)
+    {
+        wkr = &ssn_ctx->cb_wkr[i];
+        plt_mtx_lck(wkr->mtx);
+        stat->wkr[i] = wkr->stat;
+        if (reset)
+        {
+            memset(&wkr->stat, 0, sizeof(ssn_cb_wkr_stat_t));
+            wkr->stat.que_depth = wkr->stat.que_depth_max = stat->wkr[i].que_depth;
         }
+        plt_mtx_ulck(wkr->mtx);
     }
 }
 
@@ -465,6 +856,7 @@ Should be called once before calling the other session layer functions
 int32_t ssn_init(ssn_layer_ctx_t   *ssn_ctx)
 {
     int32_t     ret_val;
+    uint8_t     wkr_cnt;
 
     //Init frame layer
     ssn_ctx->frm_ctx.snd_frm_sts_cb = ssn_snd_frm_sts_cb;
@@ -481,41 +873,27 @@ int32_t ssn_init(ssn_layer_ctx_t   *ssn_ctx)
     ssn_ctx->ssn_sta = SESSION_STATE_IDLE;
     if (ssn_ctx->resp_tmout_ms < SESSION_RESPONSE_TIMEOUT_MIN)
         ssn_ctx->resp_tmout_ms = SESSION_RESPONSE_TIMEOUT_MIN;
+    if (ssn_ctx->resp_win == 0)
+        ssn_ctx->resp_win = SESSION_RESP_WIN_DEF;
+    else if (ssn_ctx->resp_win > SESSION_RESP_WIN_MAX)
+        ssn_ctx->resp_win = SESSION_RESP_WIN_MAX;
+
+    if (ssn_ctx->cb_wkr_cnt == 0)
+        ssn_ctx->cb_wkr_cnt = 1;
+    else if (ssn_ctx->cb_wkr_cnt > SESSION_CB_WKR_MAX)
+        ssn_ctx->cb_wkr_cnt = SESSION_CB_WKR_MAX;
 
     if (!plt_mtx_init(&ssn_ctx->sta_mach_mtx))
         goto l_SESSION_INIT_ERROR;
 
-    if (!plt_sem_init(&ssn_ctx->snd_frm_sts_sem))
+    wkr_cnt = ssn_cb_wkr_start(ssn_ctx);
+    if (wkr_cnt < ssn_ctx->cb_wkr_cnt)
         goto l_SESSION_INIT_ERROR1;
 
-    if (!plt_sem_init(&ssn_ctx->cmd_resp_sts_sem))
-        goto l_SESSION_INIT_ERROR2;
-
-    if (!plt_mtx_init(&ssn_ctx->cb_thrd_mtx))
-        goto l_SESSION_INIT_ERROR3;
-
-    if (!plt_sem_init(&ssn_ctx->cb_thrd_sem))
-        goto l_SESSION_INIT_ERROR4;
-
-    ssn_ctx->cb_thrd_run = 1;
-    if (plt_thrd_create(ssn_cb_thrd, ssn_ctx) < 0)
-        goto l_SESSION_INIT_ERROR5;
-
     return 0;
 
-l_SESSION_INIT_ERROR5:
-    plt_sem_destroy(ssn_ctx->cb_thrd_sem);
-
-l_SESSION_INIT_ERROR4:
-    plt_mtx_destroy(ssn_ctx->cb_thrd_mtx);
-
-l_SESSION_INIT_ERROR3:
-    plt_sem_destroy(ssn_ctx->cmd_resp_sts_sem);
-
-l_SESSION_INIT_ERROR2:
-    plt_sem_destroy(ssn_ctx->snd_frm_sts_sem);
-
 l_SESSION_INIT_ERROR1:
+    ssn_cb_wkr_stop(ssn_ctx, wkr_cnt);
     plt_mtx_destroy(ssn_ctx->sta_mach_mtx);
 
 l_SESSION_INIT_ERROR:
@@ -532,39 +910,36 @@ ssn_exit - Clean up the session layer
 */
 void ssn_exit(ssn_layer_ctx_t   *ssn_ctx)
 {
-    uint32_t        wait_count;
-    util_lst_t      *cb_req_lst;
-    ssn_cb_req_t    *cb_req;
+    ssn_req_t       *req;
 
     frm_exit(&ssn_ctx->frm_ctx);
 
-    //Stop the thread
-    ssn_ctx->cb_thrd_run = 0;
-    plt_sem_post(ssn_ctx->cb_thrd_sem);
-    wait_count = 50;
-    while (wait_count-- > 0)
+    //Fail the pending requests
+    plt_mtx_lck(ssn_ctx->sta_mach_mtx);
+    plt_tmr_stop(ssn_ctx->plt_ctx, ssn_ctx->resp_tmr_ctx);
+    ssn_ctx->resp_tmr_ctx = NULL;
+    if (ssn_ctx->snd_req)
     {
-        if (ssn_ctx->cb_thrd_sts == 0)
-            break;
-        plt_sleep(100);
+        ssn_req_done(ssn_ctx, ssn_ctx->snd_req, SESSION_ERROR_EXIT);
+        ssn_ctx->snd_req = NULL;
     }
-
-    //Extra time for the thread to fully exit
-    //Needed to avoid program crash if calling init and exit in a very short interval
-    plt_sleep(100);
-
-    //Flush lists
-    while ((cb_req_lst = util_list_get(ssn_ctx->cb_thrd_mtx, &ssn_ctx->cb_req_hd)) != NULL)
+    while ((req = ssn_ctx->resp_que.head) != NULL)
     {
-        cb_req = (ssn_cb_req_t *)cb_req_lst->wr_buf;
-        free(cb_req->cmd);
-        free(cb_req_lst);
+        ssn_req_rm(&ssn_ctx->resp_que, req, NULL);
+        ssn_req_done(ssn_ctx, req, SESSION_ERROR_EXIT);
     }
+    while ((req = ssn_ctx->req_que.head) != NULL)
+    {
+        ssn_req_rm(&ssn_ctx->req_que, req, NULL);
+        ssn_req_done(ssn_ctx, req, SESSION_ERROR_EXIT);
+    }
+    ssn_ctx->ssn_sta = SESSION_STATE_IDLE;
+    plt_mtx_ulck(ssn_ctx->sta_mach_mtx);
+
+    ssn_req_cmplt(ssn_ctx);
 
-    plt_sem_destroy(ssn_ctx->cb_thrd_sem);
-    plt_mtx_destroy(ssn_ctx->cb_thrd_mtx);
-    plt_sem_destroy(ssn_ctx->cmd_resp_sts_sem);
-    plt_sem_destroy(ssn_ctx->snd_frm_sts_sem);
+    //Stop the callback workers
+    ssn_cb_wkr_stop(ssn_ctx, ssn_ctx->cb_wkr_cnt);
     plt_mtx_destroy(ssn_ctx->sta_mach_mtx);
 
 }
@@ -18,6 +18,14 @@ comments: Initial release
 #include <sys/types.h>
 #include <errno.h>
 #include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netdb.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#ifndef OS_MAC_X
+#include <sys/eventfd.h>
+#endif
 #endif
 #include "../include/zw_hci_transport.h"
 
@@ -44,7 +52,7 @@ int32_t tpt_wr_req_create(tpt_layer_ctx_t *tpt_ctx, uint8_t   *buf, uint8_t dat_
 {
     int32_t     ret_val;    //Return value
 
-    ret_val = util_list_add(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd, buf, dat_sz);
+    ret_val = util_que_add(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd, buf, dat_sz);
     if (ret_val)
     {
         return ret_val;
@@ -60,6 +68,28 @@ int32_t tpt_wr_req_create(tpt_layer_ctx_t *tpt_ctx, uint8_t   *buf, uint8_t dat_
     return ZWHCI_NO_ERROR;
 }
 
+/**
+tpt_wr_buf_req - queue a buffer to the write thread.
+@param[in,out]	tpt_ctx		Context
+@param[in]      buf         Buffer that store the data to be sent. The caller keeps its reference
+@return                     Return 0 on success, negative error number on failure.
+*/
+int32_t tpt_wr_buf_req(tpt_layer_ctx_t *tpt_ctx, util_buf_t *buf)
+{
+    return tpt_wr_req_create(tpt_ctx, UTIL_BUF_DAT(buf), (uint8_t)buf->len);
+}
+
+/**
+tpt_ctl_byte_snd - send a single-byte control frame (ACK, NAK, CAN).
+@param[in,out]	tpt_ctx		Context
+@param[in]      data        The control byte
+@return                     Return 0 on success, negative error number on failure.
+*/
+int32_t tpt_ctl_byte_snd(tpt_layer_ctx_t *tpt_ctx, uint8_t data)
+{
+    return tpt_wr_req_create(tpt_ctx, &data, 1);
+}
+
 /**
 tpt_wr - write all the write requests to the serial comm port.
 @param[in,out]	tpt_ctx		Context
@@ -76,7 +106,7 @@ static int32_t tpt_wr(tpt_layer_ctx_t *tpt_ctx)
     DWORD bytes_written;
     DWORD result;
 
-    wr_req = util_list_get(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
+    wr_req = util_que_get(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
 
     if (!wr_req)
         return 0;
@@ -91,7 +121,7 @@ static int32_t tpt_wr(tpt_layer_ctx_t *tpt_ctx)
     if (wr_overlapped.hEvent == NULL)
     {
         debug_msg_show(tpt_ctx->plt_ctx, "CreateEvent(overlapped write request event) failed");
-        free(wr_req);
+        util_mem_free(wr_req);
         return 0;
     }
 
@@ -179,7 +209,7 @@ static int32_t tpt_wr(tpt_layer_ctx_t *tpt_ctx)
         }
     }
     CloseHandle(wr_overlapped.hEvent);
-    free(wr_req);
+    util_mem_free(wr_req);
 
     return 1;
 }
@@ -651,7 +681,7 @@ Should be called once before calling the other transport layer functions
 */
 int32_t tpt_init(tpt_layer_ctx_t *tpt_ctx)
 {
-    tpt_ctx->wr_req_hd = NULL;
+    memset(&tpt_ctx->wr_req_hd, 0, sizeof(util_que_t));
     if (tpt_ctx->tpt_rd_tmout < TRANSPORT_READ_TIMEOUT_MIN)
         tpt_ctx->tpt_rd_tmout = TRANSPORT_READ_TIMEOUT_MIN;
 
@@ -690,7 +720,7 @@ tpt_exit - Clean up the transport layer
 void tpt_exit(tpt_layer_ctx_t *tpt_ctx)
 {
     tpt_comm_port_shutdown(tpt_ctx);
-    util_list_flush(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
+    util_que_flush(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
     plt_mtx_destroy(tpt_ctx->wr_req_mtx);
     CloseHandle(tpt_ctx->thrd_exit_evt_hdl);
 }
@@ -701,6 +731,42 @@ void tpt_exit(tpt_layer_ctx_t *tpt_ctx)
 //-----------------------------------------------------------------------------------------------------
 #ifdef OS_LINUX
 
+/**
+tpt_wr_buf_req - queue a buffer to the write thread without copying the data.
+@param[in,out]	tpt_ctx		Context
+@param[in]      buf         Buffer that store the data to be sent. The transport layer takes its own
+                            reference, the caller keeps its reference. If the buffer is still waiting
+                            in the queue, it is not queued again
+@return                     Return 0 on success, negative error number on failure.
+*/
+int32_t tpt_wr_buf_req(tpt_layer_ctx_t *tpt_ctx, util_buf_t *buf)
+{
+    util_buf_que_add(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd, buf);
+
+    // Update write started flag
+    tpt_ctx->wr_started = 1;
+
+#ifdef PLT_EVT_LOOP
+    if (tpt_ctx->plt_ctx->evt_loop)
+    {
+        uint64_t    evt_cnt = 1;
+
+        // Notify the event loop that a buffer has been added
+        if (write(tpt_ctx->wr_evt_fd, &evt_cnt, sizeof(evt_cnt)) < 0)
+        {
+            //Counter overflow, the event loop has been notified
+        }
+        return ZWHCI_NO_ERROR;
+    }
+#endif
+
+    // Notify writer thread that a buffer has been added
+    plt_sem_post(tpt_ctx->wr_q_sem);
+
+    return ZWHCI_NO_ERROR;
+}
+
+
 /**
 tpt_wr_req_create - create and queue a write request to the write thread.
 @param[in,out]	tpt_ctx		Context
@@ -711,23 +777,194 @@ tpt_wr_req_create - create and queue a write request to the write thread.
 int32_t tpt_wr_req_create(tpt_layer_ctx_t *tpt_ctx, uint8_t   *buf, uint8_t dat_sz)
 {
     int32_t     ret_val;    //Return value
+    util_buf_t  *wr_buf;
 
-    ret_val = util_list_add(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd, buf, dat_sz);
-    if (ret_val)
+    wr_buf = util_buf_alloc(TPT_BUF_HEADROOM, dat_sz);
+    if (!wr_buf)
     {
-        return ret_val;
+        return ZWHCI_ERROR_MEMORY;
     }
+    memcpy(util_buf_put(wr_buf, dat_sz), buf, dat_sz);
 
-    // Update write started flag
-    tpt_ctx->wr_started = 1;
+    ret_val = tpt_wr_buf_req(tpt_ctx, wr_buf);
+    util_buf_release(wr_buf);
 
-    // Notify writer thread that a node has been added
-    plt_sem_post(tpt_ctx->wr_q_sem);
+    return ret_val;
+}
+
+
+
+/**
+tpt_port_buf_wr - write a buffer to serial comm port.
+@param[in]	tpt_ctx		Context
+@param[in]	buf		    Data buffer
+@param[in]	len		    Data length
+@return
+@pre        Caller must lock the port_wr_mtx
+*/
+static void tpt_port_buf_wr(tpt_layer_ctx_t *tpt_ctx, const uint8_t *buf, size_t len)
+{
+    ssize_t         bytes_written;
+    size_t          total_written;
+
+    total_written = 0;
+
+    if (tpt_ctx->cap_ctx)
+        cap_add(tpt_ctx->cap_ctx, CAP_REC_TX, buf, len);
+
+    while (total_written < len)
+    {
+        bytes_written = tpt_ctx->port_ops->wr(tpt_ctx, buf + total_written, len - total_written);
+
+        if (bytes_written < 0)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            debug_msg_show(tpt_ctx->plt_ctx, "Write comm port error");
+            break;
+        }
+
+        total_written += bytes_written;
+
+    }
+}
+
+
+/**
+tpt_ctl_take - take all the pending control frames.
+@param[in]	tpt_ctx		Context
+@param[out]	buf		    Buffer of TPT_CTL_PEND_MAX bytes to store the control frames
+@return     Number of control frames taken
+*/
+static uint8_t tpt_ctl_take(tpt_layer_ctx_t *tpt_ctx, uint8_t *buf)
+{
+    uint8_t     cnt;
+
+    plt_mtx_lck(tpt_ctx->wr_req_mtx);
+    cnt = tpt_ctx->ctl_pend_cnt;
+    memcpy(buf, tpt_ctx->ctl_pend, cnt);
+    tpt_ctx->ctl_pend_cnt = 0;
+    plt_mtx_ulck(tpt_ctx->wr_req_mtx);
+
+    return cnt;
+}
+
+
+/**
+tpt_ctl_flush - write the pending control frames if the comm port is not being written.
+@param[in]	tpt_ctx		Context
+@return
+@note       If the comm port is being written, the writer will flush the control frames after
+            releasing the port_wr_mtx
+*/
+static void tpt_ctl_flush(tpt_layer_ctx_t *tpt_ctx)
+{
+    uint8_t     ctl_buf[TPT_CTL_PEND_MAX];
+    uint8_t     ctl_cnt;
+
+    while (1)
+    {
+        plt_mtx_lck(tpt_ctx->wr_req_mtx);
+        ctl_cnt = tpt_ctx->ctl_pend_cnt;
+        plt_mtx_ulck(tpt_ctx->wr_req_mtx);
+
+        if (!ctl_cnt)
+        {
+            return;
+        }
+
+        if (plt_mtx_trylck(tpt_ctx->port_wr_mtx) != 0)
+        {   //The current writer will check again after releasing the comm port
+            return;
+        }
+
+        ctl_cnt = tpt_ctl_take(tpt_ctx, ctl_buf);
+        if (ctl_cnt)
+        {
+            tpt_port_buf_wr(tpt_ctx, ctl_buf, ctl_cnt);
+        }
+        plt_mtx_ulck(tpt_ctx->port_wr_mtx);
+    }
+}
+
+
+/**
+tpt_ctl_byte_snd - send a single-byte control frame (ACK, NAK, CAN).
+The byte is written to the comm port directly by the calling thread, bypassing the write queue.
+If the comm port is being written by another thread, the byte is sent together with or right after
+that write.
+@param[in,out]	tpt_ctx		Context
+@param[in]      data        The control byte
+@return                     Return 0 on success, negative error number on failure.
+*/
+int32_t tpt_ctl_byte_snd(tpt_layer_ctx_t *tpt_ctx, uint8_t data)
+{
+    uint8_t     ctl_buf[TPT_CTL_PEND_MAX + 1];
+    uint8_t     ctl_cnt;
 
+    plt_mtx_lck(tpt_ctx->wr_req_mtx);
+    if (tpt_ctx->ctl_pend_cnt < TPT_CTL_PEND_MAX)
+    {
+        tpt_ctx->ctl_pend[tpt_ctx->ctl_pend_cnt++] = data;
+        plt_mtx_ulck(tpt_ctx->wr_req_mtx);
+
+        tpt_ctl_flush(tpt_ctx);
+        return ZWHCI_NO_ERROR;
+    }
+    plt_mtx_ulck(tpt_ctx->wr_req_mtx);
+
+    //Too many pending control frames, wait for the comm port
+    plt_mtx_lck(tpt_ctx->port_wr_mtx);
+    ctl_cnt = tpt_ctl_take(tpt_ctx, ctl_buf);
+    ctl_buf[ctl_cnt++] = data;
+    tpt_port_buf_wr(tpt_ctx, ctl_buf, ctl_cnt);
+    plt_mtx_ulck(tpt_ctx->port_wr_mtx);
+
+    tpt_ctl_flush(tpt_ctx);
     return ZWHCI_NO_ERROR;
 }
 
 
+/**
+tpt_port_wr - write a buffer to serial comm port.
+Pending control frames are written in front of the data with a single write.
+@param[in]	tpt_ctx		Context
+@param[in]	wr_buf		The buffer
+@return
+*/
+static void tpt_port_wr(tpt_layer_ctx_t *tpt_ctx, util_buf_t *wr_buf)
+{
+    uint8_t     ctl_buf[TPT_CTL_PEND_MAX];
+    uint8_t     *dat;
+    uint8_t     ctl_cnt;
+
+    plt_mtx_lck(tpt_ctx->port_wr_mtx);
+
+    dat = UTIL_BUF_DAT(wr_buf);
+    ctl_cnt = tpt_ctl_take(tpt_ctx, ctl_buf);
+    if (ctl_cnt && (wr_buf->head >= ctl_cnt))
+    {   //Place the control frames in the headroom. The head offset is left unchanged as
+        //the buffer may be shared with the upper layer
+        memcpy(dat - ctl_cnt, ctl_buf, ctl_cnt);
+        tpt_port_buf_wr(tpt_ctx, dat - ctl_cnt, ctl_cnt + wr_buf->len);
+    }
+    else
+    {
+        if (ctl_cnt)
+        {
+            tpt_port_buf_wr(tpt_ctx, ctl_buf, ctl_cnt);
+        }
+        tpt_port_buf_wr(tpt_ctx, dat, wr_buf->len);
+    }
+
+    plt_mtx_ulck(tpt_ctx->port_wr_mtx);
+
+    //Control frames may have been queued while the comm port was being written
+    tpt_ctl_flush(tpt_ctx);
+}
+
 
 /**
 tpt_wr_thrd - thread for writing to serial comm port.
@@ -737,9 +974,7 @@ tpt_wr_thrd - thread for writing to serial comm port.
 static void tpt_wr_thrd(void   *data)
 {
     tpt_layer_ctx_t *tpt_ctx = (tpt_layer_ctx_t *)data;
-    util_lst_t      *wr_req;
-    ssize_t         bytes_written;
-    uint32_t        total_written;
+    util_buf_t      *wr_buf;
 
     tpt_ctx->wr_thrd_sts = 1;
 
@@ -755,35 +990,38 @@ static void tpt_wr_thrd(void   *data)
             return;
         }
 
-        wr_req = util_list_get(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
+        wr_buf = util_buf_que_get(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
 
-        if (wr_req)
+        if (wr_buf)
         {
-            total_written = 0;
-
-            while (total_written < wr_req->dat_sz)
-            {
-                bytes_written = write(tpt_ctx->comm_port_fd, wr_req->wr_buf + total_written,
-                                      wr_req->dat_sz - total_written);
-                int j=0;
-                /*printf("write data==> ");
-                for(j=0;j<wr_req->dat_sz;j++){
-                    printf("%02x ",wr_req->wr_buf[j]);
-                }
-                printf("\n");*/
+            tpt_port_wr(tpt_ctx, wr_buf);
+            util_buf_release(wr_buf);
+        }
+    }
+}
 
-                if (bytes_written < 0)
-                {
-                    debug_msg_show(tpt_ctx->plt_ctx, "Write comm port error");
-                    break;
-                }
 
-                total_written += bytes_written;
+/**
+tpt_rd_chunk_cb - pass the data read from serial comm port to the frame layer.
+@param[in]	tpt_ctx		Context
+@param[in]	buf		    Data buffer
+@param[in]	len		    Data length
+@return
+*/
+static void tpt_rd_chunk_cb(tpt_layer_ctx_t *tpt_ctx, uint8_t *buf, size_t len)
+{
+    uint8_t chunk_len;
 
-            }
+    if (tpt_ctx->cap_ctx)
+        cap_add(tpt_ctx->cap_ctx, CAP_REC_RX, buf, len);
 
-            free(wr_req);
-        }
+    //The read callback takes at most 255 bytes at a time
+    while (len > 0)
+    {
+        chunk_len = (len > 0xFF)? 0xFF : (uint8_t)len;
+        tpt_ctx->tpt_rd_cb(tpt_ctx, buf, chunk_len);
+        buf += chunk_len;
+        len -= chunk_len;
     }
 }
 
@@ -806,7 +1044,8 @@ static void tpt_rd_thrd(void   *data)
     struct timeval  timeout;
     unsigned        timeout_sec;
     unsigned        timeout_usec;
-    uint8_t         rd_char;
+    ssize_t         rd_len;
+    uint8_t         rd_buf[COMM_MAX_READ_BUFFER];
 
     tpt_ctx->rd_thrd_sts = 1;
 
@@ -850,10 +1089,16 @@ static void tpt_rd_thrd(void   *data)
         {
             if (FD_ISSET(filedes, &active_rd_set))
             {
-                if(read(filedes, &rd_char, 1) == 1)
+                //Read all the data available, up to the buffer size
+                rd_len = read(filedes, rd_buf, sizeof(rd_buf));
+                if (rd_len > 0)
                 {// read completed immediately, callback frame layer
-                    //printf("read data ==> %02x ",rd_char);
-                    tpt_ctx->tpt_rd_cb(tpt_ctx, &rd_char, 1);
+                    tpt_rd_chunk_cb(tpt_ctx, rd_buf, (size_t)rd_len);
+                }
+                else if (rd_len == 0)
+                {   //End of file, the socket peer has closed the connection
+                    debug_msg_show(tpt_ctx->plt_ctx, "Comm port closed by peer");
+                    break;
                 }
             }
 
@@ -874,6 +1119,166 @@ static void tpt_rd_thrd(void   *data)
 
 
 
+#ifdef PLT_EVT_LOOP
+/**
+tpt_rd_evt_cb - event loop callback when serial comm port is readable.
+@param[in]	data		Context
+@return
+*/
+static void tpt_rd_evt_cb(void *data)
+{
+    tpt_layer_ctx_t *tpt_ctx = (tpt_layer_ctx_t *)data;
+    ssize_t         rd_len;
+    uint8_t         rd_buf[COMM_MAX_READ_BUFFER];
+
+    rd_len = read(tpt_ctx->comm_port_fd, rd_buf, sizeof(rd_buf));
+
+    if (rd_len > 0)
+    {
+        tpt_rd_chunk_cb(tpt_ctx, rd_buf, (size_t)rd_len);
+    }
+    else if (rd_len == 0)
+    {   //End of file, the socket peer has closed the connection. Stop polling the comm port
+        debug_msg_show(tpt_ctx->plt_ctx, "Comm port closed by peer");
+        plt_mtx_lck(tpt_ctx->wr_req_mtx);
+        if (tpt_ctx->rd_evt_sts == 1)
+        {
+            plt_evt_rm(tpt_ctx->plt_ctx, tpt_ctx->comm_port_fd);
+            tpt_ctx->rd_evt_sts = -1;
+        }
+        plt_mtx_ulck(tpt_ctx->wr_req_mtx);
+    }
+    else if ((rd_len < 0) && (errno != EINTR) && (errno != EAGAIN))
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Read comm port error");
+    }
+}
+
+
+/**
+tpt_rd_evt_reg - register serial comm port to the event loop if not yet done.
+@param[in]	tpt_ctx		Context
+@return
+*/
+static void tpt_rd_evt_reg(tpt_layer_ctx_t *tpt_ctx)
+{
+    plt_mtx_lck(tpt_ctx->wr_req_mtx);
+    if (tpt_ctx->rd_evt_sts == 0)
+    {
+        if (plt_evt_add(tpt_ctx->plt_ctx, tpt_ctx->comm_port_fd, tpt_rd_evt_cb, tpt_ctx) == 0)
+        {
+            tpt_ctx->rd_evt_sts = 1;
+        }
+        else
+        {
+            debug_msg_show(tpt_ctx->plt_ctx, "Register comm port to event loop failed");
+        }
+    }
+    plt_mtx_ulck(tpt_ctx->wr_req_mtx);
+}
+
+
+/**
+tpt_rd_evt_tmout_cb - timer callback to start reading serial comm port when there is no write.
+@param[in]	data		Context
+@return
+*/
+static void tpt_rd_evt_tmout_cb(void *data)
+{
+    tpt_layer_ctx_t *tpt_ctx = (tpt_layer_ctx_t *)data;
+
+    tpt_rd_evt_reg(tpt_ctx);
+}
+
+
+/**
+tpt_wr_evt_cb - event loop callback when write requests are queued.
+@param[in]	data		Context
+@return
+*/
+static void tpt_wr_evt_cb(void *data)
+{
+    tpt_layer_ctx_t *tpt_ctx = (tpt_layer_ctx_t *)data;
+    util_buf_t      *wr_buf;
+    uint64_t        evt_cnt;
+
+    if (read(tpt_ctx->wr_evt_fd, &evt_cnt, sizeof(evt_cnt)) < 0)
+    {
+        //Already drained
+    }
+
+    //Write started, upper layer read callback functions are ready
+    tpt_rd_evt_reg(tpt_ctx);
+
+    while ((wr_buf = util_buf_que_get(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd)) != NULL)
+    {
+        tpt_port_wr(tpt_ctx, wr_buf);
+        util_buf_release(wr_buf);
+    }
+}
+
+
+/**
+tpt_evt_start - Register the serial comm port and the write requests to the event loop.
+                This replaces the read and write threads only. The received data is passed up
+                on the timer check thread, but the session layer hands callbacks and unsolicited
+                commands to its callback threads as they may issue synchronous requests.
+@param[in,out]	tpt_ctx		Context
+@return     Return non-zero indicates success, zero indicates failure.
+*/
+static int tpt_evt_start(tpt_layer_ctx_t *tpt_ctx)
+{
+    tpt_ctx->rd_evt_sts = 0;
+
+    tpt_ctx->wr_evt_fd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (tpt_ctx->wr_evt_fd < 0)
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Init transport write event failed");
+        return 0;
+    }
+
+    if (plt_evt_add(tpt_ctx->plt_ctx, tpt_ctx->wr_evt_fd, tpt_wr_evt_cb, tpt_ctx) != 0)
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Register transport write event failed");
+        close(tpt_ctx->wr_evt_fd);
+        return 0;
+    }
+
+    //Delay 1 second or until write started, before reading data to avoid race condition where
+    //upper layer read callback functions are not ready
+    tpt_ctx->rd_evt_tmr_ctx = plt_tmr_start(tpt_ctx->plt_ctx, 1000, tpt_rd_evt_tmout_cb, tpt_ctx);
+
+    return 1;
+}
+
+
+/**
+tpt_evt_stop - Unregister the serial comm port and the write requests from the event loop.
+@param[in]	tpt_ctx		Context
+@return
+*/
+static void tpt_evt_stop(tpt_layer_ctx_t *tpt_ctx)
+{
+    int     rd_evt_sts;
+
+    plt_tmr_stop(tpt_ctx->plt_ctx, tpt_ctx->rd_evt_tmr_ctx);
+
+    plt_mtx_lck(tpt_ctx->wr_req_mtx);
+    rd_evt_sts = tpt_ctx->rd_evt_sts;
+    tpt_ctx->rd_evt_sts = -1;
+    plt_mtx_ulck(tpt_ctx->wr_req_mtx);
+
+    if (rd_evt_sts == 1)
+    {
+        plt_evt_rm(tpt_ctx->plt_ctx, tpt_ctx->comm_port_fd);
+    }
+
+    plt_evt_rm(tpt_ctx->plt_ctx, tpt_ctx->wr_evt_fd);
+    close(tpt_ctx->wr_evt_fd);
+}
+#endif
+
+
 /**
 tpt_thrd_start - Creates the Reader/Status and Writer threads.
 @param[in,out]	tpt_ctx		Context
@@ -951,17 +1356,18 @@ static void tpt_thrd_stop(tpt_layer_ctx_t *tpt_ctx)
 }
 
 /**
-tpt_port_setup - Setup comm port parameters.
+tpt_tty_open - Open serial comm port and setup comm port parameters.
 @param[in,out]	tpt_ctx		Context
+@param[in]	    addr		Device name of the serial comm port
 @return     Return non-zero indicates success, zero indicates failure.
 */
-static int tpt_port_setup(tpt_layer_ctx_t *tpt_ctx)
+static int tpt_tty_open(tpt_layer_ctx_t *tpt_ctx, const char *addr)
 {
-	tpt_ctx->comm_port_fd = open(tpt_ctx->comm_port_name, O_RDWR);
+	tpt_ctx->comm_port_fd = open(addr, O_RDWR);
 
 	if (tpt_ctx->comm_port_fd < 0)
 	{
-		debug_msg_show(tpt_ctx->plt_ctx, "Failed to open:%s. Err no:%d", tpt_ctx->comm_port_name, errno);
+		debug_msg_show(tpt_ctx->plt_ctx, "Failed to open:%s. Err no:%d", addr, errno);
         if (errno == EACCES)
         {
             debug_msg_show(tpt_ctx->plt_ctx, "Access to the port is not allowed \(need root access) or the port does not exist");
@@ -1010,7 +1416,7 @@ static int tpt_port_setup(tpt_layer_ctx_t *tpt_ctx)
     }
     else
     {
-        debug_msg_show(tpt_ctx->plt_ctx, "The fd for %s is NOT a serial comm port", tpt_ctx->comm_port_name);
+        debug_msg_show(tpt_ctx->plt_ctx, "The fd for %s is NOT a serial comm port", addr);
         close(tpt_ctx->comm_port_fd);
         return 0;
     }
@@ -1020,47 +1426,559 @@ static int tpt_port_setup(tpt_layer_ctx_t *tpt_ctx)
 
 
 /**
-tpt_init - Init the transport layer.
-Should be called once before calling the other transport layer functions
+tpt_tcp_open - Connect to a serial-over-TCP bridge.
 @param[in,out]	tpt_ctx		Context
-@return     Return zero indicates success, non-zero indicates failure.
-@post       Caller should not modify the tpt_ctx after this call
+@param[in]	    addr		Host and port in the form "host:port"
+@return     Return non-zero indicates success, zero indicates failure.
 */
-int32_t tpt_init(tpt_layer_ctx_t *tpt_ctx)
+static int tpt_tcp_open(tpt_layer_ctx_t *tpt_ctx, const char *addr)
 {
-    tpt_ctx->wr_req_hd = NULL;
-    if (tpt_ctx->tpt_rd_tmout < TRANSPORT_READ_TIMEOUT_MIN)
-        tpt_ctx->tpt_rd_tmout = TRANSPORT_READ_TIMEOUT_MIN;
+    struct addrinfo hints;
+    struct addrinfo *res;
+    struct addrinfo *ai;
+    const char      *port;
+    char            host[64];
+    size_t          host_len;
+    int             opt;
+    int             result;
 
-    if (!tpt_ctx->comm_port_id)
-        return INIT_ERROR_TRANSPORT;
+    port = strrchr(addr, ':');
+    host_len = (port)? (size_t)(port - addr) : 0;
+    if ((host_len == 0) || (host_len >= sizeof(host)))
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Invalid TCP address:%s", addr);
+        return 0;
+    }
+    memcpy(host, addr, host_len);
+    host[host_len] = '\0';
+    port++;
 
-    tpt_ctx->comm_port_name = (char *)tpt_ctx->comm_port_id;
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+
+    result = getaddrinfo(host, port, &hints, &res);
+    if (result != 0)
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Failed to resolve:%s. Err:%s", addr, gai_strerror(result));
+        return 0;
+    }
+
+    tpt_ctx->comm_port_fd = -1;
+    for (ai = res; ai; ai = ai->ai_next)
+    {
+        tpt_ctx->comm_port_fd = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (tpt_ctx->comm_port_fd < 0)
+        {
+            continue;
+        }
+        if (connect(tpt_ctx->comm_port_fd, ai->ai_addr, ai->ai_addrlen) == 0)
+        {
+            break;
+        }
+        close(tpt_ctx->comm_port_fd);
+        tpt_ctx->comm_port_fd = -1;
+    }
+    freeaddrinfo(res);
+
+    if (tpt_ctx->comm_port_fd < 0)
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Failed to connect:%s. Err no:%d", addr, errno);
+        return 0;
+    }
+
+    //Frames are small and latency sensitive, send them immediately
+    opt = 1;
+    setsockopt(tpt_ctx->comm_port_fd, IPPROTO_TCP, TCP_NODELAY, &opt, sizeof(opt));
+#ifdef SO_NOSIGPIPE
+    setsockopt(tpt_ctx->comm_port_fd, SOL_SOCKET, SO_NOSIGPIPE, &opt, sizeof(opt));
+#endif
+
+    return 1;
+}
+
+
+/**
+tpt_unix_open - Connect to a Unix domain stream socket.
+@param[in,out]	tpt_ctx		Context
+@param[in]	    addr		Socket path
+@return     Return non-zero indicates success, zero indicates failure.
+*/
+static int tpt_unix_open(tpt_layer_ctx_t *tpt_ctx, const char *addr)
+{
+    struct sockaddr_un  sock_addr;
+
+    memset(&sock_addr, 0, sizeof(sock_addr));
+    if (strlen(addr) >= sizeof(sock_addr.sun_path))
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Invalid socket path:%s", addr);
+        return 0;
+    }
+    sock_addr.sun_family = AF_UNIX;
+    strcpy(sock_addr.sun_path, addr);
+
+    tpt_ctx->comm_port_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (tpt_ctx->comm_port_fd < 0)
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Failed to create socket. Err no:%d", errno);
+        return 0;
+    }
+
+    if (connect(tpt_ctx->comm_port_fd, (struct sockaddr *)&sock_addr, sizeof(sock_addr)) != 0)
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Failed to connect:%s. Err no:%d", addr, errno);
+        close(tpt_ctx->comm_port_fd);
+        return 0;
+    }
+
+#ifdef SO_NOSIGPIPE
+    {
+        int opt = 1;
+        setsockopt(tpt_ctx->comm_port_fd, SOL_SOCKET, SO_NOSIGPIPE, &opt, sizeof(opt));
+    }
+#endif
+
+    return 1;
+}
+
+
+/**
+tpt_fd_open - Use an already opened file descriptor as the comm port.
+@param[in,out]	tpt_ctx		Context
+@param[in]	    addr		File descriptor number in decimal
+@return     Return non-zero indicates success, zero indicates failure.
+@post       The transport layer owns the file descriptor and closes it in tpt_exit.
+*/
+static int tpt_fd_open(tpt_layer_ctx_t *tpt_ctx, const char *addr)
+{
+    char    *end;
+    long    fd;
+
+    fd = strtol(addr, &end, 10);
+
+    if ((end == addr) || (*end != '\0') || (fd < 0) || (fcntl((int)fd, F_GETFD) < 0))
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Invalid file descriptor:%s", addr);
+        return 0;
+    }
+
+    tpt_ctx->comm_port_fd = (int)fd;
+
+    return 1;
+}
+
+
+/**
+tpt_tty_wr - Write to the serial comm port.
+@param[in]	tpt_ctx		Context
+@param[in]	buf		    Data buffer
+@param[in]	len		    Data length
+@return     Number of bytes written; negative on error.
+*/
+static ssize_t tpt_tty_wr(tpt_layer_ctx_t *tpt_ctx, const uint8_t *buf, size_t len)
+{
+    return write(tpt_ctx->comm_port_fd, buf, len);
+}
+
+
+/**
+tpt_sock_wr - Write to the comm port socket without raising SIGPIPE if the peer has gone.
+@param[in]	tpt_ctx		Context
+@param[in]	buf		    Data buffer
+@param[in]	len		    Data length
+@return     Number of bytes written; negative on error.
+*/
+static ssize_t tpt_sock_wr(tpt_layer_ctx_t *tpt_ctx, const uint8_t *buf, size_t len)
+{
+#ifdef MSG_NOSIGNAL
+    return send(tpt_ctx->comm_port_fd, buf, len, MSG_NOSIGNAL);
+#else
+    return send(tpt_ctx->comm_port_fd, buf, len, 0);
+#endif
+}
+
+
+/**
+tpt_fd_wr - Write to an already opened file descriptor, which may be a socket or a pipe.
+@param[in]	tpt_ctx		Context
+@param[in]	buf		    Data buffer
+@param[in]	len		    Data length
+@return     Number of bytes written; negative on error.
+*/
+static ssize_t tpt_fd_wr(tpt_layer_ctx_t *tpt_ctx, const uint8_t *buf, size_t len)
+{
+#ifdef MSG_NOSIGNAL
+    ssize_t ret;
+
+    ret = send(tpt_ctx->comm_port_fd, buf, len, MSG_NOSIGNAL);
+    if ((ret >= 0) || (errno != ENOTSOCK))
+    {
+        return ret;
+    }
+#endif
+    return write(tpt_ctx->comm_port_fd, buf, len);
+}
+
+
+///
+/// Replay backend context
+typedef struct
+{
+    cap_rd_t            rd;             ///< Trace file reader
+    int                 real_time;      ///< Flag to replay with the time between records in the trace. The
+                                        ///< order of requests and responses is kept in both modes
+    int                 pipe_fd[2];     ///< Pipe that never gets data, its read end serves as comm_port_fd
+    volatile uint32_t   tx_cnt;         ///< Number of bytes the host has written
+    volatile int        thrd_run;       ///< Control the replay thread whether to run. 1 = run, 0 = stop
+    volatile int        thrd_sts;       ///< Replay thread status. 1 = running, 0 = thread exited
+
+} tpt_rpl_t;
+
+
+/**
+tpt_rpl_wait - Wait for the replay time of a received record.
+@param[in]	tpt_ctx		Context
+@param[in]	rpl_tm		Time to pass the record to the frame layer in microseconds, real time mode only
+@param[in]	trace_tx	Number of bytes the host wrote before the record in the trace
+@return
+*/
+static void tpt_rpl_wait(tpt_layer_ctx_t *tpt_ctx, uint64_t rpl_tm, uint32_t trace_tx)
+{
+    tpt_rpl_t   *rpl = (tpt_rpl_t *)tpt_ctx->rpl_ctx;
+    uint64_t    now;
+    uint32_t    wait_ms;
+
+    //Keep the order of requests and responses as in the trace. Poll at a fine interval, the host
+    //usually responds within a fraction of a millisecond
+    now = plt_mono_us();
+    while (rpl->thrd_run && ((int32_t)(rpl->tx_cnt - trace_tx) < 0)
+           && ((plt_mono_us() - now) < (TPT_RPL_SYNC_TMOUT * 1000)))
+    {
+        usleep(50);
+    }
+
+    if (rpl->real_time)
+    {
+        while (rpl->thrd_run && ((now = plt_mono_us()) < rpl_tm))
+        {
+            wait_ms = (uint32_t)((rpl_tm - now + 999) / 1000);
+            plt_sleep((wait_ms > 100)? 100 : wait_ms);
+        }
+    }
+}
+
+
+/**
+tpt_rpl_thrd - thread to pass the received bytes in the trace file to the frame layer.
+@param[in]	data		Context
+@return
+*/
+static void tpt_rpl_thrd(void   *data)
+{
+    tpt_layer_ctx_t *tpt_ctx = (tpt_layer_ctx_t *)data;
+    tpt_rpl_t       *rpl = (tpt_rpl_t *)tpt_ctx->rpl_ctx;
+    cap_rec_t       rec;
+    uint64_t        start_tm = 0;
+    uint64_t        first_ts = 0;
+    uint64_t        rpl_tm;
+    uint64_t        now;
+    uint32_t        trace_tx = 0;
+    uint32_t        rec_cnt = 0;
+    int             loop_cnt;
+
+    //Delay 1 second or until write started, as the read thread
+    loop_cnt = 10;
+    while ((loop_cnt-- > 0) && !tpt_ctx->wr_started)
+    {
+        plt_sleep(100);
+    }
+
+    while (rpl->thrd_run && cap_rd_next(&rpl->rd, &rec))
+    {
+        if (rec_cnt++ == 0)
+        {
+            start_tm = plt_mono_us();
+            first_ts = rec.ts;
+        }
+
+        if (rec.typ == CAP_REC_TX)
+        {
+            trace_tx += rec.len;
+        }
+        else if (rec.typ == CAP_REC_RX)
+        {
+            rpl_tm = start_tm + (rec.ts - first_ts);
+            tpt_rpl_wait(tpt_ctx, rpl_tm, trace_tx);
+
+            //Keep the time between the records after waiting for the host
+            now = plt_mono_us();
+            if (now > rpl_tm)
+                start_tm += now - rpl_tm;
+
+            if (rpl->thrd_run)
+                tpt_rd_chunk_cb(tpt_ctx, rec.dat, rec.len);
+        }
+    }
+
+    debug_msg_show(tpt_ctx->plt_ctx, "Replay done, %u records", rec_cnt);
+
+    rpl->thrd_sts = 0;
+}
+
+
+/**
+tpt_rpl_start - Open the trace file and start the replay thread.
+@param[in,out]	tpt_ctx		Context
+@param[in]	    addr		Trace file name
+@param[in]	    real_time	Flag to replay with the time between records in the trace
+@return     Return non-zero indicates success, zero indicates failure.
+*/
+static int tpt_rpl_start(tpt_layer_ctx_t *tpt_ctx, const char *addr, int real_time)
+{
+    tpt_rpl_t   *rpl;
+
+    rpl = (tpt_rpl_t *)calloc(1, sizeof(tpt_rpl_t));
+    if (!rpl)
+        return 0;
+
+    rpl->real_time = real_time;
+
+    if (!cap_rd_open(&rpl->rd, addr))
+    {
+        debug_msg_show(tpt_ctx->plt_ctx, "Invalid trace file:%s", addr);
+        goto l_RPL_START_ERROR;
+    }
+
+    if (pipe(rpl->pipe_fd) < 0)
+        goto l_RPL_START_ERROR1;
+
+    tpt_ctx->comm_port_fd = rpl->pipe_fd[0];
+    tpt_ctx->rpl_ctx = rpl;
+
+    rpl->thrd_run = 1;
+    rpl->thrd_sts = 1;
+    if (plt_thrd_create(tpt_rpl_thrd, tpt_ctx) < 0)
+        goto l_RPL_START_ERROR2;
+
+    return 1;
+
+l_RPL_START_ERROR2:
+    tpt_ctx->rpl_ctx = NULL;
+    close(rpl->pipe_fd[0]);
+    close(rpl->pipe_fd[1]);
+
+l_RPL_START_ERROR1:
+    cap_rd_close(&rpl->rd);
+
+l_RPL_START_ERROR:
+    free(rpl);
+    return 0;
+}
+
+
+/**
+tpt_rpl_open - Replay a trace file as fast as the host keeps up.
+@param[in,out]	tpt_ctx		Context
+@param[in]	    addr		Trace file name
+@return     Return non-zero indicates success, zero indicates failure.
+*/
+static int tpt_rpl_open(tpt_layer_ctx_t *tpt_ctx, const char *addr)
+{
+    return tpt_rpl_start(tpt_ctx, addr, 0);
+}
+
+
+/**
+tpt_rpl_rt_open - Replay a trace file in real time.
+@param[in,out]	tpt_ctx		Context
+@param[in]	    addr		Trace file name
+@return     Return non-zero indicates success, zero indicates failure.
+*/
+static int tpt_rpl_rt_open(tpt_layer_ctx_t *tpt_ctx, const char *addr)
+{
+    return tpt_rpl_start(tpt_ctx, addr, 1);
+}
+
+
+/**
+tpt_rpl_wr - Discard the bytes written by the host during replay.
+@param[in]	tpt_ctx		Context
+@param[in]	buf		    Data buffer
+@param[in]	len		    Data length
+@return     Number of bytes written
+*/
+static ssize_t tpt_rpl_wr(tpt_layer_ctx_t *tpt_ctx, const uint8_t *buf, size_t len)
+{
+    tpt_rpl_t   *rpl = (tpt_rpl_t *)tpt_ctx->rpl_ctx;
+
+    rpl->tx_cnt += (uint32_t)len;
+    return (ssize_t)len;
+}
+
+
+/**
+tpt_rpl_close - Stop the replay thread and close the trace file.
+@param[in]	tpt_ctx		Context
+@return
+*/
+static void tpt_rpl_close(tpt_layer_ctx_t *tpt_ctx)
+{
+    tpt_rpl_t   *rpl = (tpt_rpl_t *)tpt_ctx->rpl_ctx;
+    int         wait_count;
+
+    rpl->thrd_run = 0;
+
+    wait_count = 50;
+    while (wait_count-- > 0)
+    {
+        if (rpl->thrd_sts == 0)
+            break;
+        plt_sleep(100);
+    }
+
+    close(rpl->pipe_fd[0]);
+    close(rpl->pipe_fd[1]);
+    cap_rd_close(&rpl->rd);
+    free(rpl);
+    tpt_ctx->rpl_ctx = NULL;
+}
+
+
+///
+/// Transport backends, the last entry is the default
+static const tpt_port_ops_t tpt_port_ops_tbl[] =
+{
+    {TPT_PORT_PREFIX_TCP,       tpt_tcp_open,       tpt_sock_wr,    NULL},
+    {TPT_PORT_PREFIX_UNIX,      tpt_unix_open,      tpt_sock_wr,    NULL},
+    {TPT_PORT_PREFIX_FD,        tpt_fd_open,        tpt_fd_wr,      NULL},
+    {TPT_PORT_PREFIX_REPLAY,    tpt_rpl_open,       tpt_rpl_wr,     tpt_rpl_close},
+    {TPT_PORT_PREFIX_REPLAY_RT, tpt_rpl_rt_open,    tpt_rpl_wr,     tpt_rpl_close},
+    {NULL,                      tpt_tty_open,       tpt_tty_wr,     NULL}
+};
+
+
+/**
+tpt_port_setup - Select the backend by comm port name, open and setup comm port.
+@param[in,out]	tpt_ctx		Context
+@return     Return non-zero indicates success, zero indicates failure.
+*/
+static int tpt_port_setup(tpt_layer_ctx_t *tpt_ctx)
+{
+    const tpt_port_ops_t    *ops;
+    const char              *addr;
+
+    ops = tpt_port_ops_tbl;
+    addr = tpt_ctx->comm_port_name;
+
+    while (ops->prefix)
+    {
+        if (strncmp(addr, ops->prefix, strlen(ops->prefix)) == 0)
+        {
+            addr += strlen(ops->prefix);
+            break;
+        }
+        ops++;
+    }
+
+    tpt_ctx->port_ops = ops;
+
+    return ops->open(tpt_ctx, addr);
+}
+
+
+/**
+tpt_port_close - Close the comm port.
+@param[in,out]	tpt_ctx		Context
+@return
+*/
+static void tpt_port_close(tpt_layer_ctx_t *tpt_ctx)
+{
+    if (tpt_ctx->port_ops->close)
+        tpt_ctx->port_ops->close(tpt_ctx);
+    else
+        close(tpt_ctx->comm_port_fd);
+}
+
+
+/**
+tpt_init - Init the transport layer.
+Should be called once before calling the other transport layer functions
+@param[in,out]	tpt_ctx		Context
+@return     Return zero indicates success, non-zero indicates failure.
+@post       Caller should not modify the tpt_ctx after this call
+*/
+int32_t tpt_init(tpt_layer_ctx_t *tpt_ctx)
+{
+    memset(&tpt_ctx->wr_req_hd, 0, sizeof(util_buf_que_t));
+    if (tpt_ctx->tpt_rd_tmout < TRANSPORT_READ_TIMEOUT_MIN)
+        tpt_ctx->tpt_rd_tmout = TRANSPORT_READ_TIMEOUT_MIN;
+
+    if (!tpt_ctx->comm_port_id)
+        return INIT_ERROR_TRANSPORT;
+
+    tpt_ctx->comm_port_name = (char *)tpt_ctx->comm_port_id;
+
+    tpt_ctx->ctl_pend_cnt = 0;
+    tpt_ctx->rpl_ctx = NULL;
+    tpt_ctx->cap_ctx = NULL;
 
     if (!plt_mtx_init(&tpt_ctx->wr_req_mtx))
         return INIT_ERROR_TRANSPORT;
 
-    if (!plt_sem_init(&tpt_ctx->wr_q_sem))
+    if (!plt_mtx_init(&tpt_ctx->port_wr_mtx))
     {
         goto l_TRANSPORT_INIT_ERROR;
     }
 
+    if (!plt_sem_init(&tpt_ctx->wr_q_sem))
+    {
+        goto l_TRANSPORT_INIT_ERROR0;
+    }
+
     // Open and setup comm port
     if (!tpt_port_setup(tpt_ctx))
         goto l_TRANSPORT_INIT_ERROR1;
 
+    // Start capturing the comm port traffic
+    if (tpt_ctx->cap_file)
+    {
+        if (!cap_open(&tpt_ctx->cap_ctx, tpt_ctx->plt_ctx, tpt_ctx->cap_file))
+            goto l_TRANSPORT_INIT_ERROR2;
+    }
+
+#ifdef PLT_EVT_LOOP
+    if (tpt_ctx->plt_ctx->evt_loop)
+    {
+        // Serve the comm port on the event loop
+        if (!tpt_evt_start(tpt_ctx))
+            goto l_TRANSPORT_INIT_ERROR3;
+
+        return 0;
+    }
+#endif
+
     // Start threads
     if (!tpt_thrd_start(tpt_ctx))
-        goto l_TRANSPORT_INIT_ERROR2;
+        goto l_TRANSPORT_INIT_ERROR3;
 
     return 0;
 
+l_TRANSPORT_INIT_ERROR3:
+    if (tpt_ctx->cap_ctx)
+    {
+        cap_close(tpt_ctx->cap_ctx);
+        tpt_ctx->cap_ctx = NULL;
+    }
+
 l_TRANSPORT_INIT_ERROR2:
-    close(tpt_ctx->comm_port_fd);
+    tpt_port_close(tpt_ctx);
 
 l_TRANSPORT_INIT_ERROR1:
     plt_sem_destroy(tpt_ctx->wr_q_sem);
 
+l_TRANSPORT_INIT_ERROR0:
+    plt_mtx_destroy(tpt_ctx->port_wr_mtx);
+
 l_TRANSPORT_INIT_ERROR:
     plt_mtx_destroy(tpt_ctx->wr_req_mtx);
 
@@ -1075,13 +1993,32 @@ tpt_exit - Clean up the transport layer
 */
 void tpt_exit(tpt_layer_ctx_t *tpt_ctx)
 {
+#ifdef PLT_EVT_LOOP
+    if (tpt_ctx->plt_ctx->evt_loop)
+    {
+        tpt_evt_stop(tpt_ctx);
+    }
+    else
+    {
+        //Stop all the threads
+        tpt_thrd_stop(tpt_ctx);
+    }
+#else
     //Stop all the threads
     tpt_thrd_stop(tpt_ctx);
+#endif
 
-    close(tpt_ctx->comm_port_fd);
+    tpt_port_close(tpt_ctx);
     plt_sem_destroy(tpt_ctx->wr_q_sem);
 
-    util_list_flush(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
+    if (tpt_ctx->cap_ctx)
+    {
+        cap_close(tpt_ctx->cap_ctx);
+        tpt_ctx->cap_ctx = NULL;
+    }
+
+    util_buf_que_flush(tpt_ctx->wr_req_mtx, &tpt_ctx->wr_req_hd);
+    plt_mtx_destroy(tpt_ctx->port_wr_mtx);
     plt_mtx_destroy(tpt_ctx->wr_req_mtx);
 }
 #endif
@@ -323,6 +323,187 @@ int util_com_port_get(unsigned *port_count, unsigned *ports, TCHAR **friendly_na
 #endif
 
 
+///
+/// Memory pool size class
+typedef struct
+{
+    uint8_t             *arena;     ///< Preallocated blocks; NULL if the pool of this class is not available
+    uint8_t             *arena_end; ///< End of the preallocated blocks
+    void                *free_hd;   ///< Head of the list of free blocks, linked through their first word
+    void                *mtx;       ///< Mutex for accessing the free list and statistics
+    util_mem_cls_stat_t stat;       ///< Statistics
+
+} util_mem_cls_t;
+
+static util_mem_cls_t   util_mem_cls[UTIL_MEM_CLS_CNT];
+static uint32_t         util_mem_heap_cnt;     //Number of allocations larger than the largest block size
+static int              util_mem_init_done;
+
+
+/**
+util_mem_init - Preallocate the blocks of the memory pool.
+@return
+@note   The pool lives until the process exits; subsequent calls have no effect. Must be
+        called before multiple threads use the pool. A size class that fails to initialize
+        falls back to the heap.
+*/
+void util_mem_init(void)
+{
+    static const uint32_t blk_sz[UTIL_MEM_CLS_CNT] = {UTIL_MEM_BLK_SZ_0, UTIL_MEM_BLK_SZ_1, UTIL_MEM_BLK_SZ_2};
+    static const uint32_t blk_cnt[UTIL_MEM_CLS_CNT] = {UTIL_MEM_BLK_CNT_0, UTIL_MEM_BLK_CNT_1, UTIL_MEM_BLK_CNT_2};
+    util_mem_cls_t  *cls;
+    uint32_t        i;
+    uint32_t        j;
+
+    if (util_mem_init_done)
+        return;
+
+    util_mem_init_done = 1;
+
+    for (i=0; i<UTIL_MEM_CLS_CNT; i++)
+    {
+        cls = &util_mem_cls[i];
+        cls->stat.blk_sz = blk_sz[i];
+
+        if (!plt_mtx_init(&cls->mtx))
+            continue;
+
+        cls->arena = (uint8_t *)malloc(blk_sz[i] * blk_cnt[i]);
+        if (!cls->arena)
+        {
+            plt_mtx_destroy(cls->mtx);
+            continue;
+        }
+        cls->arena_end = cls->arena + (blk_sz[i] * blk_cnt[i]);
+
+        //Link up all the blocks into the free list
+        cls->free_hd = NULL;
+        for (j=blk_cnt[i]; j>0; j--)
+        {
+            void **blk = (void **)(cls->arena + (blk_sz[i] * (j - 1)));
+            *blk = cls->free_hd;
+            cls->free_hd = blk;
+        }
+        cls->stat.blk_cnt = blk_cnt[i];
+    }
+}
+
+
+/**
+util_mem_alloc - Allocate memory from the smallest size class that fits, or from the heap if
+                 the pool is exhausted or the size is larger than the largest block size.
+@param[in]  size    Number of bytes to allocate
+@return     Pointer to the allocated memory on success; otherwise NULL.
+@post       The caller must free the memory with util_mem_free.
+*/
+void *util_mem_alloc(size_t size)
+{
+    util_mem_cls_t  *cls;
+    void            **blk;
+    int             i;
+
+    for (i=0; i<UTIL_MEM_CLS_CNT; i++)
+    {
+        cls = &util_mem_cls[i];
+        if (size > cls->stat.blk_sz)
+            continue;
+
+        if (!cls->arena)
+            break;
+
+        plt_mtx_lck(cls->mtx);
+        blk = (void **)cls->free_hd;
+        if (blk)
+        {
+            cls->free_hd = *blk;
+            cls->stat.hit++;
+            if (++cls->stat.in_use > cls->stat.peak)
+            {
+                cls->stat.peak = cls->stat.in_use;
+            }
+        }
+        else
+        {
+            cls->stat.miss++;
+        }
+        plt_mtx_ulck(cls->mtx);
+
+        if (blk)
+            return blk;
+        break;
+    }
+
+    if ((i == UTIL_MEM_CLS_CNT) && util_mem_cls[UTIL_MEM_CLS_CNT - 1].arena)
+    {   //Oversized, account it under the mutex of the largest size class
+        plt_mtx_lck(util_mem_cls[UTIL_MEM_CLS_CNT - 1].mtx);
+        util_mem_heap_cnt++;
+        plt_mtx_ulck(util_mem_cls[UTIL_MEM_CLS_CNT - 1].mtx);
+    }
+
+    return malloc(size);
+}
+
+
+/**
+util_mem_free - Free memory allocated by util_mem_alloc.
+@param[in]  ptr     The memory to free. Memory allocated by malloc is also accepted.
+@return
+*/
+void util_mem_free(void *ptr)
+{
+    util_mem_cls_t  *cls;
+    int             i;
+
+    if (!ptr)
+        return;
+
+    for (i=0; i<UTIL_MEM_CLS_CNT; i++)
+    {
+        cls = &util_mem_cls[i];
+        if (((uint8_t *)ptr >= cls->arena) && ((uint8_t *)ptr < cls->arena_end))
+        {
+            plt_mtx_lck(cls->mtx);
+            *((void **)ptr) = cls->free_hd;
+            cls->free_hd = ptr;
+            cls->stat.in_use--;
+            plt_mtx_ulck(cls->mtx);
+            return;
+        }
+    }
+
+    free(ptr);
+}
+
+
+/**
+util_mem_stat_get - Get the memory pool statistics.
+@param[out] stat    The statistics
+@return
+*/
+void util_mem_stat_get(util_mem_stat_t *stat)
+{
+    util_mem_cls_t  *cls;
+    int             i;
+
+    for (i=0; i<UTIL_MEM_CLS_CNT; i++)
+    {
+        cls = &util_mem_cls[i];
+        if (cls->arena)
+        {
+            plt_mtx_lck(cls->mtx);
+            stat->cls[i] = cls->stat;
+            plt_mtx_ulck(cls->mtx);
+        }
+        else
+        {
+            memset(&stat->cls[i], 0, sizeof(util_mem_cls_stat_t));
+            stat->cls[i].blk_sz = cls->stat.blk_sz;
+        }
+    }
+    stat->heap = util_mem_heap_cnt;
+}
+
+
 /**
 util_list_add - add an entry into the end of the list.
 @param[in]      mtx_ctx     Mutex context
@@ -336,7 +517,7 @@ int util_list_add(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint8_t dat_s
     util_lst_t   *ent;     //Pointer to list entry
     util_lst_t   *temp;
 
-    ent = (util_lst_t   *)malloc(sizeof(util_lst_t) + dat_sz - 1);
+    ent = (util_lst_t   *)util_mem_alloc(sizeof(util_lst_t) + dat_sz - 1);
 
     if (!ent)
         return ZWHCI_ERROR_MEMORY;
@@ -384,7 +565,7 @@ int util_list_add_no_dup(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint8_
     util_lst_t   *ent;     //Pointer to list entry
     util_lst_t   *temp;
 
-    ent = (util_lst_t   *)malloc(sizeof(util_lst_t) + dat_sz - 1);
+    ent = (util_lst_t   *)util_mem_alloc(sizeof(util_lst_t) + dat_sz - 1);
 
     if (!ent)
         return ZWHCI_ERROR_MEMORY;
@@ -411,7 +592,7 @@ int util_list_add_no_dup(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint8_
     //Check if last entry is identical with the new entry
     if (cmp_fn(temp->wr_buf, buf) == 0)
     {
-        free(ent);
+        util_mem_free(ent);
         ret = 1;
     }
     else
@@ -471,7 +652,7 @@ void util_list_flush(void *mtx_ctx, util_lst_t **head)
     {
         del_entry = first_entry;
         first_entry = first_entry->next;
-        free(del_entry);
+        util_mem_free(del_entry);
     }
 
     *head = NULL;
@@ -479,6 +660,303 @@ void util_list_flush(void *mtx_ctx, util_lst_t **head)
 }
 
 
+/**
+util_que_ent_add - append an entry allocated by the caller to the end of the queue.
+@param[in]      mtx_ctx     Mutex context
+@param[in,out]	que		    The queue
+@param[in]      ent         The entry to append. It will be owned by the queue.
+@return
+*/
+void util_que_ent_add(void *mtx_ctx, util_que_t *que, util_lst_t *ent)
+{
+    ent->next = NULL;
+
+    plt_mtx_lck(mtx_ctx);
+
+    if (que->tail)
+    {
+        que->tail->next = ent;
+    }
+    else
+    {
+        que->head = ent;
+    }
+    que->tail = ent;
+    que->cnt++;
+
+    plt_mtx_ulck(mtx_ctx);
+}
+
+
+/**
+util_que_add - add an entry into the end of the queue.
+@param[in]      mtx_ctx     Mutex context
+@param[in,out]	que		    The queue
+@param[in]      buf         Buffer that store the data
+@param[in]      dat_sz      Size of data to be stored
+@return                     Return 0 on success, negative error number on failure.
+*/
+int util_que_add(void *mtx_ctx, util_que_t *que, uint8_t  *buf, uint16_t dat_sz)
+{
+    util_lst_t   *ent;     //Pointer to list entry
+
+    ent = (util_lst_t   *)util_mem_alloc(sizeof(util_lst_t) + dat_sz - 1);
+
+    if (!ent)
+        return ZWHCI_ERROR_MEMORY;
+
+    ent->dat_sz = dat_sz;
+    memcpy(ent->wr_buf, buf, dat_sz);
+
+    util_que_ent_add(mtx_ctx, que, ent);
+
+    return ZWHCI_NO_ERROR;
+}
+
+
+/**
+util_que_get - get the entry from the beginning of the queue.
+@param[in]      mtx_ctx     Mutex context
+@param[in, out]	que		    The queue
+@return     The first entry in the queue if the queue is not empty; otherwise, NULL.
+@post       The caller should free the returned entry.
+*/
+util_lst_t *util_que_get(void *mtx_ctx, util_que_t *que)
+{
+    util_lst_t   *first_entry;  //The entry at the beginning of the queue
+
+    plt_mtx_lck(mtx_ctx);
+
+    first_entry = que->head;
+
+    if (first_entry)
+    {
+        que->head = first_entry->next;
+        if (!que->head)
+        {
+            que->tail = NULL;
+        }
+        que->cnt--;
+    }
+
+    plt_mtx_ulck(mtx_ctx);
+    return first_entry;
+}
+
+
+/**
+util_que_flush - flush the queue.
+@param[in]      mtx_ctx     Mutex context
+@param[in, out]	que		    The queue
+@return
+*/
+void util_que_flush(void *mtx_ctx, util_que_t *que)
+{
+    util_lst_t   *first_entry;  //The entry at the beginning of the queue
+    util_lst_t   *del_entry;    //Entry to be deleted
+
+    plt_mtx_lck(mtx_ctx);
+
+    first_entry = que->head;
+
+    while (first_entry)
+    {
+        del_entry = first_entry;
+        first_entry = first_entry->next;
+        util_mem_free(del_entry);
+    }
+
+    que->head = NULL;
+    que->tail = NULL;
+    que->cnt = 0;
+    plt_mtx_ulck(mtx_ctx);
+}
+
+
+/**
+util_buf_alloc - allocate a reference counted buffer.
+@param[in]      headroom    Number of bytes reserved in front of the data for headers
+@param[in]      size        Maximum number of data and trailer bytes
+@return     The buffer with reference count of one and no data; NULL on failure.
+@post       The caller should release the buffer with util_buf_release.
+*/
+util_buf_t *util_buf_alloc(uint16_t headroom, uint16_t size)
+{
+    util_buf_t  *buf;
+
+    buf = (util_buf_t *)util_mem_alloc(sizeof(util_buf_t) + headroom + size - 1);
+
+    if (!buf)
+        return NULL;
+
+    buf->next = NULL;
+    buf->ref_cnt = 1;
+    buf->queued = 0;
+    buf->buf_sz = headroom + size;
+    buf->head = headroom;
+    buf->len = 0;
+
+    return buf;
+}
+
+
+/**
+util_buf_push - prepend data in the headroom of a buffer.
+@param[in,out]  buf         The buffer
+@param[in]      len         Number of bytes to prepend
+@return     The new first data byte for the caller to fill in; NULL if the headroom is too small.
+*/
+uint8_t *util_buf_push(util_buf_t *buf, uint16_t len)
+{
+    if (buf->head < len)
+        return NULL;
+
+    buf->head -= len;
+    buf->len += len;
+
+    return buf->buf + buf->head;
+}
+
+
+/**
+util_buf_put - append data in the tailroom of a buffer.
+@param[in,out]  buf         The buffer
+@param[in]      len         Number of bytes to append
+@return     The first appended byte for the caller to fill in; NULL if the tailroom is too small.
+*/
+uint8_t *util_buf_put(util_buf_t *buf, uint16_t len)
+{
+    uint8_t *tail;
+
+    if ((uint32_t)buf->head + buf->len + len > buf->buf_sz)
+        return NULL;
+
+    tail = buf->buf + buf->head + buf->len;
+    buf->len += len;
+
+    return tail;
+}
+
+
+/**
+util_buf_hold - add a reference to a buffer.
+@param[in]      buf         The buffer
+@return
+*/
+void util_buf_hold(util_buf_t *buf)
+{
+#ifdef WIN32
+    InterlockedIncrement((volatile LONG *)&buf->ref_cnt);
+#else
+    __sync_add_and_fetch(&buf->ref_cnt, 1);
+#endif
+}
+
+
+/**
+util_buf_release - remove a reference from a buffer and free the buffer if it is the last reference.
+@param[in]      buf         The buffer
+@return
+*/
+void util_buf_release(util_buf_t *buf)
+{
+    int32_t     ref_cnt;
+
+#ifdef WIN32
+    ref_cnt = InterlockedDecrement((volatile LONG *)&buf->ref_cnt);
+#else
+    ref_cnt = __sync_sub_and_fetch(&buf->ref_cnt, 1);
+#endif
+
+    if (ref_cnt == 0)
+    {
+        util_mem_free(buf);
+    }
+}
+
+
+/**
+util_buf_que_add - add a reference of a buffer into the end of the queue.
+@param[in]      mtx_ctx     Mutex context
+@param[in,out]	que		    The queue
+@param[in]      buf         The buffer
+@return
+@note       If the buffer is already in the queue, it is not added again.
+*/
+void util_buf_que_add(void *mtx_ctx, util_buf_que_t *que, util_buf_t *buf)
+{
+    plt_mtx_lck(mtx_ctx);
+
+    if (!buf->queued)
+    {
+        util_buf_hold(buf);
+        buf->queued = 1;
+        buf->next = NULL;
+
+        if (que->tail)
+        {
+            que->tail->next = buf;
+        }
+        else
+        {
+            que->head = buf;
+        }
+        que->tail = buf;
+        que->cnt++;
+    }
+
+    plt_mtx_ulck(mtx_ctx);
+}
+
+
+/**
+util_buf_que_get - get the buffer from the beginning of the queue.
+@param[in]      mtx_ctx     Mutex context
+@param[in, out]	que		    The queue
+@return     The first buffer in the queue if the queue is not empty; otherwise, NULL.
+@post       The caller should release the returned buffer with util_buf_release.
+*/
+util_buf_t *util_buf_que_get(void *mtx_ctx, util_buf_que_t *que)
+{
+    util_buf_t  *first_buf;
+
+    plt_mtx_lck(mtx_ctx);
+
+    first_buf = que->head;
+
+    if (first_buf)
+    {
+        que->head = first_buf->next;
+        if (!que->head)
+        {
+            que->tail = NULL;
+        }
+        que->cnt--;
+        first_buf->queued = 0;
+    }
+
+    plt_mtx_ulck(mtx_ctx);
+    return first_buf;
+}
+
+
+/**
+util_buf_que_flush - flush the queue.
+@param[in]      mtx_ctx     Mutex context
+@param[in, out]	que		    The queue
+@return
+*/
+void util_buf_que_flush(void *mtx_ctx, util_buf_que_t *que)
+{
+    util_buf_t  *buf;
+
+    while ((buf = util_buf_que_get(mtx_ctx, que)) != NULL)
+    {
+        util_buf_release(buf);
+    }
+}
+
+
 /**
 util_list_find - find an entry from the list without modifying the list.
 @param[in]      mtx_ctx     Mutex context
@@ -538,7 +1016,7 @@ int util_list_rm(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, util_list_cmp_
     if (cmp_fn(cur_ent->wr_buf, buf) == 0)
     {   //List head to be removed
         *head = cur_ent->next;
-        free(cur_ent);
+        util_mem_free(cur_ent);
         plt_mtx_ulck(mtx_ctx);
         return 1;
     }
@@ -551,7 +1029,7 @@ int util_list_rm(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, util_list_cmp_
         if (cmp_fn(cur_ent->wr_buf, buf) == 0)
         {
             prev_ent->next = cur_ent->next;
-            free(cur_ent);
+            util_mem_free(cur_ent);
             plt_mtx_ulck(mtx_ctx);
             return 1;
         }
@@ -582,7 +1060,7 @@ int util_list_rplc(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint16_t dat
 
     if (*head == NULL)
     {
-        cur_ent = (util_lst_t *)malloc(sizeof(util_lst_t) + dat_sz - 1);
+        cur_ent = (util_lst_t *)util_mem_alloc(sizeof(util_lst_t) + dat_sz - 1);
 
         if (!cur_ent)
         {
@@ -615,7 +1093,7 @@ int util_list_rplc(void *mtx_ctx, util_lst_t **head, uint8_t  *buf, uint16_t dat
     }
 
     //Add new entry at the end of list
-    cur_ent = (util_lst_t *)malloc(sizeof(util_lst_t) + dat_sz - 1);
+    cur_ent = (util_lst_t *)util_mem_alloc(sizeof(util_lst_t) + dat_sz - 1);
 
     if (!cur_ent)
     {
@@ -92,14 +92,19 @@ static const cmd_get_resp_t cmd_get_resp_tbl[] =
 zwobj_add - Add object to list
 @param[in,out]	head	list head
 @param[in]		obj		object
+@pre        The object must be fully initialized, lock-free readers may find it as soon as it is linked.
 */
 void zwobj_add(zwobj_p *head, zwobj_p obj)
 {
     zwobj_p temp;
 
+    obj->next = NULL;
+
+    //Publish the object after its content
+    zwobj_mb();
+
     if (*head == NULL)
     {
-        obj->next = NULL;
         *head = obj;
         return;
     }
@@ -111,24 +116,42 @@ void zwobj_add(zwobj_p *head, zwobj_p obj)
     }
 
     temp->next = obj;
-    obj->next = NULL;
 
 }
 
+
+/**
+zwobj_retire - Free an object which has been removed from its list once no lock-free reader can see it
+@param[in]	nw	    The network
+@param[in]	obj     object
+@pre        Caller must lock the nw->mtx before calling this function.
+*/
+static void zwobj_retire(zwnet_p nw, zwobj_p obj)
+{
+    obj->free_next = nw->rd_pend;
+    nw->rd_pend = obj;
+    zwnet_obj_reclaim(nw, 0);
+}
+
+
 /**
-zwobj_del - Remove object from list
+zwobj_del - Remove object from list and free it
+@param[in]	    nw	    The network
 @param[in,out]	head	list head
 @param[in]      obj     object
 @return		Non-zero on success; otherwise zero if object not found in the list.
+@pre        Caller must lock the nw->mtx before calling this function.
+@post       The object is freed after the lock-free readers which may see it are done. Its
+            next link is left intact for them.
 */
-int32_t zwobj_del(zwobj_p *head, zwobj_p obj)
+int32_t zwobj_del(zwnet_p nw, zwobj_p *head, zwobj_p obj)
 {
     zwobj_p temp;
 
     if (*head == obj)
     {
         *head = (*head)->next;
-        free(obj);
+        zwobj_retire(nw, obj);
         return 1;
     }
 
@@ -138,7 +161,7 @@ int32_t zwobj_del(zwobj_p *head, zwobj_p obj)
         if (temp->next == obj)
         {
             temp->next = temp->next->next;
-            free(obj);
+            zwobj_retire(nw, obj);
             return 1;
         }
         temp = temp->next;
@@ -149,23 +172,28 @@ int32_t zwobj_del(zwobj_p *head, zwobj_p obj)
 
 /**
 zwobj_rplc - Replace an object with a new one
+@param[in]	    nw	    The network
 @param[in,out]	head	list head
 @param[in]      obj     object to be replaced
 @param[in]      new_obj new object
 @return		Non-zero on success; otherwise zero if object not found in the list.
+@pre        Caller must lock the nw->mtx before calling this function.
 @post   The obj will be invalid on success, don't use it hereafter.
 */
-int32_t zwobj_rplc(zwobj_p *head, zwobj_p obj, zwobj_p new_obj)
+int32_t zwobj_rplc(zwnet_p nw, zwobj_p *head, zwobj_p obj, zwobj_p new_obj)
 {
     zwobj_p temp;
 
+    new_obj->ctx = obj->ctx;
+    new_obj->next = obj->next;
+
+    //Publish the new object after its content
+    zwobj_mb();
+
     if (*head == obj)
     {
-        new_obj->ctx = obj->ctx;
-        new_obj->next = obj->next;
-
         *head = new_obj;
-        free(obj);
+        zwobj_retire(nw, obj);
         return 1;
     }
 
@@ -174,11 +202,8 @@ int32_t zwobj_rplc(zwobj_p *head, zwobj_p obj, zwobj_p new_obj)
     {
         if (temp->next == obj)
         {
-            new_obj->ctx = obj->ctx;
-            new_obj->next = obj->next;
-
             temp->next = new_obj;
-            free(obj);
+            zwobj_retire(nw, obj);
             return 1;
         }
         temp = temp->next;
@@ -186,6 +211,111 @@ int32_t zwobj_rplc(zwobj_p *head, zwobj_p obj, zwobj_p new_obj)
     return 0;
 }
 
+
+/**
+zwobj_free_lst - Free a list of removed objects
+@param[in]	obj     first object, linked by free_next
+*/
+static void zwobj_free_lst(zwobj_p obj)
+{
+    zwobj_p temp;
+
+    while (obj)
+    {
+        temp = obj;
+        obj = obj->free_next;
+        free(temp);
+    }
+}
+
+
+/**
+zwnet_rd_lck - Enter a lock-free read section of the node, endpoint and interface lists
+@param[in]	nw	    The network
+@return		Read section index, to be passed to zwnet_rd_ulck
+@post       Nodes, endpoints and interfaces found in the read section stay allocated until
+            zwnet_rd_ulck. Only their ids, links and fields which can be read in one access
+            are consistent; anything else still needs nw->mtx.
+            Read sections may nest and may be entered with or without nw->mtx held.
+*/
+int zwnet_rd_lck(zwnet_p nw)
+{
+    uint32_t    epoch;
+    int         idx;
+
+    while (1)
+    {
+        epoch = nw->rd_epoch;
+        idx = epoch & 1;
+#ifdef WIN32
+        InterlockedIncrement((volatile LONG *)&nw->rd_cnt[idx]);
+#else
+        __sync_add_and_fetch(&nw->rd_cnt[idx], 1);
+#endif
+        //Check the writer has not started a new grace period in between,
+        //else it might have missed this reader
+        if (nw->rd_epoch == epoch)
+        {
+            return idx;
+        }
+        zwnet_rd_ulck(nw, idx);
+    }
+}
+
+
+/**
+zwnet_rd_ulck - Leave a lock-free read section
+@param[in]	nw	    The network
+@param[in]	idx	    Read section index returned by zwnet_rd_lck
+@return
+*/
+void zwnet_rd_ulck(zwnet_p nw, int idx)
+{
+#ifdef WIN32
+    InterlockedDecrement((volatile LONG *)&nw->rd_cnt[idx]);
+#else
+    __sync_sub_and_fetch(&nw->rd_cnt[idx], 1);
+#endif
+}
+
+
+/**
+zwnet_obj_reclaim - Free the removed objects which no lock-free reader can see any more
+@param[in]	nw	    The network
+@param[in]	force   Free all the removed objects. Only when no reader can be running.
+@return
+@pre        Caller must lock the nw->mtx before calling this function.
+*/
+void zwnet_obj_reclaim(zwnet_p nw, int force)
+{
+    int     i;
+
+    for (i=0; i<2; i++)
+    {
+        if (nw->rd_wait)
+        {   //Readers which started before the current grace period may still see these objects
+            zwobj_mb();
+            if (!force && nw->rd_cnt[(nw->rd_epoch - 1) & 1])
+            {
+                return;
+            }
+            zwobj_free_lst(nw->rd_wait);
+            nw->rd_wait = NULL;
+        }
+
+        if (!nw->rd_pend)
+        {
+            return;
+        }
+
+        //Start a new grace period. Readers entering it cannot find the pending objects.
+        nw->rd_wait = nw->rd_pend;
+        nw->rd_pend = NULL;
+        zwobj_mb();
+        nw->rd_epoch++;
+    }
+}
+
 /**
 @}
 @addtogroup Node Node APIs
@@ -235,11 +365,23 @@ zwnode_find - find a node based on node id
 @param[in]	first_node	first node in the network
 @param[in]	nodeid	    node id
 @return		node if found; else return NULL
-@pre        Caller must lock the nw->mtx before calling this function.
+@pre        Caller must lock the nw->mtx or be in a zwnet_rd_lck read section before calling this function.
 */
 zwnode_p zwnode_find(zwnode_p first_node, uint8_t nodeid)
 {
     zwnode_p    temp_node;
+    zwnet_p     nw;
+
+    nw = (first_node)? first_node->net : NULL;
+
+    if (nw && (first_node == &nw->ctl) && nodeid && (nodeid <= ZW_MAX_NODES))
+    {   //Search the whole network, use the index
+        if (nw->ctl.nodeid == nodeid)
+        {
+            return &nw->ctl;
+        }
+        return nw->node_tbl[nodeid];
+    }
 
     temp_node = first_node;
     while (temp_node)
@@ -255,6 +397,60 @@ zwnode_p zwnode_find(zwnode_p first_node, uint8_t nodeid)
 }
 
 
+/**
+zwnode_lst_add - Append a node to the network node list and index it by node id
+@param[in]	nw	    The network
+@param[in]	node	The node
+@pre        Caller must lock the nw->mtx before calling this function.
+*/
+void zwnode_lst_add(zwnet_p nw, zwnode_p node)
+{
+    zwobj_add(&nw->ctl.obj.next, &node->obj);
+
+    //Keep the first node of duplicate node id in the index, as zwnode_find would find it first
+    if (node->nodeid && (node->nodeid <= ZW_MAX_NODES) && !nw->node_tbl[node->nodeid])
+    {
+        nw->node_tbl[node->nodeid] = node;
+    }
+}
+
+
+/**
+zwnode_lst_del - Remove a node from the network node list and the node id index, and free it
+@param[in]	nw	    The network
+@param[in]	node	The node
+@pre        Caller must lock the nw->mtx before calling this function.
+@post       The node is freed after the lock-free readers which may see it are done.
+*/
+void zwnode_lst_del(zwnet_p nw, zwnode_p node)
+{
+    uint8_t     nodeid;
+    zwnode_p    temp_node;
+
+    nodeid = node->nodeid;
+
+    if (!zwobj_del(nw, &nw->ctl.obj.next, &node->obj))
+    {
+        return;
+    }
+
+    if (nodeid && (nodeid <= ZW_MAX_NODES) && (nw->node_tbl[nodeid] == node))
+    {   //Re-index the next node with the same id, if any
+        nw->node_tbl[nodeid] = NULL;
+        temp_node = (zwnode_p)nw->ctl.obj.next;
+        while (temp_node)
+        {
+            if (temp_node->nodeid == nodeid)
+            {
+                nw->node_tbl[nodeid] = temp_node;
+                break;
+            }
+            temp_node = (zwnode_p)temp_node->obj.next;
+        }
+    }
+}
+
+
 /**
 zwnode_probe - send a "no operation" command to a node to test if it's reachable
 @param[in]	node        node
@@ -476,7 +672,7 @@ void zwnode_rm(zwnet_p nw, uint8_t node_id)
             zwnode_ctl_clr(nw);
         }
         else
-            zwobj_del(&nw->ctl.obj.next, &node->obj);
+            zwnode_lst_del(nw, node);
     }
     plt_mtx_ulck(nw->mtx);
 }
@@ -495,7 +691,7 @@ void zwnode_ep_rm_all(zwnode_p node)
     while ((ep = (zwep_p)node->ep.obj.next) != NULL)
     {
         zwep_intf_rm_all(ep);
-        zwobj_del(&node->ep.obj.next, &ep->obj);
+        zwobj_del(node->net, &node->ep.obj.next, &ep->obj);
     }
     //Remove the first ep
     zwep_intf_rm_all(&node->ep);
@@ -615,7 +811,7 @@ void zwif_cmd_q_xtra_rm(zwnet_p nw, util_lst_t **xtra_lst_hd)
     {
         xtra = (cmd_q_xtra_t *)xtra_lst_ent->wr_buf;
         free(xtra->extra);
-        free(xtra_lst_ent);
+        util_mem_free(xtra_lst_ent);
     }
 }
 
@@ -641,7 +837,7 @@ void zwif_cmd_q_cb(appl_layer_ctx_t  *appl_ctx, uint8_t tx_sts, void *user_prm)
             xtra = (cmd_q_xtra_t *)xtra_lst_ent->wr_buf;
             zwif_cmd_q_extra_handle(nw, xtra->extra, xtra->cmd_id, xtra->node_id);
             free(xtra->extra);
-            free(xtra_lst_ent);
+            util_mem_free(xtra_lst_ent);
         }
 
     }
@@ -879,7 +1075,7 @@ void zwnode_mul_cmd_rm_q(zwnet_p net, util_lst_t  **cmd_q_hd)
         {
             free(cmd_ent->extra);
         }
-        free(cmd_lst_ent);
+        util_mem_free(cmd_lst_ent);
     }
 }
 
@@ -1008,7 +1204,7 @@ static int zwnode_mul_cmd_send(zwnoded_p noded, util_lst_t  **cmd_q_hd, uint8_t
                 if (cmd->extra)
                     zwif_cmd_q_xtra_rm(net, &cmd->extra);
             }
-            free(cmd_lst_ent);
+            util_mem_free(cmd_lst_ent);
         }
         else
         {   //Multiple commands in the queue, start encapsulate all the commands into multi command encapsulation
@@ -1062,7 +1258,7 @@ static int zwnode_mul_cmd_send(zwnoded_p noded, util_lst_t  **cmd_q_hd, uint8_t
                             {
                                 free(xtra->extra);
                             }
-                            free(xtra_lst_ent);
+                            util_mem_free(xtra_lst_ent);
                         }
                     }
                 }
@@ -1086,7 +1282,7 @@ static int zwnode_mul_cmd_send(zwnoded_p noded, util_lst_t  **cmd_q_hd, uint8_t
                     continue;
                 }
 
-                free(cmd_lst_ent);
+                util_mem_free(cmd_lst_ent);
                 //Get next command
                 cmd_lst_ent = util_list_get(net->mtx, cmd_q_hd);
             }
@@ -1297,7 +1493,7 @@ zwep_find - find an endpoint based on endpoint id
 @param[in]	first_ep	first endpoint in the node
 @param[in]	epid	    endpoint id
 @return		endpoint if found; else return NULL
-@pre        Caller must lock the nw->mtx before calling this function.
+@pre        Caller must lock the nw->mtx or be in a zwnet_rd_lck read section before calling this function.
 */
 zwep_p zwep_find(zwep_p first_ep, uint8_t epid)
 {
@@ -1326,18 +1522,19 @@ zwep_get_node - get associated device
 int zwep_get_node(zwepd_p epd, zwnoded_p noded)
 {
     zwnode_p node;
+    int      rd_idx;
 
-    plt_mtx_lck(epd->net->mtx);
+    rd_idx = zwnet_rd_lck(epd->net);
 
     node = zwnode_find(&epd->net->ctl, epd->nodeid);
 
     if (node)
     {   //Found node
         zwnode_get_desc(node, noded);
-        plt_mtx_ulck(epd->net->mtx);
+        zwnet_rd_ulck(epd->net, rd_idx);
         return ZW_ERR_NONE;
     }
-    plt_mtx_ulck(epd->net->mtx);
+    zwnet_rd_ulck(epd->net, rd_idx);
     return  ZW_ERR_NODE_NOT_FOUND;
 }
 
@@ -1345,7 +1542,7 @@ int zwep_get_node(zwepd_p epd, zwnoded_p noded)
 zwep_get_ep - Get the endpoint of the specified endpoint descriptor
 @param[in]	epd	    Endpoint descriptor
 @return		The endpoint if found; else return NULL
-@pre        Caller must lock the nw->mtx before calling this function.
+@pre        Caller must lock the nw->mtx or be in a zwnet_rd_lck read section before calling this function.
 */
 zwep_p zwep_get_ep(zwepd_p epd)
 {
@@ -1504,7 +1701,7 @@ void zwep_intf_rm_all(zwep_p ep)
     while (ep->intf)
     {
         zwif_dat_rm(ep->intf);
-        zwobj_del((zwobj_p *)(&ep->intf), &ep->intf->obj);
+        zwobj_del(ep->node->net, (zwobj_p *)(&ep->intf), &ep->intf->obj);
     }
 }
 
@@ -2164,7 +2361,7 @@ zwif_find_cls - find an interface based on its command class
 @param[in]	first_intf	first interface in an endpoint
 @param[in]	cls	        the command class to search
 @return		interface if found; else return NULL
-@pre        Caller must lock the nw->mtx before calling this function.
+@pre        Caller must lock the nw->mtx or be in a zwnet_rd_lck read section before calling this function.
 */
 zwif_p zwif_find_cls(zwif_p first_intf, uint16_t cls)
 {
@@ -2225,7 +2422,7 @@ uint8_t zwif_count(zwif_p first_intf)
 zwif_get_if - Get the interface of the specified interface descriptor
 @param[in]	ifd	    Interface descriptor
 @return		The interface if found; else return NULL
-@pre        Caller must lock the nw->mtx before calling this function.
+@pre        Caller must lock the nw->mtx or be in a zwnet_rd_lck read section before calling this function.
 */
 zwif_p zwif_get_if(zwifd_p ifd)
 {
@@ -2299,8 +2496,9 @@ int zwif_ifd_get(zwifd_p ifd, uint16_t cmd_cls, zwifd_p cmd_cls_ifd)
     zwnet_p     nw = ifd->net;
     zwif_p      intf;
     int         result;
+    int         rd_idx;
 
-    plt_mtx_lck(nw->mtx);
+    rd_idx = zwnet_rd_lck(nw);
     intf = zwif_get_if(ifd);
 
     if (intf)
@@ -2322,7 +2520,7 @@ int zwif_ifd_get(zwifd_p ifd, uint16_t cmd_cls, zwifd_p cmd_cls_ifd)
         result = ZW_ERR_INTF_NOT_FOUND;
     }
 
-    plt_mtx_ulck(nw->mtx);
+    zwnet_rd_ulck(nw, rd_idx);
     return result;
 }
 
@@ -2408,14 +2606,15 @@ void *zwif_get_user(zwifd_p ifd)
 {
     zwif_p  intf;
     void *ret_val;
+    int     rd_idx;
 
-    plt_mtx_lck(ifd->net->mtx);
+    rd_idx = zwnet_rd_lck(ifd->net);
 
     intf = zwif_get_if(ifd);
 
     ret_val = (intf)? intf->obj.ctx : NULL;
 
-    plt_mtx_ulck(ifd->net->mtx);
+    zwnet_rd_ulck(ifd->net, rd_idx);
 
     return ret_val;
 }
@@ -2596,7 +2795,7 @@ void zwnode_wait_rpt_chk(zwif_p intf, uint8_t *cmd_buf, uint8_t cmd_len)
             node->wait_rpt_flg = 0;
 
             //Submit request to wait thread for execution of queued commands
-            util_list_add(nw->mtx, &nw->wait_q_req_hd,
+            util_que_add(nw->mtx, &nw->wait_q_req_hd,
                           &node->nodeid, sizeof(uint8_t));
 
             //Send the command in command queue
@@ -2631,7 +2830,7 @@ static void    zwnode_wait_rpt_tmout_cb(void *data)
     node->wait_rpt_flg = 0;
 
     //Submit request to wait thread for execution of queued commands
-    util_list_add(nw->mtx, &nw->wait_q_req_hd,
+    util_que_add(nw->mtx, &nw->wait_q_req_hd,
                   &node->nodeid, sizeof(uint8_t));
     plt_mtx_ulck(nw->mtx);
     plt_sem_post(nw->wait_q_sem);
@@ -2714,7 +2913,7 @@ void zwnode_wait_q_thrd(void   *data)
             return;
         }
 
-        while ((req_lst = util_list_get(nw->mtx, &nw->wait_q_req_hd)) != NULL)
+        while ((req_lst = util_que_get(nw->mtx, &nw->wait_q_req_hd)) != NULL)
         {
             //Get the node id of the request
             node_id = req_lst->wr_buf[0];
@@ -2799,13 +2998,13 @@ void zwnode_wait_q_thrd(void   *data)
                     {
                         zwif_cmd_q_xtra_rm(nw, &cmd->extra);
                     }
-                    free(cmd_lst_ent);
+                    util_mem_free(cmd_lst_ent);
 
                     //Continue sending the next command for this node
                     continue;
                 }
 
-                free(cmd_lst_ent);//From this point onwards, the cmd variable is invalid
+                util_mem_free(cmd_lst_ent);//From this point onwards, the cmd variable is invalid
 
                 if (wait_rpt)
                 {
@@ -2814,7 +3013,7 @@ void zwnode_wait_q_thrd(void   *data)
                 }
             }
 
-            free(req_lst);
+            util_mem_free(req_lst);
         }
     }
 }
@@ -2854,7 +3053,7 @@ void zwnode_cmd_q_thrd(void   *data)
             return;
         }
 
-        req_lst = util_list_get(nw->cmd_q_mtx, &nw->cmd_q_req_hd);
+        req_lst = util_que_get(nw->cmd_q_mtx, &nw->cmd_q_req_hd);
 
         if (req_lst)
         {
@@ -2872,7 +3071,7 @@ void zwnode_cmd_q_thrd(void   *data)
             {   //Node no longer exists, remove its command queue
                 plt_mtx_ulck(nw->mtx);
                 zwnode_mul_cmd_rm_q(nw, &cmd_q_req->req_hd);
-                free(req_lst);
+                util_mem_free(req_lst);
                 continue;
             }
 
@@ -2880,7 +3079,7 @@ void zwnode_cmd_q_thrd(void   *data)
             {
                 plt_mtx_ulck(nw->mtx);
                 zwnode_mul_cmd_rm_q(nw, &cmd_q_req->req_hd);
-                free(req_lst);
+                util_mem_free(req_lst);
                 continue;
             }
 
@@ -2917,7 +3116,7 @@ void zwnode_cmd_q_thrd(void   *data)
                 max_sz = (node->crc_cap)? (MAX_ZWAVE_PKT_SIZE - CRC16_OVERHEAD) : MAX_ZWAVE_PKT_SIZE;
                 plt_mtx_ulck(nw->mtx);
                 zwnode_mul_cmd_send(&noded, &cmd_q_req->req_hd, max_sz);
-                free(req_lst);
+                util_mem_free(req_lst);
                 continue;
             }
 
@@ -2943,14 +3142,14 @@ void zwnode_cmd_q_thrd(void   *data)
                                           ZWIF_OPT_SKIP_ALL_IMD, NULL);
 
                 }
-                free(cmd_lst_ent);
+                util_mem_free(cmd_lst_ent);
 
                 if (result < 0)
                 {
                     debug_zwapi_msg(&nw->plt_ctx, "zwnode_cmd_q_thrd: send data with error:%d", result);
                 }
             }
-            free(req_lst);
+            util_mem_free(req_lst);
         }
     }
 }
@@ -2983,7 +3182,7 @@ static int zwif_cmd_dequeue(zwif_p intf)
         cmd_q_req.node_id = node->nodeid;
         cmd_q_req.req_hd = node->mul_cmd_q_hd;
         //Submit request to thread for execution of queued commands
-        result = util_list_add(node->net->cmd_q_mtx, &node->net->cmd_q_req_hd,
+        result = util_que_add(node->net->cmd_q_mtx, &node->net->cmd_q_req_hd,
                                (uint8_t *)&cmd_q_req, sizeof(cmd_q_req_t));
         if (result != 0)
         {   //Error, try to send on next wake up notification
@@ -3023,7 +3222,7 @@ static void zwif_fw_restrt_tout_cb(void *data)
     req.action = EXEC_ACT_PROBE_RESTART_NODE;
     plt_mtx_ulck(nw->mtx);
 
-    util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+    util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                   (uint8_t *)&req, sizeof(zwnet_exec_req_t));
     plt_sem_post(nw->nw_exec_sem);
 
@@ -5420,7 +5619,7 @@ void zwif_rep_hdlr(zwif_p intf, uint8_t *cmd_buf, uint8_t cmd_len, uint8_t rx_st
                     rm_failed_req.node_id = intf->ep->node->nodeid;
                     rm_failed_req.action = EXEC_ACT_PROBE_FAILED_NODE;
 
-                    util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                    util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                   (uint8_t *)&rm_failed_req, sizeof(zwnet_exec_req_t));
                     plt_sem_post(nw->nw_exec_sem);
                 }
@@ -5984,7 +6183,7 @@ int zwif_exec_ex(zwifd_p ifd, uint8_t *cmd_buf, int buf_len,
             }
 
             //Submit request to wait thread for execution of queued commands
-            result = util_list_add(nw->mtx, &nw->wait_q_req_hd,
+            result = util_que_add(nw->mtx, &nw->wait_q_req_hd,
                                    &node->nodeid, sizeof(uint8_t));
             if (result == 0)
             {
@@ -6372,6 +6571,211 @@ int zwif_exec(zwifd_p ifdesc, uint8_t *cmd_buf, int buf_len, tx_cmplt_cb_t cb)
 }
 
 
+/**
+zwif_mcast_put - Release a reference to a multicast execution and report its completion on the last one
+@param[in]	mc		    Multicast execution
+@return
+*/
+static void zwif_mcast_put(zwif_mcast_t *mc)
+{
+    int last;
+
+    plt_mtx_lck(mc->net->mtx);
+    last = (--mc->pending == 0);
+    plt_mtx_ulck(mc->net->mtx);
+
+    if (last)
+    {
+        if (mc->cb)
+        {
+            mc->cb(mc->user, mc->sts, mc->sts_cnt);
+        }
+        free(mc);
+    }
+}
+
+
+/**
+zwif_mcast_tx_cb - Transmit status callback of a multicast follow-up
+@param[in]	appl_ctx    The application layer context
+@param[in]	tx_sts		The transmit complete status
+@param[in]	user_prm    The user specific parameter
+@return
+*/
+static void zwif_mcast_tx_cb(appl_layer_ctx_t *appl_ctx, uint8_t tx_sts, void *user_prm)
+{
+    zwif_mcast_ref_t    *ref = (zwif_mcast_ref_t *)user_prm;
+    zwif_mcast_t        *mc = ref->mc;
+
+    mc->sts[ref->idx].tx_sts = tx_sts;
+    zwif_mcast_put(mc);
+}
+
+
+/**
+zwif_exec_mcast - execute the same action on several interfaces using one multicast frame and singlecast follow-ups
+@param[in]	ifd         array of interfaces
+@param[in]	ifd_cnt     number of interfaces in ifd
+@param[in]	cmd_buf		command and parameters
+@param[in]	buf_len		length of cmd in bytes
+@param[in]	cb		    callback function when the follow-ups have completed
+@param[in]	user	    user parameter of callback function
+@return	ZW_ERR_XXX
+*/
+int zwif_exec_mcast(zwifd_p ifd, int ifd_cnt, uint8_t *cmd_buf, int buf_len, zwif_mcast_fn cb, void *user)
+{
+    int                     result;
+    int                     i;
+    int                     j;
+    zwnet_p                 nw;
+    zwnode_p                node;
+    zwif_mcast_t            *mc;
+    appl_snd_data_multi_t   prm;
+    uint8_t                 nodes[APPL_SND_MULTI_NODE_MAX];
+    uint8_t                 node_cnt = 0;
+
+    if ((ifd_cnt <= 0) || !cmd_buf || (buf_len <= 0))
+    {
+        return ZW_ERR_VALUE;
+    }
+
+    if (buf_len > MAX_ZWAVE_PKT_SIZE)
+    {
+        return ZW_ERR_TOO_LARGE;
+    }
+
+    nw = ifd[0].net;
+    for (i = 1; i < ifd_cnt; i++)
+    {
+        if (ifd[i].net != nw)
+        {
+            return ZW_ERR_VALUE;
+        }
+    }
+
+    mc = (zwif_mcast_t *)calloc(1, sizeof(zwif_mcast_t)
+                                + ifd_cnt * (sizeof(zwif_mcast_ref_t) + sizeof(zwif_mcast_sts_t)));
+    if (!mc)
+    {
+        return ZW_ERR_MEMORY;
+    }
+
+    mc->net = nw;
+    mc->cb = cb;
+    mc->user = user;
+    mc->pending = 1;
+    mc->sts_cnt = ifd_cnt;
+    mc->ref = (zwif_mcast_ref_t *)(mc + 1);
+    mc->sts = (zwif_mcast_sts_t *)(mc->ref + ifd_cnt);
+
+    //-------------------------------------------------
+    // Select the destinations of the multicast frame
+    //-------------------------------------------------
+    plt_mtx_lck(nw->mtx);
+    for (i = 0; i < ifd_cnt; i++)
+    {
+        mc->ref[i].mc = mc;
+        mc->ref[i].idx = i;
+        mc->sts[i].nodeid = ifd[i].nodeid;
+        mc->sts[i].epid = ifd[i].epid;
+        mc->sts[i].tx_sts = TRANSMIT_COMPLETE_FAIL;
+
+        //Multicast frames cannot be encapsulated per node
+        if (ifd[i].epid > 0)
+        {
+            continue;
+        }
+#ifdef  SUPPORT_SECURITY
+        if (nw->sec_enable && (ifd[i].propty & IF_PROPTY_SECURE))
+        {
+            continue;
+        }
+#endif
+        node = zwnode_find(&nw->ctl, ifd[i].nodeid);
+        if (!node || (node->nodeid == nw->ctl.nodeid))
+        {
+            continue;
+        }
+
+        //Sleeping nodes and nodes that require wakeup beam won't hear the multicast frame
+        if ((node->security & 0x60) || node->mul_cmd_ctl || node->enable_cmd_q)
+        {
+            continue;
+        }
+
+        for (j = 0; j < node_cnt; j++)
+        {
+            if (nodes[j] == node->nodeid)
+            {
+                break;
+            }
+        }
+
+        if (j == node_cnt)
+        {
+            if (node_cnt == APPL_SND_MULTI_NODE_MAX)
+            {
+                continue;
+            }
+            nodes[node_cnt++] = node->nodeid;
+        }
+        mc->sts[i].mcast = 1;
+    }
+    plt_mtx_ulck(nw->mtx);
+
+    //-------------------------------------------------
+    // Send the multicast frame
+    //-------------------------------------------------
+    result = -1;
+    if (node_cnt >= 2)
+    {
+        //No TRANSMIT_OPTION_ACK, the follow-ups below report the delivery to each node
+        prm.tx_opt = 0;
+        prm.dat_len = (uint8_t)buf_len;
+        prm.dat_buf = cmd_buf;
+        prm.nodes_num = node_cnt;
+        prm.nodes = nodes;
+
+        result = zw_send_data_multi(&nw->appl_ctx, &prm, NULL, NULL);
+        if (result < 0)
+        {
+            debug_zwapi_msg(&nw->plt_ctx, "zwif_exec_mcast: multicast with error:%d", result);
+        }
+    }
+
+    if (result < 0)
+    {   //The follow-ups deliver the command
+        for (i = 0; i < ifd_cnt; i++)
+        {
+            mc->sts[i].mcast = 0;
+        }
+    }
+
+    //-------------------------------------------------
+    // Send the singlecast follow-ups. They are queued in
+    // the controller behind the multicast frame when the
+    // send data window allows several transmissions
+    //-------------------------------------------------
+    for (i = 0; i < ifd_cnt; i++)
+    {
+        plt_mtx_lck(nw->mtx);
+        mc->pending++;
+        plt_mtx_ulck(nw->mtx);
+
+        result = zwif_exec_ex(&ifd[i], cmd_buf, buf_len, zwif_mcast_tx_cb, &mc->ref[i], 0, NULL);
+        mc->sts[i].result = result;
+        if (result != 0)
+        {   //No transmit status will be reported
+            zwif_mcast_put(mc);
+        }
+    }
+
+    zwif_mcast_put(mc);
+
+    return ZW_ERR_NONE;
+}
+
+
 /**
 zwif_get_report - get interface report through report callback
 @param[in]	ifd	        interface
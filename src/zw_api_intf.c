@@ -80,7 +80,7 @@ static int zwif_cached_cb(zwifd_p ifd, void *cb, uint16_t rpt_type, uint16_t ext
         cb_req.rpt_type = rpt_type;
         cb_req.extra = extra;
 
-        util_list_add(nw->cb_mtx, &nw->cb_req_hd,
+        util_que_add(nw->cb_mtx, &nw->cb_req_hd,
                       (uint8_t *)&cb_req, sizeof(zwnet_cb_req_t));
         plt_sem_post(nw->cb_sem);
 
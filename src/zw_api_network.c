@@ -132,37 +132,6 @@ void zwnet_cmd_cls_show(zwnet_p nw, uint16_t *cmd_cls_buf, uint8_t cnt)
 }
 
 
-/**
-zwnet_node_is_valid - Check whether a node is in the protocol routing table
-@param[in]	nw		    Network
-@param[in]	node_id	    Node id
-@param[out]	res	        Result: Non-zero means the node is in the table; otherwise, return zero
-@return		Zero means the res is valid; otherwise ZW_ERR_xxx
-*/
-static int zwnet_node_is_valid(zwnet_p nw, uint8_t node_id, uint8_t *res)
-{
-    int32_t result;
-    appl_init_dat_t init_dat;
-
-    //Get the initialization data stored in non-volatile memory
-    result = zw_serial_api_get_init_data(&nw->appl_ctx, &init_dat);
-
-    if (result == 0)
-    {
-        int32_t i;
-
-        i = node_id - 1;
-
-        *res = (((init_dat.nodes[i>>3]) >> (i & 7)) & 0x01) ? 1 : 0;
-        return ZW_ERR_NONE;
-
-    }
-    debug_zwapi_msg(&nw->plt_ctx, "zw_serial_api_get_init_data with error:%d", result);
-    return ZW_ERR_NO_RESP;
-
-}
-
-
 /**
 zwnet_cmd_cls_find - Find a command class in the given command class list.
 @param[in]	cc_lst	Command class list
@@ -278,9 +247,12 @@ static int zwnet_cmd_cls_add(uint16_t new_cc, const uint16_t *src_cc_lst, uint8_
 zwnet_node_info_update - Update a node in the network structure.
 @param[in]	nw		    Network
 @param[in]	node_info   Node information such as node id, basic, generic and specific device classes and supported command classes
+@param[in]	proto_info  Node protocol info of 6 bytes (capability, security, ...); NULL to get it from the controller
+@param[in]	proto_skip  Flag to keep the current capability and security of the node without getting the protocol
+                        info. proto_info is ignored if set
 @return		ZW_ERR_xxx.
 */
-static int zwnet_node_info_update(zwnet_p nw, appl_node_info_t *node_info)
+static int zwnet_node_info_update(zwnet_p nw, appl_node_info_t *node_info, uint8_t *proto_info, int proto_skip)
 {
     unsigned     i;
     int         node_has_changed;
@@ -403,7 +375,7 @@ static int zwnet_node_info_update(zwnet_p nw, appl_node_info_t *node_info)
     //Save node id
     node->nodeid = node_info->node_id;
 
-    zwobj_add(&nw->ctl.obj.next, &node->obj);
+    zwnode_lst_add(nw, node);
 
     //Assign default end point
     node->ep.epid = VIRTUAL_EP_ID;
@@ -415,11 +387,19 @@ static int zwnet_node_info_update(zwnet_p nw, appl_node_info_t *node_info)
     node->ep.intf = NULL;
 
     //Update node capabilitiy and security
-    result = zw_get_node_protocol_info(&nw->appl_ctx, node->nodeid, ni);
-    if (result == 0)
+    if (proto_skip)
     {
-        node->capability = ni[0];
-        node->security = ni[1];
+        proto_info = NULL;
+    }
+    else if (!proto_info)
+    {
+        result = zw_get_node_protocol_info(&nw->appl_ctx, node->nodeid, ni);
+        proto_info = (result == 0)? ni : NULL;
+    }
+    if (proto_info)
+    {
+        node->capability = proto_info[0];
+        node->security = proto_info[1];
     }
 
     //Create unsecure interfaces based on command classes
@@ -440,14 +420,7 @@ static int zwnet_node_info_update(zwnet_p nw, appl_node_info_t *node_info)
         intf->ep = &node->ep;
 
         //Add interface to the end point
-        if (node->ep.intf)
-        {   //Second interface onwards
-            zwobj_add(&node->ep.intf->obj.next, &intf->obj);
-        }
-        else
-        {   //First interface
-            node->ep.intf = intf;
-        }
+        zwobj_add((zwobj_p *)(&node->ep.intf), &intf->obj);
     }
     plt_mtx_ulck(nw->mtx);
     if (new_cmd_cls != node_info->cmd_cls)
@@ -502,7 +475,7 @@ static int zwnet_ep_updt(zwep_p  ep, uint8_t cmd_cls, uint8_t inst, uint8_t prop
             new_ep->node = ep->node;
             new_ep->epid = tmp_ep->epid + 1;//increment the end point id from previous end point
             //Add to the end point list
-            tmp_ep->obj.next = &new_ep->obj;
+            zwobj_add(&tmp_ep->obj.next, &new_ep->obj);
             //
             //Create first interface of COMMAND_CLASS_BASIC
             //
@@ -516,7 +489,7 @@ static int zwnet_ep_updt(zwep_p  ep, uint8_t cmd_cls, uint8_t inst, uint8_t prop
             intf->ep = new_ep;
 
             //Add interface to the end point
-            new_ep->intf = intf;
+            zwobj_add((zwobj_p *)(&new_ep->intf), &intf->obj);
         }
         //Work on valid end point
         tmp_ep = (zwep_p)tmp_ep->obj.next;
@@ -534,14 +507,7 @@ static int zwnet_ep_updt(zwep_p  ep, uint8_t cmd_cls, uint8_t inst, uint8_t prop
             intf->ep = tmp_ep;
 
             //Add interface to the end point
-            if (tmp_ep->intf)
-            {   //Second interface onwards
-                zwobj_add(&tmp_ep->intf->obj.next, &intf->obj);
-            }
-            else
-            {   //First interface
-                tmp_ep->intf = intf;
-            }
+            zwobj_add((zwobj_p *)(&tmp_ep->intf), &intf->obj);
 
         }
     }
@@ -566,7 +532,7 @@ static void zwnet_ep_rm(zwep_p  ep)
     if (ep != first_ep)
     {
         //Free the end point object
-        zwobj_del(&first_ep->obj.next, &ep->obj);
+        zwobj_del(ep->node->net, &first_ep->obj.next, &ep->obj);
     }
 }
 
@@ -670,14 +636,7 @@ static int zwnet_ep_add(zwep_p  ep, ep_cap_t *ep_cap, uint8_t propty)
         intf->ep = new_ep;
 
         //Add interface to the end point
-        if (new_ep->intf)
-        {   //Second interface onwards
-            zwobj_add(&new_ep->intf->obj.next, &intf->obj);
-        }
-        else
-        {   //First interface
-            new_ep->intf = intf;
-        }
+        zwobj_add((zwobj_p *)(&new_ep->intf), &intf->obj);
     }
 
     if (new_cmd_cls != ep_cap->cmd_cls)
@@ -756,14 +715,7 @@ static int zwnet_ni_sec_updt(zwep_p ep, uint16_t *sec_cls, uint8_t cnt)
             intf->ep = ep;
 
             //Add interface to the end point
-            if (ep->intf)
-            {   //Second interface onwards
-                zwobj_add(&ep->intf->obj.next, &intf->obj);
-            }
-            else
-            {   //First interface
-                ep->intf = intf;
-            }
+            zwobj_add((zwobj_p *)(&ep->intf), &intf->obj);
         }
     }
 
@@ -3700,7 +3652,7 @@ static int zwnet_sm_ver_rpt_hdlr(zwnet_p nw, zwif_p *ver_intf, void *ver_rpt_cb,
                 zwif_dat_rm(intf);
 
                 //Replace the old interface in the end point
-                zwobj_rplc((zwobj_p *)(&ep->intf), &intf->obj, &new_intf->obj);
+                zwobj_rplc(nw, (zwobj_p *)(&ep->intf), &intf->obj, &new_intf->obj);
 
                 //Check whether the replaced interface is command class version
                 if (cmd_cls == COMMAND_CLASS_VERSION)
@@ -5129,6 +5081,166 @@ static int    zwnet_updt_sm(zwnet_p  nw, zwnet_nu_evt_t  evt, uint8_t *data)
 }
 
 
+/**
+zwnet_ni_updt_exec - Update the network structure with the node information from application update callback
+@param[in]	ni_updt	    Node information and the application update status
+@param[in]	proto_info  Node protocol info of 6 bytes; NULL if unavailable, the capability and security of the
+                        node are kept
+@return
+*/
+static void zwnet_ni_updt_exec(zwnet_ni_updt_t *ni_updt, uint8_t *proto_info)
+{
+    zwnet_p             nw = ni_updt->nw;
+    appl_node_info_t    *node_info = &ni_updt->node_info;
+    zwnode_p            node;
+
+    plt_mtx_lck(nw->mtx);
+    zwnet_node_info_update(nw, node_info, proto_info, (proto_info == NULL));
+
+    if (ni_updt->sts == UPDATE_STATE_NODE_INFO_RECEIVED)
+    {
+        zwnet_rp_ni_sm(nw, EVT_NODE_INFO, (uint8_t *)node_info);
+        zwnet_node_info_sm(nw, EVT_NODE_INFO, (uint8_t *)node_info);
+    }
+    plt_mtx_ulck(nw->mtx);
+
+    if (ni_updt->sts == UPDATE_STATE_NEW_ID_ASSIGNED)
+    {
+        //Call back to notify a node was added
+        node = zwnode_find(&nw->ctl, node_info->node_id);
+
+        if (node && nw->init.node)
+        {
+            zwnoded_t noded;
+            zwnode_get_desc(node, &noded);
+            nw->init.node(nw->init.user, &noded, ZWNET_NODE_ADDED);
+        }
+    }
+}
+
+
+/**
+zwnet_ni_proto_cb - Get node protocol info callback for application update
+@param[in]	appl_ctx    The application layer context
+@param[in]	result		0 on success, negative error number on failure
+@param[in]	node_id		Node id
+@param[in]	proto_info  Node protocol info of 6 bytes
+@param[in]	user_prm    The node information waiting for the update
+@return
+*/
+static void zwnet_ni_proto_cb(appl_layer_ctx_t *appl_ctx, int32_t result, uint8_t node_id, uint8_t *proto_info, void *user_prm)
+{
+    zwnet_ni_updt_t *ni_updt = (zwnet_ni_updt_t *)user_prm;
+
+    if (result != SESSION_ERROR_EXIT)
+    {
+        if (result != 0)
+        {   //Update without the capability and security info
+            debug_zwapi_msg(&ni_updt->nw->plt_ctx, "zw_get_node_protocol_info with error:%d", result);
+            proto_info = NULL;
+        }
+        zwnet_ni_updt_exec(ni_updt, proto_info);
+    }
+    free(ni_updt);
+}
+
+
+/**
+zwnet_ni_valid_cb - Get initialization data callback to check whether the updated node is in the
+                    protocol routing table
+@param[in]	appl_ctx    The application layer context
+@param[in]	result		0 on success, negative error number on failure
+@param[in]	init_data   The initialization data
+@param[in]	user_prm    The node information waiting for the update
+@return
+*/
+static void zwnet_ni_valid_cb(appl_layer_ctx_t *appl_ctx, int32_t result, appl_init_dat_t *init_data, void *user_prm)
+{
+    zwnet_ni_updt_t *ni_updt = (zwnet_ni_updt_t *)user_prm;
+    unsigned        i = ni_updt->node_info.node_id - 1;
+
+    if (result == 0)
+    {
+        if ((init_data->nodes[i>>3] >> (i & 7)) & 0x01)
+        {   //The node is in the protocol routing table
+            result = zw_get_node_protocol_info_async(appl_ctx, ni_updt->node_info.node_id,
+                                                     zwnet_ni_proto_cb, ni_updt);
+            if (result == 0)
+            {
+                return;
+            }
+            //Don't block the callback thread with the synchronous query, update without the protocol info
+            debug_zwapi_msg(&ni_updt->nw->plt_ctx, "zw_get_node_protocol_info with error:%d", result);
+            zwnet_ni_updt_exec(ni_updt, NULL);
+        }
+    }
+    else if (result != SESSION_ERROR_EXIT)
+    {
+        debug_zwapi_msg(&ni_updt->nw->plt_ctx, "zw_serial_api_get_init_data with error:%d", result);
+    }
+    free(ni_updt);
+}
+
+
+/**
+zwnet_ni_updt_start - Start the controller queries needed to update the network structure with the node information
+                      from application update callback. The update is done on completion of the queries without
+                      blocking the callback thread
+@param[in]	nw		    Network
+@param[in]	sts		    Application update status, UPDATE_STATE_NODE_INFO_RECEIVED or UPDATE_STATE_NEW_ID_ASSIGNED
+@param[in]	node_info   Node information
+@return
+*/
+static void zwnet_ni_updt_start(zwnet_p nw, uint8_t sts, appl_node_info_t *node_info)
+{
+    int32_t         result;
+    zwnet_ni_updt_t *ni_updt;
+
+    if ((node_info->node_id == 0) || (node_info->node_id > ZW_MAX_NODES))
+    {
+        return;
+    }
+
+    ni_updt = (zwnet_ni_updt_t *)malloc(sizeof(zwnet_ni_updt_t) + (node_info->cmd_cnt * sizeof(uint16_t)));
+    if (!ni_updt)
+    {
+        return;
+    }
+
+    ni_updt->nw = nw;
+    ni_updt->sts = sts;
+    ni_updt->node_info = *node_info;
+    ni_updt->node_info.cmd_cls = ni_updt->cmd_cls_buf;
+    if (node_info->cmd_cnt)
+    {
+        memcpy(ni_updt->cmd_cls_buf, node_info->cmd_cls, node_info->cmd_cnt * sizeof(uint16_t));
+    }
+
+    if (sts == UPDATE_STATE_NODE_INFO_RECEIVED)
+    {
+        result = zw_serial_api_get_init_data_async(&nw->appl_ctx, zwnet_ni_valid_cb, ni_updt);
+        if (result != 0)
+        {
+            debug_zwapi_msg(&nw->plt_ctx, "zw_serial_api_get_init_data with error:%d", result);
+        }
+    }
+    else
+    {
+        result = zw_get_node_protocol_info_async(&nw->appl_ctx, node_info->node_id, zwnet_ni_proto_cb, ni_updt);
+        if (result != 0)
+        {   //Don't block the callback thread with the synchronous query, update without the protocol info
+            debug_zwapi_msg(&nw->plt_ctx, "zw_get_node_protocol_info with error:%d", result);
+            zwnet_ni_updt_exec(ni_updt, NULL);
+        }
+    }
+
+    if (result != 0)
+    {
+        free(ni_updt);
+    }
+}
+
+
 /**
 application_update_cb - Application update callback function
 @param[in]	appl_ctx    The application layer context
@@ -5190,22 +5302,9 @@ static void    application_update_cb(struct _appl_layer_ctx   *appl_ctx,
 
         if (sts == UPDATE_STATE_NODE_INFO_RECEIVED)
         {   //This could be node added or deleted or even from other network!
-            uint8_t res;
-
-            //Check whether the node is in the protocol routing table
-            result = zwnet_node_is_valid(nw, node_info->node_id, &res);
-            if (result == 0 && res)
-            {
-                //The node is in the protocol routing table, update the
-                //network data structure
-                plt_mtx_lck(nw->mtx);
-                zwnet_node_info_update(nw, node_info);
-
-                zwnet_rp_ni_sm(nw, EVT_NODE_INFO, (uint8_t *)node_info);
-                zwnet_node_info_sm(nw, EVT_NODE_INFO, (uint8_t *)node_info);
-                plt_mtx_ulck(nw->mtx);
-
-            }
+            //Check whether the node is in the protocol routing table before updating
+            //the network data structure
+            zwnet_ni_updt_start(nw, sts, node_info);
         }
     }
     else
@@ -5246,7 +5345,7 @@ static void    application_update_cb(struct _appl_layer_ctx   *appl_ctx,
                         cfg_lifeln_req.node_id = node_info->node_id;
                         cfg_lifeln_req.action = EXEC_ACT_CFG_LIFELINE;
 
-                        util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                        util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                       (uint8_t *)&cfg_lifeln_req, sizeof(zwnet_exec_req_t));
                         plt_sem_post(nw->nw_exec_sem);
 
@@ -5269,17 +5368,7 @@ static void    application_update_cb(struct _appl_layer_ctx   *appl_ctx,
     //New node added with or without command classes info
     if (sts == UPDATE_STATE_NEW_ID_ASSIGNED)
     {   //New node added
-        zwnet_node_info_update(nw, node_info);
-
-        //Call back to notify a node was added
-        node = zwnode_find(&nw->ctl, node_info->node_id);
-
-        if (node && nw->init.node)
-        {
-            zwnoded_t noded;
-            zwnode_get_desc(node, &noded);
-            nw->init.node(nw->init.user, &noded, ZWNET_NODE_ADDED);
-        }
+        zwnet_ni_updt_start(nw, sts, node_info);
     }
 }
 
@@ -5563,6 +5652,67 @@ static void zwnet_power_lvl_testframe_cb(appl_layer_ctx_t *appl_ctx, uint8_t tx_
 }
 
 
+#ifdef MANF_SPEC_V2
+/**
+zwnet_ser_num_rd_cb - Read serial number from NVRAM callback to send the device specific report
+@param[in]	appl_ctx    The application layer context
+@param[in]	result		0 on success, negative error number on failure
+@param[in]	buf		    The serial number
+@param[in]	len		    Length of the serial number
+@param[in]	user_prm    The destination of the report
+@return
+*/
+static void zwnet_ser_num_rd_cb(appl_layer_ctx_t *appl_ctx, int32_t result, uint8_t *buf, uint8_t len, void *user_prm)
+{
+    zwnet_rpt_dst_t *rpt_dst = (zwnet_rpt_dst_t *)user_prm;
+    zwnet_p         nw = rpt_dst->nw;
+    uint8_t         c_buf[32 + 4];//max. device id data length + terminating char (0xFF) + Device specific report overhead
+    uint8_t         dev_id_len;
+    int             i;
+
+    if (result < 0)
+    {
+        if (result != SESSION_ERROR_EXIT)
+        {
+            debug_zwapi_msg(&nw->plt_ctx, "Get serial number from NVRAM with error:%d", result);
+        }
+        free(rpt_dst);
+        return;
+    }
+
+    debug_zwapi_msg(&nw->plt_ctx, "Serial number from NVRAM:");
+    debug_zwapi_bin_msg(&nw->plt_ctx, buf, len);
+
+    //Get device id length
+    dev_id_len = (len < 31)? len : 31;//maximum
+
+    for (i=0; i<len; i++)
+    {
+        if (buf[i] == 0xFF)
+        {
+            dev_id_len = i;
+            break;
+        }
+    }
+
+    //Prepare the report
+    c_buf[0] = COMMAND_CLASS_MANUFACTURER_SPECIFIC;
+    c_buf[1] = DEVICE_SPECIFIC_REPORT_V2;
+    c_buf[2] = 1;//serial number
+    c_buf[3] = 0x20 | dev_id_len;//binary format, data length
+    memcpy(c_buf + 4, buf, dev_id_len);
+
+    //Send the report
+    result = zwnet_rpt_send(nw, c_buf, dev_id_len + 4, rpt_dst->src_node, rpt_dst->msg_type);
+    if (result < 0)
+    {
+        debug_zwapi_msg(&nw->plt_ctx, "Send device specific rpt with error:%d", result);
+    }
+    free(rpt_dst);
+}
+#endif
+
+
 /* Received frame status flags */
 #define RECEIVE_STATUS_ROUTED_BUSY    0x01
 #define RECEIVE_STATUS_LOW_POWER      0x02    /* received at low output power level, this must */
@@ -5985,13 +6135,11 @@ static void appl_cmd_hdlr(uint8_t cmd_len, uint8_t *cmd_buf, appl_cmd_prm_t *prm
 #ifdef MANF_SPEC_V2
         else if ((cmd_buf[1] == DEVICE_SPECIFIC_GET_V2) && (cmd_len >= 3))
         {
+#if 0
             uint8_t c_buf[32 + 4];//max. device id data length + terminating char (0xFF) + Device specific report overhead
-            uint8_t ser_num_buf[32];
             //uint8_t dev_id_type;
             uint8_t dev_id_len;
-            int     i;
 
-#if 0
             //UTF-8 (for testing)
     #ifdef USE_SAFE_VERSION
             strcpy_s(c_buf + 4, 32,"sd123456789");
@@ -6011,48 +6159,34 @@ static void appl_cmd_hdlr(uint8_t cmd_len, uint8_t *cmd_buf, appl_cmd_prm_t *prm
             c_buf[2] = cmd_buf[2] & 0x07;//Device ID type
             c_buf[3] = dev_id_len;//utf-8 format, data length
 
-#else       //Binary
-
-            //Always return Device ID Type = serial number
-            //Get from the non-volatile memory
-            result = zw_memory_get_buffer(&nw->appl_ctx, ser_num_buf, SERIAL_NUMBER_OFFSET, 32);
+            //Send the report
+            result = zwnet_rpt_send(nw, c_buf, dev_id_len + 4, src_node, msg_type);
             if (result < 0)
             {
-                debug_zwapi_msg(&nw->plt_ctx, "Get serial number from NVRAM with error:%d", result);
-                return;
-            }
-            else
-            {
-                debug_zwapi_msg(&nw->plt_ctx, "Serial number from NVRAM:");
-                debug_zwapi_bin_msg(&nw->plt_ctx, ser_num_buf, 32);
+                debug_zwapi_msg(&nw->plt_ctx, "Send device specific rpt with error:%d", result);
             }
+#else       //Binary
+            zwnet_rpt_dst_t *rpt_dst;
 
-            //Get device id length
-            dev_id_len = 31;//maximum
-
-            for (i=0; i<32; i++)
+            //Always return Device ID Type = serial number
+            //Get from the non-volatile memory, the report is sent on completion
+            rpt_dst = (zwnet_rpt_dst_t *)malloc(sizeof(zwnet_rpt_dst_t));
+            if (!rpt_dst)
             {
-                if (ser_num_buf[i] == 0xFF)
-                {
-                    dev_id_len = i;
-                    break;
-                }
+                return;
             }
+            rpt_dst->nw = nw;
+            rpt_dst->src_node = src_node;
+            rpt_dst->msg_type = msg_type;
 
-            //Prepare the report
-            c_buf[0] = COMMAND_CLASS_MANUFACTURER_SPECIFIC;
-            c_buf[1] = DEVICE_SPECIFIC_REPORT_V2;
-            c_buf[2] = 1;//serial number
-            c_buf[3] = 0x20 | dev_id_len;//binary format, data length
-            memcpy(c_buf + 4, ser_num_buf, dev_id_len);
-
-#endif
-            //Send the report
-            result = zwnet_rpt_send(nw, c_buf, dev_id_len + 4, src_node, msg_type);
+            result = zw_memory_get_buffer_async(&nw->appl_ctx, SERIAL_NUMBER_OFFSET, 32,
+                                                zwnet_ser_num_rd_cb, rpt_dst);
             if (result < 0)
             {
-                debug_zwapi_msg(&nw->plt_ctx, "Send device specific rpt with error:%d", result);
+                debug_zwapi_msg(&nw->plt_ctx, "Get serial number from NVRAM with error:%d", result);
+                free(rpt_dst);
             }
+#endif
         }
 #endif
     }
@@ -6898,7 +7032,7 @@ int32_t zwnet_ctlr_info_get(zwnet_p nw, uint8_t is_create_nw)
                             node->ep.specific = node_info[5];
                             node->ep.intf = NULL;
 
-                            zwobj_add(&nw->ctl.obj.next, &node->obj);
+                            zwnode_lst_add(nw, node);
 
                         }
                         debug_zwapi_msg(&nw->plt_ctx, "Node id:%d, capability:%02X, security:%02X, basic:%02X, generic:%02X, specific:%02X,"
@@ -7168,7 +7302,7 @@ static void  zwnet_node_probe_cb(appl_layer_ctx_t *appl_ctx, uint8_t tx_sts, voi
         rm_failed_req.action = EXEC_ACT_RMV_FAILED;
         debug_zwapi_msg(appl_ctx->plt_ctx, "Send NOP with tx status:%u", (unsigned)tx_sts);
 
-        util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+        util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                       (uint8_t *)&rm_failed_req, sizeof(zwnet_exec_req_t));
         plt_sem_post(nw->nw_exec_sem);
     }
@@ -7223,7 +7357,7 @@ static void  zwnet_restart_node_probe_cb(appl_layer_ctx_t *appl_ctx, uint8_t tx_
 
         debug_zwapi_msg(appl_ctx->plt_ctx, "zwnet_restart_node_probe_cb: Send NOP with tx status:%u", (unsigned)tx_sts);
 
-        util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+        util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                       (uint8_t *)&req, sizeof(zwnet_exec_req_t));
         plt_sem_post(nw->nw_exec_sem);
     }
@@ -7262,14 +7396,14 @@ static void zwnet_exec_thrd(void *data)
             return;
         }
 
-        while ((req_lst = util_list_get(nw->nw_exec_mtx, &nw->nw_exec_req_hd)) != NULL)
+        while ((req_lst = util_que_get(nw->nw_exec_mtx, &nw->nw_exec_req_hd)) != NULL)
         {
             exec_req = (zwnet_exec_req_t *)req_lst->wr_buf;
 
             //Check whether to exit the thread
             if (nw->nw_exec_thrd_run == 0)
             {
-                free(req_lst);
+                util_mem_free(req_lst);
                 nw->nw_exec_thrd_sts = 0;
                 return;
             }
@@ -7298,7 +7432,7 @@ static void zwnet_exec_thrd(void *data)
                         if (nw->curr_op != ZWNET_OP_NONE)
                         {   //Busy, re-schedule the send NOP operation
                             plt_mtx_ulck(nw->mtx);
-                            util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                            util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                           (uint8_t *)exec_req, sizeof(zwnet_exec_req_t));
                             break;
                         }
@@ -7315,7 +7449,7 @@ static void zwnet_exec_thrd(void *data)
                                     free(noded);
                                     if (result == ZW_ERR_BUSY)
                                     {   //Send wait failed, re-schedule the send NOP operation
-                                        util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                                        util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                                       (uint8_t *)exec_req, sizeof(zwnet_exec_req_t));
                                     }
                                 }
@@ -7341,7 +7475,7 @@ static void zwnet_exec_thrd(void *data)
                         if (nw->curr_op != ZWNET_OP_NONE)
                         {   //Busy, re-schedule the removed failed node operation
                             plt_mtx_ulck(nw->mtx);
-                            util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                            util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                           (uint8_t *)exec_req, sizeof(zwnet_exec_req_t));
                             plt_sleep(3000);
 
@@ -7375,7 +7509,7 @@ static void zwnet_exec_thrd(void *data)
                         if (nw->curr_op != ZWNET_OP_NONE)
                         {   //Busy, re-schedule the send NOP operation
                             plt_mtx_ulck(nw->mtx);
-                            util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                            util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                           (uint8_t *)exec_req, sizeof(zwnet_exec_req_t));
                             break;
                         }
@@ -7389,7 +7523,7 @@ static void zwnet_exec_thrd(void *data)
                         else if (result == ZW_ERR_BUSY)
                         {   //Re-schedule the send NOP operation
                             plt_mtx_ulck(nw->mtx);
-                            util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                            util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                           (uint8_t *)exec_req, sizeof(zwnet_exec_req_t));
                             break;
                         }
@@ -7421,7 +7555,7 @@ static void zwnet_exec_thrd(void *data)
                         if (nw->curr_op != ZWNET_OP_NONE)
                         {   //Busy, re-schedule the operation
                             plt_mtx_ulck(nw->mtx);
-                            util_list_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
+                            util_que_add(nw->nw_exec_mtx, &nw->nw_exec_req_hd,
                                           (uint8_t *)exec_req, sizeof(zwnet_exec_req_t));
                             plt_sleep(3000);
 
@@ -7463,7 +7597,7 @@ static void zwnet_exec_thrd(void *data)
                     }
                     break;
             }
-            free(req_lst);
+            util_mem_free(req_lst);
         }
     }
 }
@@ -7494,7 +7628,7 @@ static void zwnet_cb_thrd(void *data)
             return;
         }
 
-        while ((req_lst = util_list_get(nw->cb_mtx, &nw->cb_req_hd)) != NULL)
+        while ((req_lst = util_que_get(nw->cb_mtx, &nw->cb_req_hd)) != NULL)
         {
             //Check whether to exit the thread
             if (nw->cb_thrd_run == 0)
@@ -7794,7 +7928,7 @@ static void zwnet_cb_thrd(void *data)
                 plt_mtx_ulck(nw->mtx);
             }
 
-            free(req_lst);
+            util_mem_free(req_lst);
         }
     }
 }
@@ -7908,7 +8042,8 @@ int zwnet_init(const zwnet_init_p init, zwnet_init_ret_p ret)
     }
 
     //Initialize platform
-    if (plt_init(&nw->plt_ctx, init->print_txt_fn) != 0)
+    nw->plt_ctx.evt_loop = init->evt_loop;
+    if (plt_init(&nw->plt_ctx, init->print_txt_fn, init->tmr_cb_thrd_cnt) != 0)
     {
         result = ZW_ERR_NO_RES;
         goto l_ZWNET_INIT_ERROR4;
@@ -7983,6 +8118,9 @@ int zwnet_init(const zwnet_init_p init, zwnet_init_ret_p ret)
     nw->appl_ctx.cb_tmout_ms = APPL_CB_TMOUT_MIN;
     nw->appl_ctx.data = nw;
     nw->appl_ctx.plt_ctx = &nw->plt_ctx;
+    nw->appl_ctx.cap_file = init->cap_file;
+    nw->appl_ctx.cb_wkr_cnt = init->cb_thrd_cnt;
+    nw->appl_ctx.snd_dat_win = init->snd_win;
 
     result = zwhci_init(&nw->appl_ctx, nw->init.comm_port_name);
 
@@ -8197,17 +8335,17 @@ void zwnet_exit(zwnet_p net, const char *node_info_file)
     }
 
     //Flush the lists
-    while ((req_lst = util_list_get(net->cmd_q_mtx, &net->cmd_q_req_hd)) != NULL)
+    while ((req_lst = util_que_get(net->cmd_q_mtx, &net->cmd_q_req_hd)) != NULL)
     {
         cmd_q_req = (cmd_q_req_t *)req_lst->wr_buf;
 
         zwnode_mul_cmd_rm_q(net, &cmd_q_req->req_hd);
 
-        free(req_lst);
+        util_mem_free(req_lst);
     }
 
-    util_list_flush(net->mtx, &net->wait_q_req_hd);
-    util_list_flush(net->mtx, &net->cb_req_hd);
+    util_que_flush(net->mtx, &net->wait_q_req_hd);
+    util_que_flush(net->mtx, &net->cb_req_hd);
 
     //Clean up security layer
     if (net->sec_enable)
@@ -8235,7 +8373,7 @@ void zwnet_exit(zwnet_p net, const char *node_info_file)
     zwhci_exit(&net->appl_ctx);
 
     //Free resources
-    util_list_flush(net->nw_exec_mtx, &net->nw_exec_req_hd);
+    util_que_flush(net->nw_exec_mtx, &net->nw_exec_req_hd);
 
     zwnet_node_rm_all(net);
     if (net->poll_enable)
@@ -8243,6 +8381,9 @@ void zwnet_exit(zwnet_p net, const char *node_info_file)
         zwpoll_exit(net->poll_ctx);
     }
 
+    //No reader is left, free the removed nodes, endpoints and interfaces
+    zwnet_obj_reclaim(net, 1);
+
 	while (net->stAGIData.pAGIGroupList != NULL)
 	{
 		AGI_Group *pGroup = net->stAGIData.pAGIGroupList;
@@ -8963,7 +9104,7 @@ static void zwnet_node_add_cb(struct _appl_layer_ctx *appl_ctx, uint8_t sts,
         //Check whether node info is available now
         if (node_info)
         {
-            zwnet_node_info_update(nw, node_info);
+            zwnet_node_info_update(nw, node_info, NULL, 0);
         }
         else
         {   //Create a node info
@@ -8971,7 +9112,7 @@ static void zwnet_node_add_cb(struct _appl_layer_ctx *appl_ctx, uint8_t sts,
             memset(&ni, 0, sizeof(appl_node_info_t));
             ni.node_id = node_id;
 
-            zwnet_node_info_update(nw, &ni);
+            zwnet_node_info_update(nw, &ni, NULL, 0);
         }
         node = zwnode_find(&nw->ctl, node_id);
 
@@ -9122,7 +9263,7 @@ void zwnet_node_rm_all(zwnet_p nw)
         }
 
         //Remove node
-        zwobj_del(&nw->ctl.obj.next, &node->obj);
+        zwnode_lst_del(nw, node);
     }
     //
     //Remove the first node (controller node)
@@ -10219,7 +10360,7 @@ static void zwnet_migrate_cb(struct _appl_layer_ctx *appl_ctx, uint8_t sts,
         //Check whether node info is available now
         if (node_info)
         {
-            zwnet_node_info_update(nw, node_info);
+            zwnet_node_info_update(nw, node_info, NULL, 0);
         }
         else
         {   //Create a node info
@@ -10227,7 +10368,7 @@ static void zwnet_migrate_cb(struct _appl_layer_ctx *appl_ctx, uint8_t sts,
             memset(&ni, 0, sizeof(appl_node_info_t));
             ni.node_id = node_id;
 
-            zwnet_node_info_update(nw, &ni);
+            zwnet_node_info_update(nw, &ni, NULL, 0);
         }
         node = zwnode_find(&nw->ctl, node_id);
 
@@ -10405,6 +10546,115 @@ void zwnet_version(uint8_t *ver, uint8_t *subver)
 }
 
 
+/**
+zwnet_mtx_prof_dump - Show the mutex contention statistics
+@param[in]	net		Network
+@param[in]	reset	Flag to clear the statistics after showing them
+@return		ZW_ERR_NONE on success; ZW_ERR_UNSUPPORTED if the profiler is not built in.
+*/
+int zwnet_mtx_prof_dump(zwnet_p net, int reset)
+{
+#if defined(OS_LINUX) && defined(PLT_MTX_PROF)
+    plt_mtx_prof_dump(&net->plt_ctx);
+    if (reset)
+    {
+        plt_mtx_prof_reset();
+    }
+    return ZW_ERR_NONE;
+#else
+    return ZW_ERR_UNSUPPORTED;
+#endif
+}
+
+
+/**
+zwnet_frm_stat_get - Get the serial frame statistics
+@param[in]	net		Network
+@param[out]	stat	Frame statistics
+@param[in]	reset	Flag to clear the statistics after reading them
+@return		ZW_ERR_XXX
+*/
+int zwnet_frm_stat_get(zwnet_p net, frm_stat_t *stat, int reset)
+{
+    if (!net || !stat)
+    {
+        return ZW_ERR_VALUE;
+    }
+
+    frm_stat_get(&net->appl_ctx.ssn_ctx.frm_ctx, stat, reset);
+    return ZW_ERR_NONE;
+}
+
+
+/**
+zwnet_snd_cls_set - Set the priority class of the commands sent by the calling thread
+@param[in]	cls		APPL_SND_CLS_XXX
+@return		The previous class of the calling thread
+*/
+int zwnet_snd_cls_set(int cls)
+{
+    return zwhci_snd_cls_set((uint8_t)cls);
+}
+
+
+/**
+zwnet_snd_stat_get - Get the send statistics of each priority class
+@param[in]	net		Network
+@param[out]	stat	Send statistics
+@param[in]	reset	Flag to clear the statistics after reading them
+@return		ZW_ERR_XXX
+*/
+int zwnet_snd_stat_get(zwnet_p net, appl_snd_stat_t *stat, int reset)
+{
+    if (!net || !stat)
+    {
+        return ZW_ERR_VALUE;
+    }
+
+    zwhci_snd_stat_get(&net->appl_ctx, stat, reset);
+    return ZW_ERR_NONE;
+}
+
+
+/**
+zwnet_node_lat_get - Get the transmit completion latency of a node
+@param[in]	net		Network
+@param[in]	nodeid	Node id
+@param[out]	lat		Latency of the node
+@param[in]	reset	Flag to clear the histogram, the highest latency and the timeout count after reading them
+@return		ZW_ERR_XXX
+*/
+int zwnet_node_lat_get(zwnet_p net, uint8_t nodeid, appl_node_lat_t *lat, int reset)
+{
+    if (!net || !lat || (nodeid == 0) || (nodeid > ZW_MAX_NODES))
+    {
+        return ZW_ERR_VALUE;
+    }
+
+    zwhci_node_lat_get(&net->appl_ctx, nodeid, lat, reset);
+    return ZW_ERR_NONE;
+}
+
+
+/**
+zwnet_cb_stat_get - Get the statistics of the received command dispatcher
+@param[in]	net		Network
+@param[out]	stat	Dispatcher statistics
+@param[in]	reset	Flag to clear the statistics after reading them
+@return		ZW_ERR_XXX
+*/
+int zwnet_cb_stat_get(zwnet_p net, ssn_cb_stat_t *stat, int reset)
+{
+    if (!net || !stat)
+    {
+        return ZW_ERR_VALUE;
+    }
+
+    ssn_cb_stat_get(&net->appl_ctx.ssn_ctx, stat, reset);
+    return ZW_ERR_NONE;
+}
+
+
 /**
 zwnet_rp_tmout_cb - Replace node id node info state-machine timeout callback
 @param[in] data     Pointer to network
@@ -13383,7 +13633,7 @@ int zwnet_quick_reset(void *comm_port_name)
         return ZW_ERR_MEMORY;
 
     //Initialize platform
-    if (plt_init(&nw->plt_ctx, NULL) != 0)
+    if (plt_init(&nw->plt_ctx, NULL, 0) != 0)
     {
         result = ZW_ERR_NO_RES;
         goto l_ZWNET_RESET_ERROR1;
@@ -597,14 +597,7 @@ static int zwutl_if_load(zwep_p ep, uint8_t *subtag_buf, uint16_t len, uint16_t
     intf->ep = ep;
 
     //Add interface to the end point
-    if (ep->intf)
-    {   //Second interface onwards
-        zwobj_add(&ep->intf->obj.next, &intf->obj);
-    }
-    else
-    {   //First interface
-        ep->intf = intf;
-    }
+    zwobj_add((zwobj_p *)(&ep->intf), &intf->obj);
 
     //Point to the next sub-tag
     subtag += 3;
@@ -58,6 +58,16 @@ static int    zwpoll_tmr_exp_chk(uint32_t now, uint32_t timer)
 }
 
 
+/**
+zwpoll_tm_get - Get current time
+@return current time in terms of timer tick
+*/
+static uint32_t   zwpoll_tm_get(void)
+{
+    return (uint32_t)(plt_mono_ms() / POLL_TIMER_TICK);
+}
+
+
 /**
 zwpoll_tm_diff - Calculate time different in terms of timer tick
 @param[in] tm1     Time 1
@@ -124,7 +134,7 @@ void zwpoll_rpt_chk(zwif_p intf, uint8_t *cmd_buf, uint8_t cmd_len)
             poll_q_ent_t    *poll_q_ent;
 
             //Re-calculate next poll time
-            poll_ctx->next_poll_tm = poll_ctx->tmr_tick + poll_ctx->cur_cmd_tm + MIN_POLL_TIME;
+            poll_ctx->next_poll_tm = zwpoll_tm_get() + poll_ctx->cur_cmd_tm + MIN_POLL_TIME;
 
             //Clear the command class and report
             poll_ctx->cur_cmd_cls = poll_ctx->cur_rpt = 0;
@@ -161,7 +171,7 @@ void zwpoll_rpt_chk(zwif_p intf, uint8_t *cmd_buf, uint8_t cmd_len)
                     break;
                 }
 
-                if (zwpoll_tmr_exp_chk(poll_ctx->tmr_tick, poll_q_ent->next_poll_tm))
+                if (zwpoll_tmr_exp_chk(zwpoll_tm_get(), poll_q_ent->next_poll_tm))
                 {   //Expired
                     //Send the polling command
                     zwpoll_cmd_send(poll_ctx, temp, prev_ent);
@@ -209,7 +219,7 @@ static void zwpoll_tx_sts_hdlr(zwpoll_ctx_t *poll_ctx, uint32_t cur_tm, uint8_t
         }
 
         //Re-calculate next poll time
-        poll_ctx->next_poll_tm = poll_ctx->tmr_tick + cmd_tm + MIN_POLL_TIME;
+        poll_ctx->next_poll_tm = zwpoll_tm_get() + cmd_tm + MIN_POLL_TIME;
 
         //Save the command time
         poll_ctx->cur_cmd_tm = cmd_tm;
@@ -218,7 +228,7 @@ static void zwpoll_tx_sts_hdlr(zwpoll_ctx_t *poll_ctx, uint32_t cur_tm, uint8_t
     else
     {
         //Re-calculate next poll time
-        poll_ctx->next_poll_tm = poll_ctx->tmr_tick + MIN_POLL_TIME;
+        poll_ctx->next_poll_tm = zwpoll_tm_get() + MIN_POLL_TIME;
     }
 
     plt_mtx_ulck(poll_ctx->poll_mtx);
@@ -238,7 +248,7 @@ void zwpoll_beam_tx_cb(appl_layer_ctx_t  *appl_ctx, uint8_t tx_sts, void *user_p
     zwpoll_ctx_t    *poll_ctx = nw->poll_ctx;
     uint32_t        cur_tm;
 
-    cur_tm = poll_ctx->tmr_tick;
+    cur_tm = zwpoll_tm_get();
 
     //Call back zwnode_wait_tx_cb
     zwnode_wait_tx_cb(appl_ctx, tx_sts, user_prm);
@@ -261,7 +271,7 @@ static void zwpoll_tx_cb(appl_layer_ctx_t  *appl_ctx, uint8_t tx_sts, void *user
     zwpoll_ctx_t    *poll_ctx = nw->poll_ctx;
     uint32_t        cur_tm;
 
-    cur_tm = poll_ctx->tmr_tick;
+    cur_tm = zwpoll_tm_get();
 
     zwpoll_tx_sts_hdlr(poll_ctx, cur_tm, tx_sts);
 
@@ -279,24 +289,28 @@ zwpoll_cmd_send - Send a poll command and update the next poll time and poll lis
 static int zwpoll_cmd_send(zwpoll_ctx_t *poll_ctx, util_lst_t *poll_lst_ent, util_lst_t *prev_lst_ent)
 {
     int             result;
+    uint8_t         snd_cls;
     poll_q_ent_t    *poll_q_ent = (poll_q_ent_t *)poll_lst_ent->wr_buf;
 
     poll_ctx->cur_node_id = poll_q_ent->node_id;
     poll_ctx->cur_handle = poll_q_ent->handle;
     poll_ctx->cur_node_last = 0;
 
+    //Let interactive and interview commands go ahead of polling
+    snd_cls = zwhci_snd_cls_set(APPL_SND_CLS_BG);
     result = zwif_exec_ex(&poll_q_ent->ifd, poll_q_ent->dat_buf, poll_q_ent->dat_len,
                           zwpoll_tx_cb, NULL,
                           ZWIF_OPT_POLL, NULL);
+    zwhci_snd_cls_set(snd_cls);
 
-    poll_ctx->cur_start_tm = poll_ctx->tmr_tick;
+    poll_ctx->cur_start_tm = zwpoll_tm_get();
     poll_ctx->cur_cmd_tm = 0;
     poll_ctx->cur_cmd_cls = poll_q_ent->cmd_cls;
     poll_ctx->cur_rpt = poll_q_ent->rpt;
 
     //Update the poll entry next polling time
     poll_q_ent->next_poll_tm = (poll_q_ent->interval < MIN_POLL_TIME)? MIN_POLL_TIME : poll_q_ent->interval;
-    poll_q_ent->next_poll_tm += poll_ctx->tmr_tick;
+    poll_q_ent->next_poll_tm += zwpoll_tm_get();
 
     //Decrement poll count for non-repetitive polling
     if (poll_q_ent->poll_cnt > 1)
@@ -318,7 +332,7 @@ static int zwpoll_cmd_send(zwpoll_ctx_t *poll_ctx, util_lst_t *poll_lst_ent, uti
     }
 
     //Update poll context next polling time
-    poll_ctx->next_poll_tm = poll_ctx->tmr_tick + MIN_POLL_TIME;
+    poll_ctx->next_poll_tm = zwpoll_tm_get() + MIN_POLL_TIME;
 
     return result;
 
@@ -326,7 +340,47 @@ static int zwpoll_cmd_send(zwpoll_ctx_t *poll_ctx, util_lst_t *poll_lst_ent, uti
 
 
 /**
-zwpoll_tmr_chk_thrd - thread to process timer tick event
+zwpoll_tmout_cb - Next poll time timeout callback
+@param[in] data     Pointer to polling context
+@return
+*/
+static void    zwpoll_tmout_cb(void *data)
+{
+    zwpoll_ctx_t   *poll_ctx = (zwpoll_ctx_t *)data;
+
+    //Send next poll time event
+    plt_sem_post(poll_ctx->tmr_sem);
+}
+
+
+/**
+zwpoll_wake_arm - Start a timer to wake up the timer check thread at the next poll time
+@param[in] poll_ctx     Polling context
+@return
+@pre    Caller must lock the poll_mtx
+*/
+static void zwpoll_wake_arm(zwpoll_ctx_t *poll_ctx)
+{
+    uint32_t    cur_tm;
+    uint32_t    tmout;
+
+    plt_tmr_stop(&poll_ctx->net->plt_ctx, poll_ctx->tick_tmr_ctx);
+    poll_ctx->tick_tmr_ctx = NULL;
+
+    if (poll_ctx->tmr_chk_thrd_run == 0)
+    {   //Shutting down
+        return;
+    }
+
+    cur_tm = zwpoll_tm_get();
+    tmout = (zwpoll_tmr_exp_chk(cur_tm, poll_ctx->next_poll_tm))? 0 : zwpoll_tm_diff(poll_ctx->next_poll_tm, cur_tm);
+
+    poll_ctx->tick_tmr_ctx = plt_tmr_start(&poll_ctx->net->plt_ctx, tmout * POLL_TIMER_TICK, zwpoll_tmout_cb, poll_ctx);
+}
+
+
+/**
+zwpoll_tmr_chk_thrd - thread to process next poll time event
 @param[in]	data		Context
 @return
 */
@@ -344,7 +398,7 @@ static void zwpoll_tmr_chk_thrd(void *data)
 
     while (1)
     {
-        //Wait for timer tick event
+        //Wait for next poll time event
         plt_sem_wait(poll_ctx->tmr_sem);
 
         //Check whether to exit the thread
@@ -357,15 +411,17 @@ static void zwpoll_tmr_chk_thrd(void *data)
         plt_mtx_lck(poll_ctx->poll_mtx);
 
         //Check whether the next poll time has expired
-        if (zwpoll_tmr_exp_chk(poll_ctx->tmr_tick, poll_ctx->next_poll_tm) == 0)
+        if (zwpoll_tmr_exp_chk(zwpoll_tm_get(), poll_ctx->next_poll_tm) == 0)
         {   //Not expire yet, continue to wait
+            zwpoll_wake_arm(poll_ctx);
             plt_mtx_ulck(poll_ctx->poll_mtx);
             continue;
         }
 
         if (poll_ctx->poll_lst_hd == NULL)
         {   //Poll queue is empty
-            poll_ctx->next_poll_tm = poll_ctx->tmr_tick + MIN_POLL_TIME;
+            poll_ctx->next_poll_tm = zwpoll_tm_get() + MIN_POLL_TIME;
+            zwpoll_wake_arm(poll_ctx);
             plt_mtx_ulck(poll_ctx->poll_mtx);
             continue;
         }
@@ -439,7 +495,7 @@ static void zwpoll_tmr_chk_thrd(void *data)
 
         while (temp)
         {
-            if (zwpoll_tmr_exp_chk(poll_ctx->tmr_tick, poll_q_ent->next_poll_tm))
+            if (zwpoll_tmr_exp_chk(zwpoll_tm_get(), poll_q_ent->next_poll_tm))
             {   //Expired
                 break;
             }
@@ -471,31 +527,16 @@ static void zwpoll_tmr_chk_thrd(void *data)
         else
         {
             //Update next poll time
-            poll_ctx->next_poll_tm = poll_ctx->tmr_tick + CHECK_EXPIRY_INTERVAL;
+            poll_ctx->next_poll_tm = zwpoll_tm_get() + CHECK_EXPIRY_INTERVAL;
         }
 
+        zwpoll_wake_arm(poll_ctx);
+
         plt_mtx_ulck(poll_ctx->poll_mtx);
     }
 }
 
 
-/**
-zwpoll_tmr_tick_cb - Timer tick timeout callback
-@param[in] data     Pointer to security layer context
-@return
-*/
-static void    zwpoll_tmr_tick_cb(void *data)
-{
-    zwpoll_ctx_t   *poll_ctx = (zwpoll_ctx_t *)data;
-
-    //Increment timer tick
-    poll_ctx->tmr_tick++;
-
-    //Send timer tick event
-    plt_sem_post(poll_ctx->tmr_sem);
-}
-
-
 /**
 zwpoll_hdl_cmp - Compare two handles
 @param[in]	h1	Handle 1
@@ -692,7 +733,7 @@ int zwpoll_add(zwnet_p net, poll_q_ent_t *poll_ent)
 
     plt_mtx_lck(poll_ctx->poll_mtx);
 
-    new_poll_ent->next_poll_tm = poll_ctx->tmr_tick + new_poll_ent->interval;
+    new_poll_ent->next_poll_tm = zwpoll_tm_get() + new_poll_ent->interval;
 
     poll_ent->handle = new_poll_ent->handle = ++poll_ctx->handle_gen;//TODO: make sure it's unique
 
@@ -767,8 +808,8 @@ zwpoll_init - Initialize the polling facility
 int zwpoll_init(zwpoll_ctx_t *poll_ctx)
 {
 
-    poll_ctx->tmr_tick = 0;
-    poll_ctx->next_poll_tm = MIN_POLL_TIME;
+    poll_ctx->next_poll_tm = zwpoll_tm_get() + MIN_POLL_TIME;
+    poll_ctx->tick_tmr_ctx = NULL;
     poll_ctx->poll_lst_hd = NULL;
     poll_ctx->handle_gen = 0;
     poll_ctx->cur_node_id = 0;
@@ -780,21 +821,21 @@ int zwpoll_init(zwpoll_ctx_t *poll_ctx)
     {
         goto l_POLL_INIT_ERROR1;
     }
-    poll_ctx->tick_tmr_ctx = plt_periodic_start(&poll_ctx->net->plt_ctx, POLL_TIMER_TICK, zwpoll_tmr_tick_cb, poll_ctx);
-    if (!poll_ctx->tick_tmr_ctx)
-        goto l_POLL_INIT_ERROR2;
 
     //Start timer check thread
     poll_ctx->tmr_chk_thrd_run = 1;
     if (plt_thrd_create(zwpoll_tmr_chk_thrd, poll_ctx) < 0)
     {
-        goto l_POLL_INIT_ERROR3;
+        goto l_POLL_INIT_ERROR2;
     }
 
+    //Wake up the thread at the first poll time
+    plt_mtx_lck(poll_ctx->poll_mtx);
+    zwpoll_wake_arm(poll_ctx);
+    plt_mtx_ulck(poll_ctx->poll_mtx);
+
     return ZW_ERR_NONE;
 
-l_POLL_INIT_ERROR3:
-    plt_tmr_stop(&poll_ctx->net->plt_ctx, poll_ctx->tick_tmr_ctx);
 l_POLL_INIT_ERROR2:
     plt_sem_destroy(poll_ctx->tmr_sem);
 l_POLL_INIT_ERROR1:
@@ -813,11 +854,11 @@ void zwpoll_shutdown(zwpoll_ctx_t *poll_ctx)
 {
     int wait_count;
 
-    //Stop timer
-    plt_tmr_stop(&poll_ctx->net->plt_ctx, poll_ctx->tick_tmr_ctx);
-
-    //Stop thread
+    //Stop thread and timer
+    plt_mtx_lck(poll_ctx->poll_mtx);
     poll_ctx->tmr_chk_thrd_run = 0;
+    zwpoll_wake_arm(poll_ctx);
+    plt_mtx_ulck(poll_ctx->poll_mtx);
     plt_sem_post(poll_ctx->tmr_sem);
 
     wait_count = 50;
@@ -144,85 +144,24 @@ int zwsec_spp_gen(zwsec_mac_t *mac_in, uint8_t *auth_key, uint8_t *enc_key, uint
 
 
 /**
-zwsec_timer_chk - Check whether the timer has expired
-@param[in] now     Current time
-@param[in] timer   The time of the timer to check
-@return 1=timer has expired; otherwise 0
-*/
-static int    zwsec_timer_chk(uint16_t now, uint16_t timer)
-{
-    uint16_t    time_diff;
-    if (now == timer)
-    {
-        return 1;
-    }
-
-    //Handle wrap over case
-    if (now > timer)
-    {
-        time_diff = now - timer;
-        if (time_diff < 0xF000)
-        {
-            return 1;
-        }
-    }
-    else //now < timer
-    {
-        time_diff = timer - now;
-        if (time_diff >= 0xF000)
-        {
-            return 1;
-        }
-    }
-    //Not expired
-    return 0;
-}
-
-
-/**
-zwsec_tmout_cb - Timer tick timeout callback
-@param[in] data     Pointer to security layer context
+zwsec_inonce_clean - Invalidate the expired internal nonces
+@param[in,out]	sec_ctx	    Security layer context
 @return
+@pre Caller should lock the mutext sec_mtx before calling this function.
 */
-static void    zwsec_tmout_cb(void *data)
+static void zwsec_inonce_clean(zwsec_layer_t *sec_ctx)
 {
-    zwsec_layer_t   *sec_ctx = (zwsec_layer_t *)data;
-
-    //Increment timer tick
-    sec_ctx->tmr_tick++;
+    int         i;
+    uint64_t    now = plt_mono_ms();
 
-    //Check if external nonce has expired
-    if (sec_ctx->ext_nonce.valid)
+    for (i=0; i<INTERNAL_NONCE_TABLE_SIZE; i++)
     {
-        if (plt_mtx_trylck(sec_ctx->sec_mtx) == 0)//prevent deadlock that causes other timer callbacks blocked
+        if (sec_ctx->inonce_tbl[i].state == INONCE_STA_VALID)
         {
-            if (zwsec_timer_chk(sec_ctx->tmr_tick, sec_ctx->ext_nonce.expiry_tick))
+            //Check whether the nonce has expired
+            if (now >= sec_ctx->inonce_tbl[i].expiry_ms)
             {   //Expired, invalidate it
-                sec_ctx->ext_nonce.valid = 0;
-            }
-            plt_mtx_ulck(sec_ctx->sec_mtx);
-        }
-    }
-
-    //Increment internal nonce table clean up tick
-    sec_ctx->clean_up_tick++;
-    if (sec_ctx->clean_up_tick >= INTERNAL_NONCE_TABLE_CHECK)
-    {
-        int i;
-
-        //Reset clean up tick
-        sec_ctx->clean_up_tick = 0;
-
-        //Clean up internal nonce table
-        for (i=0; i<INTERNAL_NONCE_TABLE_SIZE; i++)
-        {
-            if (sec_ctx->inonce_tbl[i].state == INONCE_STA_VALID)
-            {
-                //Check whether the nonce has expired
-                if (zwsec_timer_chk(sec_ctx->tmr_tick, sec_ctx->inonce_tbl[i].expiry_tick))
-                {   //Expired, invalidate it
-                    sec_ctx->inonce_tbl[i].state = INONCE_STA_INVALID;
-                }
+                sec_ctx->inonce_tbl[i].state = INONCE_STA_INVALID;
             }
         }
     }
@@ -243,6 +182,9 @@ int zwsec_inonce_gen(zwsec_layer_t *sec_ctx, uint8_t node_id, uint8_t state)
     int j;
     int found;
 
+    //Reclaim the slots of expired nonces
+    zwsec_inonce_clean(sec_ctx);
+
     //Find an empty slot to store the generated nonce
     for (i=0; i<INTERNAL_NONCE_TABLE_SIZE; i++)
     {
@@ -285,7 +227,7 @@ int zwsec_inonce_gen(zwsec_layer_t *sec_ctx, uint8_t node_id, uint8_t state)
         }
 
         sec_ctx->inonce_tbl[i].rcv_nodeid = node_id;
-        sec_ctx->inonce_tbl[i].expiry_tick = sec_ctx->tmr_tick + INTERNAL_NONCE_LIFE;
+        sec_ctx->inonce_tbl[i].expiry_ms = plt_mono_ms() + INTERNAL_NONCE_LIFE;
         sec_ctx->inonce_tbl[i].state = state;
         return i;
     }
@@ -303,7 +245,7 @@ zwsec_inonce_expire_set - Set the expiry time of the internal nonce
 */
 void zwsec_inonce_expire_set(zwsec_layer_t *sec_ctx, int index)
 {
-    sec_ctx->inonce_tbl[index].expiry_tick = sec_ctx->tmr_tick + INTERNAL_NONCE_LIFE;
+    sec_ctx->inonce_tbl[index].expiry_ms = plt_mono_ms() + INTERNAL_NONCE_LIFE;
     sec_ctx->inonce_tbl[index].state = INONCE_STA_VALID;
 }
 
@@ -326,7 +268,7 @@ int zwsec_inonce_get(zwsec_layer_t *sec_ctx, uint8_t rcv_nonce_id)
             {   //The first byte of nonce matches the receiver nonce id
 
                 //Check whether the nonce has expired
-                if (zwsec_timer_chk(sec_ctx->tmr_tick, sec_ctx->inonce_tbl[i].expiry_tick))
+                if (plt_mono_ms() >= sec_ctx->inonce_tbl[i].expiry_ms)
                 {
                     return ZW_ERR_EXPIRED;
                 }
@@ -373,6 +315,12 @@ zwsec_enonce_put - Store an external nonce
 void zwsec_enonce_put(zwsec_layer_t *sec_ctx, uint8_t *ext_nonce, uint8_t node_id)
 {
     plt_mtx_lck(sec_ctx->sec_mtx);
+    //Invalidate the stored external nonce if it has expired
+    if (sec_ctx->ext_nonce.valid && (plt_mono_ms() >= sec_ctx->ext_nonce.expiry_ms))
+    {
+        sec_ctx->ext_nonce.valid = 0;
+    }
+
     //Check for duplicate external nonce
     if (!sec_ctx->ext_nonce.valid)
     {
@@ -385,7 +333,7 @@ void zwsec_enonce_put(zwsec_layer_t *sec_ctx, uint8_t *ext_nonce, uint8_t node_i
     }
     memcpy(sec_ctx->ext_nonce.nonce, ext_nonce, 8);
     sec_ctx->ext_nonce.snd_nodeid = node_id;
-    sec_ctx->ext_nonce.expiry_tick = sec_ctx->tmr_tick + EXTERNAL_NONCE_LIFE;
+    sec_ctx->ext_nonce.expiry_ms = plt_mono_ms() + EXTERNAL_NONCE_LIFE;
     sec_ctx->ext_nonce.valid = 1;
 
     plt_mtx_ulck(sec_ctx->sec_mtx);
@@ -408,7 +356,7 @@ int zwsec_enonce_get(zwsec_layer_t *sec_ctx, uint8_t node_id, uint8_t *ext_nonce
         if(sec_ctx->ext_nonce.snd_nodeid == node_id)
         {
             //Check whether the nonce has expired
-            if (zwsec_timer_chk(sec_ctx->tmr_tick, sec_ctx->ext_nonce.expiry_tick) == 0)
+            if (plt_mono_ms() < sec_ctx->ext_nonce.expiry_ms)
             {
                 memcpy(ext_nonce, sec_ctx->ext_nonce.nonce, 8);
                 //Invalidate the stored external nonce since nonce can only be used once.
@@ -938,7 +886,7 @@ static void    zwsec_sm_next(zwnet_p nw)
                 sec_ctx->tx_sm_cb(nw, tx_param->nodeid, result, sec_ctx->tx_sm_user);
             }
         }
-        free(req_lst);
+        util_mem_free(req_lst);
 
         if (result == 0)
         {
@@ -2177,9 +2125,7 @@ int zwsec_init(zwsec_layer_t *sec_ctx)
     }
 
     sec_ctx->tx_sm_sta = ZWSEC_STA_IDLE;
-    sec_ctx->tmr_tick = 0;
     sec_ctx->tx_sm_q_cnt = 0;
-    sec_ctx->clean_up_tick = 0;
     sec_ctx->tx_sm_opp_hd = NULL;
     sec_ctx->incd_sm_sta = ZWSEC_INCD_IDLE;
     sec_ctx->add_sm_sta = ZWSEC_ADD_IDLE;
@@ -2187,10 +2133,6 @@ int zwsec_init(zwsec_layer_t *sec_ctx)
     if (!plt_mtx_init(&sec_ctx->sec_mtx))
         return ZW_ERR_NO_RES;
 
-    sec_ctx->tick_tmr_ctx = plt_periodic_start(&sec_ctx->net->plt_ctx, SEC_TIMER_TICK, zwsec_tmout_cb, sec_ctx);
-    if (!sec_ctx->tick_tmr_ctx)
-        goto l_SEC_INIT_ERROR1;
-
     //Generate network key
     zwsec_rand_output(&sec_ctx->prng_ctx, 16, sec_ctx->nw_key);
 
@@ -2204,10 +2146,6 @@ int zwsec_init(zwsec_layer_t *sec_ctx)
     sec_ctx->init_done = 1;
     return ZW_ERR_NONE;
 
-l_SEC_INIT_ERROR1:
-    plt_mtx_destroy(sec_ctx->sec_mtx);
-    return ZW_ERR_NO_RES;
-
 }
 
 /**
@@ -2226,7 +2164,6 @@ void zwsec_exit(zwsec_layer_t *sec_ctx)
     //Flush the transmission queue
     util_list_flush(sec_ctx->sec_mtx, &sec_ctx->tx_sm_opp_hd);
 
-    plt_tmr_stop(&sec_ctx->net->plt_ctx, sec_ctx->tick_tmr_ctx);
     plt_tmr_stop(&sec_ctx->net->plt_ctx, sec_ctx->tx_sm_tmr_ctx);
     plt_mtx_destroy(sec_ctx->sec_mtx);
 }